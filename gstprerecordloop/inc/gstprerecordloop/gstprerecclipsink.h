@@ -0,0 +1,46 @@
+/*
+ * GStreamer pre-record loop: direct-I/O clip sink
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#ifndef __GST_PRERECCLIPSINK_H__
+#define __GST_PRERECCLIPSINK_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_PREREC_CLIP_SINK (gst_prerec_clip_sink_get_type())
+G_DECLARE_FINAL_TYPE(GstPreRecClipSink, gst_prerec_clip_sink, GST, PREREC_CLIP_SINK, GstElement)
+
+struct _GstPreRecClipSink {
+  GstElement element;
+
+  GstPad* sinkpad;
+
+  /* properties, under the object lock */
+  gchar* location;         /* file name, or printf pattern taking the clip id */
+  gboolean direct_io;
+  guint buffer_size;       /* bounce buffer, multiple of the I/O alignment */
+  gboolean preallocate;
+  gboolean sync_per_clip;
+
+  /* streaming thread only */
+  gint fd;
+  gchar* filename;
+  gboolean direct_active;  /* fd has O_DIRECT (or F_NOCACHE) */
+  guint8* bounce;          /* aligned; holds the unwritten tail of the file */
+  gsize bounce_size;
+  gsize fill;
+  guint64 offset;          /* file offset of bounce[0], always aligned */
+  guint64 clip_bytes;      /* bytes written to the current clip */
+  guint clip_id;
+  gint64 clip_start_us;
+};
+
+GST_ELEMENT_REGISTER_DECLARE(prerec_clipsink);
+
+G_END_DECLS
+
+#endif /* __GST_PRERECCLIPSINK_H__ */
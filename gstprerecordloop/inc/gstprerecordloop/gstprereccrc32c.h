@@ -0,0 +1,21 @@
+/*
+ * GStreamer pre-record loop: CRC32C (Castagnoli)
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#ifndef __GST_PRERECCRC32C_H__
+#define __GST_PRERECCRC32C_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Continues crc over data; start with crc = 0. Uses the SSE4.2 crc32
+ * instruction on x86-64 when the CPU has it, the ARMv8 CRC extension when
+ * built for it, and a table otherwise. All paths give identical results. */
+guint32 gst_prerec_crc32c(guint32 crc, const guint8* data, gsize len);
+
+G_END_DECLS
+
+#endif /* __GST_PRERECCRC32C_H__ */
@@ -0,0 +1,28 @@
+/*
+ * GStreamer pre-record loop: window dump writer
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#ifndef __GST_PRERECDUMP_H__
+#define __GST_PRERECDUMP_H__
+
+#include <gstprerecordloop/gstprerecordloop.h>
+
+G_BEGIN_DECLS
+
+/* Writes buffers (starting at a keyframe) to location. Payloads go to the
+ * file straight from mapped buffer memory with writev(), one batch per GOP;
+ * only start codes and box headers are generated.
+ *
+ * ANNEXB: length-prefixed H.264/H.265 (avc/avc3/hvc1/hev1) is rewritten to
+ *         start codes with the codec_data parameter sets before each
+ *         keyframe; anything else is written as is.
+ * FMP4:   needs length-prefixed H.264/H.265 caps with codec_data, width
+ *         and height; writes an init segment and one moof/mdat per GOP. */
+gboolean gst_prerec_dump_write(const gchar* location, GstPreRecDumpFormat format, GstCaps* caps,
+                               GstBuffer** buffers, guint n_buffers, guint64* bytes_written, GError** error);
+
+G_END_DECLS
+
+#endif /* __GST_PRERECDUMP_H__ */
@@ -0,0 +1,74 @@
+/*
+ * GStreamer pre-record loop: lock-free flight recorder
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#ifndef __GST_PRERECFLIGHT_H__
+#define __GST_PRERECFLIGHT_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Fixed ring of the last GST_PREREC_FLIGHT_ENTRIES ring decisions of one
+ * element, kept in binary form so recording stays a few stores on the data
+ * path and can remain on in production. Only gst_prerec_flight_dump()
+ * formats anything.
+ *
+ * Writers claim a slot with one atomic add and publish it through its seq
+ * (slot index + 1; 0 while being written). The dump takes no lock: it copies
+ * each slot between two reads of seq and skips slots that changed meanwhile,
+ * so it never blocks or slows the streaming thread. */
+#define GST_PREREC_FLIGHT_ENTRIES 1024
+
+typedef enum {
+  GST_PREREC_FLIGHT_ENQUEUE, /* gop_id, a = pts, b = size */
+  GST_PREREC_FLIGHT_PRUNE,   /* gop_id dropped, a = queued time left, b = GOPs left */
+  GST_PREREC_FLIGHT_TRIGGER, /* gop_id newest, a = queued bytes, b = queued buffers */
+  GST_PREREC_FLIGHT_DRAIN,   /* gop_id newest, a = bytes pushed, b = buffers pushed */
+  GST_PREREC_FLIGHT_ARM,     /* a = rearm count */
+  GST_PREREC_FLIGHT_FLUSH,   /* a = full flush, b = buffers dropped */
+  GST_PREREC_FLIGHT_EOS,     /* a = drain, b = queued buffers */
+} GstPreRecFlightKind;
+
+typedef struct {
+  guint seq;
+  guint gop_id;
+  guint64 ts; /* gst_util_get_timestamp() */
+  guint64 a;
+  guint32 b;
+  guint32 kind;
+} GstPreRecFlightEntry;
+
+typedef struct {
+  guint head; /* slots ever claimed */
+  GstPreRecFlightEntry* entries;
+} GstPreRecFlight;
+
+void gst_prerec_flight_init(GstPreRecFlight* flight);
+void gst_prerec_flight_clear(GstPreRecFlight* flight);
+
+static inline void gst_prerec_flight_record(GstPreRecFlight* flight, GstPreRecFlightKind kind, guint gop_id,
+                                            guint64 a, guint32 b) {
+  guint idx = __atomic_fetch_add(&flight->head, 1, __ATOMIC_RELAXED);
+  GstPreRecFlightEntry* e = &flight->entries[idx & (GST_PREREC_FLIGHT_ENTRIES - 1)];
+
+  __atomic_store_n(&e->seq, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  e->gop_id = gop_id;
+  e->ts = gst_util_get_timestamp();
+  e->a = a;
+  e->b = b;
+  e->kind = kind;
+  __atomic_store_n(&e->seq, idx + 1, __ATOMIC_RELEASE);
+}
+
+/* One line per recorded decision, oldest first, with the time relative to
+ * the newest one. Safe to call from any thread while recording goes on.
+ * Free with g_free(). */
+gchar* gst_prerec_flight_dump(const GstPreRecFlight* flight);
+
+G_END_DECLS
+
+#endif /* __GST_PRERECFLIGHT_H__ */
@@ -0,0 +1,27 @@
+/*
+ * GStreamer pre-record loop: memfd hand-off sender
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#ifndef __GST_PRERECHANDOFF_H__
+#define __GST_PRERECHANDOFF_H__
+
+#include <gst/gst.h>
+#include <gstprerecordloop/gstprerechandoffproto.h>
+#include <gstprerecordloop/gstprerecspill.h>
+
+G_BEGIN_DECLS
+
+/* Sends buffers to the consumer listening on socket_path (see
+ * gstprerechandoffproto.h) and blocks until it acks or timeout_ms passes.
+ * Only the frame index crosses the socket; payloads stay in the arena's
+ * memfd. Buffers that are not in the arena yet are copied into it first;
+ * those that do not fit are skipped and counted in *skipped. */
+gboolean gst_prerec_handoff_send(const gchar* socket_path, GstPreRecSpill* arena, guint64 clip_id, GstCaps* caps,
+                                 GstBuffer** buffers, guint n_buffers, guint timeout_ms, guint* frames,
+                                 guint* skipped, guint64* bytes, GError** error);
+
+G_END_DECLS
+
+#endif /* __GST_PRERECHANDOFF_H__ */
@@ -0,0 +1,51 @@
+/*
+ * GStreamer pre-record loop: memfd hand-off wire protocol
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ *
+ * Plain C so consumers can include it without GLib. On a trigger the element
+ * connects to handoff-socket (AF_UNIX, SOCK_STREAM) and sends, in one
+ * sendmsg() carrying the ring's memfd as SCM_RIGHTS:
+ *
+ *   GstPreRecHandoffHeader
+ *   caps string (caps_len bytes, not NUL terminated)
+ *   n_frames x GstPreRecHandoffFrame
+ *
+ * All fields are host byte order (both ends share the machine). Frame
+ * payloads are [offset, offset + size) of the memfd. The consumer maps the fd
+ * read-only, writes the frames out and replies with a single
+ * GST_PREREC_HANDOFF_ACK byte; until then the element keeps those regions of
+ * the ring alive.
+ */
+
+#ifndef __GST_PRERECHANDOFFPROTO_H__
+#define __GST_PRERECHANDOFFPROTO_H__
+
+#include <stdint.h>
+
+#define GST_PREREC_HANDOFF_MAGIC 0x31485250u /* "PRH1" */
+#define GST_PREREC_HANDOFF_VERSION 1u
+#define GST_PREREC_HANDOFF_ACK 'A'
+
+#define GST_PREREC_HANDOFF_FRAME_KEY (1u << 0)
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t clip_id;
+  uint64_t arena_size;
+  uint32_t n_frames;
+  uint32_t caps_len;
+} GstPreRecHandoffHeader;
+
+typedef struct {
+  uint64_t offset;
+  uint64_t size;
+  uint64_t pts; /* GST_CLOCK_TIME_NONE (all ones) when unset */
+  uint64_t dts;
+  uint64_t duration;
+  uint32_t flags;
+  uint32_t reserved;
+} GstPreRecHandoffFrame;
+
+#endif /* __GST_PRERECHANDOFFPROTO_H__ */
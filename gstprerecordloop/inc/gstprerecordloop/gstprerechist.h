@@ -0,0 +1,68 @@
+/*
+ * GStreamer pre-record loop: log-bucketed latency histograms
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#ifndef __GST_PRERECHIST_H__
+#define __GST_PRERECHIST_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* HDR-style layout: every power of two is split into GST_PREREC_HIST_SUB
+ * linear sub-buckets, so any recorded value is known to within 1/8 of itself
+ * over the whole 64-bit range at a fixed size and without configuration.
+ * Values below GST_PREREC_HIST_SUB get one exact bucket each. */
+#define GST_PREREC_HIST_SUB_BITS 3
+#define GST_PREREC_HIST_SUB (1 << GST_PREREC_HIST_SUB_BITS)
+#define GST_PREREC_HIST_BUCKETS ((64 - GST_PREREC_HIST_SUB_BITS + 1) * GST_PREREC_HIST_SUB)
+
+typedef struct {
+  guint64 count;
+  guint64 sum;
+  guint64 min;
+  guint64 max;
+  guint64 buckets[GST_PREREC_HIST_BUCKETS];
+} GstPreRecHist;
+
+static inline guint gst_prerec_hist_index(guint64 value) {
+  guint msb;
+
+  if (value < GST_PREREC_HIST_SUB)
+    return (guint) value;
+  msb = 63 - __builtin_clzll(value);
+  return (msb - GST_PREREC_HIST_SUB_BITS + 1) * GST_PREREC_HIST_SUB +
+         (guint) ((value >> (msb - GST_PREREC_HIST_SUB_BITS)) & (GST_PREREC_HIST_SUB - 1));
+}
+
+/* Not thread-safe: callers serialize on their own lock. A handful of integer
+ * operations, cheap enough to stay on in production. */
+static inline void gst_prerec_hist_record(GstPreRecHist* hist, guint64 value) {
+  hist->buckets[gst_prerec_hist_index(value)]++;
+  if (hist->count == 0 || value < hist->min)
+    hist->min = value;
+  if (value > hist->max)
+    hist->max = value;
+  hist->count++;
+  hist->sum += value;
+}
+
+void gst_prerec_hist_reset(GstPreRecHist* hist);
+
+/* Smallest value of bucket index */
+guint64 gst_prerec_hist_bucket_start(guint index);
+
+/* Upper edge of the bucket holding the given quantile (0.0 - 1.0), clamped to
+ * the largest value seen; 0 if nothing was recorded */
+guint64 gst_prerec_hist_quantile(const GstPreRecHist* hist, gdouble quantile);
+
+/* Adds <name>-count, -min, -mean, -max, -p50, -p90, -p99, -p999 (ns) and
+ * <name>-buckets, a flat array of (bucket start, count) pairs for the
+ * non-empty buckets, to s */
+void gst_prerec_hist_to_structure(const GstPreRecHist* hist, GstStructure* s, const gchar* name);
+
+G_END_DECLS
+
+#endif /* __GST_PRERECHIST_H__ */
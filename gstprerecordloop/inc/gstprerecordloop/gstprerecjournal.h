@@ -0,0 +1,48 @@
+/*
+ * GStreamer pre-record loop: crash-persistent GOP journal
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#ifndef __GST_PRERECJOURNAL_H__
+#define __GST_PRERECJOURNAL_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* One file per closed GOP, written in a single writev() and renamed into
+ * place after fdatasync(), so a file either exists complete or not at all:
+ *
+ *   header   magic "PRJ1", version, seq, frame count, caps length,
+ *            GstSegment snapshot (sticky state of the GOP)
+ *   caps     caps string, NUL padded to 8 bytes
+ *   index    per frame: pts, dts, duration, flags, size, CRC32C
+ *   crc      CRC32C of everything above
+ *   payload  frame data back to back
+ *
+ * Running times are not stored: replay derives them from the segment
+ * snapshot, like any queued GOP. Fields are host endian: a journal is
+ * recovered on the box that wrote it.
+ */
+typedef struct {
+  guint64 seq;
+  GstCaps* caps;
+  GstSegment segment;
+  GPtrArray* buffers; /* GstBuffer*, owned */
+} GstPreRecJournalGop;
+
+gboolean gst_prerec_journal_write(const gchar* dir, guint64 seq, GstCaps* caps, const GstSegment* segment,
+                                  GstBuffer** buffers, guint n_buffers, GError** error);
+
+/* Validates header and per-frame CRCs; NULL (with error) on any mismatch */
+GstPreRecJournalGop* gst_prerec_journal_read(const gchar* dir, guint64 seq, GError** error);
+void gst_prerec_journal_gop_free(GstPreRecJournalGop* gop);
+
+/* Sequence numbers of complete GOP files, ascending; removes stale temp files */
+GArray* gst_prerec_journal_list(const gchar* dir);
+void gst_prerec_journal_remove(const gchar* dir, guint64 seq);
+
+G_END_DECLS
+
+#endif /* __GST_PRERECJOURNAL_H__ */
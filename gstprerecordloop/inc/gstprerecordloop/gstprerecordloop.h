@@ -49,6 +49,10 @@
 
 #include <gst/gst.h>
 #include <gst/gstvecdeque.h>
+#include <gstprerecordloop/gstprerecflight.h>
+#include <gstprerecordloop/gstprerechist.h>
+#include <gstprerecordloop/gstprerecspill.h>
+#include <gstprerecordloop/gstprerecstatspage.h>
 
 G_BEGIN_DECLS
 
@@ -62,6 +66,42 @@ typedef enum {
 #define GST_TYPE_PREREC_FLUSH_ON_EOS (gst_prerec_flush_on_eos_get_type())
 GType gst_prerec_flush_on_eos_get_type(void);
 
+/* Overflow policy of the "live" request pad queue */
+typedef enum {
+  GST_PREREC_LIVE_LEAKY_UPSTREAM,  /* drop the incoming buffer */
+  GST_PREREC_LIVE_LEAKY_DOWNSTREAM /* drop the oldest queued buffer */
+} GstPreRecLiveLeaky;
+
+#define GST_TYPE_PREREC_LIVE_LEAKY (gst_prerec_live_leaky_get_type())
+GType gst_prerec_live_leaky_get_type(void);
+
+/* Meaning of the strip-meta-apis list */
+typedef enum {
+  GST_PREREC_META_STRIP_REMOVE, /* remove the listed meta APIs */
+  GST_PREREC_META_STRIP_KEEP    /* keep only the listed meta APIs */
+} GstPreRecMetaStripMode;
+
+#define GST_TYPE_PREREC_META_STRIP_MODE (gst_prerec_meta_strip_mode_get_type())
+GType gst_prerec_meta_strip_mode_get_type(void);
+
+/* What max-time bounds when the ring prunes */
+typedef enum {
+  GST_PREREC_RETENTION_AT_MOST, /* prune while the ring holds more than max-time */
+  GST_PREREC_RETENTION_AT_LEAST /* prune only what is not needed to cover max-time */
+} GstPreRecRetentionPolicy;
+
+#define GST_TYPE_PREREC_RETENTION_POLICY (gst_prerec_retention_policy_get_type())
+GType gst_prerec_retention_policy_get_type(void);
+
+/* File format of the dump-window action signal */
+typedef enum {
+  GST_PREREC_DUMP_ANNEXB, /* raw elementary stream, H.264/H.265 as Annex-B */
+  GST_PREREC_DUMP_FMP4    /* fragmented MP4, one fragment per GOP */
+} GstPreRecDumpFormat;
+
+#define GST_TYPE_PREREC_DUMP_FORMAT (gst_prerec_dump_format_get_type())
+GType gst_prerec_dump_format_get_type(void);
+
 #define GST_TYPE_PRERECORDLOOP (gst_pre_record_loop_get_type())
 G_DECLARE_FINAL_TYPE(GstPreRecordLoop, gst_pre_record_loop, GST, PRERECORDLOOP, GstElement)
 #define GST_PRERECLOOP(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj), GST_TYPE_PRERECORDLOOP, GstPreRecordLoop))
@@ -73,6 +113,7 @@ typedef struct _GstPreRecSize {
   guint buffers;
   guint bytes;
   guint64 time;
+  guint events; /* queued serialized events other than SEGMENT/GAP */
 } GstPreRecSize;
 
 typedef enum { GST_PREREC_MODE_PASS_THROUGH, GST_PREREC_MODE_BUFFERING } GstPreRecLoopMode;
@@ -86,8 +127,37 @@ typedef struct _GstPreRecStats {
   guint queued_buffers_cur; /* current buffer count (mirror of cur_level.buffers) */
   guint flush_count;        /* number of accepted prerecord-flush events (T026) */
   guint rearm_count;        /* number of prerecord-arm events processed (T026) */
+  guint adopt_count;        /* number of parked rings adopted via ring-id */
+  guint live_drops;         /* buffers dropped by the live pad leaky policy */
+  guint64 ram_bytes_cur;    /* ring payload held in RAM (snapshot) */
+  guint64 spill_bytes_cur;  /* bytes occupied in the spill arena (snapshot) */
+  guint64 spill_written;    /* bytes copied into the spill arena */
+  guint64 spill_time_us;    /* spill worker time spent copying */
+  guint spill_full;         /* spill attempts that found the arena full */
+  guint journal_written;    /* GOP files written to the journal */
+  guint journal_recovered;  /* GOPs restored from the journal at startup */
+  guint journal_corrupt;    /* journal GOP files rejected by the CRC checks */
+  guint journal_skipped;    /* closed GOPs not journaled: too many writes pending */
+  guint handoff_count;      /* windows acknowledged by the hand-off consumer */
+  guint handoff_failed;     /* hand-offs that could not be sent or were not acked */
+  guint handoff_copied;     /* buffers copied into the memfd at ingest (not allocated there) */
+  guint64 slab_reserved_cur; /* bytes mapped by the slab allocator (snapshot) */
+  guint64 slab_used_cur;     /* slab bytes held by live memories (snapshot) */
+  guint slab_fallbacks;      /* allocations the slab handed to system memory */
+  guint64 meta_stripped;     /* metas removed from buffered frames */
+  guint64 meta_stripped_bytes; /* struct bytes of those metas */
+  guint state_restored;      /* snapshot sticky events a drain pushed before their GOP */
+  guint gaps_coalesced;      /* GAPs merged into the GAP queued before them */
+  guint events_queued;       /* other serialized events queued in order with the data */
+  guint events_superseded;   /* queued sticky events replaced by a newer one in the same GOP */
+  guint events_overflow;     /* events forwarded right away because max-queued-events was reached */
+  guint qos_dropped_buffers; /* drained frames skipped because downstream reported them late */
+  guint qos_dropped_gops;    /* whole GOPs among them */
 } GstPreRecStats;
 
+/* Sticky state (caps, segment, tags) in effect at a keyframe; see gstprerecordloop.c */
+typedef struct _GstPreRecGopState GstPreRecGopState;
+
 typedef struct _GstPreRecordLoop {
   GstElement element;
 
@@ -122,8 +192,18 @@ typedef struct _GstPreRecordLoop {
 
   gboolean newseg_applied_to_src;
 
+  /* sticky state seen on the sink pad so far; every keyframe entering the
+   * ring takes a ref, later changes copy it first */
+  GstPreRecGopState* gop_state;
+
+  /* one GstPreRecGopInfo per queued GOP, oldest first (prerec-catalog) */
+  GArray* gop_catalog;
+
   guint current_gop_id;
   guint last_gop_id;
+  guint min_gops; /* pruning floor, the GOP being recorded always stays */
+  guint max_gops; /* 0 = no GOP-count cap */
+  GstPreRecRetentionPolicy retention_policy;
   guint gop_size;
   guint num_gops;
 
@@ -139,6 +219,134 @@ typedef struct _GstPreRecordLoop {
 
   /* stats (incremented under lock; read-only snapshot via helper) */
   GstPreRecStats stats;
+
+  /* clip boundary events (prerecord-clip-start / prerecord-clip-end) */
+  gboolean clip_events;
+  guint clip_id;            /* id of the most recently started clip */
+  gboolean clip_open;       /* clip-start sent, clip-end not yet sent */
+  gboolean clip_start_pending; /* trigger accepted, waiting for first buffer */
+  gboolean clip_end_pending;   /* re-armed, clip-end goes out on the streaming thread */
+  guint64 clip_drain_bytes;    /* ring payload at the trigger, announced in clip-start */
+
+  /* keep the ring across pad deactivation; discarded on NULL/prerecord-discard */
+  gboolean preserve_on_reconfigure;
+
+  /* ring hand-over between instances (process-wide registry keyed by ring_id) */
+  gchar* ring_id;
+  guint ring_park_timeout;         /* ms */
+  GstCaps* caps;                   /* current sink caps, compared on adoption */
+  GstClockTimeDiff adopt_offset;   /* sink time shift while src drains adopted data */
+  gboolean adopt_rebase_pending;   /* compute adopt_offset on next sink buffer */
+  gboolean adopt_epoch_pending;    /* mark next enqueued item as epoch_start */
+
+  /* drained clip rebasing (drain-rebase / drain-base-time) */
+  gboolean drain_rebase;
+  GstClockTime drain_base_time;
+  gint64 rebase_offset;     /* running-time shift applied to outgoing SEGMENTs */
+  gboolean rebase_pending;  /* trigger accepted, offset computed at first buffer */
+  gboolean rebase_active;   /* rebase_offset applies until re-arm */
+
+  /* measured by each drain, used to answer BUFFERING and LATENCY queries */
+  guint64 drain_bytes_per_sec; /* throughput of the last drain, 0 until measured */
+  GstClockTime drain_duration; /* wall time the last drain took */
+  GstClockTime trigger_received; /* monotonic arrival of the trigger/EOS being drained */
+
+  /* QoS thinning of the drain (drain-qos). QOS events arrive on the src pad
+   * while the drain pushes with the ring lock held, so they use qos_lock. */
+  gboolean drain_qos;
+  GMutex qos_lock;
+  gboolean qos_draining;       /* a drain-qos drain is running, QOS is ours */
+  gdouble qos_proportion;
+  GstClockTimeDiff qos_jitter;
+  GstClockTime qos_timestamp;  /* NONE until downstream reported this drain */
+
+  /* latency histograms (ns), recorded under the ring lock, reported and
+   * optionally reset by prerec-stats */
+  GstPreRecHist hist_enqueue;   /* enqueue of one buffer */
+  GstPreRecHist hist_prune;     /* one GOP pruned */
+  GstPreRecHist hist_drain_push; /* one item pushed by a drain */
+  GstPreRecHist hist_residency; /* buffer enqueue to push or drop */
+
+  /* last ring decisions in binary form, written lock-free, formatted only by
+   * dump-flight-recorder and on element errors */
+  GstPreRecFlight flight;
+
+  /* element messages (post-messages): queued under the lock, posted with a
+   * stats snapshot by gst_prerec_post_messages() once it is released */
+  gboolean post_messages;
+  gchar* fill_thresholds;      /* as set, comma-separated percent of max-time */
+  GArray* fill_levels;         /* guint percent, ascending, at most 64 */
+  guint64 fill_posted;         /* bit i: fill_levels[i] posted since the last drain */
+  guint message_interval;      /* ms between two prerec-prune messages */
+  GstClockTime prune_posted_at; /* monotonic, NONE before the first one */
+  guint prune_pending_gops;    /* pruned since the last prerec-prune */
+  GPtrArray* messages;         /* GstStructure* waiting to be posted */
+  gint messages_pending;       /* atomic, messages is not empty */
+
+  /* shared-memory stats page (stats-page): mapped on NULL→READY, updated
+   * under the lock by gst_prerec_locked_publish_stats() */
+  gboolean stats_page;
+  GstPreRecStatsShm* stats_shm;
+
+  /* optional ungated "live" request pad, fed by reference from the sink pad
+   * and pushed by its own task; guarded by live_lock, not lock */
+  GMutex live_lock;
+  GCond live_cond;
+  GstPad* live_pad;
+  GstVecDeque* live_queue;  /* GstMiniObject* (buffers and serialized events) */
+  guint live_level;         /* buffers in live_queue */
+  guint live_events;        /* events in live_queue, capped at LIVE_MAX_EVENTS */
+  guint live_max_buffers;
+  GstPreRecLiveLeaky live_leaky;
+  gboolean live_flushing;
+  gboolean live_paused;     /* branch returned EOS or a fatal flow; waits for RECONFIGURE */
+
+  /* disk spill tier: GOPs older than spill_ram_time move into an mmap arena,
+   * copied by spill_thread; spill_cond pairs with lock */
+  gchar* spill_location;
+  GstClockTime spill_ram_time;
+  guint64 spill_max_bytes;
+  GstPreRecSpill* spill;
+  GThread* spill_thread;
+  GCond spill_cond;
+  gboolean spill_stop;
+  GstClockTime spill_newest_ts;  /* DTS/PTS of the newest enqueued buffer */
+  guint64 spill_queued_bytes;    /* payload of spilled buffers still in the ring */
+
+  /* crash-persistent GOP journal: every closed GOP is written to
+   * journal_location by journal_thread and removed once it leaves the ring */
+  gchar* journal_location;
+  gchar* journal_dir;            /* location the running journal writes to */
+  GThread* journal_thread;
+  GAsyncQueue* journal_jobs;
+  GArray* journal_entries;       /* journaled GOPs still queued, oldest first */
+  guint journal_pending;         /* GOP writes queued, capped at JOURNAL_MAX_PENDING */
+  guint64 journal_seq;           /* sequence number of the next GOP file */
+  gboolean journal_recover_pending; /* replay the journal on the next CAPS */
+  GPtrArray* journal_loaded;     /* GstPreRecJournalGop* read by journal_thread for the replay */
+  gboolean journal_loaded_done;  /* journal_loaded is final; signalled on journal_cond */
+  GCond journal_cond;            /* pairs with lock */
+
+  /* memfd hand-off: buffering payloads live in a sealed memfd arena,
+   * allocated there by upstream through handoff_allocator (or copied in at
+   * ingest); a trigger sends the fd and a frame index to handoff_socket. */
+  gchar* handoff_socket;
+  guint64 handoff_max_bytes;
+  GstPreRecSpill* handoff;
+  GstAllocator* handoff_allocator;
+
+  /* slab allocator proposed in ALLOCATION queries; created on NULL→READY */
+  gboolean slab_enabled;
+  guint64 slab_max_bytes;
+  gboolean slab_hugepages;
+  gboolean slab_mlock;
+  GstAllocator* slab;
+
+  /* metas removed from buffers entering the ring; quarks of the names
+   * parsed from strip_meta_apis, NULL when stripping is off */
+  gchar* strip_meta_apis;
+  GArray* strip_meta_quarks;
+  GstPreRecMetaStripMode strip_meta_mode;
 } GstPreRecordLoop;
 
 G_END_DECLS
@@ -0,0 +1,49 @@
+/*
+ * GStreamer pre-record loop: USDT static probes
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#ifndef __GST_PRERECPROBES_H__
+#define __GST_PRERECPROBES_H__
+
+/* Static tracepoints on the data path, provider "prerecordloop". Each probe
+ * compiles to a single nop plus an ELF note; tools such as bpftrace patch it
+ * only while they are attached, so the probes stay in release builds. Build
+ * with -DPREREC_ENABLE_USDT=OFF (or without <sys/sdt.h>) to compile them out.
+ *
+ * Arguments are integers or pointers already at hand at the probe site. The
+ * first one is always the element, so scripts can tell instances apart:
+ *
+ *   chain        (loop, pts, duration, keyframe, mode)
+ *   enqueue      (loop, gop_id, pts, size, queued_buffers, queued_bytes)
+ *   prune        (loop, queued_gops, level_time, queued_bytes, elapsed_ns)
+ *   dequeue      (loop, gop_id, pts, size, residency_ns)
+ *   drain_start  (loop, reason, queued_buffers, queued_bytes, level_time)
+ *   drain_done   (loop, reason, buffers, bytes, elapsed_ns)
+ *   flush        (loop, full, queued_buffers, queued_bytes)
+ *   arm          (loop, rearm_count)
+ *   eos          (loop, drain, queued_buffers, queued_bytes)
+ *
+ * Times are nanoseconds, GST_CLOCK_TIME_NONE when unknown; reason is a C
+ * string ("trigger-flush", "eos-flush").
+ */
+#ifndef PREREC_ENABLE_USDT
+#define PREREC_ENABLE_USDT 0
+#endif
+
+#if PREREC_ENABLE_USDT
+#include <sys/sdt.h>
+
+#define PREREC_PROBE2(name, a, b) DTRACE_PROBE2(prerecordloop, name, a, b)
+#define PREREC_PROBE4(name, a, b, c, d) DTRACE_PROBE4(prerecordloop, name, a, b, c, d)
+#define PREREC_PROBE5(name, a, b, c, d, e) DTRACE_PROBE5(prerecordloop, name, a, b, c, d, e)
+#define PREREC_PROBE6(name, a, b, c, d, e, f) DTRACE_PROBE6(prerecordloop, name, a, b, c, d, e, f)
+#else
+#define PREREC_PROBE2(name, a, b) G_STMT_START {} G_STMT_END
+#define PREREC_PROBE4(name, a, b, c, d) G_STMT_START {} G_STMT_END
+#define PREREC_PROBE5(name, a, b, c, d, e) G_STMT_START {} G_STMT_END
+#define PREREC_PROBE6(name, a, b, c, d, e, f) G_STMT_START {} G_STMT_END
+#endif
+
+#endif /* __GST_PRERECPROBES_H__ */
@@ -0,0 +1,44 @@
+/*
+ * GStreamer pre-record loop: slab allocator for encoded frames
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#ifndef __GST_PRERECSLAB_H__
+#define __GST_PRERECSLAB_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Slab allocator proposed upstream in the ALLOCATION query
+ *
+ * Frames held by the ring live for the whole look-back window, so heap
+ * allocations from encoders and parsers fragment the heap and fault pages in
+ * and out as the window slides. This allocator carves blocks out of large
+ * anonymous chunks (optionally hugepage backed and mlock()ed) into size
+ * classes a quarter power of two apart, and keeps freed blocks on per-class
+ * free lists: once the window is full, frames reuse the same warm pages.
+ *
+ * Chunks are never returned before the allocator is finalized, which only
+ * happens once every memory from it is gone (each memory holds a ref).
+ * Requests the slab cannot serve (over 1 MiB, alignment above 255, or
+ * max_bytes reached) fall back to the system memory allocator and are
+ * counted in fallbacks.
+ */
+#define GST_PREREC_SLAB_MEMORY_TYPE "PreRecSlab"
+
+#define GST_TYPE_PREREC_SLAB_ALLOCATOR (gst_prerec_slab_allocator_get_type())
+G_DECLARE_FINAL_TYPE(GstPreRecSlabAllocator, gst_prerec_slab_allocator, GST, PREREC_SLAB_ALLOCATOR, GstAllocator)
+
+/* max_bytes caps the chunks reserved; hugepages tries MAP_HUGETLB, then
+ * transparent hugepages; lock_pages mlock()s every chunk (Linux) */
+GstAllocator* gst_prerec_slab_allocator_new(guint64 max_bytes, gboolean hugepages, gboolean lock_pages);
+
+/* Bytes reserved in chunks, bytes handed out in blocks, fallback count */
+void gst_prerec_slab_allocator_get_stats(GstAllocator* allocator, guint64* reserved, guint64* used,
+                                         guint* fallbacks);
+
+G_END_DECLS
+
+#endif /* __GST_PRERECSLAB_H__ */
@@ -0,0 +1,66 @@
+/*
+ * GStreamer pre-record loop: disk spill tier
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#ifndef __GST_PRERECSPILL_H__
+#define __GST_PRERECSPILL_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Memory-mapped spill arena
+ *
+ * A fixed-size file (unlinked right after creation, so it never outlives the
+ * process) mapped MAP_SHARED and carved into blocks in FIFO order, matching
+ * how the ring ages out GOPs. Spilled buffers wrap their block as read-only
+ * GstMemory; a block is returned when the last memory ref goes away, which
+ * may be downstream after a drain. Blocks may be released out of order; space
+ * is reclaimed once every older block is released too.
+ *
+ * The arena is reference counted: every outstanding block holds a ref, so it
+ * stays mapped until the last spilled buffer is gone.
+ */
+typedef struct _GstPreRecSpill GstPreRecSpill;
+
+GstPreRecSpill* gst_prerec_spill_new(const gchar* location, guint64 max_bytes, GError** error);
+/* Same arena over a sealed memfd (RAM, shareable with other processes by fd) */
+GstPreRecSpill* gst_prerec_spill_new_memfd(const gchar* name, guint64 max_bytes, GError** error);
+GstPreRecSpill* gst_prerec_spill_ref(GstPreRecSpill* spill);
+void gst_prerec_spill_unref(GstPreRecSpill* spill);
+
+/* Copies buf's payload into the arena and returns a new buffer with the same
+ * flags, timestamps and metas backed by the mapping; NULL if the arena is full. */
+GstBuffer* gst_prerec_spill_store(GstPreRecSpill* spill, GstBuffer* buf);
+
+/* Bytes currently occupied in the arena (released blocks included until
+ * they can be reclaimed) */
+guint64 gst_prerec_spill_get_used(GstPreRecSpill* spill);
+
+/* Asks the kernel to read a spilled buffer's pages ahead of the push */
+void gst_prerec_spill_prefetch(GstBuffer* buf);
+
+/* Backing descriptor and size, for handing the arena to another process */
+gint gst_prerec_spill_get_fd(GstPreRecSpill* spill);
+gsize gst_prerec_spill_get_capacity(GstPreRecSpill* spill);
+
+/* TRUE with the byte offset of buf's payload if it lives in this arena */
+gboolean gst_prerec_spill_locate(GstPreRecSpill* spill, GstBuffer* buf, guint64* offset);
+
+/* Allocator over an arena, proposed upstream in the ALLOCATION query so
+ * producers write payloads straight into it (the memfd hand-off arena).
+ * Memories are writable and give their block back like a stored buffer does.
+ * Requests the arena cannot serve (full, or alignment above 63 bytes) come
+ * from system memory. Holds a ref on the arena. */
+#define GST_PREREC_ARENA_MEMORY_TYPE "PreRecArena"
+
+#define GST_TYPE_PREREC_ARENA_ALLOCATOR (gst_prerec_arena_allocator_get_type())
+G_DECLARE_FINAL_TYPE(GstPreRecArenaAllocator, gst_prerec_arena_allocator, GST, PREREC_ARENA_ALLOCATOR, GstAllocator)
+
+GstAllocator* gst_prerec_arena_allocator_new(GstPreRecSpill* spill);
+
+G_END_DECLS
+
+#endif /* __GST_PRERECSPILL_H__ */
@@ -0,0 +1,46 @@
+/*
+ * GStreamer pre-record loop: shared-memory stats page
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#ifndef __GST_PRERECSTATSPAGE_H__
+#define __GST_PRERECSTATSPAGE_H__
+
+#include <gst/gst.h>
+#include <gstprerecordloop/gstprerecstatsproto.h>
+
+G_BEGIN_DECLS
+
+/* Writer side of the page in gstprerecstatsproto.h. One writer at a time
+ * (the element publishes under its ring lock); readers in other processes
+ * never make it wait. */
+typedef struct {
+  GstPreRecStatsPage* page; /* shared mapping */
+  gchar* name;              /* shm object name, unlinked on free */
+} GstPreRecStatsShm;
+
+/* Creates and maps a new page for element_path */
+GstPreRecStatsShm* gst_prerec_stats_shm_new(const gchar* element_path, GError** error);
+
+/* Unlinks and unmaps the page; monitors still mapping it keep their copy */
+void gst_prerec_stats_shm_free(GstPreRecStatsShm* shm);
+
+/* Brackets an update of the fields after seq */
+static inline GstPreRecStatsPage* gst_prerec_stats_shm_begin(GstPreRecStatsShm* shm) {
+  GstPreRecStatsPage* page = shm->page;
+
+  __atomic_store_n(&page->seq, page->seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  return page;
+}
+
+static inline void gst_prerec_stats_shm_end(GstPreRecStatsShm* shm) {
+  GstPreRecStatsPage* page = shm->page;
+
+  __atomic_store_n(&page->seq, page->seq + 1, __ATOMIC_RELEASE);
+}
+
+G_END_DECLS
+
+#endif /* __GST_PRERECSTATSPAGE_H__ */
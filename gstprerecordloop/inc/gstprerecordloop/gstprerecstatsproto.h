@@ -0,0 +1,74 @@
+/*
+ * GStreamer pre-record loop: shared-memory stats page layout
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ *
+ * Plain C so monitors can include it without GLib. With stats-page=true
+ * every element publishes one page as the POSIX shared memory object
+ * GST_PREREC_STATS_SHM_PREFIX "<pid>-<n>" (/dev/shm/prerec-stats-<pid>-<n>
+ * on Linux), created on NULL→READY and unlinked on READY→NULL.
+ *
+ * The header up to seq is written once before the page becomes visible. The
+ * fields after seq are guarded by a seqlock: the element makes seq odd,
+ * updates them and makes seq even again, never blocking on readers. Readers
+ * copy the page and retry when seq was odd or changed meanwhile (see
+ * gst_prerec_stats_page_read()). All fields are host byte order.
+ */
+
+#ifndef __GST_PRERECSTATSPROTO_H__
+#define __GST_PRERECSTATSPROTO_H__
+
+#include <stdint.h>
+#include <string.h>
+
+#define GST_PREREC_STATS_MAGIC 0x31535250u /* "PRS1" */
+#define GST_PREREC_STATS_VERSION 1u
+#define GST_PREREC_STATS_SHM_PREFIX "/prerec-stats-"
+
+#define GST_PREREC_STATS_MODE_PASS_THROUGH 0u
+#define GST_PREREC_STATS_MODE_BUFFERING 1u
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size; /* sizeof(GstPreRecStatsPage) of the writer */
+  uint32_t pid;
+  char element[128]; /* object path of the element, NUL terminated */
+
+  uint32_t seq; /* odd while the fields below are being updated */
+  uint32_t mode;
+  uint32_t gops;
+  uint32_t buffers;
+  uint64_t bytes;
+  uint64_t time;     /* queued running time, ns */
+  uint64_t max_time; /* ns */
+  uint32_t drops_gops;
+  uint32_t drops_buffers;
+  uint32_t drops_events;
+  uint32_t flush_count;
+  uint32_t rearm_count;
+  uint32_t reserved;
+  uint64_t drain_duration;      /* last drain, ns; 0 before the first one */
+  uint64_t drain_bytes_per_sec; /* rate of the last drain */
+  uint64_t updated;             /* CLOCK_MONOTONIC ns of the last update */
+} GstPreRecStatsPage;
+
+/* Consistent copy of page into out: 0 on success, -1 while the writer kept
+ * it busy for all attempts (a writer that died mid-update leaves seq odd) */
+static inline int gst_prerec_stats_page_read(const GstPreRecStatsPage* page, GstPreRecStatsPage* out) {
+  for (int attempt = 0; attempt < 1000; ++attempt) {
+    uint32_t seq = __atomic_load_n(&page->seq, __ATOMIC_ACQUIRE);
+
+    if (seq & 1)
+      continue;
+    memcpy(out, page, sizeof(*out));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&page->seq, __ATOMIC_RELAXED) == seq) {
+      out->seq = seq;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+#endif /* __GST_PRERECSTATSPROTO_H__ */
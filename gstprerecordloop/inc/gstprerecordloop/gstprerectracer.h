@@ -0,0 +1,34 @@
+/*
+ * GStreamer pre-record loop: "prerec" tracer
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#ifndef __GST_PRERECTRACER_H__
+#define __GST_PRERECTRACER_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_PREREC_TRACER (gst_prerec_tracer_get_type())
+G_DECLARE_FINAL_TYPE(GstPreRecTracer, gst_prerec_tracer, GST, PREREC_TRACER, GstTracer)
+
+/* Number of live "prerec" tracer instances. pre_record_loop only gathers
+ * and logs its tracer records while this is non-zero, so an unused tracer
+ * costs one atomic read per call site. */
+extern gint gst_prerec_tracer_active;
+
+#define GST_PREREC_TRACER_ACTIVE() G_UNLIKELY(g_atomic_int_get(&gst_prerec_tracer_active) > 0)
+
+void gst_prerec_tracer_log_level(GstElement* element, guint gops, guint buffers, guint64 bytes, GstClockTime time);
+void gst_prerec_tracer_log_prune(GstElement* element, guint gops, GstClockTime time, GstClockTime duration);
+void gst_prerec_tracer_log_drain(GstElement* element, const gchar* reason, guint buffers, guint64 bytes,
+                                 GstClockTime duration);
+void gst_prerec_tracer_log_trigger(GstElement* element, const gchar* reason, GstClockTime latency);
+
+gboolean gst_prerec_tracer_register(GstPlugin* plugin);
+
+G_END_DECLS
+
+#endif /* __GST_PRERECTRACER_H__ */
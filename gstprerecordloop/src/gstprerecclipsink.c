@@ -0,0 +1,577 @@
+/*
+ * GStreamer pre-record loop: direct-I/O clip sink
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+/**
+ * SECTION:element-prerec_clipsink
+ *
+ * File sink for the output of pre_record_loop, built for drain bursts: when
+ * many loops drain at once, a plain filesink pushes every clip through the
+ * page cache and the writeback storm stalls the live pass-through of every
+ * other stream. prerec_clipsink instead
+ *
+ * - opens the file with O_DIRECT (F_NOCACHE on macOS) and writes from an
+ *   aligned bounce buffer of #GstPreRecClipSink:buffer-size, so clip data
+ *   never sits in the page cache; only the unaligned tail of a clip goes
+ *   through a regular write when the clip is closed;
+ * - preallocates the clip with fallocate() from the `drain-bytes` field of
+ *   `prerecord-clip-start` (pre_record_loop clip-events=true);
+ * - writes buffer lists in one pass;
+ * - can fdatasync() every clip when it ends (#GstPreRecClipSink:sync-per-clip).
+ *
+ * With a `%u`-style #GstPreRecClipSink:location each clip goes to its own
+ * file; data arriving between a `prerecord-clip-end` and the next
+ * `prerecord-clip-start` goes to a new file with a `.1`, `.2`, ... suffix,
+ * so a finished clip is never reopened. Every finished clip posts a
+ * `prerec-clip-written` element message
+ * (location, clip-id, bytes, elapsed). File systems without O_DIRECT support
+ * (tmpfs) fall back to buffered writes with a warning.
+ *
+ * |[
+ * gst-launch-1.0 ... ! pre_record_loop clip-events=true ! \
+ *     prerec_clipsink location=/mnt/nvme/cam1-%05u.h264 sync-per-clip=true
+ * ]|
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE /* O_DIRECT, fallocate */
+#endif
+
+#include <gstprerecordloop/gstprerecclipsink.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+GST_DEBUG_CATEGORY_STATIC(prerec_clipsink_debug);
+#define GST_CAT_DEFAULT prerec_clipsink_debug
+
+#define CLIPSINK_ALIGN 4096 /* logical block size O_DIRECT needs on common devices */
+
+enum { PROP_0, PROP_LOCATION, PROP_DIRECT_IO, PROP_BUFFER_SIZE, PROP_PREALLOCATE, PROP_SYNC_PER_CLIP };
+
+#define DEFAULT_DIRECT_IO TRUE
+#define DEFAULT_BUFFER_SIZE (4 * 1024 * 1024)
+#define DEFAULT_PREALLOCATE TRUE
+#define DEFAULT_SYNC_PER_CLIP FALSE
+
+static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
+                                                                   GST_STATIC_CAPS_ANY);
+
+G_DEFINE_TYPE(GstPreRecClipSink, gst_prerec_clip_sink, GST_TYPE_ELEMENT);
+GST_ELEMENT_REGISTER_DEFINE(prerec_clipsink, "prerec_clipsink", GST_RANK_NONE, GST_TYPE_PREREC_CLIP_SINK);
+
+static gboolean clipsink_set_direct(GstPreRecClipSink* sink, gboolean enable) {
+#ifdef O_DIRECT
+  gint flags = fcntl(sink->fd, F_GETFL);
+  return flags >= 0 && fcntl(sink->fd, F_SETFL, enable ? flags | O_DIRECT : flags & ~O_DIRECT) == 0;
+#elif defined(F_NOCACHE)
+  return fcntl(sink->fd, F_NOCACHE, enable ? 1 : 0) == 0;
+#else
+  return !enable;
+#endif
+}
+
+static void clipsink_preallocate(GstPreRecClipSink* sink, guint64 bytes) {
+#ifdef __linux__
+  guint64 len = GST_ROUND_UP_N(bytes, CLIPSINK_ALIGN);
+  /* KEEP_SIZE: the file only grows as data lands; the excess is trimmed on close */
+  if (len > 0 && fallocate(sink->fd, FALLOC_FL_KEEP_SIZE, (off_t) sink->offset, (off_t) len) != 0)
+    GST_DEBUG_OBJECT(sink, "fallocate of %" G_GUINT64_FORMAT " bytes failed: %s", len, g_strerror(errno));
+#else
+  (void) sink;
+  (void) bytes;
+#endif
+}
+
+/* Opens the file for clip_id. With exclusive, an existing file is never
+ * reused: the name gets a .1, .2, ... suffix instead. Data that arrives
+ * with no clip-start (e.g. after a clip-end) must not truncate the clip
+ * that was just finished. */
+static gboolean clipsink_open(GstPreRecClipSink* sink, guint clip_id, guint64 prealloc, gboolean exclusive) {
+  gchar* location;
+  gboolean direct, preallocate;
+  guint size;
+  gint flags = O_WRONLY | O_CREAT | O_CLOEXEC | (exclusive ? O_EXCL : O_TRUNC);
+  gchar* base;
+
+  GST_OBJECT_LOCK(sink);
+  location = g_strdup(sink->location);
+  direct = sink->direct_io;
+  size = sink->buffer_size;
+  preallocate = sink->preallocate;
+  GST_OBJECT_UNLOCK(sink);
+
+  if (!location) {
+    GST_ELEMENT_ERROR(sink, RESOURCE, NOT_FOUND, ("No file name specified for writing."), (NULL));
+    return FALSE;
+  }
+  if (strchr(location, '%')) {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+    base = g_strdup_printf(location, clip_id);
+#pragma GCC diagnostic pop
+  } else {
+    base = g_strdup(location);
+  }
+  g_free(location);
+
+  for (guint n = 0;; ++n) {
+    g_free(sink->filename);
+    sink->filename = n == 0 ? g_strdup(base) : g_strdup_printf("%s.%u", base, n);
+#ifdef O_DIRECT
+    sink->fd = open(sink->filename, flags | (direct ? O_DIRECT : 0), 0644);
+    if (sink->fd < 0 && direct && errno == EINVAL) {
+      GST_ELEMENT_WARNING(sink, RESOURCE, SETTINGS, ("Direct I/O not supported for %s, using buffered writes",
+                                                     sink->filename), (NULL));
+      direct = FALSE;
+      sink->fd = open(sink->filename, flags, 0644);
+    }
+#else
+    sink->fd = open(sink->filename, flags, 0644);
+    if (sink->fd >= 0 && direct)
+      direct = clipsink_set_direct(sink, TRUE);
+#endif
+    if (sink->fd >= 0 || !exclusive || errno != EEXIST || n == G_MAXUINT)
+      break;
+  }
+  g_free(base);
+  if (sink->fd < 0) {
+    GST_ELEMENT_ERROR(sink, RESOURCE, OPEN_WRITE, ("Could not open file \"%s\" for writing.", sink->filename),
+                      GST_ERROR_SYSTEM);
+    return FALSE;
+  }
+  sink->direct_active = direct;
+
+  if (!sink->bounce || size != sink->bounce_size) {
+    free(sink->bounce);
+    sink->bounce = NULL;
+    sink->bounce_size = size;
+    if (posix_memalign((void**) &sink->bounce, CLIPSINK_ALIGN, size) != 0) {
+      GST_ELEMENT_ERROR(sink, RESOURCE, NO_SPACE_LEFT, ("Cannot allocate the bounce buffer"), (NULL));
+      close(sink->fd);
+      sink->fd = -1;
+      return FALSE;
+    }
+  }
+  sink->fill = 0;
+  sink->offset = 0;
+  if (preallocate)
+    clipsink_preallocate(sink, prealloc);
+  GST_INFO_OBJECT(sink, "opened %s (direct=%d, prealloc=%" G_GUINT64_FORMAT ")", sink->filename, direct, prealloc);
+  return TRUE;
+}
+
+static gboolean clipsink_write_all(GstPreRecClipSink* sink, const guint8* data, gsize len) {
+  while (len > 0) {
+    ssize_t n = write(sink->fd, data, len);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0) {
+      GST_ELEMENT_ERROR(sink, RESOURCE, WRITE, ("Error while writing to file \"%s\".", sink->filename),
+                        GST_ERROR_SYSTEM);
+      return FALSE;
+    }
+    data += n;
+    len -= n;
+    sink->offset += n;
+  }
+  return TRUE;
+}
+
+/* Appends to the file; only whole aligned blocks reach the disk here */
+static gboolean clipsink_append(GstPreRecClipSink* sink, const guint8* data, gsize len) {
+  gsize size = sink->bounce_size;
+
+  sink->clip_bytes += len;
+  while (len > 0) {
+    gsize n;
+
+    if (sink->fill == 0 && len >= size && ((guintptr) data & (CLIPSINK_ALIGN - 1)) == 0) {
+      /* aligned source, empty bounce: write straight from the buffer */
+      n = len & ~(gsize) (CLIPSINK_ALIGN - 1);
+      if (!clipsink_write_all(sink, data, n))
+        return FALSE;
+      data += n;
+      len -= n;
+      continue;
+    }
+    n = MIN(len, size - sink->fill);
+    memcpy(sink->bounce + sink->fill, data, n);
+    sink->fill += n;
+    data += n;
+    len -= n;
+    if (sink->fill == size) {
+      if (!clipsink_write_all(sink, sink->bounce, size))
+        return FALSE;
+      sink->fill = 0;
+    }
+  }
+  return TRUE;
+}
+
+/* Puts the unaligned tail on disk without consuming it: it stays in the
+ * bounce buffer and is rewritten as part of the next full block, so the
+ * file offset of direct writes stays aligned. */
+static gboolean clipsink_write_tail(GstPreRecClipSink* sink) {
+  gsize done = 0;
+
+  if (sink->fill == 0)
+    return TRUE;
+  if (sink->direct_active)
+    clipsink_set_direct(sink, FALSE);
+  while (done < sink->fill) {
+    ssize_t n = pwrite(sink->fd, sink->bounce + done, sink->fill - done, (off_t) (sink->offset + done));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0) {
+      GST_ELEMENT_ERROR(sink, RESOURCE, WRITE, ("Error while writing to file \"%s\".", sink->filename),
+                        GST_ERROR_SYSTEM);
+      return FALSE;
+    }
+    done += n;
+  }
+  if (sink->direct_active)
+    clipsink_set_direct(sink, TRUE);
+  return TRUE;
+}
+
+static gboolean clipsink_finish_clip(GstPreRecClipSink* sink) {
+  gboolean sync;
+  GstStructure* s;
+
+  if (sink->fd < 0)
+    return TRUE;
+  GST_OBJECT_LOCK(sink);
+  sync = sink->sync_per_clip;
+  GST_OBJECT_UNLOCK(sink);
+
+  if (!clipsink_write_tail(sink))
+    return FALSE;
+  if (sync && fdatasync(sink->fd) != 0) {
+    GST_ELEMENT_ERROR(sink, RESOURCE, SYNC, ("Error while syncing file \"%s\".", sink->filename), GST_ERROR_SYSTEM);
+    return FALSE;
+  }
+  s = gst_structure_new("prerec-clip-written", "location", G_TYPE_STRING, sink->filename, "clip-id", G_TYPE_UINT,
+                        sink->clip_id, "bytes", G_TYPE_UINT64, sink->clip_bytes, "elapsed", G_TYPE_UINT64,
+                        (guint64) (g_get_monotonic_time() - sink->clip_start_us) * GST_USECOND, NULL);
+  gst_element_post_message(GST_ELEMENT(sink), gst_message_new_element(GST_OBJECT(sink), s));
+  sink->clip_bytes = 0;
+  sink->clip_start_us = g_get_monotonic_time();
+  return TRUE;
+}
+
+static void clipsink_close(GstPreRecClipSink* sink) {
+  if (sink->fd < 0)
+    return;
+  clipsink_write_tail(sink);
+  /* drops preallocated blocks past the data */
+  if (ftruncate(sink->fd, (off_t) (sink->offset + sink->fill)) != 0)
+    GST_DEBUG_OBJECT(sink, "ftruncate failed: %s", g_strerror(errno));
+  close(sink->fd);
+  sink->fd = -1;
+  sink->fill = 0;
+  sink->offset = 0;
+}
+
+static gboolean clipsink_per_clip_files(GstPreRecClipSink* sink) {
+  gboolean per_clip;
+  GST_OBJECT_LOCK(sink);
+  per_clip = sink->location && strchr(sink->location, '%') != NULL;
+  GST_OBJECT_UNLOCK(sink);
+  return per_clip;
+}
+
+static gboolean clipsink_clip_start(GstPreRecClipSink* sink, const GstStructure* s) {
+  guint clip_id = 0;
+  guint64 drain_bytes = 0;
+
+  gst_structure_get_uint(s, "clip-id", &clip_id);
+  gst_structure_get_uint64(s, "drain-bytes", &drain_bytes);
+  if (clipsink_per_clip_files(sink)) {
+    clipsink_close(sink);
+    if (!clipsink_open(sink, clip_id, drain_bytes, FALSE))
+      return FALSE;
+  } else if (sink->fd < 0) {
+    if (!clipsink_open(sink, clip_id, drain_bytes, FALSE))
+      return FALSE;
+  } else {
+    gboolean preallocate;
+    GST_OBJECT_LOCK(sink);
+    preallocate = sink->preallocate;
+    GST_OBJECT_UNLOCK(sink);
+    if (preallocate)
+      clipsink_preallocate(sink, drain_bytes + sink->fill);
+  }
+  sink->clip_id = clip_id;
+  sink->clip_bytes = 0;
+  sink->clip_start_us = g_get_monotonic_time();
+  return TRUE;
+}
+
+static GstFlowReturn clipsink_render(GstPreRecClipSink* sink, GstBuffer* buf) {
+  GstMapInfo map;
+  gboolean ok;
+
+  if (!gst_buffer_map(buf, &map, GST_MAP_READ)) {
+    GST_ELEMENT_ERROR(sink, STREAM, FAILED, ("Cannot map buffer"), (NULL));
+    return GST_FLOW_ERROR;
+  }
+  ok = clipsink_append(sink, map.data, map.size);
+  gst_buffer_unmap(buf, &map);
+  return ok ? GST_FLOW_OK : GST_FLOW_ERROR;
+}
+
+static GstFlowReturn gst_prerec_clip_sink_chain(GstPad* pad, GstObject* parent, GstBuffer* buf) {
+  GstPreRecClipSink* sink = GST_PREREC_CLIP_SINK(parent);
+  GstFlowReturn ret;
+
+  if (sink->fd < 0 && !clipsink_open(sink, sink->clip_id, 0, clipsink_per_clip_files(sink))) {
+    gst_buffer_unref(buf);
+    return GST_FLOW_ERROR;
+  }
+  ret = clipsink_render(sink, buf);
+  gst_buffer_unref(buf);
+  return ret;
+}
+
+/* Whole lists go through the bounce buffer in one pass */
+static GstFlowReturn gst_prerec_clip_sink_chain_list(GstPad* pad, GstObject* parent, GstBufferList* list) {
+  GstPreRecClipSink* sink = GST_PREREC_CLIP_SINK(parent);
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint len = gst_buffer_list_length(list);
+
+  if (sink->fd < 0 && !clipsink_open(sink, sink->clip_id, 0, clipsink_per_clip_files(sink))) {
+    gst_buffer_list_unref(list);
+    return GST_FLOW_ERROR;
+  }
+  for (guint i = 0; i < len && ret == GST_FLOW_OK; ++i)
+    ret = clipsink_render(sink, gst_buffer_list_get(list, i));
+  gst_buffer_list_unref(list);
+  return ret;
+}
+
+static gboolean gst_prerec_clip_sink_event(GstPad* pad, GstObject* parent, GstEvent* event) {
+  GstPreRecClipSink* sink = GST_PREREC_CLIP_SINK(parent);
+  gboolean ret = TRUE;
+
+  switch (GST_EVENT_TYPE(event)) {
+  case GST_EVENT_CUSTOM_DOWNSTREAM: {
+    const GstStructure* s = gst_event_get_structure(event);
+    if (s && gst_structure_has_name(s, "prerecord-clip-start")) {
+      ret = clipsink_clip_start(sink, s);
+    } else if (s && gst_structure_has_name(s, "prerecord-clip-end")) {
+      ret = clipsink_finish_clip(sink);
+      if (clipsink_per_clip_files(sink))
+        clipsink_close(sink);
+    }
+    break;
+  }
+  case GST_EVENT_EOS: {
+    GstMessage* msg;
+    if (sink->fd >= 0 && sink->clip_bytes > 0)
+      clipsink_finish_clip(sink);
+    clipsink_close(sink);
+    msg = gst_message_new_eos(GST_OBJECT(sink));
+    gst_message_set_seqnum(msg, gst_event_get_seqnum(event));
+    gst_element_post_message(GST_ELEMENT(sink), msg);
+    break;
+  }
+  default:
+    break;
+  }
+  gst_event_unref(event);
+  return ret;
+}
+
+static GstStateChangeReturn gst_prerec_clip_sink_change_state(GstElement* element, GstStateChange transition) {
+  GstPreRecClipSink* sink = GST_PREREC_CLIP_SINK(element);
+  GstStateChangeReturn ret;
+
+  ret = GST_ELEMENT_CLASS(gst_prerec_clip_sink_parent_class)->change_state(element, transition);
+
+  switch (transition) {
+  case GST_STATE_CHANGE_PAUSED_TO_READY:
+    /* streaming has stopped: the pad is deactivated */
+    clipsink_close(sink);
+    sink->clip_id = 0;
+    sink->clip_bytes = 0;
+    break;
+  case GST_STATE_CHANGE_READY_TO_NULL:
+    free(sink->bounce);
+    sink->bounce = NULL;
+    break;
+  default:
+    break;
+  }
+  return ret;
+}
+
+static void gst_prerec_clip_sink_set_property(GObject* object, guint prop_id, const GValue* value,
+                                              GParamSpec* pspec) {
+  GstPreRecClipSink* sink = GST_PREREC_CLIP_SINK(object);
+
+  GST_OBJECT_LOCK(sink);
+  switch (prop_id) {
+  case PROP_LOCATION:
+    g_free(sink->location);
+    sink->location = g_value_dup_string(value);
+    break;
+  case PROP_DIRECT_IO:
+    sink->direct_io = g_value_get_boolean(value);
+    break;
+  case PROP_BUFFER_SIZE:
+    sink->buffer_size = GST_ROUND_UP_N(g_value_get_uint(value), CLIPSINK_ALIGN);
+    break;
+  case PROP_PREALLOCATE:
+    sink->preallocate = g_value_get_boolean(value);
+    break;
+  case PROP_SYNC_PER_CLIP:
+    sink->sync_per_clip = g_value_get_boolean(value);
+    break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+    break;
+  }
+  GST_OBJECT_UNLOCK(sink);
+}
+
+static void gst_prerec_clip_sink_get_property(GObject* object, guint prop_id, GValue* value, GParamSpec* pspec) {
+  GstPreRecClipSink* sink = GST_PREREC_CLIP_SINK(object);
+
+  GST_OBJECT_LOCK(sink);
+  switch (prop_id) {
+  case PROP_LOCATION:
+    g_value_set_string(value, sink->location);
+    break;
+  case PROP_DIRECT_IO:
+    g_value_set_boolean(value, sink->direct_io);
+    break;
+  case PROP_BUFFER_SIZE:
+    g_value_set_uint(value, sink->buffer_size);
+    break;
+  case PROP_PREALLOCATE:
+    g_value_set_boolean(value, sink->preallocate);
+    break;
+  case PROP_SYNC_PER_CLIP:
+    g_value_set_boolean(value, sink->sync_per_clip);
+    break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+    break;
+  }
+  GST_OBJECT_UNLOCK(sink);
+}
+
+static void gst_prerec_clip_sink_finalize(GObject* object) {
+  GstPreRecClipSink* sink = GST_PREREC_CLIP_SINK(object);
+
+  if (sink->fd >= 0)
+    close(sink->fd);
+  free(sink->bounce);
+  g_free(sink->filename);
+  g_free(sink->location);
+  G_OBJECT_CLASS(gst_prerec_clip_sink_parent_class)->finalize(object);
+}
+
+static void gst_prerec_clip_sink_class_init(GstPreRecClipSinkClass* klass) {
+  GObjectClass* gobject_class = G_OBJECT_CLASS(klass);
+  GstElementClass* gstelement_class = GST_ELEMENT_CLASS(klass);
+
+  GST_DEBUG_CATEGORY_INIT(prerec_clipsink_debug, "prerec_clipsink", 0, "pre record loop direct-I/O clip sink");
+
+  gobject_class->set_property = gst_prerec_clip_sink_set_property;
+  gobject_class->get_property = gst_prerec_clip_sink_get_property;
+  gobject_class->finalize = gst_prerec_clip_sink_finalize;
+
+  /**
+   * GstPreRecClipSink:location:
+   *
+   * File to write. A printf pattern with one integer conversion (e.g.
+   * `clip-%05u.h264`) writes every clip to its own file, named by the
+   * clip-id of `prerecord-clip-start`.
+   *
+   * Default: %NULL
+   */
+  g_object_class_install_property(gobject_class, PROP_LOCATION,
+                                  g_param_spec_string("location", "File Location",
+                                                      "File to write, or a pattern taking the clip id", NULL,
+                                                      G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecClipSink:direct-io:
+   *
+   * Bypass the page cache (O_DIRECT, F_NOCACHE on macOS). Falls back to
+   * buffered writes where the file system refuses it.
+   *
+   * Default: %TRUE
+   */
+  g_object_class_install_property(gobject_class, PROP_DIRECT_IO,
+                                  g_param_spec_boolean("direct-io", "Direct I/O", "Bypass the page cache",
+                                                       DEFAULT_DIRECT_IO, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecClipSink:buffer-size:
+   *
+   * Size of the aligned bounce buffer and of each direct write, rounded up
+   * to 4096 bytes. Applied when the next file is opened.
+   *
+   * Default: 4 MiB
+   */
+  g_object_class_install_property(gobject_class, PROP_BUFFER_SIZE,
+                                  g_param_spec_uint("buffer-size", "Buffer Size",
+                                                    "Bytes per direct write (multiple of 4096)", CLIPSINK_ALIGN,
+                                                    G_MAXINT / 2, DEFAULT_BUFFER_SIZE, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecClipSink:preallocate:
+   *
+   * Reserve disk space for each clip with fallocate() from the
+   * `drain-bytes` field of `prerecord-clip-start` (Linux).
+   *
+   * Default: %TRUE
+   */
+  g_object_class_install_property(gobject_class, PROP_PREALLOCATE,
+                                  g_param_spec_boolean("preallocate", "Preallocate",
+                                                       "Preallocate each clip from the drained byte count",
+                                                       DEFAULT_PREALLOCATE, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecClipSink:sync-per-clip:
+   *
+   * fdatasync() the file when a clip ends (`prerecord-clip-end` or EOS),
+   * before `prerec-clip-written` is posted.
+   *
+   * Default: %FALSE
+   */
+  g_object_class_install_property(gobject_class, PROP_SYNC_PER_CLIP,
+                                  g_param_spec_boolean("sync-per-clip", "Sync Per Clip",
+                                                       "fdatasync() the file at the end of every clip",
+                                                       DEFAULT_SYNC_PER_CLIP, G_PARAM_READWRITE));
+
+  gst_element_class_set_static_metadata(gstelement_class, "PreRecord Clip Sink", "Sink/File",
+                                        "Writes pre_record_loop clips with direct I/O and preallocation",
+                                        "Kartik Aiyer <kartik.aiyer@gmail.com>");
+  gst_element_class_add_static_pad_template(gstelement_class, &sink_factory);
+  gstelement_class->change_state = gst_prerec_clip_sink_change_state;
+}
+
+static void gst_prerec_clip_sink_init(GstPreRecClipSink* sink) {
+  sink->sinkpad = gst_pad_new_from_static_template(&sink_factory, "sink");
+  gst_pad_set_chain_function(sink->sinkpad, gst_prerec_clip_sink_chain);
+  gst_pad_set_chain_list_function(sink->sinkpad, gst_prerec_clip_sink_chain_list);
+  gst_pad_set_event_function(sink->sinkpad, gst_prerec_clip_sink_event);
+  gst_element_add_pad(GST_ELEMENT(sink), sink->sinkpad);
+  /* no GstBaseSink: flag it so bins aggregate our EOS message */
+  GST_OBJECT_FLAG_SET(sink, GST_ELEMENT_FLAG_SINK);
+
+  sink->direct_io = DEFAULT_DIRECT_IO;
+  sink->buffer_size = DEFAULT_BUFFER_SIZE;
+  sink->preallocate = DEFAULT_PREALLOCATE;
+  sink->sync_per_clip = DEFAULT_SYNC_PER_CLIP;
+  sink->fd = -1;
+}
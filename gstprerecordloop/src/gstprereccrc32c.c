@@ -0,0 +1,88 @@
+/*
+ * GStreamer pre-record loop: CRC32C (Castagnoli)
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#include <gstprerecordloop/gstprereccrc32c.h>
+
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PREREC_CRC32C_X86 1
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define PREREC_CRC32C_ARM 1
+#include <arm_acle.h>
+#endif
+
+#define CRC32C_POLY 0x82F63B78u /* reflected Castagnoli polynomial */
+
+static guint32 crc32c_table[256];
+
+static void crc32c_init_table(void) {
+  for (guint32 i = 0; i < 256; ++i) {
+    guint32 c = i;
+    for (int k = 0; k < 8; ++k)
+      c = (c & 1) ? (c >> 1) ^ CRC32C_POLY : c >> 1;
+    crc32c_table[i] = c;
+  }
+}
+
+static guint32 crc32c_sw(guint32 crc, const guint8* data, gsize len) {
+  while (len--)
+    crc = crc32c_table[(crc ^ *data++) & 0xff] ^ (crc >> 8);
+  return crc;
+}
+
+#if PREREC_CRC32C_X86
+__attribute__((target("sse4.2"))) static guint32 crc32c_hw(guint32 crc, const guint8* data, gsize len) {
+  guint64 c = crc;
+  while (len >= 8) {
+    guint64 v;
+    memcpy(&v, data, 8);
+    c = _mm_crc32_u64(c, v);
+    data += 8;
+    len -= 8;
+  }
+  crc = (guint32) c;
+  while (len--)
+    crc = _mm_crc32_u8(crc, *data++);
+  return crc;
+}
+#elif PREREC_CRC32C_ARM
+static guint32 crc32c_hw(guint32 crc, const guint8* data, gsize len) {
+  while (len >= 8) {
+    guint64 v;
+    memcpy(&v, data, 8);
+    crc = __crc32cd(crc, v);
+    data += 8;
+    len -= 8;
+  }
+  while (len--)
+    crc = __crc32cb(crc, *data++);
+  return crc;
+}
+#endif
+
+typedef guint32 (*Crc32cFunc)(guint32 crc, const guint8* data, gsize len);
+
+static Crc32cFunc crc32c_select(void) {
+#if PREREC_CRC32C_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse4.2"))
+    return crc32c_hw;
+#elif PREREC_CRC32C_ARM
+  return crc32c_hw;
+#endif
+  crc32c_init_table();
+  return crc32c_sw;
+}
+
+guint32 gst_prerec_crc32c(guint32 crc, const guint8* data, gsize len) {
+  static gsize impl = 0;
+
+  if (g_once_init_enter(&impl))
+    g_once_init_leave(&impl, (gsize) crc32c_select());
+  return ~((Crc32cFunc) impl)(~crc, data, len);
+}
@@ -0,0 +1,559 @@
+/*
+ * GStreamer pre-record loop: window dump writer
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#include <gstprerecordloop/gstprerecdump.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+#define DUMP_TIMESCALE 90000
+
+static const guint8 start_code[4] = {0, 0, 0, 1};
+
+/* One writev() batch: iovecs point into mapped buffers and generated chunks,
+ * both released once the batch is on disk */
+typedef struct {
+  gint fd;
+  GArray* iov;       /* struct iovec */
+  GPtrArray* chunks; /* generated headers referenced by iov */
+  GPtrArray* mapped; /* GstBuffer* mapped for iov, parallel to maps */
+  GArray* maps;      /* GstMapInfo */
+  guint64 written;
+} DumpWriter;
+
+typedef struct {
+  gboolean h265;
+  gboolean length_prefixed; /* avc/avc3/hvc1/hev1 */
+  const gchar* sample_entry; /* fMP4 sample entry fourcc */
+  GstBuffer* codec_data;     /* borrowed from the caps */
+  gint width, height;
+} DumpStreamInfo;
+
+static void dump_add(DumpWriter* w, const void* data, gsize len) {
+  struct iovec v;
+
+  if (len == 0)
+    return;
+  v.iov_base = (void*) data;
+  v.iov_len = len;
+  g_array_append_val(w->iov, v);
+}
+
+static void dump_add_copy(DumpWriter* w, const void* data, gsize len) {
+  gpointer chunk = g_memdup2(data, len);
+  g_ptr_array_add(w->chunks, chunk);
+  dump_add(w, chunk, len);
+}
+
+static gboolean dump_map(DumpWriter* w, GstBuffer* buf, GstMapInfo* out, GError** error) {
+  if (!gst_buffer_map(buf, out, GST_MAP_READ)) {
+    g_set_error(error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ, "Cannot map buffer %p", buf);
+    return FALSE;
+  }
+  g_ptr_array_add(w->mapped, buf);
+  g_array_append_val(w->maps, *out);
+  return TRUE;
+}
+
+static void dump_release(DumpWriter* w) {
+  for (guint i = 0; i < w->mapped->len; ++i)
+    gst_buffer_unmap(g_ptr_array_index(w->mapped, i), &g_array_index(w->maps, GstMapInfo, i));
+  g_ptr_array_set_size(w->mapped, 0);
+  g_array_set_size(w->maps, 0);
+  g_ptr_array_set_size(w->chunks, 0);
+  g_array_set_size(w->iov, 0);
+}
+
+/* writev() the batch, continuing after partial writes */
+static gboolean dump_flush(DumpWriter* w, GError** error) {
+  struct iovec* iov = (struct iovec*) w->iov->data;
+  guint n_iov = w->iov->len;
+  guint64 total = 0;
+  gboolean ok = TRUE;
+
+  for (guint i = 0; i < n_iov; ++i)
+    total += iov[i].iov_len;
+  while (n_iov > 0) {
+    ssize_t n = writev(w->fd, iov, (int) MIN(n_iov, IOV_MAX));
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno), "Write failed: %s", g_strerror(errno));
+      ok = FALSE;
+      break;
+    }
+    while (n_iov > 0 && (gsize) n >= iov->iov_len) {
+      n -= iov->iov_len;
+      iov++;
+      n_iov--;
+    }
+    if (n_iov > 0) {
+      iov->iov_base = (guint8*) iov->iov_base + n;
+      iov->iov_len -= n;
+    }
+  }
+  if (ok)
+    w->written += total;
+  dump_release(w);
+  return ok;
+}
+
+static void dump_stream_info(GstCaps* caps, DumpStreamInfo* info) {
+  const GstStructure* s = gst_caps_get_structure(caps, 0);
+  const gchar* stream_format = gst_structure_get_string(s, "stream-format");
+  const GValue* codec_data = gst_structure_get_value(s, "codec_data");
+  gboolean h264 = gst_structure_has_name(s, "video/x-h264");
+
+  memset(info, 0, sizeof(*info));
+  info->h265 = gst_structure_has_name(s, "video/x-h265");
+  if ((h264 || info->h265) && stream_format && g_strcmp0(stream_format, "byte-stream") != 0) {
+    info->length_prefixed = TRUE;
+    if (g_strcmp0(stream_format, "avc3") == 0 || g_strcmp0(stream_format, "hev1") == 0)
+      info->sample_entry = stream_format; /* parameter sets may also be in-band */
+    else
+      info->sample_entry = info->h265 ? "hvc1" : "avc1";
+  }
+  if (codec_data && G_VALUE_HOLDS(codec_data, GST_TYPE_BUFFER))
+    info->codec_data = gst_value_get_buffer(codec_data);
+  gst_structure_get_int(s, "width", &info->width);
+  gst_structure_get_int(s, "height", &info->height);
+}
+
+/* Parameter sets of an avcC/hvcC record as Annex-B */
+static gboolean dump_parse_codec_data(const DumpStreamInfo* info, guint* nal_length_size, GByteArray* param_sets) {
+  GstMapInfo map;
+  const guint8* d;
+  gsize len, off;
+  guint groups, count;
+  gboolean ok = FALSE;
+
+  if (!gst_buffer_map(info->codec_data, &map, GST_MAP_READ))
+    return FALSE;
+  d = map.data;
+  len = map.size;
+  if (info->h265) {
+    if (len < 23)
+      goto out;
+    *nal_length_size = (d[21] & 3) + 1;
+    groups = d[22];
+    off = 23;
+  } else {
+    if (len < 7)
+      goto out;
+    *nal_length_size = (d[4] & 3) + 1;
+    groups = 2; /* SPS, then PPS */
+    off = 5;
+  }
+  for (guint g = 0; g < groups; ++g) {
+    if (info->h265) {
+      if (off + 3 > len)
+        goto out;
+      count = (d[off + 1] << 8) | d[off + 2];
+      off += 3;
+    } else {
+      if (off + 1 > len)
+        goto out;
+      count = g == 0 ? d[off] & 0x1f : d[off];
+      off += 1;
+    }
+    for (guint i = 0; i < count; ++i) {
+      gsize nal;
+      if (off + 2 > len)
+        goto out;
+      nal = (d[off] << 8) | d[off + 1];
+      off += 2;
+      if (nal > len - off)
+        goto out;
+      g_byte_array_append(param_sets, start_code, sizeof(start_code));
+      g_byte_array_append(param_sets, d + off, nal);
+      off += nal;
+    }
+  }
+  ok = TRUE;
+
+out:
+  gst_buffer_unmap(info->codec_data, &map);
+  return ok;
+}
+
+static gboolean dump_annexb(DumpWriter* w, const DumpStreamInfo* info, GstBuffer** buffers, guint n_buffers,
+                            GError** error) {
+  GByteArray* param_sets = g_byte_array_new();
+  guint nal_length_size = 4;
+  gboolean ok = FALSE;
+
+  if (info->length_prefixed && info->codec_data && !dump_parse_codec_data(info, &nal_length_size, param_sets)) {
+    g_set_error(error, GST_STREAM_ERROR, GST_STREAM_ERROR_FORMAT, "Malformed codec_data");
+    goto out;
+  }
+
+  for (guint i = 0; i < n_buffers; ++i) {
+    gboolean keyframe = !GST_BUFFER_FLAG_IS_SET(buffers[i], GST_BUFFER_FLAG_DELTA_UNIT);
+    GstMapInfo map;
+
+    if (keyframe && i > 0 && !dump_flush(w, error)) /* one batch per GOP */
+      goto out;
+    if (!dump_map(w, buffers[i], &map, error))
+      goto out;
+    if (!info->length_prefixed) {
+      dump_add(w, map.data, map.size);
+      continue;
+    }
+    if (keyframe)
+      dump_add(w, param_sets->data, param_sets->len);
+    for (gsize off = 0; off < map.size;) {
+      gsize nal = 0;
+      if (map.size - off < nal_length_size)
+        goto malformed;
+      for (guint k = 0; k < nal_length_size; ++k)
+        nal = (nal << 8) | map.data[off + k];
+      off += nal_length_size;
+      if (nal > map.size - off)
+        goto malformed;
+      dump_add(w, start_code, sizeof(start_code));
+      dump_add(w, map.data + off, nal);
+      off += nal;
+    }
+    continue;
+
+  malformed:
+    g_set_error(error, GST_STREAM_ERROR, GST_STREAM_ERROR_DECODE, "Buffer %u is not %u-byte length prefixed", i,
+                nal_length_size);
+    goto out;
+  }
+  ok = dump_flush(w, error);
+
+out:
+  g_byte_array_unref(param_sets);
+  return ok;
+}
+
+/* ISO BMFF box building */
+static void put_u16(GByteArray* b, guint16 v) {
+  guint8 d[2] = {v >> 8, v};
+  g_byte_array_append(b, d, 2);
+}
+
+static void put_u32(GByteArray* b, guint32 v) {
+  guint8 d[4] = {v >> 24, v >> 16, v >> 8, v};
+  g_byte_array_append(b, d, 4);
+}
+
+static void put_u64(GByteArray* b, guint64 v) {
+  put_u32(b, (guint32) (v >> 32));
+  put_u32(b, (guint32) v);
+}
+
+static void put_zeros(GByteArray* b, guint n) {
+  static const guint8 zeros[32] = {0};
+  g_byte_array_append(b, zeros, n);
+}
+
+static void put_matrix(GByteArray* b) {
+  static const guint32 unity[9] = {0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000};
+  for (guint i = 0; i < 9; ++i)
+    put_u32(b, unity[i]);
+}
+
+static guint box_open(GByteArray* b, const gchar* type) {
+  guint pos = b->len;
+  put_u32(b, 0);
+  g_byte_array_append(b, (const guint8*) type, 4);
+  return pos;
+}
+
+static guint full_box_open(GByteArray* b, const gchar* type, guint8 version, guint32 flags) {
+  guint pos = box_open(b, type);
+  put_u32(b, ((guint32) version << 24) | flags);
+  return pos;
+}
+
+static void box_close(GByteArray* b, guint pos) {
+  GST_WRITE_UINT32_BE(b->data + pos, b->len - pos);
+}
+
+static void dump_fmp4_init(GByteArray* b, const DumpStreamInfo* info, const GstMapInfo* codec_data) {
+  guint moov, trak, mdia, minf, stbl, stsd, entry, dinf, dref, mvex, box;
+
+  box = box_open(b, "ftyp");
+  g_byte_array_append(b, (const guint8*) "isom", 4);
+  put_u32(b, 0x200);
+  g_byte_array_append(b, (const guint8*) "isomiso6mp41", 12);
+  box_close(b, box);
+
+  moov = box_open(b, "moov");
+  box = full_box_open(b, "mvhd", 0, 0);
+  put_u32(b, 0);          /* creation time */
+  put_u32(b, 0);          /* modification time */
+  put_u32(b, 1000);       /* timescale */
+  put_u32(b, 0);          /* duration: fragmented */
+  put_u32(b, 0x00010000); /* rate 1.0 */
+  put_u16(b, 0x0100);     /* volume 1.0 */
+  put_zeros(b, 10);
+  put_matrix(b);
+  put_zeros(b, 24);
+  put_u32(b, 2); /* next track id */
+  box_close(b, box);
+
+  trak = box_open(b, "trak");
+  box = full_box_open(b, "tkhd", 0, 3); /* enabled, in movie */
+  put_u32(b, 0);
+  put_u32(b, 0);
+  put_u32(b, 1); /* track id */
+  put_u32(b, 0);
+  put_u32(b, 0); /* duration */
+  put_zeros(b, 8);
+  put_u16(b, 0); /* layer */
+  put_u16(b, 0); /* alternate group */
+  put_u16(b, 0); /* volume */
+  put_u16(b, 0);
+  put_matrix(b);
+  put_u32(b, (guint32) info->width << 16);
+  put_u32(b, (guint32) info->height << 16);
+  box_close(b, box);
+
+  mdia = box_open(b, "mdia");
+  box = full_box_open(b, "mdhd", 0, 0);
+  put_u32(b, 0);
+  put_u32(b, 0);
+  put_u32(b, DUMP_TIMESCALE);
+  put_u32(b, 0);
+  put_u16(b, 0x55c4); /* "und" */
+  put_u16(b, 0);
+  box_close(b, box);
+  box = full_box_open(b, "hdlr", 0, 0);
+  put_u32(b, 0);
+  g_byte_array_append(b, (const guint8*) "vide", 4);
+  put_zeros(b, 12);
+  g_byte_array_append(b, (const guint8*) "VideoHandler", 13);
+  box_close(b, box);
+
+  minf = box_open(b, "minf");
+  box = full_box_open(b, "vmhd", 0, 1);
+  put_zeros(b, 8);
+  box_close(b, box);
+  dinf = box_open(b, "dinf");
+  dref = full_box_open(b, "dref", 0, 0);
+  put_u32(b, 1);
+  box = full_box_open(b, "url ", 0, 1); /* media in this file */
+  box_close(b, box);
+  box_close(b, dref);
+  box_close(b, dinf);
+
+  stbl = box_open(b, "stbl");
+  stsd = full_box_open(b, "stsd", 0, 0);
+  put_u32(b, 1);
+  entry = box_open(b, info->sample_entry);
+  put_zeros(b, 6);
+  put_u16(b, 1); /* data reference index */
+  put_zeros(b, 16);
+  put_u16(b, (guint16) info->width);
+  put_u16(b, (guint16) info->height);
+  put_u32(b, 0x00480000); /* 72 dpi */
+  put_u32(b, 0x00480000);
+  put_u32(b, 0);
+  put_u16(b, 1); /* frame count */
+  put_zeros(b, 32);
+  put_u16(b, 0x0018);
+  put_u16(b, 0xffff);
+  box = box_open(b, info->h265 ? "hvcC" : "avcC");
+  g_byte_array_append(b, codec_data->data, codec_data->size);
+  box_close(b, box);
+  box_close(b, entry);
+  box_close(b, stsd);
+  /* samples live in the fragments: empty tables */
+  box = full_box_open(b, "stts", 0, 0);
+  put_u32(b, 0);
+  box_close(b, box);
+  box = full_box_open(b, "stsc", 0, 0);
+  put_u32(b, 0);
+  box_close(b, box);
+  box = full_box_open(b, "stsz", 0, 0);
+  put_u32(b, 0);
+  put_u32(b, 0);
+  box_close(b, box);
+  box = full_box_open(b, "stco", 0, 0);
+  put_u32(b, 0);
+  box_close(b, box);
+  box_close(b, stbl);
+  box_close(b, minf);
+  box_close(b, mdia);
+  box_close(b, trak);
+
+  mvex = box_open(b, "mvex");
+  box = full_box_open(b, "trex", 0, 0);
+  put_u32(b, 1); /* track id */
+  put_u32(b, 1); /* sample description index */
+  put_u32(b, 0);
+  put_u32(b, 0);
+  put_u32(b, 0);
+  box_close(b, box);
+  box_close(b, mvex);
+  box_close(b, moov);
+}
+
+static GstClockTime dump_dts(GstBuffer* buf) {
+  return GST_BUFFER_DTS_IS_VALID(buf) ? GST_BUFFER_DTS(buf) : GST_BUFFER_PTS(buf);
+}
+
+static guint64 dump_ticks(GstClockTime t, GstClockTime origin) {
+  if (!GST_CLOCK_TIME_IS_VALID(t) || t < origin)
+    return 0;
+  return gst_util_uint64_scale(t - origin, DUMP_TIMESCALE, GST_SECOND);
+}
+
+/* moof + mdat for buffers[first, end) */
+static gboolean dump_fmp4_fragment(DumpWriter* w, GstBuffer** buffers, guint n_buffers, guint first, guint end,
+                                   guint32 seq, GstClockTime origin, guint32* last_duration, GError** error) {
+  GByteArray* b = g_byte_array_new();
+  guint moof, traf, trun, box, data_offset_pos;
+  guint64 mdat_size = 8;
+
+  moof = box_open(b, "moof");
+  box = full_box_open(b, "mfhd", 0, 0);
+  put_u32(b, seq);
+  box_close(b, box);
+  traf = box_open(b, "traf");
+  box = full_box_open(b, "tfhd", 0, 0x020000); /* default-base-is-moof */
+  put_u32(b, 1);
+  box_close(b, box);
+  box = full_box_open(b, "tfdt", 1, 0);
+  put_u64(b, dump_ticks(dump_dts(buffers[first]), origin));
+  box_close(b, box);
+  /* data offset, sample duration, size, flags, composition offset */
+  trun = full_box_open(b, "trun", 1, 0x000F01);
+  put_u32(b, end - first);
+  data_offset_pos = b->len;
+  put_u32(b, 0);
+  for (guint i = first; i < end; ++i) {
+    GstBuffer* buf = buffers[i];
+    guint64 dts = dump_ticks(dump_dts(buf), origin);
+    guint32 duration = *last_duration;
+
+    if (GST_BUFFER_DURATION_IS_VALID(buf))
+      duration = (guint32) gst_util_uint64_scale(GST_BUFFER_DURATION(buf), DUMP_TIMESCALE, GST_SECOND);
+    else if (i + 1 < n_buffers && dump_ticks(dump_dts(buffers[i + 1]), origin) > dts)
+      duration = (guint32) (dump_ticks(dump_dts(buffers[i + 1]), origin) - dts);
+    *last_duration = duration;
+
+    put_u32(b, duration);
+    put_u32(b, (guint32) gst_buffer_get_size(buf));
+    put_u32(b, GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_DELTA_UNIT) ? 0x01010000 : 0x02000000);
+    put_u32(b, GST_BUFFER_PTS_IS_VALID(buf) ? (guint32) (gint32) ((gint64) dump_ticks(GST_BUFFER_PTS(buf), origin) -
+                                                                  (gint64) dts)
+                                            : 0);
+    mdat_size += gst_buffer_get_size(buf);
+  }
+  box_close(b, trun);
+  box_close(b, traf);
+  box_close(b, moof);
+  GST_WRITE_UINT32_BE(b->data + data_offset_pos, b->len + 8); /* first sample right after the mdat header */
+
+  if (mdat_size > G_MAXUINT32) {
+    g_set_error(error, GST_STREAM_ERROR, GST_STREAM_ERROR_ENCODE, "GOP %u exceeds 4 GiB", seq);
+    g_byte_array_unref(b);
+    return FALSE;
+  }
+  put_u32(b, (guint32) mdat_size);
+  g_byte_array_append(b, (const guint8*) "mdat", 4);
+  dump_add_copy(w, b->data, b->len);
+  g_byte_array_unref(b);
+
+  for (guint i = first; i < end; ++i) {
+    GstMapInfo map;
+    if (!dump_map(w, buffers[i], &map, error))
+      return FALSE;
+    dump_add(w, map.data, map.size);
+  }
+  return dump_flush(w, error);
+}
+
+static gboolean dump_fmp4(DumpWriter* w, const DumpStreamInfo* info, GstBuffer** buffers, guint n_buffers,
+                          GError** error) {
+  GByteArray* init;
+  GstMapInfo codec_data;
+  GstClockTime origin = dump_dts(buffers[0]);
+  guint32 last_duration = 0, seq = 1;
+
+  if (!info->length_prefixed || !info->codec_data || info->width <= 0 || info->height <= 0) {
+    g_set_error(error, GST_STREAM_ERROR, GST_STREAM_ERROR_FORMAT,
+                "fmp4 dumps need length-prefixed H.264/H.265 caps with codec_data, width and height");
+    return FALSE;
+  }
+  if (!gst_buffer_map(info->codec_data, &codec_data, GST_MAP_READ)) {
+    g_set_error(error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ, "Cannot map codec_data");
+    return FALSE;
+  }
+  init = g_byte_array_new();
+  dump_fmp4_init(init, info, &codec_data);
+  gst_buffer_unmap(info->codec_data, &codec_data);
+  dump_add_copy(w, init->data, init->len);
+  g_byte_array_unref(init);
+  if (!GST_CLOCK_TIME_IS_VALID(origin))
+    origin = 0;
+
+  for (guint first = 0, end; first < n_buffers; first = end) {
+    end = first + 1;
+    while (end < n_buffers && GST_BUFFER_FLAG_IS_SET(buffers[end], GST_BUFFER_FLAG_DELTA_UNIT))
+      end++;
+    if (!dump_fmp4_fragment(w, buffers, n_buffers, first, end, seq++, origin, &last_duration, error))
+      return FALSE;
+  }
+  return TRUE;
+}
+
+gboolean gst_prerec_dump_write(const gchar* location, GstPreRecDumpFormat format, GstCaps* caps,
+                               GstBuffer** buffers, guint n_buffers, guint64* bytes_written, GError** error) {
+  DumpStreamInfo info;
+  DumpWriter w;
+  gboolean ok;
+
+  *bytes_written = 0;
+  g_return_val_if_fail(n_buffers > 0, FALSE);
+  dump_stream_info(caps, &info);
+
+  w.fd = g_open(location, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (w.fd < 0) {
+    g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno), "Cannot open %s: %s", location,
+                g_strerror(errno));
+    return FALSE;
+  }
+  w.iov = g_array_new(FALSE, FALSE, sizeof(struct iovec));
+  w.chunks = g_ptr_array_new_with_free_func(g_free);
+  w.mapped = g_ptr_array_new();
+  w.maps = g_array_new(FALSE, FALSE, sizeof(GstMapInfo));
+  w.written = 0;
+
+  if (format == GST_PREREC_DUMP_FMP4)
+    ok = dump_fmp4(&w, &info, buffers, n_buffers, error);
+  else
+    ok = dump_annexb(&w, &info, buffers, n_buffers, error);
+  if (ok && fdatasync(w.fd) != 0) {
+    g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno), "Cannot sync %s: %s", location,
+                g_strerror(errno));
+    ok = FALSE;
+  }
+
+  dump_release(&w);
+  close(w.fd);
+  if (!ok)
+    g_unlink(location);
+  *bytes_written = w.written;
+  g_array_unref(w.iov);
+  g_ptr_array_unref(w.chunks);
+  g_ptr_array_unref(w.mapped);
+  g_array_unref(w.maps);
+  return ok;
+}
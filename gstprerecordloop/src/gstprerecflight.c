@@ -0,0 +1,95 @@
+/*
+ * GStreamer pre-record loop: lock-free flight recorder
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#include <gstprerecordloop/gstprerecflight.h>
+
+G_STATIC_ASSERT((GST_PREREC_FLIGHT_ENTRIES & (GST_PREREC_FLIGHT_ENTRIES - 1)) == 0);
+
+void gst_prerec_flight_init(GstPreRecFlight* flight) {
+  flight->head = 0;
+  flight->entries = g_new0(GstPreRecFlightEntry, GST_PREREC_FLIGHT_ENTRIES);
+}
+
+void gst_prerec_flight_clear(GstPreRecFlight* flight) {
+  g_clear_pointer(&flight->entries, g_free);
+  flight->head = 0;
+}
+
+/* Copies slot idx into out if it still holds that decision */
+static gboolean read_entry(const GstPreRecFlight* flight, guint idx, GstPreRecFlightEntry* out) {
+  const GstPreRecFlightEntry* e = &flight->entries[idx & (GST_PREREC_FLIGHT_ENTRIES - 1)];
+  guint seq = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+
+  if (seq != idx + 1)
+    return FALSE;
+  out->gop_id = e->gop_id;
+  out->ts = e->ts;
+  out->a = e->a;
+  out->b = e->b;
+  out->kind = e->kind;
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  out->seq = seq;
+  return __atomic_load_n(&e->seq, __ATOMIC_RELAXED) == seq;
+}
+
+static void append_entry(GString* out, const GstPreRecFlightEntry* e, GstClockTime newest) {
+  /* concurrent writers may publish slightly out of timestamp order */
+  GstClockTime ago = newest > e->ts ? newest - e->ts : 0;
+
+  g_string_append_printf(out, "%10u -%" GST_TIME_FORMAT " ", e->seq - 1, GST_TIME_ARGS(ago));
+  switch (e->kind) {
+  case GST_PREREC_FLIGHT_ENQUEUE:
+    g_string_append_printf(out, "enqueue gop=%u pts=%" GST_TIME_FORMAT " size=%u\n", e->gop_id,
+                           GST_TIME_ARGS(e->a), e->b);
+    break;
+  case GST_PREREC_FLIGHT_PRUNE:
+    g_string_append_printf(out, "prune   gop=%u left-gops=%u left-time=%" GST_TIME_FORMAT "\n", e->gop_id, e->b,
+                           GST_TIME_ARGS(e->a));
+    break;
+  case GST_PREREC_FLIGHT_TRIGGER:
+    g_string_append_printf(out, "trigger gop=%u queued-buffers=%u queued-bytes=%" G_GUINT64_FORMAT "\n", e->gop_id,
+                           e->b, e->a);
+    break;
+  case GST_PREREC_FLIGHT_DRAIN:
+    g_string_append_printf(out, "drain   gop=%u buffers=%u bytes=%" G_GUINT64_FORMAT "\n", e->gop_id, e->b, e->a);
+    break;
+  case GST_PREREC_FLIGHT_ARM:
+    g_string_append_printf(out, "arm     rearm-count=%" G_GUINT64_FORMAT "\n", e->a);
+    break;
+  case GST_PREREC_FLIGHT_FLUSH:
+    g_string_append_printf(out, "flush   full=%s buffers=%u\n", e->a ? "yes" : "no", e->b);
+    break;
+  case GST_PREREC_FLIGHT_EOS:
+    g_string_append_printf(out, "eos     drain=%s queued-buffers=%u\n", e->a ? "yes" : "no", e->b);
+    break;
+  default:
+    g_string_append_printf(out, "kind-%u  gop=%u a=%" G_GUINT64_FORMAT " b=%u\n", e->kind, e->gop_id, e->a, e->b);
+    break;
+  }
+}
+
+gchar* gst_prerec_flight_dump(const GstPreRecFlight* flight) {
+  GstPreRecFlightEntry* copy;
+  GString* out;
+  guint head, first, n = 0;
+
+  if (!flight->entries)
+    return g_strdup("");
+  head = __atomic_load_n(&flight->head, __ATOMIC_ACQUIRE);
+  first = head > GST_PREREC_FLIGHT_ENTRIES ? head - GST_PREREC_FLIGHT_ENTRIES : 0;
+  copy = g_new(GstPreRecFlightEntry, head - first);
+  /* Slots overwritten while copying are skipped, not waited for */
+  for (guint idx = first; idx != head; ++idx) {
+    if (read_entry(flight, idx, &copy[n]))
+      n++;
+  }
+
+  out = g_string_sized_new(64 * (n + 1));
+  for (guint i = 0; i < n; ++i)
+    append_entry(out, &copy[i], copy[n - 1].ts);
+  g_free(copy);
+  return g_string_free(out, FALSE);
+}
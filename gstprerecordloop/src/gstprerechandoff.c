@@ -0,0 +1,214 @@
+/*
+ * GStreamer pre-record loop: memfd hand-off sender
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#include <gstprerecordloop/gstprerechandoff.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+GST_DEBUG_CATEGORY_STATIC(prerec_handoff_debug);
+#define GST_CAT_DEFAULT prerec_handoff_debug
+
+#ifndef MSG_NOSIGNAL /* macOS */
+#define MSG_NOSIGNAL 0
+#endif
+#ifndef SOCK_CLOEXEC
+#define SOCK_CLOEXEC 0
+#endif
+
+static void gst_prerec_handoff_init_debug(void) {
+  static gsize done = 0;
+  if (g_once_init_enter(&done)) {
+    GST_DEBUG_CATEGORY_INIT(prerec_handoff_debug, "pre_record_loop_handoff", 0, "pre record loop memfd hand-off");
+    g_once_init_leave(&done, 1);
+  }
+}
+
+static gboolean handoff_fail(GError** error, const gchar* what, const gchar* path) {
+  gint err = errno;
+  g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(err), "%s %s: %s", what, path, g_strerror(err));
+  return FALSE;
+}
+
+/* Read-only descriptor for the arena: a fresh open file description, so the
+ * consumer cannot write to the ring through it. Falls back to the arena's
+ * own descriptor where /proc is not available. */
+static gint handoff_ro_fd(GstPreRecSpill* arena, gboolean* owned) {
+  gint fd = gst_prerec_spill_get_fd(arena);
+  gchar proc[64];
+  gint ro;
+
+  g_snprintf(proc, sizeof(proc), "/proc/self/fd/%d", fd);
+  ro = open(proc, O_RDONLY | O_CLOEXEC);
+  *owned = ro >= 0;
+  return ro >= 0 ? ro : fd;
+}
+
+/* sendmsg() the first chunk with the descriptor attached, then the rest */
+static gboolean handoff_send_all(gint sock, gint fd, struct iovec* iov, gint n_iov) {
+  union {
+    struct cmsghdr hdr;
+    gchar buf[CMSG_SPACE(sizeof(gint))];
+  } control;
+  struct msghdr msg;
+  struct cmsghdr* cmsg;
+  gboolean fd_sent = FALSE;
+
+  while (n_iov > 0) {
+    ssize_t n;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = n_iov;
+    if (!fd_sent) {
+      memset(&control, 0, sizeof(control));
+      msg.msg_control = control.buf;
+      msg.msg_controllen = sizeof(control.buf);
+      cmsg = CMSG_FIRSTHDR(&msg);
+      cmsg->cmsg_level = SOL_SOCKET;
+      cmsg->cmsg_type = SCM_RIGHTS;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(gint));
+      memcpy(CMSG_DATA(cmsg), &fd, sizeof(gint));
+    }
+    n = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return FALSE;
+    }
+    fd_sent = TRUE;
+    while (n_iov > 0 && (gsize) n >= iov->iov_len) {
+      n -= iov->iov_len;
+      iov++;
+      n_iov--;
+    }
+    if (n_iov > 0) {
+      iov->iov_base = (guint8*) iov->iov_base + n;
+      iov->iov_len -= n;
+    }
+  }
+  return TRUE;
+}
+
+gboolean gst_prerec_handoff_send(const gchar* socket_path, GstPreRecSpill* arena, guint64 clip_id, GstCaps* caps,
+                                 GstBuffer** buffers, guint n_buffers, guint timeout_ms, guint* frames,
+                                 guint* skipped, guint64* bytes, GError** error) {
+  GstPreRecHandoffHeader header;
+  GstPreRecHandoffFrame* index;
+  struct sockaddr_un addr;
+  struct iovec iov[3];
+  struct pollfd pfd;
+  GPtrArray* late;
+  gchar* caps_str;
+  gint sock, fd;
+  gboolean fd_owned, ok = FALSE;
+  guint n = 0;
+  gchar ack = 0;
+
+  g_return_val_if_fail(socket_path != NULL && arena != NULL, FALSE);
+  gst_prerec_handoff_init_debug();
+
+  *frames = *skipped = 0;
+  *bytes = 0;
+  if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+    g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_NAMETOOLONG, "Socket path too long: %s", socket_path);
+    return FALSE;
+  }
+
+  index = g_new0(GstPreRecHandoffFrame, MAX(n_buffers, 1));
+  late = g_ptr_array_new_with_free_func((GDestroyNotify) gst_buffer_unref);
+  for (guint i = 0; i < n_buffers; ++i) {
+    GstBuffer* buf = buffers[i];
+    GstPreRecHandoffFrame* f = &index[n];
+
+    if (!gst_prerec_spill_locate(arena, buf, &f->offset)) {
+      /* missed the arena at ingest (it was full): copy now if it has room */
+      GstBuffer* copy = gst_prerec_spill_store(arena, buf);
+      if (!copy || !gst_prerec_spill_locate(arena, copy, &f->offset)) {
+        if (copy)
+          gst_buffer_unref(copy);
+        (*skipped)++;
+        continue;
+      }
+      g_ptr_array_add(late, copy);
+    }
+    f->size = gst_buffer_get_size(buf);
+    f->pts = GST_BUFFER_PTS(buf);
+    f->dts = GST_BUFFER_DTS(buf);
+    f->duration = GST_BUFFER_DURATION(buf);
+    f->flags = GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_DELTA_UNIT) ? 0 : GST_PREREC_HANDOFF_FRAME_KEY;
+    *bytes += f->size;
+    n++;
+  }
+
+  caps_str = caps ? gst_caps_to_string(caps) : g_strdup("");
+  memset(&header, 0, sizeof(header));
+  header.magic = GST_PREREC_HANDOFF_MAGIC;
+  header.version = GST_PREREC_HANDOFF_VERSION;
+  header.clip_id = clip_id;
+  header.arena_size = gst_prerec_spill_get_capacity(arena);
+  header.n_frames = n;
+  header.caps_len = (uint32_t) strlen(caps_str);
+
+  sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (sock < 0) {
+    handoff_fail(error, "Cannot create socket for", socket_path);
+    goto out;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, socket_path);
+  if (connect(sock, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+    handoff_fail(error, "Cannot connect to", socket_path);
+    goto out_close;
+  }
+
+  iov[0].iov_base = &header;
+  iov[0].iov_len = sizeof(header);
+  iov[1].iov_base = caps_str;
+  iov[1].iov_len = header.caps_len;
+  iov[2].iov_base = index;
+  iov[2].iov_len = n * sizeof(GstPreRecHandoffFrame);
+  fd = handoff_ro_fd(arena, &fd_owned);
+  ok = handoff_send_all(sock, fd, iov, 3);
+  if (fd_owned)
+    close(fd);
+  if (!ok) {
+    handoff_fail(error, "Cannot send hand-off to", socket_path);
+    goto out_close;
+  }
+
+  /* the consumer may read straight from the ring until it acks */
+  pfd.fd = sock;
+  pfd.events = POLLIN;
+  ok = FALSE;
+  if (poll(&pfd, 1, (gint) timeout_ms) <= 0) {
+    g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "No acknowledgement from %s", socket_path);
+    goto out_close;
+  }
+  if (recv(sock, &ack, 1, 0) != 1 || ack != GST_PREREC_HANDOFF_ACK) {
+    g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "Bad acknowledgement from %s", socket_path);
+    goto out_close;
+  }
+  ok = TRUE;
+  *frames = n;
+  GST_DEBUG("clip %" G_GUINT64_FORMAT ": %u frames (%" G_GUINT64_FORMAT " bytes) acked by %s, %u skipped", clip_id,
+            n, *bytes, socket_path, *skipped);
+
+out_close:
+  close(sock);
+out:
+  g_ptr_array_unref(late);
+  g_free(caps_str);
+  g_free(index);
+  return ok;
+}
@@ -0,0 +1,82 @@
+/*
+ * GStreamer pre-record loop: log-bucketed latency histograms
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#include <gstprerecordloop/gstprerechist.h>
+
+#include <string.h>
+
+void gst_prerec_hist_reset(GstPreRecHist* hist) {
+  memset(hist, 0, sizeof(*hist));
+}
+
+guint64 gst_prerec_hist_bucket_start(guint index) {
+  guint group = index / GST_PREREC_HIST_SUB;
+  guint64 sub = index % GST_PREREC_HIST_SUB;
+
+  if (group == 0)
+    return sub;
+  return (GST_PREREC_HIST_SUB + sub) << (group - 1);
+}
+
+guint64 gst_prerec_hist_quantile(const GstPreRecHist* hist, gdouble quantile) {
+  guint64 rank, seen = 0;
+
+  if (hist->count == 0)
+    return 0;
+  rank = (guint64) (quantile * hist->count);
+  if (rank >= hist->count)
+    rank = hist->count - 1;
+  for (guint i = 0; i < GST_PREREC_HIST_BUCKETS; ++i) {
+    seen += hist->buckets[i];
+    if (seen > rank) {
+      guint64 edge = i + 1 < GST_PREREC_HIST_BUCKETS ? gst_prerec_hist_bucket_start(i + 1) - 1 : G_MAXUINT64;
+      return MIN(edge, hist->max);
+    }
+  }
+  return hist->max;
+}
+
+static void append_uint64(GValue* array, guint64 v) {
+  GValue item = G_VALUE_INIT;
+
+  g_value_init(&item, G_TYPE_UINT64);
+  g_value_set_uint64(&item, v);
+  gst_value_array_append_and_take_value(array, &item);
+}
+
+void gst_prerec_hist_to_structure(const GstPreRecHist* hist, GstStructure* s, const gchar* name) {
+  static const struct {
+    const gchar* suffix;
+    gdouble quantile;
+  } quantiles[] = {{"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p999", 0.999}};
+  GValue buckets = G_VALUE_INIT;
+  gchar field[64];
+
+#define SET_FIELD(suffix, value)                                  \
+  G_STMT_START {                                                  \
+    g_snprintf(field, sizeof(field), "%s-%s", name, suffix);      \
+    gst_structure_set(s, field, G_TYPE_UINT64, (guint64) (value), NULL); \
+  }                                                               \
+  G_STMT_END
+
+  SET_FIELD("count", hist->count);
+  SET_FIELD("min", hist->min);
+  SET_FIELD("mean", hist->count ? hist->sum / hist->count : 0);
+  SET_FIELD("max", hist->max);
+  for (guint i = 0; i < G_N_ELEMENTS(quantiles); ++i)
+    SET_FIELD(quantiles[i].suffix, gst_prerec_hist_quantile(hist, quantiles[i].quantile));
+#undef SET_FIELD
+
+  g_value_init(&buckets, GST_TYPE_ARRAY);
+  for (guint i = 0; i < GST_PREREC_HIST_BUCKETS; ++i) {
+    if (hist->buckets[i] == 0)
+      continue;
+    append_uint64(&buckets, gst_prerec_hist_bucket_start(i));
+    append_uint64(&buckets, hist->buckets[i]);
+  }
+  g_snprintf(field, sizeof(field), "%s-buckets", name);
+  gst_structure_take_value(s, field, &buckets);
+}
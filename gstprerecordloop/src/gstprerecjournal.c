@@ -0,0 +1,308 @@
+/*
+ * GStreamer pre-record loop: crash-persistent GOP journal
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#include <gstprerecordloop/gstprereccrc32c.h>
+#include <gstprerecordloop/gstprerecjournal.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define JOURNAL_MAGIC "PRJ1"
+#define JOURNAL_VERSION 2
+#define JOURNAL_SUFFIX ".prj"
+#define JOURNAL_TMP_SUFFIX ".tmp"
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+typedef struct {
+  gchar magic[4];
+  guint32 version;
+  guint64 seq;
+  guint32 n_frames;
+  guint32 caps_len;
+  /* GstSegment snapshot */
+  guint32 seg_flags;
+  gint32 seg_format;
+  gdouble seg_rate, seg_applied_rate;
+  guint64 seg_base, seg_offset, seg_start, seg_stop, seg_time, seg_position, seg_duration;
+} JournalHeader;
+
+typedef struct {
+  guint64 pts, dts, duration;
+  guint32 flags;
+  guint32 size;
+  guint32 crc;
+  guint32 reserved;
+} JournalFrame;
+
+static gchar* journal_path(const gchar* dir, guint64 seq, const gchar* suffix) {
+  gchar name[64];
+  g_snprintf(name, sizeof(name), "gop-%020" G_GUINT64_FORMAT "%s", seq, suffix);
+  return g_build_filename(dir, name, NULL);
+}
+
+/* writev() everything, continuing after partial writes */
+static gboolean journal_writev_all(gint fd, struct iovec* iov, guint n_iov) {
+  while (n_iov > 0) {
+    ssize_t n = writev(fd, iov, (int) MIN(n_iov, IOV_MAX));
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return FALSE;
+    }
+    while (n_iov > 0 && (gsize) n >= iov->iov_len) {
+      n -= iov->iov_len;
+      iov++;
+      n_iov--;
+    }
+    if (n_iov > 0) {
+      iov->iov_base = (guint8*) iov->iov_base + n;
+      iov->iov_len -= n;
+    }
+  }
+  return TRUE;
+}
+
+gboolean gst_prerec_journal_write(const gchar* dir, guint64 seq, GstCaps* caps, const GstSegment* segment,
+                                  GstBuffer** buffers, guint n_buffers, GError** error) {
+  gchar* caps_str = gst_caps_to_string(caps);
+  guint32 caps_len = GST_ROUND_UP_8((guint32) strlen(caps_str) + 1); /* keeps the index 8-byte aligned */
+  GByteArray* meta = g_byte_array_new();
+  GstMapInfo* maps = g_new0(GstMapInfo, n_buffers);
+  struct iovec* iov = g_new(struct iovec, n_buffers + 1);
+  JournalHeader header;
+  guint32 crc;
+  gchar *tmp_path = journal_path(dir, seq, JOURNAL_TMP_SUFFIX), *path = journal_path(dir, seq, JOURNAL_SUFFIX);
+  gboolean ok = FALSE;
+  guint mapped = 0;
+  gint fd = -1;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, JOURNAL_MAGIC, 4);
+  header.version = JOURNAL_VERSION;
+  header.seq = seq;
+  header.n_frames = n_buffers;
+  header.caps_len = caps_len;
+  header.seg_flags = segment->flags;
+  header.seg_format = segment->format;
+  header.seg_rate = segment->rate;
+  header.seg_applied_rate = segment->applied_rate;
+  header.seg_base = segment->base;
+  header.seg_offset = segment->offset;
+  header.seg_start = segment->start;
+  header.seg_stop = segment->stop;
+  header.seg_time = segment->time;
+  header.seg_position = segment->position;
+  header.seg_duration = segment->duration;
+  g_byte_array_append(meta, (const guint8*) &header, sizeof(header));
+  g_byte_array_append(meta, (const guint8*) caps_str, strlen(caps_str));
+  g_byte_array_set_size(meta, sizeof(header) + caps_len);
+  memset(meta->data + sizeof(header) + strlen(caps_str), 0, caps_len - strlen(caps_str));
+
+  for (guint i = 0; i < n_buffers; ++i) {
+    GstBuffer* buf = buffers[i];
+    JournalFrame frame;
+
+    if (!gst_buffer_map(buf, &maps[i], GST_MAP_READ)) {
+      g_set_error(error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ, "Cannot map frame %u of GOP %" G_GUINT64_FORMAT,
+                  i, seq);
+      goto done;
+    }
+    mapped++;
+    memset(&frame, 0, sizeof(frame));
+    frame.pts = GST_BUFFER_PTS(buf);
+    frame.dts = GST_BUFFER_DTS(buf);
+    frame.duration = GST_BUFFER_DURATION(buf);
+    frame.flags = GST_BUFFER_FLAGS(buf);
+    frame.size = (guint32) maps[i].size;
+    frame.crc = gst_prerec_crc32c(0, maps[i].data, maps[i].size);
+    g_byte_array_append(meta, (const guint8*) &frame, sizeof(frame));
+  }
+  crc = gst_prerec_crc32c(0, meta->data, meta->len);
+  g_byte_array_append(meta, (const guint8*) &crc, sizeof(crc));
+
+  iov[0].iov_base = meta->data;
+  iov[0].iov_len = meta->len;
+  for (guint i = 0; i < n_buffers; ++i) {
+    iov[i + 1].iov_base = maps[i].data;
+    iov[i + 1].iov_len = maps[i].size;
+  }
+
+  fd = g_open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0 || !journal_writev_all(fd, iov, n_buffers + 1) || fdatasync(fd) != 0) {
+    g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno), "Cannot write %s: %s", tmp_path,
+                g_strerror(errno));
+    goto done;
+  }
+  close(fd);
+  fd = -1;
+  if (g_rename(tmp_path, path) != 0) {
+    g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno), "Cannot rename %s: %s", tmp_path,
+                g_strerror(errno));
+    goto done;
+  }
+  /* make the rename itself durable */
+  fd = g_open(dir, O_RDONLY | O_CLOEXEC, 0);
+  if (fd >= 0)
+    fsync(fd);
+  ok = TRUE;
+
+done:
+  if (fd >= 0)
+    close(fd);
+  if (!ok)
+    g_unlink(tmp_path);
+  for (guint i = 0; i < mapped; ++i)
+    gst_buffer_unmap(buffers[i], &maps[i]);
+  g_free(maps);
+  g_free(iov);
+  g_byte_array_unref(meta);
+  g_free(caps_str);
+  g_free(tmp_path);
+  g_free(path);
+  return ok;
+}
+
+GstPreRecJournalGop* gst_prerec_journal_read(const gchar* dir, guint64 seq, GError** error) {
+  gchar* path = journal_path(dir, seq, JOURNAL_SUFFIX);
+  gchar* contents = NULL;
+  gsize length = 0, meta_len, offset;
+  const JournalHeader* header;
+  const JournalFrame* frames;
+  GstPreRecJournalGop* gop = NULL;
+  GstMemory* whole;
+  guint32 crc;
+
+  if (!g_file_get_contents(path, &contents, &length, error))
+    goto out;
+
+  header = (const JournalHeader*) contents;
+  if (length < sizeof(JournalHeader) || memcmp(header->magic, JOURNAL_MAGIC, 4) != 0 ||
+      header->version != JOURNAL_VERSION || header->seq != seq || header->caps_len == 0 ||
+      header->n_frames > (length - sizeof(JournalHeader)) / sizeof(JournalFrame)) {
+    g_set_error(error, GST_STREAM_ERROR, GST_STREAM_ERROR_CORRUPT, "%s: bad header", path);
+    goto out;
+  }
+  meta_len = sizeof(JournalHeader) + header->caps_len + (gsize) header->n_frames * sizeof(JournalFrame);
+  if (meta_len + sizeof(crc) > length) {
+    g_set_error(error, GST_STREAM_ERROR, GST_STREAM_ERROR_CORRUPT, "%s: truncated index", path);
+    goto out;
+  }
+  memcpy(&crc, contents + meta_len, sizeof(crc));
+  if (crc != gst_prerec_crc32c(0, (const guint8*) contents, meta_len) || contents[sizeof(JournalHeader) +
+                                                                                   header->caps_len - 1] != '\0') {
+    g_set_error(error, GST_STREAM_ERROR, GST_STREAM_ERROR_CORRUPT, "%s: header CRC mismatch", path);
+    goto out;
+  }
+
+  frames = (const JournalFrame*) (contents + sizeof(JournalHeader) + header->caps_len);
+  offset = meta_len + sizeof(crc);
+  for (guint i = 0; i < header->n_frames; ++i) {
+    if (frames[i].size > length - offset ||
+        frames[i].crc != gst_prerec_crc32c(0, (const guint8*) contents + offset, frames[i].size)) {
+      g_set_error(error, GST_STREAM_ERROR, GST_STREAM_ERROR_CORRUPT, "%s: frame %u CRC mismatch", path, i);
+      goto out;
+    }
+    offset += frames[i].size;
+  }
+
+  gop = g_new0(GstPreRecJournalGop, 1);
+  gop->seq = seq;
+  gop->caps = gst_caps_from_string(contents + sizeof(JournalHeader));
+  gst_segment_init(&gop->segment, (GstFormat) header->seg_format);
+  gop->segment.flags = header->seg_flags;
+  gop->segment.rate = header->seg_rate;
+  gop->segment.applied_rate = header->seg_applied_rate;
+  gop->segment.base = header->seg_base;
+  gop->segment.offset = header->seg_offset;
+  gop->segment.start = header->seg_start;
+  gop->segment.stop = header->seg_stop;
+  gop->segment.time = header->seg_time;
+  gop->segment.position = header->seg_position;
+  gop->segment.duration = header->seg_duration;
+  gop->buffers = g_ptr_array_new_with_free_func((GDestroyNotify) gst_buffer_unref);
+
+  /* frames share the file contents, no per-frame copy */
+  whole = gst_memory_new_wrapped(GST_MEMORY_FLAG_READONLY, contents, length, 0, length, contents, g_free);
+  offset = meta_len + sizeof(crc);
+  for (guint i = 0; i < header->n_frames; ++i) {
+    GstBuffer* buf = gst_buffer_new();
+    if (frames[i].size > 0)
+      gst_buffer_append_memory(buf, gst_memory_share(whole, (gssize) offset, (gssize) frames[i].size));
+    GST_BUFFER_PTS(buf) = frames[i].pts;
+    GST_BUFFER_DTS(buf) = frames[i].dts;
+    GST_BUFFER_DURATION(buf) = frames[i].duration;
+    GST_BUFFER_FLAGS(buf) = frames[i].flags;
+    g_ptr_array_add(gop->buffers, buf);
+    offset += frames[i].size;
+  }
+  gst_memory_unref(whole);
+  contents = NULL; /* owned by the memory now */
+  if (!gop->caps) {
+    g_set_error(error, GST_STREAM_ERROR, GST_STREAM_ERROR_CORRUPT, "%s: unparsable caps", path);
+    gst_prerec_journal_gop_free(gop);
+    gop = NULL;
+  }
+
+out:
+  g_free(contents);
+  g_free(path);
+  return gop;
+}
+
+void gst_prerec_journal_gop_free(GstPreRecJournalGop* gop) {
+  if (gop->caps)
+    gst_caps_unref(gop->caps);
+  g_ptr_array_unref(gop->buffers);
+  g_free(gop);
+}
+
+static gint journal_seq_compare(gconstpointer a, gconstpointer b) {
+  guint64 x = *(const guint64*) a, y = *(const guint64*) b;
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+GArray* gst_prerec_journal_list(const gchar* dir) {
+  GArray* seqs = g_array_new(FALSE, FALSE, sizeof(guint64));
+  GDir* d = g_dir_open(dir, 0, NULL);
+  const gchar* name;
+
+  if (!d)
+    return seqs;
+  while ((name = g_dir_read_name(d))) {
+    gchar* end = NULL;
+    guint64 seq;
+
+    if (!g_str_has_prefix(name, "gop-"))
+      continue;
+    seq = g_ascii_strtoull(name + 4, &end, 10);
+    if (end == name + 4)
+      continue;
+    if (g_strcmp0(end, JOURNAL_SUFFIX) == 0) {
+      g_array_append_val(seqs, seq);
+    } else if (g_strcmp0(end, JOURNAL_TMP_SUFFIX) == 0) {
+      gchar* path = g_build_filename(dir, name, NULL); /* interrupted write */
+      g_unlink(path);
+      g_free(path);
+    }
+  }
+  g_dir_close(d);
+  g_array_sort(seqs, journal_seq_compare);
+  return seqs;
+}
+
+void gst_prerec_journal_remove(const gchar* dir, guint64 seq) {
+  gchar* path = journal_path(dir, seq, JOURNAL_SUFFIX);
+  g_unlink(path);
+  g_free(path);
+}
@@ -100,7 +100,8 @@
  * The element respects GOP boundaries for all operations:
  * - Keyframes (non-delta-unit buffers) start new GOPs
  * - Pruning always removes complete GOPs, never partial frames
- * - Minimum 2-GOP retention ensures playback continuity
+ * - Minimum GOP retention (#GstPreRecordLoop:min-gops, 2 by default) ensures
+ *   playback continuity
  * - Even if a single GOP exceeds #GstPreRecordLoop:max-time, it's retained
  *
  * ## EOS Behavior
@@ -135,6 +136,7 @@
 #include <gst/gstinfo.h>
 #include <gst/gstminiobject.h>
 #include <gst/gstpad.h>
+#include <errno.h>
 #include <stdlib.h>
 #include <time.h>
 #ifdef HAVE_CONFIG_H
@@ -143,6 +145,15 @@
 
 #include <gst/gst.h>
 
+#include <gstprerecordloop/gstprerecclipsink.h>
+#include <gstprerecordloop/gstprerecdump.h>
+#include <gstprerecordloop/gstprerecflight.h>
+#include <gstprerecordloop/gstprerechandoff.h>
+#include <gstprerecordloop/gstprerecjournal.h>
+#include <gstprerecordloop/gstprerecprobes.h>
+#include <gstprerecordloop/gstprerecslab.h>
+#include <gstprerecordloop/gstprerecstatspage.h>
+#include <gstprerecordloop/gstprerectracer.h>
 #include <gstprerecordloop/gstprerecordloop.h>
 
 /* Instrumentation helper: log every explicit mini-object unref we perform.
@@ -193,6 +204,58 @@ GType gst_prerec_flush_on_eos_get_type(void) {
   return flush_on_eos_type;
 }
 
+GType gst_prerec_live_leaky_get_type(void) {
+  static GType live_leaky_type = 0;
+  static const GEnumValue live_leaky_types[] = {
+      {GST_PREREC_LIVE_LEAKY_UPSTREAM, "Drop the incoming buffer", "upstream"},
+      {GST_PREREC_LIVE_LEAKY_DOWNSTREAM, "Drop the oldest queued buffer", "downstream"},
+      {0, NULL, NULL}};
+
+  if (!live_leaky_type) {
+    live_leaky_type = g_enum_register_static("GstPreRecLiveLeaky", live_leaky_types);
+  }
+  return live_leaky_type;
+}
+
+GType gst_prerec_meta_strip_mode_get_type(void) {
+  static GType meta_strip_mode_type = 0;
+  static const GEnumValue meta_strip_mode_types[] = {
+      {GST_PREREC_META_STRIP_REMOVE, "Remove the listed meta APIs", "remove"},
+      {GST_PREREC_META_STRIP_KEEP, "Keep only the listed meta APIs", "keep"},
+      {0, NULL, NULL}};
+
+  if (!meta_strip_mode_type) {
+    meta_strip_mode_type = g_enum_register_static("GstPreRecMetaStripMode", meta_strip_mode_types);
+  }
+  return meta_strip_mode_type;
+}
+
+GType gst_prerec_retention_policy_get_type(void) {
+  static GType retention_policy_type = 0;
+  static const GEnumValue retention_policy_types[] = {
+      {GST_PREREC_RETENTION_AT_MOST, "Keep at most max-time", "at-most"},
+      {GST_PREREC_RETENTION_AT_LEAST, "Keep at least max-time", "at-least"},
+      {0, NULL, NULL}};
+
+  if (!retention_policy_type) {
+    retention_policy_type = g_enum_register_static("GstPreRecRetentionPolicy", retention_policy_types);
+  }
+  return retention_policy_type;
+}
+
+GType gst_prerec_dump_format_get_type(void) {
+  static GType dump_format_type = 0;
+  static const GEnumValue dump_format_types[] = {
+      {GST_PREREC_DUMP_ANNEXB, "Raw elementary stream (H.264/H.265 as Annex-B)", "annexb"},
+      {GST_PREREC_DUMP_FMP4, "Fragmented MP4, one fragment per GOP", "fmp4"},
+      {0, NULL, NULL}};
+
+  if (!dump_format_type) {
+    dump_format_type = g_enum_register_static("GstPreRecDumpFormat", dump_format_types);
+  }
+  return dump_format_type;
+}
+
 GST_DEBUG_CATEGORY_STATIC(prerec_debug);
 #define GST_CAT_DEFAULT prerec_debug
 GST_DEBUG_CATEGORY_STATIC(prerec_dataflow);
@@ -212,16 +275,69 @@ static inline gboolean prerec_metrics_are_enabled(void) {
 
 /* Filter signals and args */
 enum {
-  /* FILL ME */
+  SIGNAL_DUMP_WINDOW,
+  SIGNAL_DUMP_FLIGHT_RECORDER,
   LAST_SIGNAL
 };
 
-enum { PROP_0, PROP_SILENT, PROP_FLUSH_ON_EOS, PROP_FLUSH_TRIGGER_NAME, PROP_MAX_TIME };
+static guint gst_prerec_signals[LAST_SIGNAL] = {0};
+
+enum {
+  PROP_0,
+  PROP_SILENT,
+  PROP_FLUSH_ON_EOS,
+  PROP_FLUSH_TRIGGER_NAME,
+  PROP_MAX_TIME,
+  PROP_CLIP_EVENTS,
+  PROP_PRESERVE_ON_RECONFIGURE,
+  PROP_RING_ID,
+  PROP_RING_PARK_TIMEOUT,
+  PROP_DRAIN_REBASE,
+  PROP_DRAIN_BASE_TIME,
+  PROP_LIVE_MAX_BUFFERS,
+  PROP_LIVE_LEAKY,
+  PROP_SPILL_LOCATION,
+  PROP_SPILL_RAM_TIME,
+  PROP_SPILL_MAX_BYTES,
+  PROP_JOURNAL_LOCATION,
+  PROP_HANDOFF_SOCKET,
+  PROP_HANDOFF_MAX_BYTES,
+  PROP_SLAB_ALLOCATOR,
+  PROP_SLAB_MAX_BYTES,
+  PROP_SLAB_HUGEPAGES,
+  PROP_SLAB_MLOCK,
+  PROP_STRIP_META_APIS,
+  PROP_STRIP_META_MODE,
+  PROP_MAX_QUEUED_EVENTS,
+  PROP_MIN_GOPS,
+  PROP_MAX_GOPS,
+  PROP_RETENTION_POLICY,
+  PROP_DRAIN_QOS,
+  PROP_POST_MESSAGES,
+  PROP_FILL_THRESHOLDS,
+  PROP_MESSAGE_INTERVAL,
+  PROP_STATS_PAGE
+};
 
 /* default property values */
 #define DEFAULT_MAX_SIZE_BUFFERS 200               /* 200 buffers */
 #define DEFAULT_MAX_SIZE_BYTES (300 * 1024 * 1024) /* 300 MB       */
 #define DEFAULT_MAX_SIZE_TIME 10 * GST_SECOND      /* 10 seconds    */
+#define DEFAULT_MAX_QUEUED_EVENTS 0                /* forward other events */
+#define DEFAULT_MIN_GOPS 2                         /* playable even when pruned hard */
+#define DEFAULT_MAX_GOPS 0                         /* no GOP-count cap */
+#define DEFAULT_FILL_THRESHOLDS "100"              /* ring full */
+#define DEFAULT_MESSAGE_INTERVAL 1000              /* 1 s, in ms */
+#define DEFAULT_STATS_PAGE FALSE                   /* no shared-memory page */
+#define DEFAULT_RING_PARK_TIMEOUT 30000            /* 30 s, in ms   */
+#define DEFAULT_LIVE_MAX_BUFFERS 30                /* ~1 s of video */
+#define LIVE_MAX_EVENTS 64 /* serialized events queued for the live pad */
+#define DEFAULT_SPILL_RAM_TIME (5 * GST_SECOND)    /* newest 5 s stay in RAM */
+#define DEFAULT_SPILL_MAX_BYTES (G_GUINT64_CONSTANT(1) << 30) /* 1 GiB */
+#define DEFAULT_HANDOFF_MAX_BYTES (G_GUINT64_CONSTANT(256) << 20) /* 256 MiB */
+#define HANDOFF_ACK_TIMEOUT_MS 10000
+#define JOURNAL_MAX_PENDING 8 /* GOP writes queued for the journal thread */
+#define DEFAULT_SLAB_MAX_BYTES (G_GUINT64_CONSTANT(512) << 20) /* 512 MiB */
 
 #define GST_PREREC_MUTEX_LOCK(loop) \
   G_STMT_START {                    \
@@ -299,6 +415,9 @@ static GstStaticPadTemplate sink_factory =
 static GstStaticPadTemplate src_factory =
     GST_STATIC_PAD_TEMPLATE("src", GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS("video/x-h264; video/x-h265"));
 
+static GstStaticPadTemplate live_factory =
+    GST_STATIC_PAD_TEMPLATE("live", GST_PAD_SRC, GST_PAD_REQUEST, GST_STATIC_CAPS("video/x-h264; video/x-h265"));
+
 #define gst_pre_record_loop_parent_class parent_class
 G_DEFINE_TYPE(GstPreRecordLoop, gst_pre_record_loop, GST_TYPE_ELEMENT);
 
@@ -324,8 +443,20 @@ static gboolean gst_pre_record_loop_src_query(GstPad* pad, GstObject* parent, Gs
 
 static GstFlowReturn gst_pre_record_loop_chain(GstPad* pad, GstObject* parent, GstBuffer* buf);
 
+static GstPad* gst_pre_record_loop_request_new_pad(GstElement* element, GstPadTemplate* templ, const gchar* name,
+                                                   const GstCaps* caps);
+static void gst_pre_record_loop_release_pad(GstElement* element, GstPad* pad);
+
 /* Internal static helper forward decl */
 static void gst_prerec_get_stats(GstPreRecordLoop* loop, GstPreRecStats* out_stats);
+static void update_time_level(GstPreRecordLoop* loop);
+static void gst_prerec_live_locked_clear(GstPreRecordLoop* loop);
+static void gst_prerec_locked_journal_gop(GstPreRecordLoop* loop, guint gop_id);
+static void gst_prerec_locked_journal_trim(GstPreRecordLoop* loop);
+static void gst_prerec_locked_catalog_trim(GstPreRecordLoop* loop);
+static void gst_prerec_locked_prune(GstPreRecordLoop* loop);
+static void gst_prerec_set_fill_thresholds(GstPreRecordLoop* loop, const gchar* s);
+static void gst_prerec_post_messages(GstPreRecordLoop* loop);
 
 typedef struct {
   GstMiniObject* item;
@@ -333,8 +464,95 @@ typedef struct {
   gboolean is_query;
   gboolean is_keyframe;
   guint gop_id;
+  gboolean epoch_start; /* first item enqueued after adopting a parked ring */
+  gboolean spilled;     /* buffer payload lives in the spill arena */
+  GstPreRecGopState* state; /* keyframes only: sticky state of the GOP (owned ref) */
+  GstClockTime enqueued;    /* buffers only: monotonic enqueue time, for hist_residency */
 } GstQueueItem;
 
+/* Per-GOP sticky state
+ *
+ * Queued SEGMENT/GAP events leave with the GOP they were queued in when the
+ * ring is pruned, and CAPS/TAG are forwarded rather than queued, so after
+ * pruning the oldest GOP left may not be preceded by the state it was
+ * recorded under. Each keyframe item holds a ref on an immutable snapshot of
+ * the sink pad's sticky events instead; the drain pushes the parts of it
+ * downstream does not hold yet right before that keyframe. GOPs share a
+ * snapshot until a sticky event changes, which copies it.
+ */
+struct _GstPreRecGopState {
+  gint refcount;
+  GstEvent* caps;
+  GstEvent* segment;
+  GstEvent* tags;        /* GST_TAG_SCOPE_STREAM */
+  GstEvent* global_tags; /* GST_TAG_SCOPE_GLOBAL */
+};
+
+static GstPreRecGopState* gst_prerec_gop_state_ref(GstPreRecGopState* state) {
+  if (state)
+    g_atomic_int_inc(&state->refcount);
+  return state;
+}
+
+static void gst_prerec_gop_state_unref(GstPreRecGopState* state) {
+  if (!state || !g_atomic_int_dec_and_test(&state->refcount))
+    return;
+  gst_event_replace(&state->caps, NULL);
+  gst_event_replace(&state->segment, NULL);
+  gst_event_replace(&state->tags, NULL);
+  gst_event_replace(&state->global_tags, NULL);
+  g_free(state);
+}
+
+/* Called with the lock held for sticky events seen on the sink pad */
+static void gst_prerec_locked_note_sticky(GstPreRecordLoop* loop, GstEvent* event) {
+  GstPreRecGopState* state = loop->gop_state;
+  GstEvent** slot;
+
+  switch (GST_EVENT_TYPE(event)) {
+  case GST_EVENT_CAPS:
+  case GST_EVENT_SEGMENT:
+  case GST_EVENT_TAG:
+  case GST_EVENT_STREAM_START:
+    break;
+  default:
+    return;
+  }
+  if (!state || g_atomic_int_get(&state->refcount) > 1) {
+    GstPreRecGopState* copy = g_new0(GstPreRecGopState, 1);
+
+    copy->refcount = 1;
+    if (state) {
+      gst_event_replace(&copy->caps, state->caps);
+      gst_event_replace(&copy->segment, state->segment);
+      gst_event_replace(&copy->tags, state->tags);
+      gst_event_replace(&copy->global_tags, state->global_tags);
+      gst_prerec_gop_state_unref(state);
+    }
+    loop->gop_state = state = copy;
+  }
+
+  switch (GST_EVENT_TYPE(event)) {
+  case GST_EVENT_CAPS:
+    slot = &state->caps;
+    break;
+  case GST_EVENT_SEGMENT:
+    slot = &state->segment;
+    break;
+  case GST_EVENT_TAG: {
+    GstTagList* tags;
+    gst_event_parse_tag(event, &tags);
+    slot = gst_tag_list_get_scope(tags) == GST_TAG_SCOPE_GLOBAL ? &state->global_tags : &state->tags;
+    break;
+  }
+  default:
+    /* a new stream drops the stream-scoped tags of the previous one */
+    gst_event_replace(&state->tags, NULL);
+    return;
+  }
+  gst_event_replace(slot, event);
+}
+
 /* Tracking data structures only compiled when diagnostics enabled */
 #if PREREC_ENABLE_LIFE_DIAG
 /* Sticky event tracking */
@@ -474,6 +692,183 @@ static inline void clear_level(GstPreRecSize* level) {
   level->buffers = 0;
   level->bytes = 0;
   level->time = 0;
+  level->events = 0;
+}
+
+/* Process-wide registry of parked rings (ring-id property)
+ *
+ * A finalized element with a ring-id parks its queue, timing and GOP tracking
+ * here instead of freeing them. A later instance with the same ring-id adopts
+ * the parked ring on its first CAPS event if the caps are equal, so history
+ * survives a pipeline rebuild without copying a single buffer. Parked rings
+ * expire after ring-park-timeout through an async system clock id, so no main
+ * loop is needed.
+ */
+typedef struct {
+  gchar* ring_id; /* also the hash table key */
+  GstVecDeque* queue;
+  GstCaps* caps;
+  GstPreRecSize cur_level;
+  GstSegment src_segment;
+  GstClockTimeDiff sinktime, srctime, sink_start_time;
+  gboolean newseg_applied_to_src;
+  guint current_gop_id, last_gop_id;
+  guint64 spill_queued_bytes;
+  GArray* gop_catalog;
+  GstClockID expiry;
+} GstPreRecParkedRing;
+
+static GMutex prerec_registry_lock;
+static GHashTable* prerec_registry = NULL; /* ring-id -> GstPreRecParkedRing* */
+
+static void gst_prerec_parked_ring_free(GstPreRecParkedRing* parked) {
+  GstQueueItem* qitem;
+
+  if (parked->expiry) {
+    gst_clock_id_unschedule(parked->expiry);
+    gst_clock_id_unref(parked->expiry);
+  }
+  while ((qitem = gst_vec_deque_pop_head_struct(parked->queue))) {
+    if (qitem->item)
+      PREREC_UNREF(qitem->item, "parked ring free");
+    gst_prerec_gop_state_unref(qitem->state);
+  }
+  gst_vec_deque_free(parked->queue);
+  g_array_unref(parked->gop_catalog);
+  gst_caps_unref(parked->caps);
+  g_free(parked->ring_id);
+  g_free(parked);
+}
+
+static gboolean gst_prerec_parked_ring_expired(GstClock* clock, GstClockTime time, GstClockID id, gpointer user_data) {
+  const gchar* ring_id = user_data;
+  GstPreRecParkedRing* parked;
+
+  g_mutex_lock(&prerec_registry_lock);
+  parked = prerec_registry ? g_hash_table_lookup(prerec_registry, ring_id) : NULL;
+  if (parked && parked->expiry == id) {
+    GST_CAT_INFO(prerec_debug, "Parked ring '%s' expired with %u buffers", ring_id, parked->cur_level.buffers);
+    gst_clock_id_unref(parked->expiry);
+    parked->expiry = NULL;
+    g_hash_table_remove(prerec_registry, ring_id);
+  }
+  g_mutex_unlock(&prerec_registry_lock);
+  return TRUE;
+}
+
+/* Called from finalize: move the ring into the registry. Returns TRUE if the
+ * queue was taken (loop->queue is NULL afterwards). */
+static gboolean gst_prerec_registry_park(GstPreRecordLoop* loop) {
+  GstPreRecParkedRing* parked;
+  GstClock* clock;
+
+  if (!loop->ring_id || loop->ring_park_timeout == 0 || !loop->caps || gst_vec_deque_is_empty(loop->queue))
+    return FALSE;
+
+  parked = g_new0(GstPreRecParkedRing, 1);
+  parked->ring_id = g_strdup(loop->ring_id);
+  parked->queue = loop->queue;
+  parked->caps = gst_caps_ref(loop->caps);
+  parked->cur_level = loop->cur_level;
+  parked->src_segment = loop->src_segment;
+  parked->sinktime = loop->sinktime;
+  parked->srctime = loop->srctime;
+  parked->sink_start_time = loop->sink_start_time;
+  parked->newseg_applied_to_src = loop->newseg_applied_to_src;
+  parked->current_gop_id = loop->current_gop_id;
+  parked->last_gop_id = loop->last_gop_id;
+  parked->spill_queued_bytes = loop->spill_queued_bytes;
+  parked->gop_catalog = loop->gop_catalog;
+  loop->queue = NULL;
+  loop->gop_catalog = NULL;
+
+  clock = gst_system_clock_obtain();
+  parked->expiry =
+      gst_clock_new_single_shot_id(clock, gst_clock_get_time(clock) + loop->ring_park_timeout * GST_MSECOND);
+  gst_object_unref(clock);
+
+  GST_CAT_INFO_OBJECT(prerec_debug, loop, "Parking ring '%s' with %u buffers for %u ms", parked->ring_id,
+                      parked->cur_level.buffers, loop->ring_park_timeout);
+
+  g_mutex_lock(&prerec_registry_lock);
+  if (!prerec_registry)
+    prerec_registry =
+        g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify) gst_prerec_parked_ring_free);
+  /* replace (not insert): the key string is owned by the value */
+  g_hash_table_replace(prerec_registry, parked->ring_id, parked);
+  gst_clock_id_wait_async(parked->expiry, gst_prerec_parked_ring_expired, g_strdup(parked->ring_id), g_free);
+  g_mutex_unlock(&prerec_registry_lock);
+  return TRUE;
+}
+
+/* Called with the lock held on CAPS: adopt a parked ring with the same id
+ * and equal caps if we have not buffered anything ourselves yet. */
+static void gst_prerec_locked_adopt_parked(GstPreRecordLoop* loop, GstCaps* caps) {
+  GstPreRecParkedRing* parked = NULL;
+  GstQueueItem* qitem;
+
+  if (!loop->ring_id || loop->mode != GST_PREREC_MODE_BUFFERING || loop->cur_level.buffers > 0 || !caps)
+    return;
+
+  g_mutex_lock(&prerec_registry_lock);
+  if (prerec_registry)
+    parked = g_hash_table_lookup(prerec_registry, loop->ring_id);
+  if (parked && !gst_caps_is_equal(parked->caps, caps)) {
+    GST_CAT_INFO_OBJECT(prerec_debug, loop, "Parked ring '%s' has incompatible caps %" GST_PTR_FORMAT,
+                        loop->ring_id, parked->caps);
+    parked = NULL;
+  }
+  if (parked)
+    g_hash_table_steal(prerec_registry, loop->ring_id);
+  g_mutex_unlock(&prerec_registry_lock);
+
+  if (!parked)
+    return;
+
+  if (parked->expiry) {
+    gst_clock_id_unschedule(parked->expiry);
+    gst_clock_id_unref(parked->expiry);
+  }
+
+  /* Anything we hold so far (stream-start time SEGMENT) goes behind the
+   * adopted history, which is older. */
+  while ((qitem = gst_vec_deque_pop_head_struct(loop->queue)))
+    gst_vec_deque_push_tail_struct(parked->queue, qitem);
+  gst_vec_deque_free(loop->queue);
+  loop->queue = parked->queue;
+  /* nothing buffered yet, so our catalog is empty */
+  g_array_unref(loop->gop_catalog);
+  loop->gop_catalog = parked->gop_catalog;
+  parked->gop_catalog = NULL;
+
+  loop->cur_level.buffers += parked->cur_level.buffers;
+  loop->cur_level.bytes += parked->cur_level.bytes;
+  loop->cur_level.events += parked->cur_level.events;
+  loop->spill_queued_bytes += parked->spill_queued_bytes;
+  loop->src_segment = parked->src_segment;
+  loop->srctime = parked->srctime;
+  loop->src_tainted = FALSE;
+  loop->sinktime = parked->sinktime;
+  loop->sink_tainted = FALSE;
+  loop->sink_start_time = parked->sink_start_time;
+  loop->newseg_applied_to_src = parked->newseg_applied_to_src;
+  loop->current_gop_id = parked->current_gop_id;
+  loop->last_gop_id = parked->last_gop_id;
+  loop->adopt_offset = 0;
+  loop->adopt_rebase_pending = TRUE;
+  loop->adopt_epoch_pending = TRUE;
+  loop->stats.adopt_count++;
+  loop->stats.queued_buffers_cur = loop->cur_level.buffers;
+  if (loop->current_gop_id >= loop->last_gop_id)
+    loop->stats.queued_gops_cur = loop->current_gop_id - loop->last_gop_id + 1;
+  update_time_level(loop);
+
+  GST_CAT_INFO_OBJECT(prerec_debug, loop, "Adopted parked ring '%s': %u buffers, %u bytes", loop->ring_id,
+                      parked->cur_level.buffers, parked->cur_level.bytes);
+
+  gst_caps_unref(parked->caps);
+  g_free(parked->ring_id);
+  g_free(parked);
 }
 
 /** Finalize Function */
@@ -484,14 +879,56 @@ static void gst_pre_record_loop_finalize(GObject* object) {
 
   GST_DEBUG_OBJECT(prerec, "finalize pre rec loop");
 
-  while ((qitem = gst_vec_deque_pop_head_struct(prerec->queue))) {
-    if (qitem->item) {
-      PREREC_UNREF(qitem->item, "finalize pop");
-      qitem->item = NULL;
+  if (!gst_prerec_registry_park(prerec)) {
+    while ((qitem = gst_vec_deque_pop_head_struct(prerec->queue))) {
+      if (qitem->item) {
+        PREREC_UNREF(qitem->item, "finalize pop");
+        qitem->item = NULL;
+      }
+      gst_prerec_gop_state_unref(qitem->state);
     }
+    gst_vec_deque_free(prerec->queue);
   }
   prerec_dump_life(prerec, "finalize");
-  gst_vec_deque_free(prerec->queue);
+  gst_caps_replace(&prerec->caps, NULL);
+  gst_prerec_gop_state_unref(prerec->gop_state);
+  if (prerec->gop_catalog) /* NULL once parked */
+    g_array_unref(prerec->gop_catalog);
+  g_free(prerec->ring_id);
+
+  /* live pad (if any) was deactivated with the element; drop leftovers */
+  gst_prerec_live_locked_clear(prerec);
+  gst_vec_deque_free(prerec->live_queue);
+  g_mutex_clear(&prerec->live_lock);
+  g_mutex_clear(&prerec->qos_lock);
+  g_cond_clear(&prerec->live_cond);
+
+  if (prerec->spill) /* spilled buffers still out there keep the arena mapped */
+    gst_prerec_spill_unref(prerec->spill);
+  g_free(prerec->spill_location);
+  g_cond_clear(&prerec->spill_cond);
+
+  g_free(prerec->journal_location);
+  g_free(prerec->journal_dir);
+  g_array_unref(prerec->journal_entries);
+  g_cond_clear(&prerec->journal_cond);
+
+  if (prerec->handoff_allocator)
+    gst_object_unref(prerec->handoff_allocator);
+  if (prerec->handoff)
+    gst_prerec_spill_unref(prerec->handoff);
+  g_free(prerec->handoff_socket);
+  if (prerec->slab)
+    gst_object_unref(prerec->slab);
+  g_free(prerec->strip_meta_apis);
+  gst_prerec_flight_clear(&prerec->flight);
+  gst_prerec_stats_shm_free(prerec->stats_shm);
+  if (prerec->strip_meta_quarks)
+    g_array_unref(prerec->strip_meta_quarks);
+  g_free(prerec->fill_thresholds);
+  g_array_unref(prerec->fill_levels);
+  g_ptr_array_foreach(prerec->messages, (GFunc) gst_structure_free, NULL);
+  g_ptr_array_unref(prerec->messages);
 
   g_mutex_clear(&prerec->lock);
   g_cond_clear(&prerec->item_add);
@@ -524,9 +961,186 @@ static void gst_pre_record_loop_set_property(GObject* object, guint prop_id, con
     gint secs = g_value_get_int(value);
     if (secs < 0)
       secs = 0;
+    GST_PREREC_MUTEX_LOCK(filter);
     filter->max_size.time = (guint64) secs * GST_SECOND;
+    gst_prerec_locked_prune(filter); /* a lower limit applies right away */
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    gst_prerec_post_messages(filter);
+    break;
+  }
+  case PROP_CLIP_EVENTS:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->clip_events = g_value_get_boolean(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_PRESERVE_ON_RECONFIGURE:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->preserve_on_reconfigure = g_value_get_boolean(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_RING_ID:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_free(filter->ring_id);
+    filter->ring_id = g_value_dup_string(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_RING_PARK_TIMEOUT:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->ring_park_timeout = g_value_get_uint(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_DRAIN_REBASE:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->drain_rebase = g_value_get_boolean(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_DRAIN_BASE_TIME:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->drain_base_time = g_value_get_uint64(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_LIVE_MAX_BUFFERS:
+    g_mutex_lock(&filter->live_lock);
+    filter->live_max_buffers = g_value_get_uint(value);
+    g_mutex_unlock(&filter->live_lock);
+    break;
+  case PROP_LIVE_LEAKY:
+    g_mutex_lock(&filter->live_lock);
+    filter->live_leaky = g_value_get_enum(value);
+    g_mutex_unlock(&filter->live_lock);
+    break;
+  case PROP_SPILL_LOCATION:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_free(filter->spill_location);
+    filter->spill_location = g_value_dup_string(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_SPILL_RAM_TIME:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->spill_ram_time = g_value_get_uint64(value);
+    if (filter->spill_thread)
+      g_cond_signal(&filter->spill_cond);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_SPILL_MAX_BYTES:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->spill_max_bytes = g_value_get_uint64(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_JOURNAL_LOCATION:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_free(filter->journal_location);
+    filter->journal_location = g_value_dup_string(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_HANDOFF_SOCKET:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_free(filter->handoff_socket);
+    filter->handoff_socket = g_value_dup_string(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_HANDOFF_MAX_BYTES:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->handoff_max_bytes = g_value_get_uint64(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_SLAB_ALLOCATOR:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->slab_enabled = g_value_get_boolean(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_SLAB_MAX_BYTES:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->slab_max_bytes = g_value_get_uint64(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_SLAB_HUGEPAGES:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->slab_hugepages = g_value_get_boolean(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_SLAB_MLOCK:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->slab_mlock = g_value_get_boolean(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_STRIP_META_APIS: {
+    const gchar* s = g_value_get_string(value);
+    GArray* quarks = NULL;
+    if (s) {
+      gchar** names = g_strsplit_set(s, ",; ", -1);
+      quarks = g_array_new(FALSE, FALSE, sizeof(GQuark));
+      for (gchar** n = names; *n; ++n) {
+        if (**n) {
+          GQuark q = g_quark_from_string(*n);
+          g_array_append_val(quarks, q);
+        }
+      }
+      g_strfreev(names);
+    }
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_free(filter->strip_meta_apis);
+    filter->strip_meta_apis = g_strdup(s);
+    if (filter->strip_meta_quarks)
+      g_array_unref(filter->strip_meta_quarks);
+    filter->strip_meta_quarks = quarks;
+    GST_PREREC_MUTEX_UNLOCK(filter);
     break;
   }
+  case PROP_STRIP_META_MODE:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->strip_meta_mode = g_value_get_enum(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_MAX_QUEUED_EVENTS:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->max_size.events = g_value_get_uint(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_MIN_GOPS:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->min_gops = g_value_get_uint(value);
+    gst_prerec_locked_prune(filter);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    gst_prerec_post_messages(filter);
+    break;
+  case PROP_MAX_GOPS:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->max_gops = g_value_get_uint(value);
+    gst_prerec_locked_prune(filter);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    gst_prerec_post_messages(filter);
+    break;
+  case PROP_RETENTION_POLICY:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->retention_policy = g_value_get_enum(value);
+    gst_prerec_locked_prune(filter);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    gst_prerec_post_messages(filter);
+    break;
+  case PROP_DRAIN_QOS:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->drain_qos = g_value_get_boolean(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_POST_MESSAGES:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->post_messages = g_value_get_boolean(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_FILL_THRESHOLDS:
+    gst_prerec_set_fill_thresholds(filter, g_value_get_string(value));
+    break;
+  case PROP_MESSAGE_INTERVAL:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->message_interval = g_value_get_uint(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_STATS_PAGE:
+    GST_PREREC_MUTEX_LOCK(filter);
+    filter->stats_page = g_value_get_boolean(value);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
     break;
@@ -548,7 +1162,154 @@ static void gst_pre_record_loop_get_property(GObject* object, guint prop_id, GVa
     break;
   case PROP_MAX_TIME:
     /* Return current max seconds (rounded down) */
+    GST_PREREC_MUTEX_LOCK(filter);
     g_value_set_int(value, (gint) (filter->max_size.time / GST_SECOND));
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_CLIP_EVENTS:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_boolean(value, filter->clip_events);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_PRESERVE_ON_RECONFIGURE:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_boolean(value, filter->preserve_on_reconfigure);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_RING_ID:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_string(value, filter->ring_id);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_RING_PARK_TIMEOUT:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_uint(value, filter->ring_park_timeout);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_DRAIN_REBASE:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_boolean(value, filter->drain_rebase);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_DRAIN_BASE_TIME:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_uint64(value, filter->drain_base_time);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_LIVE_MAX_BUFFERS:
+    g_mutex_lock(&filter->live_lock);
+    g_value_set_uint(value, filter->live_max_buffers);
+    g_mutex_unlock(&filter->live_lock);
+    break;
+  case PROP_LIVE_LEAKY:
+    g_mutex_lock(&filter->live_lock);
+    g_value_set_enum(value, filter->live_leaky);
+    g_mutex_unlock(&filter->live_lock);
+    break;
+  case PROP_SPILL_LOCATION:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_string(value, filter->spill_location);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_SPILL_RAM_TIME:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_uint64(value, filter->spill_ram_time);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_SPILL_MAX_BYTES:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_uint64(value, filter->spill_max_bytes);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_JOURNAL_LOCATION:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_string(value, filter->journal_location);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_HANDOFF_SOCKET:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_string(value, filter->handoff_socket);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_HANDOFF_MAX_BYTES:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_uint64(value, filter->handoff_max_bytes);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_SLAB_ALLOCATOR:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_boolean(value, filter->slab_enabled);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_SLAB_MAX_BYTES:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_uint64(value, filter->slab_max_bytes);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_SLAB_HUGEPAGES:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_boolean(value, filter->slab_hugepages);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_SLAB_MLOCK:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_boolean(value, filter->slab_mlock);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_STRIP_META_APIS:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_string(value, filter->strip_meta_apis);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_STRIP_META_MODE:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_enum(value, filter->strip_meta_mode);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_MAX_QUEUED_EVENTS:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_uint(value, filter->max_size.events);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_MIN_GOPS:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_uint(value, filter->min_gops);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_MAX_GOPS:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_uint(value, filter->max_gops);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_RETENTION_POLICY:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_enum(value, filter->retention_policy);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_DRAIN_QOS:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_boolean(value, filter->drain_qos);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_POST_MESSAGES:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_boolean(value, filter->post_messages);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_FILL_THRESHOLDS:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_string(value, filter->fill_thresholds);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_MESSAGE_INTERVAL:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_uint(value, filter->message_interval);
+    GST_PREREC_MUTEX_UNLOCK(filter);
+    break;
+  case PROP_STATS_PAGE:
+    GST_PREREC_MUTEX_LOCK(filter);
+    g_value_set_boolean(value, filter->stats_page);
+    GST_PREREC_MUTEX_UNLOCK(filter);
     break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
@@ -589,6 +1350,8 @@ static void update_time_level(GstPreRecordLoop* loop) {
     loop->sink_tainted = FALSE;
   }
   sink_time = loop->sinktime;
+  if (GST_CLOCK_STIME_IS_VALID(sink_time))
+    sink_time += loop->adopt_offset; /* non-zero only while draining an adopted ring */
   sink_start_time = loop->sink_start_time;
 
   if (loop->src_tainted) {
@@ -694,6 +1457,17 @@ static void locked_apply_buffer(GstPreRecordLoop* loop, GstBuffer* buffer, GstSe
     GST_DEBUG_OBJECT(loop, "Start time updated to %" GST_STIME_FORMAT, GST_STIME_ARGS(loop->sink_start_time));
   }
 
+  if (is_sink && G_UNLIKELY(loop->adopt_rebase_pending)) {
+    /* First buffer after adopting a parked ring: the new pipeline has its own
+     * running-time base, so continue the sink time where the parked ring
+     * stopped until the src side reaches the new data (see epoch_start). */
+    GstClockTimeDiff rt = segment_to_running_time(segment, timestamp);
+    if (GST_CLOCK_STIME_IS_VALID(rt) && GST_CLOCK_STIME_IS_VALID(loop->sinktime))
+      loop->adopt_offset = loop->sinktime - rt;
+    loop->adopt_rebase_pending = FALSE;
+    GST_DEBUG_OBJECT(loop, "Adopted ring time offset %" GST_STIME_FORMAT, GST_STIME_ARGS(loop->adopt_offset));
+  }
+
   if (duration != GST_CLOCK_TIME_NONE) {
     timestamp += duration;
   }
@@ -742,6 +1516,13 @@ static gboolean gst_prerec_locked_dequeue(GstPreRecordLoop* loop, GstQueueItem*
   item = out_item->item;
   buf_size = out_item->size;
 
+  if (G_UNLIKELY(out_item->epoch_start)) {
+    /* src side leaves the adopted history: both ends share one time base again */
+    loop->adopt_offset = 0;
+  }
+  if (out_item->spilled)
+    loop->spill_queued_bytes -= buf_size;
+
   if (item) {
     GST_CAT_LOG_OBJECT(prerec_debug, loop, "DEQUEUE item=%p kind=%s ref=%d gop=%u size=%zu", item,
                        GST_IS_BUFFER(item) ? "buffer" : (GST_IS_EVENT(item) ? "event" : "other"),
@@ -751,7 +1532,14 @@ static gboolean gst_prerec_locked_dequeue(GstPreRecordLoop* loop, GstQueueItem*
   if (GST_IS_BUFFER(item)) {
     GstBuffer* buffer = GST_BUFFER_CAST(item);
 
+    GstClockTime residency = GST_CLOCK_TIME_NONE;
+
     GST_CAT_LOG_OBJECT(prerec_dataflow, loop, "retrieved buffer %p from prerec loop", buffer);
+    if (GST_CLOCK_TIME_IS_VALID(out_item->enqueued)) { /* pushed or pruned: it leaves the ring now */
+      residency = gst_util_get_timestamp() - out_item->enqueued;
+      gst_prerec_hist_record(&loop->hist_residency, residency);
+    }
+    PREREC_PROBE5(dequeue, loop, out_item->gop_id, GST_BUFFER_PTS(buffer), buf_size, residency);
     loop->cur_level.buffers--;
     loop->cur_level.bytes -= buf_size;
     locked_apply_buffer(loop, buffer, &loop->src_segment, FALSE);
@@ -776,6 +1564,7 @@ static gboolean gst_prerec_locked_dequeue(GstPreRecordLoop* loop, GstQueueItem*
       locked_apply_gap(loop, event, &loop->src_segment, FALSE);
       break;
     default:
+      loop->cur_level.events--;
       break;
     }
   } else {
@@ -790,6 +1579,10 @@ static gboolean gst_prerec_locked_dequeue(GstPreRecordLoop* loop, GstQueueItem*
 
 static void gst_prerec_locked_flush(GstPreRecordLoop* loop, gboolean full) {
   GstQueueItem* qitem;
+
+  PREREC_PROBE4(flush, loop, full, loop->cur_level.buffers, loop->cur_level.bytes);
+  gst_prerec_flight_record(&loop->flight, GST_PREREC_FLIGHT_FLUSH, loop->current_gop_id, full,
+                           loop->cur_level.buffers);
   while ((qitem = gst_vec_deque_pop_head_struct(loop->queue))) {
     /* Flush queue item:
      *  - We never manually re-store sticky events here (handled by GStreamer core).
@@ -800,11 +1593,18 @@ static void gst_prerec_locked_flush(GstPreRecordLoop* loop, gboolean full) {
       GST_CAT_LOG_OBJECT(prerec_debug, loop, "FLUSH item=%p kind=%s ref(before)=%d full=%d", qitem->item,
                          GST_IS_BUFFER(qitem->item) ? "buffer" : (GST_IS_EVENT(qitem->item) ? "event" : "other"),
                          (int) GST_MINI_OBJECT_REFCOUNT_VALUE(qitem->item), full);
+      if (GST_CLOCK_TIME_IS_VALID(qitem->enqueued))
+        gst_prerec_hist_record(&loop->hist_residency, gst_util_get_timestamp() - qitem->enqueued);
       PREREC_UNREF(qitem->item, full ? "flush full" : "flush partial");
     }
+    gst_prerec_gop_state_unref(qitem->state);
     memset(qitem, 0, sizeof(GstQueueItem));
   }
   clear_level(&loop->cur_level);
+  loop->spill_queued_bytes = 0;
+  loop->fill_posted = 0;
+  gst_prerec_locked_journal_trim(loop);
+  gst_prerec_locked_catalog_trim(loop);
   if (full) {
     gst_segment_init(&loop->sink_segment, GST_FORMAT_TIME);
     gst_segment_init(&loop->src_segment, GST_FORMAT_TIME);
@@ -812,6 +1612,8 @@ static void gst_prerec_locked_flush(GstPreRecordLoop* loop, gboolean full) {
     loop->sinktime = loop->srctime = GST_CLOCK_STIME_NONE;
     loop->sink_start_time = GST_CLOCK_STIME_NONE;
     loop->sink_tainted = loop->src_tainted = FALSE;
+    loop->adopt_offset = 0;
+    loop->adopt_rebase_pending = loop->adopt_epoch_pending = FALSE;
   } else {
     GST_CAT_LOG_OBJECT(prerec_debug, loop, "Partial flush: preserving segment timing state");
   }
@@ -819,16 +1621,148 @@ static void gst_prerec_locked_flush(GstPreRecordLoop* loop, gboolean full) {
   GST_PREREC_SIGNAL_DEL(loop);
 }
 
+/* TRUE when the ring must outlive pad deactivation (preserve-on-reconfigure,
+ * or ring-id so finalize can park it) */
+static inline gboolean gst_prerec_keeps_ring(GstPreRecordLoop* loop) {
+  return loop->preserve_on_reconfigure || loop->ring_id != NULL;
+}
+
+/* Drop the whole ring together with timing and GOP tracking (EOS discard,
+ * FLUSH_START, prerecord-discard and the transition to NULL). */
+static void gst_prerec_locked_discard(GstPreRecordLoop* loop) {
+  gst_prerec_locked_flush(loop, TRUE);
+  loop->current_gop_id = loop->last_gop_id = 0;
+  loop->stats.queued_gops_cur = 0;
+  loop->stats.queued_buffers_cur = 0;
+}
+
+/* Meta stripping (strip-meta-apis / strip-meta-mode)
+ *
+ * Analytics metas (ROIs, tensors, custom structures) ride along with every
+ * frame and would otherwise stay in the ring for the whole window. A meta
+ * matches when its API type or, for custom metas, its registered name is
+ * listed. Locked metas are never removed. Counted bytes are the meta structs
+ * themselves; data a meta only points to is released with it but not counted.
+ */
+static gboolean gst_prerec_locked_meta_strippable(GstPreRecordLoop* loop, GstMeta* meta) {
+  gboolean listed = FALSE;
+
+  if (GST_META_FLAG_IS_SET(meta, GST_META_FLAG_LOCKED))
+    return FALSE;
+  for (guint i = 0; i < loop->strip_meta_quarks->len && !listed; ++i) {
+    GQuark q = g_array_index(loop->strip_meta_quarks, GQuark, i);
+    listed = q == g_type_qname(meta->info->api) || q == g_type_qname(meta->info->type);
+  }
+  return loop->strip_meta_mode == GST_PREREC_META_STRIP_KEEP ? !listed : listed;
+}
+
+typedef struct {
+  GstPreRecordLoop* loop;
+  guint64 count;
+  guint64 bytes;
+} GstPreRecMetaStrip;
+
+static gboolean gst_prerec_strip_meta_cb(GstBuffer* buffer, GstMeta** meta, gpointer user_data) {
+  GstPreRecMetaStrip* strip = user_data;
+
+  if (gst_prerec_locked_meta_strippable(strip->loop, *meta)) {
+    strip->count++;
+    strip->bytes += (*meta)->info->size;
+    *meta = NULL; /* removes it */
+  }
+  return TRUE;
+}
+
+/* Returns the buffer to queue: buffer itself when nothing matches, else a
+ * writable version of it (usually the same object) without the metas */
+static GstBuffer* gst_prerec_locked_strip_metas(GstPreRecordLoop* loop, GstBuffer* buffer) {
+  GstPreRecMetaStrip strip = {loop, 0, 0};
+  gpointer state = NULL;
+  GstMeta* meta;
+  gboolean any = FALSE;
+
+  if (!loop->strip_meta_quarks)
+    return buffer;
+  /* look first: a shared buffer is only copied when there is work */
+  while (!any && (meta = gst_buffer_iterate_meta(buffer, &state)))
+    any = gst_prerec_locked_meta_strippable(loop, meta);
+  if (!any)
+    return buffer;
+
+  buffer = gst_buffer_make_writable(buffer);
+  gst_buffer_foreach_meta(buffer, gst_prerec_strip_meta_cb, &strip);
+  loop->stats.meta_stripped += strip.count;
+  loop->stats.meta_stripped_bytes += strip.bytes;
+  return buffer;
+}
+
+/* GOP catalog (prerec-catalog query)
+ *
+ * Clip planning wants to know which GOPs the ring holds, when they start and
+ * how big they are. Walking the queue for that would hold the lock for the
+ * whole ring, so enqueue keeps one small entry per GOP up to date instead and
+ * the query only copies the array. Entries leave with their GOP, the same way
+ * journal_entries do.
+ */
+typedef struct {
+  guint gop_id;
+  GstClockTimeDiff start; /* running time of the keyframe */
+  GstClockTimeDiff end;   /* running time the newest buffer ends at */
+  guint64 bytes;
+  guint64 keyframe_bytes;
+  guint buffers;
+} GstPreRecGopInfo;
+
+static void gst_prerec_locked_catalog_add(GstPreRecordLoop* loop, GstBuffer* buffer, gboolean keyframe, gsize size) {
+  GArray* catalog = loop->gop_catalog;
+  GstClockTime ts = GST_BUFFER_DTS_OR_PTS(buffer);
+  GstClockTimeDiff end;
+  GstPreRecGopInfo* info;
+
+  if (keyframe) {
+    GstPreRecGopInfo fresh = {loop->current_gop_id, GST_CLOCK_STIME_NONE, GST_CLOCK_STIME_NONE, 0, size, 0};
+    g_array_append_val(catalog, fresh);
+  } else if (catalog->len == 0) {
+    return; /* leading delta units belong to no GOP */
+  }
+  info = &g_array_index(catalog, GstPreRecGopInfo, catalog->len - 1);
+  info->bytes += size;
+  info->buffers++;
+
+  if (!GST_CLOCK_TIME_IS_VALID(ts))
+    return;
+  if (GST_BUFFER_DURATION_IS_VALID(buffer))
+    ts += GST_BUFFER_DURATION(buffer);
+  end = segment_to_running_time(&loop->sink_segment, ts);
+  if (!GST_CLOCK_STIME_IS_VALID(info->start))
+    info->start = segment_to_running_time(&loop->sink_segment, GST_BUFFER_DTS_OR_PTS(buffer));
+  if (!GST_CLOCK_STIME_IS_VALID(info->end) || end > info->end)
+    info->end = end;
+}
+
+/* Forget the GOPs that left the ring (pruned, drained, flushed) */
+static void gst_prerec_locked_catalog_trim(GstPreRecordLoop* loop) {
+  GArray* catalog = loop->gop_catalog;
+  guint n = 0;
+
+  while (n < catalog->len && (loop->cur_level.buffers == 0 ||
+                              g_array_index(catalog, GstPreRecGopInfo, n).gop_id < loop->last_gop_id))
+    n++;
+  if (n > 0)
+    g_array_remove_range(catalog, 0, n);
+}
+
 static inline void gst_prerec_locked_enqueue_buffer(GstPreRecordLoop* loop, gpointer item) {
   GstQueueItem qitem;
-  GstBuffer* buffer = GST_BUFFER_CAST(item);
+  GstClockTime now = gst_util_get_timestamp();
+  GstBuffer* buffer = gst_prerec_locked_strip_metas(loop, GST_BUFFER_CAST(item));
   gsize bsize = gst_buffer_get_size(buffer);
 
   /* Ownership: buffer enters with upstream refcount = 1 (exclusive ownership by caller).
    * We do NOT gst_buffer_ref() here; the queue assumes ownership of that single ref.
    * On subsequent push (trigger/EOS) we transfer ownership to downstream. If dropped, we unref in flush/drop paths. */
 
-  qitem.item = item;
+  qitem.item = GST_MINI_OBJECT_CAST(buffer);
   qitem.is_query = FALSE;
   qitem.is_keyframe = !(GST_BUFFER_FLAGS(buffer) & GST_BUFFER_FLAG_DELTA_UNIT);
   if (qitem.is_keyframe) {
@@ -836,6 +1770,11 @@ static inline void gst_prerec_locked_enqueue_buffer(GstPreRecordLoop* loop, gpoi
   }
   qitem.gop_id = loop->current_gop_id;
   qitem.size = bsize;
+  qitem.epoch_start = loop->adopt_epoch_pending;
+  qitem.spilled = FALSE;
+  qitem.state = qitem.is_keyframe ? gst_prerec_gop_state_ref(loop->gop_state) : NULL;
+  qitem.enqueued = now;
+  loop->adopt_epoch_pending = FALSE;
   if (gst_vec_deque_get_length(loop->queue) == 0 || loop->cur_level.buffers == 0) {
     if (!qitem.is_keyframe) {
       GST_CAT_ERROR_OBJECT(prerec_dataflow, loop, "Adding first buffer to queue but it is not a keyframe");
@@ -847,17 +1786,64 @@ static inline void gst_prerec_locked_enqueue_buffer(GstPreRecordLoop* loop, gpoi
   loop->cur_level.buffers++;
   loop->cur_level.bytes += bsize;
   locked_apply_buffer(loop, buffer, &loop->sink_segment, TRUE);
+  gst_prerec_locked_catalog_add(loop, buffer, qitem.is_keyframe, bsize);
 
   gst_vec_deque_push_tail_struct(loop->queue, &qitem);
   GST_PREREC_SIGNAL_ADD(loop);
+
+  if (loop->spill_thread) {
+    if (GST_BUFFER_DTS_OR_PTS(buffer) != GST_CLOCK_TIME_NONE)
+      loop->spill_newest_ts = GST_BUFFER_DTS_OR_PTS(buffer);
+    if (qitem.is_keyframe) /* a GOP just closed; it may be old enough to spill */
+      g_cond_signal(&loop->spill_cond);
+  }
+  if (loop->journal_jobs && qitem.is_keyframe)
+    gst_prerec_locked_journal_gop(loop, loop->current_gop_id - 1);
+  gst_prerec_hist_record(&loop->hist_enqueue, gst_util_get_timestamp() - now);
+  PREREC_PROBE6(enqueue, loop, qitem.gop_id, GST_BUFFER_PTS(buffer), bsize, loop->cur_level.buffers,
+                loop->cur_level.bytes);
+  gst_prerec_flight_record(&loop->flight, GST_PREREC_FLIGHT_ENQUEUE, qitem.gop_id, GST_BUFFER_PTS(buffer), bsize);
+}
+
+/* Sparse streams send runs of GAPs with nothing in between; a GAP following
+ * a queued GAP replaces it with one GAP spanning both, so the run costs one
+ * ring slot and one push on drain. Only GAPs with a duration, in order and
+ * with the same flags, are merged. Takes ownership of event if it returns
+ * TRUE. */
+static gboolean gst_prerec_locked_coalesce_gap(GstPreRecordLoop* loop, GstEvent* event) {
+  GstQueueItem* tail = gst_vec_deque_peek_tail_struct(loop->queue);
+  GstClockTime ts, dur, tail_ts, tail_dur;
+  GstGapFlags flags, tail_flags;
+  GstEvent* merged;
+
+  if (!tail || !tail->item || !GST_IS_EVENT(tail->item) || GST_EVENT_TYPE(tail->item) != GST_EVENT_GAP)
+    return FALSE;
+  gst_event_parse_gap(event, &ts, &dur);
+  gst_event_parse_gap_flags(event, &flags);
+  gst_event_parse_gap(GST_EVENT_CAST(tail->item), &tail_ts, &tail_dur);
+  gst_event_parse_gap_flags(GST_EVENT_CAST(tail->item), &tail_flags);
+  if (!GST_CLOCK_TIME_IS_VALID(dur) || !GST_CLOCK_TIME_IS_VALID(tail_dur) || ts < tail_ts || flags != tail_flags)
+    return FALSE;
+
+  merged = gst_event_new_gap(tail_ts, MAX(tail_ts + tail_dur, ts + dur) - tail_ts);
+  gst_event_set_gap_flags(merged, flags);
+  gst_event_set_seqnum(merged, gst_event_get_seqnum(event));
+  GST_CAT_LOG_OBJECT(prerec_dataflow, loop, "Coalesced GAP %" GST_TIME_FORMAT " into %" GST_PTR_FORMAT,
+                     GST_TIME_ARGS(ts), merged);
+  PREREC_UNREF(tail->item, "coalesced gap");
+  tail->item = GST_MINI_OBJECT_CAST(merged);
+  gst_event_unref(event);
+  loop->stats.gaps_coalesced++;
+  return TRUE;
 }
 
 static inline void gst_prerec_locked_enqueue_event(GstPreRecordLoop* loop, gpointer item) {
   GstQueueItem qitem;
   GstEvent* event = GST_EVENT_CAST(item);
 
-  /* Ownership: caller passed an event we have just gst_event_ref()'d for SEGMENT/GAP in sink_event handler.
-   * This function only queues SEGMENT and GAP events (EOS is handled directly in sink_event handler).
+  /* Ownership: caller passed an event we have just gst_event_ref()'d for SEGMENT/GAP in sink_event handler,
+   * or the sink_event reference itself for the other serialized events (max-queued-events).
+   * EOS is handled directly in sink_event handler.
    * Every enqueued event has exactly one owned reference here. */
 
   switch (GST_EVENT_TYPE(event)) {
@@ -872,24 +1858,105 @@ static inline void gst_prerec_locked_enqueue_event(GstPreRecordLoop* loop, gpoin
     break;
   case GST_EVENT_GAP:
     locked_apply_gap(loop, event, &loop->sink_segment, TRUE);
+    if (gst_prerec_locked_coalesce_gap(loop, event))
+      return;
     break;
   default:
-    GST_CAT_WARNING_OBJECT(prerec_dataflow, loop, "Unexpected event type %s in enqueue_event",
-                           GST_EVENT_TYPE_NAME(event));
+    loop->cur_level.events++;
     break;
   }
   qitem.item = item;
   qitem.is_query = FALSE;
   qitem.is_keyframe = FALSE;
+  qitem.gop_id = loop->current_gop_id;
   qitem.size = 0;
+  qitem.epoch_start = loop->adopt_epoch_pending;
+  qitem.spilled = FALSE;
+  qitem.state = NULL;
+  qitem.enqueued = GST_CLOCK_TIME_NONE;
+  loop->adopt_epoch_pending = FALSE;
   gst_vec_deque_push_tail_struct(loop->queue, &qitem);
   GST_PREREC_SIGNAL_ADD(loop);
 }
 
+/* Other serialized events (max-queued-events property)
+ *
+ * Events that are neither stream setup (STREAM_START, CAPS), timing
+ * (SEGMENT, GAP, queued above) nor EOS would otherwise be forwarded ahead of
+ * the buffered data they follow. They are queued like SEGMENT/GAP instead,
+ * so pruning drops them with their GOP and the drain emits them in place.
+ * A sticky one replaces the event in the same sticky slot queued earlier in
+ * the current GOP, which keeps the count bounded by the GOPs held rather
+ * than by how often upstream re-sends tags.
+ */
+static gboolean gst_prerec_event_queueable(GstEvent* event) {
+  switch (GST_EVENT_TYPE(event)) {
+  case GST_EVENT_STREAM_START:
+  case GST_EVENT_CAPS:
+  case GST_EVENT_SEGMENT:
+  case GST_EVENT_GAP:
+  case GST_EVENT_EOS:
+  case GST_EVENT_FLUSH_STOP:
+    return FALSE;
+  default:
+    return GST_EVENT_IS_SERIALIZED(event) && GST_EVENT_IS_DOWNSTREAM(event);
+  }
+}
+
+static gboolean gst_prerec_same_sticky_slot(GstEvent* a, GstEvent* b) {
+  if (GST_EVENT_TYPE(a) != GST_EVENT_TYPE(b))
+    return FALSE;
+  if (GST_EVENT_TYPE(a) == GST_EVENT_TAG) {
+    GstTagList *ta, *tb;
+    gst_event_parse_tag(a, &ta);
+    gst_event_parse_tag(b, &tb);
+    return gst_tag_list_get_scope(ta) == gst_tag_list_get_scope(tb);
+  }
+  if (gst_event_type_get_flags(GST_EVENT_TYPE(a)) & GST_EVENT_TYPE_STICKY_MULTI) {
+    const GstStructure* sa = gst_event_get_structure(a);
+    const GstStructure* sb = gst_event_get_structure(b);
+    return sa && sb && gst_structure_has_name(sb, gst_structure_get_name(sa));
+  }
+  return TRUE;
+}
+
+/* Called with the lock held in BUFFERING mode. Takes ownership of event and
+ * returns TRUE if it was queued. */
+static gboolean gst_prerec_locked_queue_event(GstPreRecordLoop* loop, GstEvent* event) {
+  if (loop->max_size.events == 0 || !gst_prerec_event_queueable(event))
+    return FALSE;
+
+  if (GST_EVENT_IS_STICKY(event)) {
+    for (guint i = gst_vec_deque_get_length(loop->queue); i > 0; --i) {
+      GstQueueItem* qitem = gst_vec_deque_peek_nth_struct(loop->queue, i - 1);
+      GstQueueItem old;
+
+      if (qitem->gop_id != loop->current_gop_id)
+        break;
+      if (!qitem->item || !GST_IS_EVENT(qitem->item) ||
+          !gst_prerec_same_sticky_slot(GST_EVENT_CAST(qitem->item), event))
+        continue;
+      gst_vec_deque_drop_struct(loop->queue, i - 1, &old);
+      PREREC_UNREF(old.item, "superseded sticky event");
+      loop->cur_level.events--;
+      loop->stats.events_superseded++;
+      break;
+    }
+  }
+  if (loop->cur_level.events >= loop->max_size.events) {
+    loop->stats.events_overflow++;
+    return FALSE;
+  }
+  loop->stats.events_queued++;
+  gst_prerec_locked_enqueue_event(loop, event);
+  return TRUE;
+}
+
 static void drop_last_item(GstPreRecordLoop* loop) {
   GstQueueItem qitem; /* stack-allocated to avoid pointer aliasing (FR-015) */
   if (!gst_prerec_locked_dequeue(loop, &qitem))
     return;
+  gst_prerec_gop_state_unref(qitem.state);
   GstMiniObject* item = qitem.item;
   if (item) {
     if (GST_IS_EVENT(item)) {
@@ -905,6 +1972,21 @@ static void drop_last_item(GstPreRecordLoop* loop) {
   }
 }
 
+/* Writes the flight recorder to the debug log when the data path fails
+ * (fatal flow return, inconsistent ring), so the decisions leading up to it
+ * survive without INFO logging on the data path */
+static void gst_prerec_log_flight(GstPreRecordLoop* loop) {
+#ifndef GST_DISABLE_GST_DEBUG
+  gchar* dump;
+
+  if (gst_debug_category_get_threshold(prerec_debug) < GST_LEVEL_ERROR)
+    return;
+  dump = gst_prerec_flight_dump(&loop->flight);
+  GST_CAT_ERROR_OBJECT(prerec_debug, loop, "Flight recorder, oldest first:\n%s", dump);
+  g_free(dump);
+#endif
+}
+
 static void gst_prerec_locked_drop(GstPreRecordLoop* loop) {
   gboolean done = FALSE;
   guint id_to_remove = loop->last_gop_id;
@@ -912,7 +1994,6 @@ static void gst_prerec_locked_drop(GstPreRecordLoop* loop) {
   guint buffers_dropped = 0;
   // Lets get to the starting point
   gboolean at_first = FALSE;
-  GST_CAT_INFO(prerec_debug, "Will Attempt to drop items");
   do {
     GstQueueItem* qitem = gst_vec_deque_peek_head_struct(loop->queue);
     if (qitem && qitem->item) {
@@ -950,6 +2031,7 @@ static void gst_prerec_locked_drop(GstPreRecordLoop* loop) {
 
   if (gst_loop_is_empty(loop)) {
     GST_CAT_ERROR_OBJECT(prerec_dataflow, loop, "Couldn't find a starting point and queue is empty");
+    gst_prerec_log_flight(loop);
     return;
   }
   GST_CAT_LOG_OBJECT(prerec_debug, loop, "Dropped %d events and %d buffers trying to get to start of gop for drop",
@@ -991,6 +2073,8 @@ static void gst_prerec_locked_drop(GstPreRecordLoop* loop) {
   loop->stats.drops_events += events_dropped;
   loop->stats.drops_buffers += buffers_dropped;
   loop->stats.drops_gops += 1; /* we attempted a GOP level pruning */
+  gst_prerec_locked_journal_trim(loop);
+  gst_prerec_locked_catalog_trim(loop);
   /* Approximate queued GOPs: difference between current and last id */
   loop->stats.queued_buffers_cur = loop->cur_level.buffers;
   if (loop->current_gop_id >= loop->last_gop_id)
@@ -1020,25 +2104,1745 @@ static inline guint gst_prerec_queued_gops(GstPreRecordLoop* loop) {
   /* Should not happen, but return 0 defensively */
   return 0;
 }
+/* Time the ring would still cover without its oldest GOP, from the catalog
+ * (0 when unknown, so at-least never prunes blindly) */
+static GstClockTime gst_prerec_locked_time_without_head(GstPreRecordLoop* loop) {
+  GArray* catalog = loop->gop_catalog;
+  GstPreRecGopInfo *head, *next;
+
+  if (catalog->len < 2)
+    return 0;
+  head = &g_array_index(catalog, GstPreRecGopInfo, 0);
+  next = &g_array_index(catalog, GstPreRecGopInfo, 1);
+  if (!GST_CLOCK_STIME_IS_VALID(head->start) || !GST_CLOCK_STIME_IS_VALID(next->start) || next->start < head->start ||
+      loop->cur_level.time < (guint64) (next->start - head->start))
+    return 0;
+  return loop->cur_level.time - (next->start - head->start);
+}
+
 static inline gboolean gst_prerec_should_prune(GstPreRecordLoop* loop) {
-  if (!gst_loop_is_filled(loop))
+  guint gops = gst_prerec_queued_gops(loop);
+
+  if (gops <= 1) /* never the GOP being recorded */
+    return FALSE;
+  if (loop->max_gops > 0 && gops > loop->max_gops)
+    return TRUE; /* the cap wins over min-gops */
+  if (gops <= loop->min_gops || !gst_loop_is_filled(loop))
     return FALSE;
-  return gst_prerec_queued_gops(loop) > 2; /* enforce 2-GOP floor */
+  if (loop->retention_policy == GST_PREREC_RETENTION_AT_LEAST)
+    return gst_prerec_locked_time_without_head(loop) >= loop->max_size.time;
+  return TRUE;
 }
 
-/* chain function
- * this function does the actual processing
+/* Element messages (post-messages)
+ *
+ * Fill thresholds, prune bursts, drains and mode changes are queued as bare
+ * structures while the lock is held and posted by gst_prerec_post_messages()
+ * after it is released, so a bus sync handler can query the element. The
+ * stats snapshot is added at posting time.
  */
-static GstFlowReturn gst_pre_record_loop_chain(GstPad* pad, GstObject* parent, GstBuffer* buffer) {
-  GstPreRecordLoop* loop = GST_PREREC_CAST(parent);
-  GstClockTime duration, timestamp;
-
-  GST_PREREC_MUTEX_LOCK_CHECK(loop, out_flushing);
-  GST_CAT_INFO_OBJECT(prerec_debug, loop, "Chain Function");
+static gint gst_prerec_compare_uint(gconstpointer a, gconstpointer b) {
+  guint x = *(const guint*) a, y = *(const guint*) b;
+  return x < y ? -1 : x > y;
+}
 
-  if (loop->eos) {
-    GST_CAT_INFO(prerec_debug, "Going to EOS");
-    goto out_eos;
+/* Parses fill-thresholds ("50,90,100") into ascending, distinct percentages
+ * of max-time. Malformed or out of range entries are skipped. */
+static void gst_prerec_set_fill_thresholds(GstPreRecordLoop* loop, const gchar* s) {
+  GArray* levels = g_array_new(FALSE, FALSE, sizeof(guint));
+  GArray* old;
+
+  if (s) {
+    gchar** parts = g_strsplit_set(s, ",; ", -1);
+    for (gchar** p = parts; *p; ++p) {
+      guint64 v;
+      guint level;
+      if (!**p)
+        continue;
+      if (!g_ascii_string_to_unsigned(*p, 10, 1, 100, &v, NULL)) {
+        GST_WARNING_OBJECT(loop, "ignoring fill threshold '%s', expected a percentage from 1 to 100", *p);
+        continue;
+      }
+      level = (guint) v;
+      g_array_append_val(levels, level);
+    }
+    g_strfreev(parts);
+  }
+  g_array_sort(levels, gst_prerec_compare_uint);
+  for (guint i = 1; i < levels->len;) {
+    if (g_array_index(levels, guint, i) == g_array_index(levels, guint, i - 1))
+      g_array_remove_index(levels, i);
+    else
+      ++i;
+  }
+  if (levels->len > 64) /* one bit each in fill_posted */
+    g_array_set_size(levels, 64);
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  g_free(loop->fill_thresholds);
+  loop->fill_thresholds = g_strdup(s);
+  old = loop->fill_levels;
+  loop->fill_levels = levels;
+  loop->fill_posted = 0;
+  GST_PREREC_MUTEX_UNLOCK(loop);
+  if (old)
+    g_array_unref(old);
+}
+
+static void gst_prerec_locked_queue_message(GstPreRecordLoop* loop, GstStructure* s) {
+  g_ptr_array_add(loop->messages, s);
+  g_atomic_int_set(&loop->messages_pending, 1);
+}
+
+/* Each fill threshold is posted once when the ring reaches it, and again
+ * only after a drain or flush emptied the ring. */
+static void gst_prerec_locked_check_fill(GstPreRecordLoop* loop) {
+  guint64 percent;
+
+  if (!loop->post_messages || loop->max_size.time == 0)
+    return;
+  percent = gst_util_uint64_scale(loop->cur_level.time, 100, loop->max_size.time);
+  for (guint i = 0; i < loop->fill_levels->len; ++i) {
+    guint level = g_array_index(loop->fill_levels, guint, i);
+    guint64 bit = G_GUINT64_CONSTANT(1) << i;
+    if (level > percent)
+      break;
+    if (loop->fill_posted & bit)
+      continue;
+    loop->fill_posted |= bit;
+    gst_prerec_locked_queue_message(loop, gst_structure_new("prerec-fill", "threshold", G_TYPE_UINT, level,
+                                                            "percent", G_TYPE_UINT, (guint) MIN(percent, G_MAXUINT),
+                                                            "level-time", G_TYPE_UINT64, loop->cur_level.time, NULL));
+  }
+}
+
+/* Prune bursts are rate limited: the first prune after message-interval
+ * posts right away, later ones are summed into the next message. */
+static void gst_prerec_locked_note_prune(GstPreRecordLoop* loop, guint gops) {
+  GstClockTime now = gst_util_get_timestamp();
+
+  loop->prune_pending_gops += gops;
+  if (GST_CLOCK_TIME_IS_VALID(loop->prune_posted_at) &&
+      now - loop->prune_posted_at < (GstClockTime) loop->message_interval * GST_MSECOND)
+    return;
+  gst_prerec_locked_queue_message(loop, gst_structure_new("prerec-prune", "gops", G_TYPE_UINT,
+                                                          loop->prune_pending_gops, NULL));
+  loop->prune_pending_gops = 0;
+  loop->prune_posted_at = now;
+}
+
+/* Copies the level and counters into the stats page, if there is one. A
+ * few plain stores between two seq bumps; monitors never block it. */
+static void gst_prerec_locked_publish_stats(GstPreRecordLoop* loop) {
+  GstPreRecStatsPage* page;
+
+  if (!loop->stats_shm)
+    return;
+  page = gst_prerec_stats_shm_begin(loop->stats_shm);
+  page->mode = loop->mode == GST_PREREC_MODE_BUFFERING ? GST_PREREC_STATS_MODE_BUFFERING
+                                                       : GST_PREREC_STATS_MODE_PASS_THROUGH;
+  page->gops = loop->stats.queued_gops_cur;
+  page->buffers = loop->cur_level.buffers;
+  page->bytes = loop->cur_level.bytes;
+  page->time = loop->cur_level.time;
+  page->max_time = loop->max_size.time;
+  page->drops_gops = loop->stats.drops_gops;
+  page->drops_buffers = loop->stats.drops_buffers;
+  page->drops_events = loop->stats.drops_events;
+  page->flush_count = loop->stats.flush_count;
+  page->rearm_count = loop->stats.rearm_count;
+  page->drain_duration = loop->drain_duration;
+  page->drain_bytes_per_sec = loop->drain_bytes_per_sec;
+  page->updated = gst_util_get_timestamp();
+  gst_prerec_stats_shm_end(loop->stats_shm);
+}
+
+static void gst_prerec_locked_note_mode(GstPreRecordLoop* loop) {
+  if (!loop->post_messages)
+    return;
+  gst_prerec_locked_queue_message(
+      loop, gst_structure_new("prerec-mode", "mode", G_TYPE_STRING,
+                              loop->mode == GST_PREREC_MODE_BUFFERING ? "buffering" : "pass-through", NULL));
+}
+
+/* Drop the oldest GOPs until the retention limits hold. Runs after every
+ * buffered frame and whenever a limit changes, so lowering max-time,
+ * max-gops or min-gops shrinks the ring without waiting for the next
+ * buffer. */
+static void gst_prerec_locked_prune(GstPreRecordLoop* loop) {
+  guint pruned = 0;
+
+  if (loop->mode != GST_PREREC_MODE_BUFFERING)
+    return;
+  while (gst_prerec_should_prune(loop)) {
+    guint before = gst_prerec_queued_gops(loop), gop = loop->last_gop_id;
+    GstClockTime started = gst_util_get_timestamp(), elapsed;
+    GST_CAT_LOG_OBJECT(prerec_debug, loop, "Prune loop start: queued_gops=%u", before);
+    gst_prerec_locked_drop(loop);
+    elapsed = gst_util_get_timestamp() - started;
+    gst_prerec_hist_record(&loop->hist_prune, elapsed);
+    guint after = gst_prerec_queued_gops(loop);
+    GST_CAT_LOG_OBJECT(prerec_debug, loop, "Prune loop end: queued_gops=%u", after);
+    PREREC_PROBE5(prune, loop, after, loop->cur_level.time, loop->cur_level.bytes, elapsed);
+    gst_prerec_flight_record(&loop->flight, GST_PREREC_FLIGHT_PRUNE, gop, loop->cur_level.time, after);
+    if (GST_PREREC_TRACER_ACTIVE())
+      gst_prerec_tracer_log_prune(GST_ELEMENT(loop), after, loop->cur_level.time, elapsed);
+    if (after >= before)
+      break; /* no progress safeguard */
+    pruned += before - after;
+  }
+
+  loop->stats.queued_buffers_cur = loop->cur_level.buffers;
+  loop->stats.queued_gops_cur = gst_prerec_queued_gops(loop);
+  if (pruned && loop->post_messages)
+    gst_prerec_locked_note_prune(loop, pruned);
+}
+
+/* Disk spill tier (spill-location property)
+ *
+ * The newest spill-ram-time of the ring stays in RAM for fast drains. A
+ * worker thread takes the oldest GOP past that window, copies its buffers into
+ * the mmap arena without holding the lock, then swaps the queue items for
+ * buffers wrapping the arena (gst_prerec_spill_store). Items that were drained
+ * or pruned in the meantime are simply not found and their copies dropped.
+ * The newest GOP never spills.
+ */
+static GPtrArray* gst_prerec_locked_collect_spill(GstPreRecordLoop* loop) {
+  GPtrArray* batch = NULL;
+  guint gop_id = 0;
+  guint len = gst_vec_deque_get_length(loop->queue);
+
+  for (guint i = 0; i < len; ++i) {
+    GstQueueItem* qitem = gst_vec_deque_peek_nth_struct(loop->queue, i);
+    if (!qitem->item || !GST_IS_BUFFER(qitem->item) || qitem->spilled || qitem->size == 0)
+      continue;
+    if (!batch) {
+      GstClockTime ts = GST_BUFFER_DTS_OR_PTS(GST_BUFFER_CAST(qitem->item));
+      if (qitem->gop_id == loop->current_gop_id || !GST_CLOCK_TIME_IS_VALID(ts) ||
+          !GST_CLOCK_TIME_IS_VALID(loop->spill_newest_ts) || loop->spill_newest_ts < ts + loop->spill_ram_time)
+        return NULL;
+      gop_id = qitem->gop_id;
+      batch = g_ptr_array_new_with_free_func((GDestroyNotify) gst_buffer_unref);
+    } else if (qitem->gop_id != gop_id) {
+      break;
+    }
+    g_ptr_array_add(batch, gst_buffer_ref(GST_BUFFER_CAST(qitem->item)));
+  }
+  return batch;
+}
+
+/* Replaces orig by its spilled copy if orig is still queued; *hint is the
+ * index to start from (batches are in queue order). */
+static gboolean gst_prerec_locked_swap_spilled(GstPreRecordLoop* loop, GstBuffer* orig, GstBuffer* spilled,
+                                               guint* hint) {
+  guint len = gst_vec_deque_get_length(loop->queue);
+
+  for (guint i = *hint; i < len; ++i) {
+    GstQueueItem* qitem = gst_vec_deque_peek_nth_struct(loop->queue, i);
+    if (qitem->item == GST_MINI_OBJECT_CAST(orig)) {
+      qitem->item = GST_MINI_OBJECT_CAST(spilled);
+      qitem->spilled = TRUE;
+      loop->spill_queued_bytes += qitem->size;
+      PREREC_UNREF(orig, "spilled");
+      *hint = i + 1;
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+static gpointer gst_prerec_spill_thread(gpointer user_data) {
+  GstPreRecordLoop* loop = user_data;
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  while (!loop->spill_stop) {
+    GPtrArray* batch = gst_prerec_locked_collect_spill(loop);
+    GstPreRecSpill* spill;
+    GstBuffer** copies;
+    guint64 bytes = 0;
+    gboolean full = FALSE;
+    gint64 start;
+    guint hint = 0;
+
+    if (!batch) {
+      g_cond_wait(&loop->spill_cond, &loop->lock);
+      continue;
+    }
+    spill = gst_prerec_spill_ref(loop->spill);
+    GST_PREREC_MUTEX_UNLOCK(loop);
+
+    copies = g_new0(GstBuffer*, batch->len);
+    start = g_get_monotonic_time();
+    for (guint i = 0; i < batch->len; ++i) {
+      GstBuffer* orig = g_ptr_array_index(batch, i);
+      copies[i] = gst_prerec_spill_store(spill, orig);
+      if (!copies[i]) {
+        full = TRUE;
+        break;
+      }
+      bytes += gst_buffer_get_size(orig);
+    }
+    gst_prerec_spill_unref(spill);
+
+    GST_PREREC_MUTEX_LOCK(loop);
+    loop->stats.spill_written += bytes;
+    loop->stats.spill_time_us += g_get_monotonic_time() - start;
+    for (guint i = 0; i < batch->len && copies[i]; ++i) {
+      if (!gst_prerec_locked_swap_spilled(loop, g_ptr_array_index(batch, i), copies[i], &hint))
+        gst_buffer_unref(copies[i]); /* drained or pruned meanwhile */
+    }
+    g_free(copies);
+    g_ptr_array_unref(batch);
+
+    if (full) {
+      /* retry once pruning or draining has released arena space */
+      loop->stats.spill_full++;
+      GST_CAT_DEBUG_OBJECT(prerec_debug, loop, "Spill arena full, keeping GOP in RAM");
+      g_cond_wait_until(&loop->spill_cond, &loop->lock, g_get_monotonic_time() + 100 * G_TIME_SPAN_MILLISECOND);
+    }
+  }
+  GST_PREREC_MUTEX_UNLOCK(loop);
+  return NULL;
+}
+
+static gboolean gst_prerec_spill_start(GstPreRecordLoop* loop) {
+  GError* error = NULL;
+  GstPreRecSpill* spill;
+  gchar* location;
+  guint64 max_bytes;
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  location = g_strdup(loop->spill_location);
+  max_bytes = loop->spill_max_bytes;
+  GST_PREREC_MUTEX_UNLOCK(loop);
+  if (!location)
+    return TRUE;
+
+  spill = gst_prerec_spill_new(location, max_bytes, &error);
+  g_free(location);
+  if (!spill) {
+    GST_ELEMENT_ERROR(loop, RESOURCE, OPEN_WRITE, ("Could not set up the spill tier"), ("%s", error->message));
+    g_clear_error(&error);
+    return FALSE;
+  }
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  if (loop->spill) /* previous arena lives on in buffers still referencing it */
+    gst_prerec_spill_unref(loop->spill);
+  loop->spill = spill;
+  loop->spill_stop = FALSE;
+  loop->spill_newest_ts = GST_CLOCK_TIME_NONE;
+  loop->spill_thread = g_thread_new("prerec-spill", gst_prerec_spill_thread, loop);
+  GST_PREREC_MUTEX_UNLOCK(loop);
+  return TRUE;
+}
+
+static void gst_prerec_spill_stop(GstPreRecordLoop* loop) {
+  GThread* thread;
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  thread = loop->spill_thread;
+  loop->spill_thread = NULL;
+  loop->spill_stop = TRUE;
+  g_cond_signal(&loop->spill_cond);
+  GST_PREREC_MUTEX_UNLOCK(loop);
+  if (thread)
+    g_thread_join(thread);
+}
+
+/* Called right after a GOP start left the queue (or before the first one):
+ * advise the kernel to read the next GOP's spilled pages while we push. */
+static void gst_prerec_locked_prefetch_next_gop(GstPreRecordLoop* loop) {
+  guint len = gst_vec_deque_get_length(loop->queue);
+  gboolean in_gop = FALSE;
+
+  if (loop->spill_queued_bytes == 0)
+    return;
+  for (guint i = 0; i < len; ++i) {
+    GstQueueItem* qitem = gst_vec_deque_peek_nth_struct(loop->queue, i);
+    if (!qitem->item || !GST_IS_BUFFER(qitem->item))
+      continue;
+    if (qitem->is_keyframe) {
+      if (in_gop)
+        break;
+      in_gop = TRUE;
+    }
+    if (in_gop && qitem->spilled)
+      gst_prerec_spill_prefetch(GST_BUFFER_CAST(qitem->item));
+  }
+}
+
+/* Crash-persistent GOP journal (journal-location property)
+ *
+ * When a keyframe closes a GOP, the GOP's buffers are handed by reference to
+ * journal_thread, which writes one file per GOP (gst_prerec_journal_write)
+ * while the ring keeps running. journal_entries maps the queued GOP ids to
+ * their files so a file leaves the disk when its GOP leaves the ring. Jobs
+ * run in order, so a removal never overtakes the write of the same file.
+ */
+typedef struct {
+  guint gop_id;
+  guint64 seq;
+} GstPreRecJournalEntry;
+
+typedef struct {
+  GPtrArray* buffers; /* GOP to write (GstBuffer*, owned), or NULL */
+  GstCaps* caps;
+  GstSegment segment;
+  guint64 seq;
+  GArray* remove; /* seqs of files to delete, or NULL */
+  GArray* load;   /* seqs left by a previous run, to read for the replay */
+  gboolean stop;
+} GstPreRecJournalJob;
+
+static void gst_prerec_journal_job_free(GstPreRecJournalJob* job) {
+  if (job->buffers)
+    g_ptr_array_unref(job->buffers);
+  if (job->caps)
+    gst_caps_unref(job->caps);
+  if (job->remove)
+    g_array_unref(job->remove);
+  if (job->load)
+    g_array_unref(job->load);
+  g_free(job);
+}
+
+/* Called from enqueue right after the keyframe that closed gop_id */
+static void gst_prerec_locked_journal_gop(GstPreRecordLoop* loop, guint gop_id) {
+  GArray* entries = loop->journal_entries;
+  GstPreRecJournalJob* job;
+  GstPreRecJournalEntry entry;
+  gint len = (gint) gst_vec_deque_get_length(loop->queue);
+  gint first = len - 1;
+
+  if (gop_id == 0 || !loop->caps)
+    return;
+  /* already on disk: replayed from the journal */
+  if (entries->len > 0 && g_array_index(entries, GstPreRecJournalEntry, entries->len - 1).gop_id >= gop_id)
+    return;
+  /* every queued write holds a whole GOP; past the cap the disk is not
+   * keeping up, so leave this one out of the journal */
+  if (loop->journal_pending >= JOURNAL_MAX_PENDING) {
+    loop->stats.journal_skipped++;
+    loop->journal_seq++; /* the missing file stops a replay at this GOP */
+    GST_CAT_DEBUG_OBJECT(prerec_debug, loop, "journal behind (%u writes pending), GOP %u not journaled",
+                         loop->journal_pending, gop_id);
+    return;
+  }
+  while (first > 0 && ((GstQueueItem*) gst_vec_deque_peek_nth_struct(loop->queue, first - 1))->gop_id == gop_id)
+    first--;
+
+  job = g_new0(GstPreRecJournalJob, 1);
+  job->buffers = g_ptr_array_new_with_free_func((GDestroyNotify) gst_buffer_unref);
+  /* sink_segment may already be the next GOP's (a SEGMENT right before the
+   * closing keyframe); the keyframe's GOP state has the one it was queued on */
+  gst_segment_copy_into(&loop->sink_segment, &job->segment);
+  for (gint i = first; i < len - 1; ++i) {
+    GstQueueItem* qitem = gst_vec_deque_peek_nth_struct(loop->queue, i);
+    if (qitem->item && GST_IS_BUFFER(qitem->item)) {
+      if (job->buffers->len == 0 && qitem->state && qitem->state->segment)
+        gst_event_copy_segment(qitem->state->segment, &job->segment);
+      g_ptr_array_add(job->buffers, gst_buffer_ref(GST_BUFFER_CAST(qitem->item)));
+    }
+  }
+  if (job->buffers->len == 0) {
+    gst_prerec_journal_job_free(job);
+    return;
+  }
+  job->caps = gst_caps_ref(loop->caps);
+  job->seq = loop->journal_seq++;
+  entry.gop_id = gop_id;
+  entry.seq = job->seq;
+  g_array_append_val(entries, entry);
+  loop->journal_pending++;
+  g_async_queue_push(loop->journal_jobs, job);
+}
+
+/* Forget the files of GOPs that left the ring (pruned, drained, flushed) */
+static void gst_prerec_locked_journal_trim(GstPreRecordLoop* loop) {
+  GArray* entries = loop->journal_entries;
+  GstPreRecJournalJob* job;
+  guint n = 0;
+
+  while (n < entries->len && (loop->cur_level.buffers == 0 ||
+                              g_array_index(entries, GstPreRecJournalEntry, n).gop_id < loop->last_gop_id))
+    n++;
+  if (n == 0)
+    return;
+  if (loop->journal_jobs) {
+    job = g_new0(GstPreRecJournalJob, 1);
+    job->remove = g_array_sized_new(FALSE, FALSE, sizeof(guint64), n);
+    for (guint i = 0; i < n; ++i)
+      g_array_append_val(job->remove, g_array_index(entries, GstPreRecJournalEntry, i).seq);
+    g_async_queue_push(loop->journal_jobs, job);
+  }
+  g_array_remove_range(entries, 0, n);
+}
+
+/* Reads and checks the files a previous run left behind, on the journal
+ * thread, so the first CAPS only splices them into the ring. Seqs are
+ * consecutive; a missing one is a GOP that never made it to disk (skipped
+ * or failed), so only the GOPs before that hole are kept for the replay. */
+static void gst_prerec_journal_load(GstPreRecordLoop* loop, const gchar* dir, GArray* seqs) {
+  GPtrArray* gops = g_ptr_array_new_with_free_func((GDestroyNotify) gst_prerec_journal_gop_free);
+  gboolean hole = FALSE;
+  guint corrupt = 0;
+
+  for (guint i = 0; i < seqs->len; ++i) {
+    guint64 seq = g_array_index(seqs, guint64, i);
+    GstPreRecJournalGop* gop = NULL;
+    GError* error = NULL;
+
+    if (!hole && i > 0 && seq != g_array_index(seqs, guint64, i - 1) + 1) {
+      GST_CAT_WARNING_OBJECT(prerec_debug, loop, "Journal misses GOPs before %" G_GUINT64_FORMAT
+                             ", not replaying past them", seq);
+      hole = TRUE;
+    }
+    if (!hole) {
+      gop = gst_prerec_journal_read(dir, seq, &error);
+      if (!gop) {
+        GST_CAT_WARNING_OBJECT(prerec_debug, loop, "Dropping journal GOP %" G_GUINT64_FORMAT ": %s", seq,
+                               error->message);
+        corrupt++;
+        g_clear_error(&error);
+      }
+    }
+    if (gop)
+      g_ptr_array_add(gops, gop);
+    else
+      gst_prerec_journal_remove(dir, seq);
+  }
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  loop->journal_loaded = gops;
+  loop->journal_loaded_done = TRUE;
+  loop->stats.journal_corrupt += corrupt;
+  g_cond_broadcast(&loop->journal_cond);
+  GST_PREREC_MUTEX_UNLOCK(loop);
+}
+
+static gpointer gst_prerec_journal_thread(gpointer user_data) {
+  GstPreRecordLoop* loop = user_data;
+  GAsyncQueue* jobs = loop->journal_jobs; /* both stay valid until the join in journal_stop */
+  const gchar* dir = loop->journal_dir;
+  gboolean warned = FALSE, warned_skip = FALSE;
+  guint skipped_before;
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  skipped_before = loop->stats.journal_skipped; /* counted by earlier runs */
+  GST_PREREC_MUTEX_UNLOCK(loop);
+  for (;;) {
+    GstPreRecJournalJob* job = g_async_queue_pop(jobs);
+    GError* error = NULL;
+
+    if (job->stop) {
+      gst_prerec_journal_job_free(job);
+      break;
+    }
+    if (job->load)
+      gst_prerec_journal_load(loop, dir, job->load);
+    if (job->buffers) {
+      gboolean written = gst_prerec_journal_write(dir, job->seq, job->caps, &job->segment,
+                                                  (GstBuffer**) job->buffers->pdata, job->buffers->len, &error);
+      guint skipped;
+
+      GST_PREREC_MUTEX_LOCK(loop);
+      if (written)
+        loop->stats.journal_written++;
+      loop->journal_pending--;
+      skipped = loop->stats.journal_skipped - skipped_before;
+      GST_PREREC_MUTEX_UNLOCK(loop);
+      if (skipped > 0 && !warned_skip) {
+        GST_ELEMENT_WARNING(loop, RESOURCE, WRITE, ("The GOP journal cannot keep up with the stream"),
+                            ("%u GOPs not journaled, more than %d writes were pending", skipped,
+                             JOURNAL_MAX_PENDING));
+        warned_skip = TRUE;
+      }
+      if (!written) {
+        if (!warned)
+          GST_ELEMENT_WARNING(loop, RESOURCE, WRITE, ("Could not write to the GOP journal"), ("%s", error->message));
+        else
+          GST_CAT_WARNING_OBJECT(prerec_debug, loop, "%s", error->message);
+        warned = TRUE;
+        g_clear_error(&error);
+      }
+    }
+    for (guint i = 0; job->remove && i < job->remove->len; ++i)
+      gst_prerec_journal_remove(dir, g_array_index(job->remove, guint64, i));
+    gst_prerec_journal_job_free(job);
+  }
+  return NULL;
+}
+
+static gboolean gst_prerec_journal_start(GstPreRecordLoop* loop) {
+  GArray* seqs;
+  gchar* location;
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  location = g_strdup(loop->journal_location);
+  GST_PREREC_MUTEX_UNLOCK(loop);
+  if (!location)
+    return TRUE;
+
+  if (g_mkdir_with_parents(location, 0700) != 0) {
+    GST_ELEMENT_ERROR(loop, RESOURCE, OPEN_WRITE, ("Could not set up the GOP journal"), ("%s: %s", location,
+                                                                                          g_strerror(errno)));
+    g_free(location);
+    return FALSE;
+  }
+  seqs = gst_prerec_journal_list(location);
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  g_free(loop->journal_dir);
+  loop->journal_dir = location;
+  loop->journal_jobs = g_async_queue_new_full((GDestroyNotify) gst_prerec_journal_job_free);
+  loop->journal_pending = 0;
+  g_array_set_size(loop->journal_entries, 0);
+  /* never reuse the name of a file left over from a previous run */
+  loop->journal_seq = seqs->len > 0 ? g_array_index(seqs, guint64, seqs->len - 1) + 1 : 0;
+  loop->journal_recover_pending = TRUE;
+  loop->journal_loaded_done = seqs->len == 0;
+  if (seqs->len > 0) {
+    /* first job of the thread: read the leftovers before anything is written */
+    GstPreRecJournalJob* job = g_new0(GstPreRecJournalJob, 1);
+    job->load = seqs;
+    g_async_queue_push(loop->journal_jobs, job);
+  } else {
+    g_array_unref(seqs);
+  }
+  loop->journal_thread = g_thread_new("prerec-journal", gst_prerec_journal_thread, loop);
+  GST_PREREC_MUTEX_UNLOCK(loop);
+  return TRUE;
+}
+
+static void gst_prerec_journal_stop(GstPreRecordLoop* loop) {
+  GstPreRecJournalJob* job;
+  GAsyncQueue* jobs;
+  GThread* thread;
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  thread = loop->journal_thread;
+  jobs = loop->journal_jobs;
+  loop->journal_thread = NULL;
+  loop->journal_jobs = NULL;
+  loop->journal_recover_pending = FALSE;
+  g_array_set_size(loop->journal_entries, 0);
+  g_cond_broadcast(&loop->journal_cond);
+  GST_PREREC_MUTEX_UNLOCK(loop);
+  if (!thread)
+    return;
+
+  job = g_new0(GstPreRecJournalJob, 1);
+  job->stop = TRUE;
+  g_async_queue_push(jobs, job);
+  g_thread_join(thread);
+  g_async_queue_unref(jobs);
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  if (loop->journal_loaded) /* never replayed: no CAPS in this run */
+    g_ptr_array_unref(loop->journal_loaded);
+  loop->journal_loaded = NULL;
+  loop->journal_loaded_done = FALSE;
+  GST_PREREC_MUTEX_UNLOCK(loop);
+}
+
+/* Called with the lock held on the first CAPS after NULL→READY, after
+ * ring-id adoption: replay the GOPs a crashed run left behind. The journal
+ * thread has read them since NULL→READY; this only waits for it to finish
+ * (with the lock released) and splices the result in, before any buffer. */
+static void gst_prerec_locked_journal_recover(GstPreRecordLoop* loop, GstCaps* caps) {
+  GPtrArray* gops;
+  GArray* unused;
+  gboolean replay;
+  guint recovered = 0;
+
+  if (!loop->journal_recover_pending)
+    return;
+  loop->journal_recover_pending = FALSE;
+
+  while (loop->journal_jobs && !loop->journal_loaded_done)
+    g_cond_wait(&loop->journal_cond, &loop->lock);
+  gops = loop->journal_loaded;
+  loop->journal_loaded = NULL;
+  if (!gops)
+    return;
+
+  /* an adopted ring is newer than anything the journal holds */
+  replay = caps && loop->mode == GST_PREREC_MODE_BUFFERING && loop->cur_level.buffers == 0;
+  unused = g_array_new(FALSE, FALSE, sizeof(guint64));
+  for (guint i = 0; i < gops->len; ++i) {
+    GstPreRecJournalGop* gop = g_ptr_array_index(gops, i);
+    GstPreRecJournalEntry entry;
+
+    if (!replay || !gst_caps_is_equal(gop->caps, caps)) {
+      if (replay)
+        GST_CAT_INFO_OBJECT(prerec_debug, loop, "Journal GOP %" G_GUINT64_FORMAT " has incompatible caps %" GST_PTR_FORMAT,
+                            gop->seq, gop->caps);
+      g_array_append_val(unused, gop->seq);
+      continue;
+    }
+
+    GstEvent* segment = gst_event_new_segment(&gop->segment);
+    gst_prerec_locked_note_sticky(loop, segment);
+    gst_prerec_locked_enqueue_event(loop, segment);
+    for (guint k = 0; k < gop->buffers->len; ++k)
+      gst_prerec_locked_enqueue_buffer(loop, gst_buffer_ref(g_ptr_array_index(gop->buffers, k)));
+    entry.gop_id = loop->current_gop_id;
+    entry.seq = gop->seq;
+    g_array_append_val(loop->journal_entries, entry);
+    recovered++;
+  }
+  g_ptr_array_unref(gops);
+  if (unused->len > 0 && loop->journal_jobs) {
+    /* deleted by the journal thread, not here on the streaming thread */
+    GstPreRecJournalJob* job = g_new0(GstPreRecJournalJob, 1);
+    job->remove = unused;
+    g_async_queue_push(loop->journal_jobs, job);
+  } else {
+    g_array_unref(unused);
+  }
+  if (recovered == 0)
+    return;
+
+  /* live data continues on its own time base, exactly as after adoption */
+  loop->adopt_offset = 0;
+  loop->adopt_rebase_pending = TRUE;
+  loop->adopt_epoch_pending = TRUE;
+  loop->stats.journal_recovered += recovered;
+  loop->stats.queued_buffers_cur = loop->cur_level.buffers;
+  if (loop->current_gop_id >= loop->last_gop_id)
+    loop->stats.queued_gops_cur = loop->current_gop_id - loop->last_gop_id + 1;
+  update_time_level(loop);
+
+  GST_CAT_INFO_OBJECT(prerec_debug, loop, "Recovered %u GOPs (%u buffers) from the journal in %s", recovered,
+                      loop->cur_level.buffers, loop->journal_dir);
+}
+
+/* dump-window action signal
+ *
+ * The handler takes a reference to every queued buffer and returns; a
+ * detached worker writes them (gst_prerec_dump_write) while the ring keeps
+ * buffering, then posts a `prerec-dump-done` element message.
+ */
+typedef struct {
+  GstPreRecordLoop* loop; /* owned ref */
+  gchar* location;
+  GstPreRecDumpFormat format;
+  GstCaps* caps;
+  GPtrArray* buffers; /* GstBuffer*, owned */
+} GstPreRecDumpJob;
+
+static gpointer gst_prerec_dump_thread(gpointer user_data) {
+  GstPreRecDumpJob* job = user_data;
+  GError* error = NULL;
+  guint64 bytes = 0;
+  gint64 start = g_get_monotonic_time();
+  gboolean ok;
+  GstStructure* s;
+
+  ok = gst_prerec_dump_write(job->location, job->format, job->caps, (GstBuffer**) job->buffers->pdata,
+                             job->buffers->len, &bytes, &error);
+  s = gst_structure_new("prerec-dump-done", "location", G_TYPE_STRING, job->location, "format",
+                        GST_TYPE_PREREC_DUMP_FORMAT, job->format, "success", G_TYPE_BOOLEAN, ok, "buffers",
+                        G_TYPE_UINT, job->buffers->len, "bytes", G_TYPE_UINT64, bytes, "elapsed", G_TYPE_UINT64,
+                        (guint64) (g_get_monotonic_time() - start) * GST_USECOND, NULL);
+  if (!ok) {
+    GST_CAT_WARNING_OBJECT(prerec_debug, job->loop, "Dump to %s failed: %s", job->location, error->message);
+    gst_structure_set(s, "error", G_TYPE_STRING, error->message, NULL);
+    g_clear_error(&error);
+  } else {
+    GST_CAT_INFO_OBJECT(prerec_debug, job->loop, "Dumped %u buffers (%" G_GUINT64_FORMAT " bytes) to %s",
+                        job->buffers->len, bytes, job->location);
+  }
+  gst_element_post_message(GST_ELEMENT(job->loop), gst_message_new_element(GST_OBJECT(job->loop), s));
+
+  g_ptr_array_unref(job->buffers);
+  gst_caps_unref(job->caps);
+  g_free(job->location);
+  gst_object_unref(job->loop);
+  g_free(job);
+  return NULL;
+}
+
+static gboolean gst_pre_record_loop_dump_window(GstPreRecordLoop* loop, const gchar* location,
+                                                GstPreRecDumpFormat format) {
+  GstPreRecDumpJob* job;
+  guint len;
+
+  if (!location || !*location)
+    return FALSE;
+
+  job = g_new0(GstPreRecDumpJob, 1);
+  job->buffers = g_ptr_array_new_with_free_func((GDestroyNotify) gst_buffer_unref);
+  GST_PREREC_MUTEX_LOCK(loop);
+  len = gst_vec_deque_get_length(loop->queue);
+  for (guint i = 0; i < len; ++i) {
+    GstQueueItem* qitem = gst_vec_deque_peek_nth_struct(loop->queue, i);
+    if (qitem->item && GST_IS_BUFFER(qitem->item))
+      g_ptr_array_add(job->buffers, gst_buffer_ref(GST_BUFFER_CAST(qitem->item)));
+  }
+  if (loop->caps)
+    job->caps = gst_caps_ref(loop->caps);
+  GST_PREREC_MUTEX_UNLOCK(loop);
+
+  if (job->buffers->len == 0 || !job->caps) {
+    GST_CAT_INFO_OBJECT(prerec_debug, loop, "dump-window: nothing buffered");
+    g_ptr_array_unref(job->buffers);
+    if (job->caps)
+      gst_caps_unref(job->caps);
+    g_free(job);
+    return FALSE;
+  }
+  job->loop = gst_object_ref(loop);
+  job->location = g_strdup(location);
+  job->format = format;
+  g_thread_unref(g_thread_new("prerec-dump", gst_prerec_dump_thread, job));
+  return TRUE;
+}
+
+/* dump-flight-recorder action signal. Lock-free: the streaming thread keeps
+ * recording while the text is built. */
+static gchar* gst_pre_record_loop_dump_flight_recorder(GstPreRecordLoop* loop) {
+  return gst_prerec_flight_dump(&loop->flight);
+}
+
+/* memfd hand-off (handoff-socket property)
+ *
+ * The arena is a sealed memfd (the spill arena over memfd_create). Its
+ * allocator is proposed upstream in ALLOCATION queries, so producers that
+ * honour it write payloads straight into the memfd. While buffering, chain
+ * copies any other payload in once and queues the wrapping buffer; those
+ * copies count in handoff-copied. Spilled GOPs and payloads that did not
+ * fit are copied in by the worker at trigger time. A
+ * trigger takes a reference to every queued buffer and a detached worker
+ * sends the memfd plus a GOP/frame index (gstprerechandoffproto.h) to the
+ * consumer on handoff-socket, which maps the fd and writes the clip without
+ * another copy. The references, and with them the arena regions, are held
+ * until the consumer acks; then a `prerec-handoff-done` element message is
+ * posted. The drain downstream proceeds as usual.
+ */
+typedef struct {
+  GstPreRecordLoop* loop; /* owned ref */
+  GstPreRecSpill* arena;  /* owned ref */
+  gchar* socket_path;
+  guint64 clip_id;
+  GstCaps* caps;
+  GPtrArray* buffers; /* GstBuffer*, owned */
+} GstPreRecHandoffJob;
+
+static gpointer gst_prerec_handoff_thread(gpointer user_data) {
+  GstPreRecHandoffJob* job = user_data;
+  GError* error = NULL;
+  guint frames = 0, skipped = 0;
+  guint64 bytes = 0;
+  gint64 start = g_get_monotonic_time();
+  gboolean ok;
+  GstStructure* s;
+
+  ok = gst_prerec_handoff_send(job->socket_path, job->arena, job->clip_id, job->caps,
+                               (GstBuffer**) job->buffers->pdata, job->buffers->len, HANDOFF_ACK_TIMEOUT_MS, &frames,
+                               &skipped, &bytes, &error);
+  /* acked (or given up): the consumer is done with the ring regions */
+  g_ptr_array_set_size(job->buffers, 0);
+
+  GST_PREREC_MUTEX_LOCK(job->loop);
+  if (ok)
+    job->loop->stats.handoff_count++;
+  else
+    job->loop->stats.handoff_failed++;
+  GST_PREREC_MUTEX_UNLOCK(job->loop);
+
+  s = gst_structure_new("prerec-handoff-done", "socket", G_TYPE_STRING, job->socket_path, "clip-id", G_TYPE_UINT64,
+                        job->clip_id, "success", G_TYPE_BOOLEAN, ok, "frames", G_TYPE_UINT, frames, "skipped",
+                        G_TYPE_UINT, skipped, "bytes", G_TYPE_UINT64, bytes, "elapsed", G_TYPE_UINT64,
+                        (guint64) (g_get_monotonic_time() - start) * GST_USECOND, NULL);
+  if (!ok) {
+    GST_CAT_WARNING_OBJECT(prerec_debug, job->loop, "Hand-off to %s failed: %s", job->socket_path, error->message);
+    gst_structure_set(s, "error", G_TYPE_STRING, error->message, NULL);
+    g_clear_error(&error);
+  } else {
+    GST_CAT_INFO_OBJECT(prerec_debug, job->loop,
+                        "Handed off clip %" G_GUINT64_FORMAT ": %u frames (%" G_GUINT64_FORMAT " bytes), %u skipped",
+                        job->clip_id, frames, bytes, skipped);
+  }
+  gst_element_post_message(GST_ELEMENT(job->loop), gst_message_new_element(GST_OBJECT(job->loop), s));
+
+  g_ptr_array_unref(job->buffers);
+  if (job->caps)
+    gst_caps_unref(job->caps);
+  g_free(job->socket_path);
+  gst_prerec_spill_unref(job->arena);
+  gst_object_unref(job->loop);
+  g_free(job);
+  return NULL;
+}
+
+/* Called on a trigger, before the drain */
+static void gst_prerec_locked_handoff(GstPreRecordLoop* loop) {
+  GstPreRecHandoffJob* job;
+  guint len = gst_vec_deque_get_length(loop->queue);
+
+  job = g_new0(GstPreRecHandoffJob, 1);
+  job->buffers = g_ptr_array_new_full(len, (GDestroyNotify) gst_buffer_unref);
+  for (guint i = 0; i < len; ++i) {
+    GstQueueItem* qitem = gst_vec_deque_peek_nth_struct(loop->queue, i);
+    if (qitem->item && GST_IS_BUFFER(qitem->item))
+      g_ptr_array_add(job->buffers, gst_buffer_ref(GST_BUFFER_CAST(qitem->item)));
+  }
+  job->loop = gst_object_ref(loop);
+  job->arena = gst_prerec_spill_ref(loop->handoff);
+  job->socket_path = g_strdup(loop->handoff_socket);
+  job->clip_id = loop->stats.flush_count;
+  job->caps = loop->caps ? gst_caps_ref(loop->caps) : NULL;
+  g_thread_unref(g_thread_new("prerec-handoff", gst_prerec_handoff_thread, job));
+}
+
+static gboolean gst_prerec_handoff_start(GstPreRecordLoop* loop) {
+  GError* error = NULL;
+  GstPreRecSpill* arena;
+  GstAllocator* allocator;
+  gchar* name;
+  guint64 max_bytes;
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  gboolean enabled = loop->handoff_socket != NULL;
+  max_bytes = loop->handoff_max_bytes;
+  GST_PREREC_MUTEX_UNLOCK(loop);
+  if (!enabled)
+    return TRUE;
+
+  name = g_strdup_printf("prerec-%s", GST_OBJECT_NAME(loop));
+  arena = gst_prerec_spill_new_memfd(name, max_bytes, &error);
+  g_free(name);
+  if (!arena) {
+    GST_ELEMENT_ERROR(loop, RESOURCE, OPEN_WRITE, ("Could not set up the hand-off arena"), ("%s", error->message));
+    g_clear_error(&error);
+    return FALSE;
+  }
+  allocator = gst_prerec_arena_allocator_new(arena);
+  GST_PREREC_MUTEX_LOCK(loop);
+  loop->handoff = arena;
+  loop->handoff_allocator = allocator;
+  GST_PREREC_MUTEX_UNLOCK(loop);
+  return TRUE;
+}
+
+/* Buffers still queued, in a hand-off or allocated upstream keep the arena
+ * mapped */
+static void gst_prerec_handoff_stop(GstPreRecordLoop* loop) {
+  GstPreRecSpill* arena;
+  GstAllocator* allocator;
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  arena = loop->handoff;
+  allocator = loop->handoff_allocator;
+  loop->handoff = NULL;
+  loop->handoff_allocator = NULL;
+  GST_PREREC_MUTEX_UNLOCK(loop);
+  if (allocator)
+    gst_object_unref(allocator);
+  if (arena)
+    gst_prerec_spill_unref(arena);
+}
+
+/* Slab allocator (slab-allocator property)
+ *
+ * Created on NULL→READY and proposed upstream in ALLOCATION queries, so
+ * encoders and parsers write frames straight into slab blocks that the ring
+ * keeps for the whole window (see gstprerecslab.h). Downstream's answer is
+ * kept for its metas and allocation params, but its pools are dropped: the
+ * ring holds buffers far longer than a pool sized for downstream expects, and
+ * would starve it. */
+static void gst_prerec_slab_start(GstPreRecordLoop* loop) {
+  GstAllocator* slab;
+  guint64 max_bytes;
+  gboolean hugepages, lock_pages;
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  gboolean enabled = loop->slab_enabled;
+  max_bytes = loop->slab_max_bytes;
+  hugepages = loop->slab_hugepages;
+  lock_pages = loop->slab_mlock;
+  GST_PREREC_MUTEX_UNLOCK(loop);
+  if (!enabled)
+    return;
+
+  slab = gst_prerec_slab_allocator_new(max_bytes, hugepages, lock_pages);
+  GST_PREREC_MUTEX_LOCK(loop);
+  loop->slab = slab;
+  GST_PREREC_MUTEX_UNLOCK(loop);
+}
+
+/* Outstanding memories keep the allocator alive */
+static void gst_prerec_slab_stop(GstPreRecordLoop* loop) {
+  GstAllocator* slab;
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  slab = loop->slab;
+  loop->slab = NULL;
+  GST_PREREC_MUTEX_UNLOCK(loop);
+  if (slab)
+    gst_object_unref(slab);
+}
+
+/* Stats page (stats-page property)
+ *
+ * Created on NULL→READY under the element's object path and unlinked on
+ * READY→NULL. Not being able to publish only costs monitoring, so a failure
+ * is a warning and the element carries on without the page. */
+static void gst_prerec_stats_page_start(GstPreRecordLoop* loop) {
+  GError* error = NULL;
+  GstPreRecStatsShm* shm;
+  gchar* path;
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  gboolean enabled = loop->stats_page;
+  GST_PREREC_MUTEX_UNLOCK(loop);
+  if (!enabled)
+    return;
+
+  path = gst_object_get_path_string(GST_OBJECT(loop));
+  shm = gst_prerec_stats_shm_new(path, &error);
+  g_free(path);
+  if (!shm) {
+    GST_ELEMENT_WARNING(loop, RESOURCE, OPEN_WRITE, ("Could not publish the stats page"), ("%s", error->message));
+    g_clear_error(&error);
+    return;
+  }
+  GST_PREREC_MUTEX_LOCK(loop);
+  loop->stats_shm = shm;
+  gst_prerec_locked_publish_stats(loop);
+  GST_PREREC_MUTEX_UNLOCK(loop);
+}
+
+static void gst_prerec_stats_page_stop(GstPreRecordLoop* loop) {
+  GstPreRecStatsShm* shm;
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  shm = loop->stats_shm;
+  loop->stats_shm = NULL;
+  GST_PREREC_MUTEX_UNLOCK(loop);
+  gst_prerec_stats_shm_free(shm);
+}
+
+/* Puts allocator (slab or hand-off arena) first in an ALLOCATION answer */
+static void gst_prerec_propose_allocator(GstQuery* query, GstAllocator* allocator) {
+  GstAllocationParams params;
+
+  while (gst_query_get_n_allocation_pools(query) > 0)
+    gst_query_remove_nth_allocation_pool(query, 0);
+
+  gst_allocation_params_init(&params);
+  if (gst_query_get_n_allocation_params(query) > 0) {
+    /* keep downstream's alignment/prefix/padding, put ours first */
+    gst_query_parse_nth_allocation_param(query, 0, NULL, &params);
+    gst_query_set_nth_allocation_param(query, 0, allocator, &params);
+  } else {
+    gst_query_add_allocation_param(query, allocator, &params);
+  }
+}
+
+/* Clip boundary events (clip-events property)
+ *
+ * Every accepted trigger opens a new clip. Right before the first buffer of
+ * that clip leaves the element (first drained keyframe, or first pass-through
+ * buffer if the ring was empty) we push a prerecord-clip-start custom event
+ * followed by a GstForceKeyUnit event. The latter uses the same structure as
+ * gst_video_event_new_downstream_force_key_unit(); it is built by hand so the
+ * plugin does not need to link gstreamer-video. Re-arm or EOS closes the clip
+ * with prerecord-clip-end. All of these are serialized, so a long-lived
+ * splitting muxer sees them exactly at the clip boundaries.
+ */
+static void gst_prerec_locked_take_clip_start(GstPreRecordLoop* loop, GstBuffer* buf, const GstSegment* segment,
+                                              GstEvent** out_start, GstEvent** out_fku) {
+  GstClockTime ts, running_time = GST_CLOCK_TIME_NONE, stream_time = GST_CLOCK_TIME_NONE;
+
+  *out_start = *out_fku = NULL;
+  if (G_LIKELY(!loop->clip_start_pending))
+    return;
+
+  ts = GST_BUFFER_PTS_IS_VALID(buf) ? GST_BUFFER_PTS(buf) : GST_BUFFER_DTS(buf);
+  if (GST_CLOCK_TIME_IS_VALID(ts) && segment->format == GST_FORMAT_TIME) {
+    running_time = gst_segment_to_running_time(segment, GST_FORMAT_TIME, ts);
+    stream_time = gst_segment_to_stream_time(segment, GST_FORMAT_TIME, ts);
+  }
+
+  *out_start = gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                    gst_structure_new("prerecord-clip-start", "clip-id", G_TYPE_UINT, loop->clip_id,
+                                                      "timestamp", G_TYPE_UINT64, ts, "running-time", G_TYPE_UINT64,
+                                                      running_time, "drain-bytes", G_TYPE_UINT64,
+                                                      loop->clip_drain_bytes, NULL));
+  *out_fku = gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                  gst_structure_new("GstForceKeyUnit", "timestamp", G_TYPE_UINT64, ts, "stream-time",
+                                                    G_TYPE_UINT64, stream_time, "running-time", G_TYPE_UINT64,
+                                                    running_time, "all-headers", G_TYPE_BOOLEAN, TRUE, "count",
+                                                    G_TYPE_UINT, loop->clip_id, NULL));
+  loop->clip_start_pending = FALSE;
+  loop->clip_open = TRUE;
+  loop->clip_drain_bytes = 0;
+  GST_CAT_DEBUG_OBJECT(prerec_debug, loop, "Clip %u starts at running-time %" GST_TIME_FORMAT, loop->clip_id,
+                       GST_TIME_ARGS(running_time));
+}
+
+/* Drained clip rebasing (drain-rebase property)
+ *
+ * The first buffer of a clip fixes rebase_offset = drain-base-time minus its
+ * running time. The offset lives in running-time space, so it can be applied
+ * with gst_segment_offset_running_time() to any later SEGMENT of the clip,
+ * whatever its start/base, and running time stays continuous from drain into
+ * pass-through. Re-arm ends the clip and the offset.
+ */
+static void gst_prerec_locked_start_rebase(GstPreRecordLoop* loop, GstBuffer* buf, const GstSegment* segment) {
+  GstClockTime ts = GST_BUFFER_PTS_IS_VALID(buf) ? GST_BUFFER_PTS(buf) : GST_BUFFER_DTS(buf);
+  guint64 abs_rt = 0;
+  gint sign = 0;
+  GstClockTimeDiff running_time;
+
+  loop->rebase_pending = FALSE;
+  if (GST_CLOCK_TIME_IS_VALID(ts) && segment->format == GST_FORMAT_TIME)
+    sign = gst_segment_to_running_time_full(segment, GST_FORMAT_TIME, ts, &abs_rt);
+  if (sign == 0) {
+    GST_CAT_WARNING_OBJECT(prerec_debug, loop, "Cannot rebase clip: first buffer has no running time");
+    return;
+  }
+  running_time = sign > 0 ? (GstClockTimeDiff) abs_rt : -(GstClockTimeDiff) abs_rt;
+  loop->rebase_offset = (gint64) loop->drain_base_time - running_time;
+  loop->rebase_active = TRUE;
+  GST_CAT_DEBUG_OBJECT(prerec_debug, loop, "Rebasing clip: running-time %" GST_STIME_FORMAT " -> %" GST_TIME_FORMAT,
+                       GST_STIME_ARGS(running_time), GST_TIME_ARGS(loop->drain_base_time));
+}
+
+/* Applies the active clip offset to segment in place */
+static void gst_prerec_rebase_segment(GstPreRecordLoop* loop, GstSegment* segment) {
+  if (!loop->rebase_active || segment->format != GST_FORMAT_TIME)
+    return;
+  if (!gst_segment_offset_running_time(segment, GST_FORMAT_TIME, loop->rebase_offset))
+    GST_CAT_WARNING_OBJECT(prerec_debug, loop, "Failed to apply rebase offset %" G_GINT64_FORMAT,
+                           loop->rebase_offset);
+}
+
+static GstEvent* gst_prerec_rebase_segment_event(GstPreRecordLoop* loop, const GstSegment* segment, guint32 seqnum) {
+  GstSegment rebased;
+  GstEvent* event;
+
+  gst_segment_copy_into(segment, &rebased);
+  gst_prerec_rebase_segment(loop, &rebased);
+  event = gst_event_new_segment(&rebased);
+  if (seqnum != GST_SEQNUM_INVALID)
+    gst_event_set_seqnum(event, seqnum);
+  return event;
+}
+
+static GstEvent* gst_prerec_locked_take_clip_end(GstPreRecordLoop* loop) {
+  loop->clip_start_pending = FALSE;
+  loop->clip_end_pending = FALSE;
+  if (!loop->clip_open)
+    return NULL;
+  loop->clip_open = FALSE;
+  GST_CAT_DEBUG_OBJECT(prerec_debug, loop, "Clip %u ends", loop->clip_id);
+  return gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                              gst_structure_new("prerecord-clip-end", "clip-id", G_TYPE_UINT, loop->clip_id, NULL));
+}
+
+/* TRUE if the src pad holds event, or a sticky event of its type equal to it */
+static gboolean gst_prerec_src_holds(GstPreRecordLoop* loop, GstEvent* event) {
+  GstEvent* held;
+  gboolean same = FALSE;
+
+  for (guint idx = 0; !same && (held = gst_pad_get_sticky_event(loop->srcpad, GST_EVENT_TYPE(event), idx)); ++idx) {
+    same = held == event;
+    if (!same) {
+      switch (GST_EVENT_TYPE(event)) {
+      case GST_EVENT_CAPS: {
+        GstCaps *a, *b;
+        gst_event_parse_caps(held, &a);
+        gst_event_parse_caps(event, &b);
+        same = gst_caps_is_equal(a, b);
+        break;
+      }
+      case GST_EVENT_SEGMENT: {
+        const GstSegment *a, *b;
+        gst_event_parse_segment(held, &a);
+        gst_event_parse_segment(event, &b);
+        same = gst_segment_is_equal(a, b);
+        break;
+      }
+      case GST_EVENT_TAG: {
+        GstTagList *a, *b;
+        gst_event_parse_tag(held, &a);
+        gst_event_parse_tag(event, &b);
+        same = gst_tag_list_get_scope(a) == gst_tag_list_get_scope(b) && gst_tag_list_is_equal(a, b);
+        break;
+      }
+      default:
+        break;
+      }
+    }
+    gst_event_unref(held);
+  }
+  return same;
+}
+
+static void gst_prerec_locked_restore_sticky(GstPreRecordLoop* loop, GstEvent* event) {
+  if (!event || gst_prerec_src_holds(loop, event))
+    return;
+  GST_CAT_DEBUG_OBJECT(prerec_dataflow, loop, "Restoring GOP state %" GST_PTR_FORMAT, event);
+  loop->stats.state_restored++;
+  gst_pad_push_event(loop->srcpad, gst_event_ref(event));
+}
+
+/* Before a drained keyframe: push the parts of its GOP's sticky state that
+ * downstream does not hold, in sticky order. *segment follows the snapshot;
+ * *last_segment is the SEGMENT the drain emitted last (owned ref). */
+static void gst_prerec_locked_emit_gop_state(GstPreRecordLoop* loop, GstPreRecGopState* state, GstSegment* segment,
+                                             GstEvent** last_segment) {
+  gst_prerec_locked_restore_sticky(loop, state->caps);
+  if (state->segment && state->segment != *last_segment) {
+    gst_event_replace(last_segment, state->segment);
+    gst_event_copy_segment(state->segment, segment);
+    /* with a rebase pending, the rebased SEGMENT goes out with the keyframe */
+    if (loop->rebase_active) {
+      loop->stats.state_restored++;
+      gst_pad_push_event(loop->srcpad,
+                         gst_prerec_rebase_segment_event(loop, segment, gst_event_get_seqnum(state->segment)));
+    } else if (!loop->rebase_pending) {
+      gst_prerec_locked_restore_sticky(loop, state->segment);
+    }
+  }
+  gst_prerec_locked_restore_sticky(loop, state->global_tags);
+  gst_prerec_locked_restore_sticky(loop, state->tags);
+}
+
+/* QoS thinning of the drain (drain-qos property)
+ *
+ * Draining a long backlog into a synchronised live sink makes every frame
+ * late, and pushing them all only delays the return to live. While such a
+ * drain runs, the src pad keeps the latest QOS report instead of forwarding
+ * it upstream, and the drain skips what downstream would render late anyway:
+ * a late keyframe takes its whole GOP with it, a late delta unit goes alone
+ * if it is droppable, or with the rest of its GOP when downstream is also
+ * slower than real time (proportion >= 1). The newest GOP is never cut since
+ * pass-through continues it. Events are always pushed.
+ */
+static gboolean gst_prerec_locked_qos_late(GstPreRecordLoop* loop, GstBuffer* buf, const GstSegment* segment,
+                                           gdouble* proportion) {
+  GstClockTime ts = GST_BUFFER_PTS_IS_VALID(buf) ? GST_BUFFER_PTS(buf) : GST_BUFFER_DTS(buf);
+  GstClockTime qos_ts, rt;
+  GstClockTimeDiff jitter;
+  GstSegment out_segment;
+
+  g_mutex_lock(&loop->qos_lock);
+  qos_ts = loop->qos_timestamp;
+  jitter = loop->qos_jitter;
+  *proportion = loop->qos_proportion;
+  g_mutex_unlock(&loop->qos_lock);
+  if (!GST_CLOCK_TIME_IS_VALID(qos_ts) || jitter <= 0 || !GST_CLOCK_TIME_IS_VALID(ts))
+    return FALSE;
+
+  /* compare in downstream's running time, i.e. after the clip rebase */
+  gst_segment_copy_into(segment, &out_segment);
+  gst_prerec_rebase_segment(loop, &out_segment);
+  rt = gst_segment_to_running_time(&out_segment, GST_FORMAT_TIME, ts);
+  if (!GST_CLOCK_TIME_IS_VALID(rt))
+    return FALSE;
+  if (GST_BUFFER_DURATION_IS_VALID(buf))
+    rt += GST_BUFFER_DURATION(buf);
+  /* twice the jitter leaves room to catch up, as decoders do */
+  return rt < qos_ts + 2 * jitter;
+}
+
+/* TRUE if the drain should drop qitem's buffer; skip_gop is the GOP being
+ * dropped as a whole (G_MAXUINT for none; 0 is the id of leading delta units) */
+static gboolean gst_prerec_locked_qos_skip(GstPreRecordLoop* loop, GstQueueItem* qitem, const GstSegment* segment,
+                                           guint* skip_gop) {
+  GstBuffer* buf = GST_BUFFER_CAST(qitem->item);
+  gdouble proportion;
+
+  if (qitem->gop_id != *skip_gop) {
+    if (!gst_prerec_locked_qos_late(loop, buf, segment, &proportion))
+      return FALSE;
+    if (qitem->is_keyframe) {
+      if (qitem->gop_id == loop->current_gop_id)
+        return FALSE;
+      *skip_gop = qitem->gop_id;
+      loop->stats.qos_dropped_gops++;
+    } else if (!GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_DROPPABLE)) {
+      if (proportion < 1.0 || qitem->gop_id == loop->current_gop_id)
+        return FALSE;
+      *skip_gop = qitem->gop_id;
+    }
+  }
+  loop->stats.qos_dropped_buffers++;
+  return TRUE;
+}
+
+/* Push every queued item downstream in order (trigger flush and EOS flush).
+ * Called with the lock held; ownership of each dequeued item moves to the
+ * push call as described in gst_prerec_locked_dequeue(). */
+static void gst_prerec_locked_drain(GstPreRecordLoop* loop, const gchar* why) {
+  GstQueueItem qitem; /* stack-allocated (FR-015) */
+  GstSegment segment; /* segment the next drained buffer is timed against */
+  GstEvent* last_segment = NULL;
+  GstEvent* seg_event = gst_pad_get_sticky_event(loop->srcpad, GST_EVENT_SEGMENT, 0);
+  guint64 bytes = loop->cur_level.bytes;
+  gint64 started = g_get_monotonic_time(), elapsed;
+  guint skip_gop = G_MAXUINT; /* GOP dropped for QoS, none yet */
+  guint buffers = 0;
+  GstClockTime pushed;
+  GstFlowReturn fret;
+  gboolean dumped = FALSE; /* flight recorder logged for this drain */
+
+  /* Start from what downstream currently holds; queued SEGMENTs override it */
+  gst_segment_init(&segment, GST_FORMAT_TIME);
+  if (seg_event) {
+    gst_event_copy_segment(seg_event, &segment);
+    gst_event_unref(seg_event);
+  }
+  PREREC_PROBE5(drain_start, loop, why, loop->cur_level.buffers, bytes, loop->cur_level.time);
+  gst_prerec_locked_prefetch_next_gop(loop);
+  g_mutex_lock(&loop->qos_lock);
+  loop->qos_draining = loop->drain_qos;
+  loop->qos_timestamp = GST_CLOCK_TIME_NONE;
+  g_mutex_unlock(&loop->qos_lock);
+
+  while (gst_prerec_locked_dequeue(loop, &qitem)) {
+    if (qitem.item) {
+      if (GST_IS_BUFFER(qitem.item)) {
+        GstBuffer* buf = GST_BUFFER_CAST(qitem.item);
+        if (qitem.is_keyframe)
+          gst_prerec_locked_prefetch_next_gop(loop);
+        if (G_UNLIKELY(loop->drain_qos) && gst_prerec_locked_qos_skip(loop, &qitem, &segment, &skip_gop)) {
+          gst_prerec_gop_state_unref(qitem.state);
+          qitem.state = NULL;
+          PREREC_UNREF(qitem.item, "drain qos");
+          qitem.item = NULL;
+          continue;
+        }
+        if (qitem.state) {
+          gst_prerec_locked_emit_gop_state(loop, qitem.state, &segment, &last_segment);
+          gst_prerec_gop_state_unref(qitem.state);
+          qitem.state = NULL;
+        }
+        if (G_UNLIKELY(loop->rebase_pending)) {
+          gst_prerec_locked_start_rebase(loop, buf, &segment);
+          if (loop->rebase_active)
+            gst_pad_push_event(loop->srcpad, gst_prerec_rebase_segment_event(loop, &segment, GST_SEQNUM_INVALID));
+        }
+        if (G_UNLIKELY(loop->clip_start_pending)) {
+          GstEvent *clip_start, *fku;
+          GstSegment out_segment;
+          gst_segment_copy_into(&segment, &out_segment);
+          gst_prerec_rebase_segment(loop, &out_segment);
+          gst_prerec_locked_take_clip_start(loop, buf, &out_segment, &clip_start, &fku);
+          gst_pad_push_event(loop->srcpad, clip_start);
+          gst_pad_push_event(loop->srcpad, fku);
+        }
+        GST_CAT_LOG_OBJECT(prerec_dataflow, loop, "PUSH(%s) buffer=%p ref=%d", why, buf,
+                           (int) GST_MINI_OBJECT_REFCOUNT_VALUE(buf));
+        prerec_track_push(loop, GST_MINI_OBJECT_CAST(buf), FALSE, why);
+        pushed = gst_util_get_timestamp();
+        if (buffers == 0 && GST_PREREC_TRACER_ACTIVE() && GST_CLOCK_TIME_IS_VALID(loop->trigger_received))
+          gst_prerec_tracer_log_trigger(GST_ELEMENT(loop), why, pushed - loop->trigger_received);
+        fret = gst_pad_push(loop->srcpad, buf); /* consumes ref */
+        gst_prerec_hist_record(&loop->hist_drain_push, gst_util_get_timestamp() - pushed);
+        buffers++;
+        if (G_UNLIKELY(fret < GST_FLOW_EOS) && !dumped) {
+          GST_CAT_WARNING_OBJECT(prerec_dataflow, loop, "drain (%s) push returned %s", why, gst_flow_get_name(fret));
+          gst_prerec_log_flight(loop);
+          dumped = TRUE;
+        }
+      } else if (GST_IS_EVENT(qitem.item)) {
+        GstEvent* ev = GST_EVENT_CAST(qitem.item);
+        if (GST_EVENT_TYPE(ev) == GST_EVENT_SEGMENT) {
+          gst_event_copy_segment(ev, &segment);
+          if (ev == last_segment) {
+            /* already pushed from a GOP snapshot */
+            PREREC_UNREF(ev, "drain segment already restored");
+            qitem.item = NULL;
+            continue;
+          }
+          gst_event_replace(&last_segment, ev);
+          if (G_UNLIKELY(loop->rebase_pending)) {
+            /* Superseded by the rebased SEGMENT pushed with the first buffer */
+            PREREC_UNREF(ev, "drain segment before rebase");
+            qitem.item = NULL;
+            continue;
+          }
+          if (loop->rebase_active) {
+            GstEvent* rebased = gst_prerec_rebase_segment_event(loop, &segment, gst_event_get_seqnum(ev));
+            gst_event_unref(ev);
+            ev = rebased;
+          }
+        }
+        GST_CAT_LOG_OBJECT(prerec_dataflow, loop, "PUSH(%s) event=%p type=%s ref=%d", why, ev,
+                           GST_EVENT_TYPE_NAME(ev), (int) GST_MINI_OBJECT_REFCOUNT_VALUE(ev));
+        prerec_track_push(loop, GST_MINI_OBJECT_CAST(ev), TRUE, why);
+        pushed = gst_util_get_timestamp();
+        gst_pad_push_event(loop->srcpad, ev); /* consumes ref */
+        gst_prerec_hist_record(&loop->hist_drain_push, gst_util_get_timestamp() - pushed);
+      } else {
+        PREREC_UNREF(qitem.item, "drain unknown item");
+      }
+      qitem.item = NULL;
+    }
+  }
+  gst_event_replace(&last_segment, NULL);
+  gst_prerec_locked_journal_trim(loop);
+  gst_prerec_locked_catalog_trim(loop);
+  g_mutex_lock(&loop->qos_lock);
+  loop->qos_draining = FALSE;
+  g_mutex_unlock(&loop->qos_lock);
+
+  elapsed = g_get_monotonic_time() - started;
+  if (bytes > 0 && elapsed > 0) {
+    loop->drain_bytes_per_sec = gst_util_uint64_scale(bytes, G_USEC_PER_SEC, elapsed);
+    loop->drain_duration = elapsed * GST_USECOND;
+  }
+  PREREC_PROBE5(drain_done, loop, why, buffers, bytes, elapsed * GST_USECOND);
+  gst_prerec_flight_record(&loop->flight, GST_PREREC_FLIGHT_DRAIN, loop->current_gop_id, bytes, buffers);
+  if (GST_PREREC_TRACER_ACTIVE())
+    gst_prerec_tracer_log_drain(GST_ELEMENT(loop), why, buffers, bytes, elapsed * GST_USECOND);
+  loop->trigger_received = GST_CLOCK_TIME_NONE;
+  loop->fill_posted = 0;
+  if (loop->post_messages)
+    gst_prerec_locked_queue_message(loop, gst_structure_new("prerec-drain-done", "reason", G_TYPE_STRING, why,
+                                                            "buffers", G_TYPE_UINT, buffers, "bytes", G_TYPE_UINT64,
+                                                            bytes, "duration", G_TYPE_UINT64,
+                                                            (guint64) (elapsed * GST_USECOND), NULL));
+}
+
+/* chain function
+ * this function does the actual processing
+ */
+/* Live request pad
+ *
+ * The "live" pad sees every input buffer and serialized event by reference,
+ * independent of mode, so one element replaces `tee ! queue` in front of a
+ * viewer. Items go through a small queue of their own (live_lock, not the
+ * ring lock) and are pushed by a task on the live pad, so a slow viewer only
+ * ever costs dropped live buffers (live-max-buffers / live-leaky), never a
+ * stalled ingest. Queued events are capped too (LIVE_MAX_EVENTS): past
+ * the cap a sticky event replaces the queued one of its type and other
+ * events are dropped.
+ *
+ * Downstream FLUSHING and NOT_LINKED drop the item. EOS or a fatal flow
+ * pauses the task and nothing is queued until the branch sends RECONFIGURE
+ * (relinked or reconfigured), which replays the sticky events and restarts
+ * the task.
+ */
+static void gst_prerec_live_locked_clear(GstPreRecordLoop* loop) {
+  GstMiniObject* item;
+
+  while ((item = gst_vec_deque_pop_head(loop->live_queue)))
+    gst_mini_object_unref(item);
+  loop->live_level = 0;
+  loop->live_events = 0;
+}
+
+/* Takes a new ref on obj if it is accepted */
+static void gst_prerec_live_locked_offer(GstPreRecordLoop* loop, GstMiniObject* obj) {
+  if (GST_IS_BUFFER(obj)) {
+    if (loop->live_level >= loop->live_max_buffers) {
+      if (loop->live_leaky == GST_PREREC_LIVE_LEAKY_UPSTREAM) {
+        loop->stats.live_drops++;
+        return;
+      }
+      /* drop the oldest queued buffer, keep events in place */
+      for (guint i = 0; i < gst_vec_deque_get_length(loop->live_queue); ++i) {
+        GstMiniObject* old = gst_vec_deque_peek_nth(loop->live_queue, i);
+        if (GST_IS_BUFFER(old)) {
+          gst_vec_deque_drop_element(loop->live_queue, i);
+          gst_mini_object_unref(old);
+          loop->live_level--;
+          loop->stats.live_drops++;
+          break;
+        }
+      }
+    }
+    loop->live_level++;
+  } else if (loop->live_events >= LIVE_MAX_EVENTS) {
+    GstEventType type = GST_EVENT_TYPE(obj);
+    gboolean replaced = FALSE;
+    if (!GST_EVENT_IS_STICKY(obj))
+      return;
+    for (guint i = 0; i < gst_vec_deque_get_length(loop->live_queue) && !replaced; ++i) {
+      GstMiniObject* old = gst_vec_deque_peek_nth(loop->live_queue, i);
+      if (GST_IS_EVENT(old) && GST_EVENT_TYPE(old) == type) {
+        gst_vec_deque_drop_element(loop->live_queue, i);
+        gst_mini_object_unref(old);
+        replaced = TRUE;
+      }
+    }
+    if (!replaced)
+      loop->live_events++;
+  } else {
+    loop->live_events++;
+  }
+  gst_vec_deque_push_tail(loop->live_queue, gst_mini_object_ref(obj));
+  g_cond_signal(&loop->live_cond);
+}
+
+static void gst_prerec_live_offer(GstPreRecordLoop* loop, GstMiniObject* obj) {
+  if (G_LIKELY(g_atomic_pointer_get(&loop->live_pad) == NULL))
+    return;
+  g_mutex_lock(&loop->live_lock);
+  if (loop->live_pad && !loop->live_flushing && !loop->live_paused)
+    gst_prerec_live_locked_offer(loop, obj);
+  g_mutex_unlock(&loop->live_lock);
+}
+
+static void gst_prerec_live_loop(GstPad* pad) {
+  GstPreRecordLoop* loop = GST_PRERECORDLOOP(GST_PAD_PARENT(pad));
+  GstMiniObject* item;
+
+  g_mutex_lock(&loop->live_lock);
+  while (!loop->live_flushing && gst_vec_deque_is_empty(loop->live_queue))
+    g_cond_wait(&loop->live_cond, &loop->live_lock);
+  if (loop->live_flushing) {
+    g_mutex_unlock(&loop->live_lock);
+    gst_pad_pause_task(pad);
+    return;
+  }
+  item = gst_vec_deque_pop_head(loop->live_queue);
+  if (GST_IS_BUFFER(item))
+    loop->live_level--;
+  else
+    loop->live_events--;
+  g_mutex_unlock(&loop->live_lock);
+
+  if (GST_IS_BUFFER(item)) {
+    GstFlowReturn ret = gst_pad_push(pad, GST_BUFFER_CAST(item));
+    /* the viewer branch may be flushing, unlinked or being replaced */
+    if (ret == GST_FLOW_OK || ret == GST_FLOW_NOT_LINKED || ret == GST_FLOW_FLUSHING)
+      return;
+    GST_CAT_DEBUG_OBJECT(prerec_dataflow, loop, "pausing live task, push returned %s", gst_flow_get_name(ret));
+    if (ret < GST_FLOW_EOS) {
+      GST_ELEMENT_FLOW_ERROR(loop, ret);
+      gst_pad_push_event(pad, gst_event_new_eos());
+    }
+    /* paused under live_lock so a RECONFIGURE cannot restart the task first */
+    g_mutex_lock(&loop->live_lock);
+    loop->live_paused = TRUE;
+    gst_prerec_live_locked_clear(loop);
+    gst_pad_pause_task(pad);
+    g_mutex_unlock(&loop->live_lock);
+  } else {
+    gst_pad_push_event(pad, GST_EVENT_CAST(item));
+  }
+}
+
+static gboolean gst_prerec_live_copy_sticky(GstPad* pad, GstEvent** event, gpointer user_data);
+
+/* RECONFIGURE from the viewer branch resumes a task paused on EOS or a
+ * fatal flow, starting over from the current sticky events */
+static gboolean gst_prerec_live_src_event(GstPad* pad, GstObject* parent, GstEvent* event) {
+  GstPreRecordLoop* loop = GST_PRERECORDLOOP(parent);
+
+  if (GST_EVENT_TYPE(event) == GST_EVENT_RECONFIGURE) {
+    gboolean resume;
+    g_mutex_lock(&loop->live_lock);
+    resume = loop->live_paused && !loop->live_flushing;
+    if (resume) {
+      loop->live_paused = FALSE;
+      gst_pad_sticky_events_foreach(loop->sinkpad, gst_prerec_live_copy_sticky, loop);
+    }
+    g_mutex_unlock(&loop->live_lock);
+    if (resume) {
+      GST_CAT_DEBUG_OBJECT(prerec_dataflow, loop, "live branch reconfigured, resuming");
+      gst_pad_start_task(pad, (GstTaskFunction) gst_prerec_live_loop, pad, NULL);
+    }
+  }
+  return gst_pad_event_default(pad, parent, event);
+}
+
+static gboolean gst_prerec_live_activate_mode(GstPad* pad, GstObject* parent, GstPadMode mode, gboolean active) {
+  GstPreRecordLoop* loop = GST_PRERECORDLOOP(parent);
+  gboolean result;
+
+  if (mode != GST_PAD_MODE_PUSH)
+    return FALSE;
+
+  g_mutex_lock(&loop->live_lock);
+  loop->live_flushing = !active;
+  loop->live_paused = FALSE;
+  g_cond_signal(&loop->live_cond);
+  g_mutex_unlock(&loop->live_lock);
+
+  if (active)
+    return gst_pad_start_task(pad, (GstTaskFunction) gst_prerec_live_loop, pad, NULL);
+
+  result = gst_pad_stop_task(pad);
+  g_mutex_lock(&loop->live_lock);
+  gst_prerec_live_locked_clear(loop);
+  g_mutex_unlock(&loop->live_lock);
+  return result;
+}
+
+/* FLUSH_START/FLUSH_STOP from upstream also flush the live branch */
+static void gst_prerec_live_flush(GstPreRecordLoop* loop, GstEvent* event) {
+  gboolean start = GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_START;
+  GstPad* live = NULL;
+
+  g_mutex_lock(&loop->live_lock);
+  if (loop->live_pad)
+    live = gst_object_ref(loop->live_pad);
+  if (start) {
+    loop->live_flushing = TRUE;
+    gst_prerec_live_locked_clear(loop);
+    g_cond_signal(&loop->live_cond);
+  }
+  g_mutex_unlock(&loop->live_lock);
+  if (!live)
+    return;
+
+  gst_pad_push_event(live, gst_event_ref(event));
+  if (start) {
+    gst_pad_pause_task(live);
+  } else if (GST_PAD_IS_ACTIVE(live)) {
+    g_mutex_lock(&loop->live_lock);
+    loop->live_flushing = FALSE;
+    loop->live_paused = FALSE;
+    g_mutex_unlock(&loop->live_lock);
+    gst_pad_start_task(live, (GstTaskFunction) gst_prerec_live_loop, live, NULL);
+  }
+  gst_object_unref(live);
+}
+
+/* Mirrors a sink pad event onto the live pad; the trigger stays internal */
+static void gst_prerec_live_sink_event(GstPreRecordLoop* loop, GstEvent* event) {
+  if (G_LIKELY(g_atomic_pointer_get(&loop->live_pad) == NULL))
+    return;
+
+  switch (GST_EVENT_TYPE(event)) {
+  case GST_EVENT_FLUSH_START:
+  case GST_EVENT_FLUSH_STOP:
+    gst_prerec_live_flush(loop, event);
+    break;
+  case GST_EVENT_CUSTOM_DOWNSTREAM: {
+    const GstStructure* structure = gst_event_get_structure(event);
+    const gchar* trigger = loop->flush_trigger_name ? loop->flush_trigger_name : "prerecord-flush";
+    if (structure && gst_structure_has_name(structure, trigger))
+      break;
+    gst_prerec_live_offer(loop, GST_MINI_OBJECT_CAST(event));
+    break;
+  }
+  default:
+    if (GST_EVENT_IS_SERIALIZED(event))
+      gst_prerec_live_offer(loop, GST_MINI_OBJECT_CAST(event));
+    break;
+  }
+}
+
+static gboolean gst_prerec_live_copy_sticky(GstPad* pad, GstEvent** event, gpointer user_data) {
+  gst_prerec_live_locked_offer(GST_PRERECORDLOOP(user_data), GST_MINI_OBJECT_CAST(*event));
+  return TRUE;
+}
+
+static GstPad* gst_pre_record_loop_request_new_pad(GstElement* element, GstPadTemplate* templ, const gchar* name,
+                                                   const GstCaps* caps) {
+  GstPreRecordLoop* loop = GST_PRERECORDLOOP(element);
+  GstPad* pad;
+
+  g_mutex_lock(&loop->live_lock);
+  if (loop->live_pad) {
+    g_mutex_unlock(&loop->live_lock);
+    GST_CAT_WARNING_OBJECT(prerec_debug, loop, "live pad already requested");
+    return NULL;
+  }
+  pad = gst_pad_new_from_template(templ, "live");
+  gst_pad_set_activatemode_function(pad, gst_prerec_live_activate_mode);
+  gst_pad_set_event_function(pad, gst_prerec_live_src_event);
+  gst_pad_use_fixed_caps(pad);
+  /* replay stream-start/caps/segment so the viewer can start mid-stream */
+  gst_pad_sticky_events_foreach(loop->sinkpad, gst_prerec_live_copy_sticky, loop);
+  g_atomic_pointer_set(&loop->live_pad, pad);
+  g_mutex_unlock(&loop->live_lock);
+
+  if (GST_PAD_IS_ACTIVE(loop->srcpad))
+    gst_pad_set_active(pad, TRUE);
+  gst_element_add_pad(element, pad);
+  GST_CAT_INFO_OBJECT(prerec_debug, loop, "live pad requested");
+  return pad;
+}
+
+static void gst_pre_record_loop_release_pad(GstElement* element, GstPad* pad) {
+  GstPreRecordLoop* loop = GST_PRERECORDLOOP(element);
+
+  g_mutex_lock(&loop->live_lock);
+  if (pad != loop->live_pad) {
+    g_mutex_unlock(&loop->live_lock);
+    return;
+  }
+  g_atomic_pointer_set(&loop->live_pad, NULL);
+  g_mutex_unlock(&loop->live_lock);
+
+  gst_pad_set_active(pad, FALSE);
+  gst_element_remove_pad(element, pad);
+  GST_CAT_INFO_OBJECT(prerec_debug, loop, "live pad released");
+}
+
+/* Sink-side default forwarding (events, queries) targets the gated src pad
+ * only; the live pad is fed through its own queue. */
+static GstIterator* gst_pre_record_loop_sink_iterate_internal_links(GstPad* pad, GstObject* parent) {
+  GstPreRecordLoop* loop = GST_PRERECORDLOOP(parent);
+  GValue val = G_VALUE_INIT;
+  GstIterator* it;
+
+  g_value_init(&val, GST_TYPE_PAD);
+  g_value_set_object(&val, loop->srcpad);
+  it = gst_iterator_new_single(GST_TYPE_PAD, &val);
+  g_value_unset(&val);
+  return it;
+}
+
+static GstFlowReturn gst_pre_record_loop_chain(GstPad* pad, GstObject* parent, GstBuffer* buffer) {
+  GstPreRecordLoop* loop = GST_PREREC_CAST(parent);
+  GstClockTime duration, timestamp;
+  GstPreRecSpill* handoff = NULL;
+  gboolean handoff_copied = FALSE;
+  guint64 handoff_offset;
+
+  gst_prerec_live_offer(loop, GST_MINI_OBJECT_CAST(buffer));
+
+  GST_PREREC_MUTEX_LOCK_CHECK(loop, out_flushing);
+  if (loop->handoff && loop->mode == GST_PREREC_MODE_BUFFERING)
+    handoff = gst_prerec_spill_ref(loop->handoff);
+  GST_PREREC_MUTEX_UNLOCK(loop);
+
+  /* Payloads upstream allocated from handoff_allocator are in the memfd
+   * already; others are copied in, without the lock. mode was only a hint:
+   * a buffer copied just as a trigger lands is simply pushed from the arena. */
+  if (handoff) {
+    if (!gst_prerec_spill_locate(handoff, buffer, &handoff_offset)) {
+      GstBuffer* stored = gst_prerec_spill_store(handoff, buffer);
+      if (stored) {
+        gst_buffer_unref(buffer);
+        buffer = stored;
+        handoff_copied = TRUE;
+      }
+    }
+    gst_prerec_spill_unref(handoff);
+  }
+
+  GST_PREREC_MUTEX_LOCK_CHECK(loop, out_flushing);
+  if (handoff_copied)
+    loop->stats.handoff_copied++;
+  PREREC_PROBE5(chain, loop, GST_BUFFER_PTS(buffer), GST_BUFFER_DURATION(buffer),
+                !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT), loop->mode);
+
+  if (G_UNLIKELY(loop->clip_end_pending)) {
+    /* Re-armed since the last buffer: close the clip behind the last
+     * pass-through buffer, on the streaming thread so ordering holds. */
+    GstEvent* clip_end = gst_prerec_locked_take_clip_end(loop);
+    GST_PREREC_MUTEX_UNLOCK(loop);
+    if (clip_end)
+      gst_pad_push_event(loop->srcpad, clip_end);
+    GST_PREREC_MUTEX_LOCK_CHECK(loop, out_flushing);
+  }
+
+  if (loop->eos) {
+    GST_CAT_INFO(prerec_debug, "Going to EOS");
+    goto out_eos;
   }
   if (loop->unexpected) {
     GST_CAT_INFO(prerec_debug, "Going to EOS(Unexpected)");
@@ -1059,9 +3863,36 @@ static GstFlowReturn gst_pre_record_loop_chain(GstPad* pad, GstObject* parent, G
   case GST_PREREC_MODE_PASS_THROUGH: {
     /* True pass-through: forward buffer immediately without queuing. */
     GstFlowReturn fret;
+    GstEvent *clip_start = NULL, *fku = NULL;
     GST_CAT_LOG_OBJECT(prerec_dataflow, loop, "Pass-through mode - pushing buffer directly");
-    GST_PREREC_MUTEX_UNLOCK(loop);             /* release lock before downstream push */
+    GstEvent* rebased = NULL;
+    if (G_UNLIKELY(loop->clip_start_pending || loop->rebase_pending)) {
+      /* Trigger arrived with an empty ring: this buffer opens the clip. */
+      GstSegment segment;
+      GstEvent* seg_event = gst_pad_get_sticky_event(loop->sinkpad, GST_EVENT_SEGMENT, 0);
+      gst_segment_init(&segment, GST_FORMAT_TIME);
+      if (seg_event) {
+        gst_event_copy_segment(seg_event, &segment);
+        gst_event_unref(seg_event);
+      }
+      if (loop->rebase_pending) {
+        gst_prerec_locked_start_rebase(loop, buffer, &segment);
+        if (loop->rebase_active)
+          rebased = gst_prerec_rebase_segment_event(loop, &segment, GST_SEQNUM_INVALID);
+      }
+      gst_prerec_rebase_segment(loop, &segment);
+      gst_prerec_locked_take_clip_start(loop, buffer, &segment, &clip_start, &fku);
+    }
+    GST_PREREC_MUTEX_UNLOCK(loop); /* release lock before downstream push */
+    if (rebased)
+      gst_pad_push_event(loop->srcpad, rebased);
+    if (clip_start) {
+      gst_pad_push_event(loop->srcpad, clip_start);
+      gst_pad_push_event(loop->srcpad, fku);
+    }
     fret = gst_pad_push(loop->srcpad, buffer); /* consumes buffer ref */
+    if (G_UNLIKELY(fret < GST_FLOW_EOS))
+      gst_prerec_log_flight(loop);
     return fret;
   }
 
@@ -1070,25 +3901,17 @@ static GstFlowReturn gst_pre_record_loop_chain(GstPad* pad, GstObject* parent, G
 
     // Add buffer to ring buffer
     gst_prerec_locked_enqueue_buffer(loop, buffer);
+    gst_prerec_locked_check_fill(loop);
 
-    // Check if buffer is full and drop old GOPs if needed while staying above 2-GOP floor
-    while (gst_prerec_should_prune(loop)) {
-      guint before = gst_prerec_queued_gops(loop);
-      GST_CAT_LOG_OBJECT(prerec_debug, loop, "Prune loop start: queued_gops=%u", before);
-      gst_prerec_locked_drop(loop);
-      guint after = gst_prerec_queued_gops(loop);
-      GST_CAT_LOG_OBJECT(prerec_debug, loop, "Prune loop end: queued_gops=%u", after);
-      if (after <= 2)
-        break; /* safety net */
-      if (after >= before)
-        break; /* no progress safeguard */
-    }
-
-    /* Update live stats snapshot after enqueue/prune */
-    loop->stats.queued_buffers_cur = loop->cur_level.buffers;
-    loop->stats.queued_gops_cur = gst_prerec_queued_gops(loop);
+    // Drop old GOPs if the retention limits are exceeded (updates the stats)
+    gst_prerec_locked_prune(loop);
+    if (GST_PREREC_TRACER_ACTIVE())
+      gst_prerec_tracer_log_level(GST_ELEMENT(loop), loop->stats.queued_gops_cur, loop->cur_level.buffers,
+                                  loop->cur_level.bytes, loop->cur_level.time);
+    gst_prerec_locked_publish_stats(loop);
 
     GST_PREREC_MUTEX_UNLOCK(loop);
+    gst_prerec_post_messages(loop);
     return GST_FLOW_OK;
     break;
 
@@ -1118,8 +3941,11 @@ static gboolean gst_pre_record_loop_sink_event(GstPad* pad, GstObject* parent, G
   loop = GST_PRERECORDLOOP(parent);
   GST_LOG_OBJECT(loop, "Received %s event: %" GST_PTR_FORMAT, GST_EVENT_TYPE_NAME(event), event);
 
+  gst_prerec_live_sink_event(loop, event);
+
   switch (GST_EVENT_TYPE(event)) {
-  case GST_EVENT_EOS:
+  case GST_EVENT_EOS: {
+    GstClockTime received = gst_util_get_timestamp();
     GST_PREREC_MUTEX_LOCK(loop);
     /* FR-023: AUTO policy flushes remaining buffered data only if already in PASS_THROUGH;
      * otherwise buffered data is discarded and EOS forwarded.
@@ -1128,31 +3954,24 @@ static gboolean gst_pre_record_loop_sink_event(GstPad* pad, GstObject* parent, G
     gboolean should_drain =
         (loop->flush_on_eos == GST_PREREC_FLUSH_ON_EOS_ALWAYS ||
          (loop->flush_on_eos == GST_PREREC_FLUSH_ON_EOS_AUTO && loop->mode == GST_PREREC_MODE_PASS_THROUGH));
+    PREREC_PROBE4(eos, loop, should_drain, loop->cur_level.buffers, loop->cur_level.bytes);
+    gst_prerec_flight_record(&loop->flight, GST_PREREC_FLIGHT_EOS, loop->current_gop_id, should_drain,
+                             loop->cur_level.buffers);
 
     if (should_drain) {
       GST_CAT_LOG_OBJECT(prerec_dataflow, loop, "EOS: draining queue (policy=%d mode=%d)", loop->flush_on_eos,
                          loop->mode);
-      GstQueueItem qitem; /* stack-allocated (FR-015) */
-      while (gst_prerec_locked_dequeue(loop, &qitem)) {
-        if (qitem.item) {
-          if (GST_IS_BUFFER(qitem.item)) {
-            GstBuffer* buf = GST_BUFFER_CAST(qitem.item);
-            GST_CAT_LOG_OBJECT(prerec_dataflow, loop, "PUSH(EOS flush) buffer=%p ref=%d", buf,
-                               (int) GST_MINI_OBJECT_REFCOUNT_VALUE(buf));
-            prerec_track_push(loop, GST_MINI_OBJECT_CAST(buf), FALSE, "eos-flush");
-            gst_pad_push(loop->srcpad, buf); /* consumes ref */
-          } else if (GST_IS_EVENT(qitem.item)) {
-            GstEvent* ev = GST_EVENT_CAST(qitem.item);
-            GST_CAT_LOG_OBJECT(prerec_dataflow, loop, "PUSH(EOS flush) event=%p type=%s ref=%d", ev,
-                               GST_EVENT_TYPE_NAME(ev), (int) GST_MINI_OBJECT_REFCOUNT_VALUE(ev));
-            prerec_track_push(loop, GST_MINI_OBJECT_CAST(ev), TRUE, "eos-flush");
-            gst_pad_push_event(loop->srcpad, ev); /* consumes ref */
-          } else {
-            PREREC_UNREF(qitem.item, "eos flush unknown item");
-          }
-          qitem.item = NULL;
-        }
+      loop->trigger_received = received;
+      if (loop->clip_events && loop->mode == GST_PREREC_MODE_BUFFERING && !gst_vec_deque_is_empty(loop->queue)) {
+        /* the buffered window is a clip of its own, like a trigger drain */
+        GstEvent* clip_end = gst_prerec_locked_take_clip_end(loop);
+        if (clip_end)
+          gst_pad_push_event(loop->srcpad, clip_end);
+        loop->clip_id++;
+        loop->clip_start_pending = TRUE;
+        loop->clip_drain_bytes = loop->cur_level.bytes;
       }
+      gst_prerec_locked_drain(loop, "eos-flush");
       /* Reset GOP tracking after draining queue completely */
       loop->current_gop_id = loop->last_gop_id = 0;
       /* Update stats to reflect empty queue */
@@ -1161,17 +3980,17 @@ static gboolean gst_pre_record_loop_sink_event(GstPad* pad, GstObject* parent, G
     } else if (!gst_vec_deque_is_empty(loop->queue)) {
       GST_CAT_LOG_OBJECT(prerec_dataflow, loop, "EOS: discarding queue (policy=%d mode=%d)", loop->flush_on_eos,
                          loop->mode);
-      gst_prerec_locked_flush(loop, TRUE);
-      /* GOP IDs already reset by gst_prerec_locked_flush with full=TRUE via segment reset,
-       * but explicitly reset here for clarity */
-      loop->current_gop_id = loop->last_gop_id = 0;
-      /* Update stats to reflect empty queue */
-      loop->stats.queued_gops_cur = 0;
-      loop->stats.queued_buffers_cur = 0;
+      gst_prerec_locked_discard(loop);
     }
+    gst_prerec_locked_publish_stats(loop);
+    GstEvent* clip_end = gst_prerec_locked_take_clip_end(loop);
     GST_PREREC_MUTEX_UNLOCK(loop);
+    gst_prerec_post_messages(loop);
+    if (clip_end)
+      gst_pad_push_event(loop->srcpad, clip_end);
     gst_pad_push_event(loop->srcpad, event);
     break;
+  }
 
   case GST_EVENT_CAPS: {
     GstCaps* caps;
@@ -1184,6 +4003,12 @@ static gboolean gst_pre_record_loop_sink_event(GstPad* pad, GstObject* parent, G
       GST_LOG_OBJECT(loop, "Media Type: %s", media_type);
       GST_INFO_OBJECT(loop, "Received caps: %" GST_PTR_FORMAT, caps);
     }
+    GST_PREREC_MUTEX_LOCK(loop);
+    gst_caps_replace(&loop->caps, caps);
+    gst_prerec_locked_note_sticky(loop, event);
+    gst_prerec_locked_adopt_parked(loop, caps);
+    gst_prerec_locked_journal_recover(loop, caps);
+    GST_PREREC_MUTEX_UNLOCK(loop);
     /* Forward CAPS to src pad (FR-012: sticky event propagation) */
     ret = gst_pad_push_event(loop->srcpad, event);
     break;
@@ -1195,19 +4020,12 @@ static gboolean gst_pre_record_loop_sink_event(GstPad* pad, GstObject* parent, G
                         loop->mode == GST_PREREC_MODE_BUFFERING ? "BUFFERING" : "PASS_THROUGH");
     GST_PREREC_MUTEX_LOCK(loop);
 
-    /* Clear queue - buffered frames become invalid after seek */
-    gst_prerec_locked_flush(loop, TRUE);
-
-    /* Reset GOP tracking */
-    loop->current_gop_id = 0;
-    loop->last_gop_id = 0;
-
-    /* Reset stats counters for queue state */
-    loop->stats.queued_gops_cur = 0;
-    loop->stats.queued_buffers_cur = 0;
+    /* Clear queue and GOP tracking - buffered frames become invalid after seek */
+    gst_prerec_locked_discard(loop);
 
     /* Set srcresult to FLUSHING to stop any pending operations */
     loop->srcresult = GST_FLOW_FLUSHING;
+    gst_prerec_locked_publish_stats(loop);
 
     GST_PREREC_MUTEX_UNLOCK(loop);
 
@@ -1252,31 +4070,27 @@ static gboolean gst_pre_record_loop_sink_event(GstPad* pad, GstObject* parent, G
     const gchar* expected = loop->flush_trigger_name ? loop->flush_trigger_name : "prerecord-flush";
     if (structure && gst_structure_has_name(structure, expected)) {
       GST_CAT_INFO_OBJECT(prerec_debug, loop, "Received flush trigger '%s'", expected);
+      GstClockTime received = gst_util_get_timestamp();
       GST_PREREC_MUTEX_LOCK(loop);
       if (loop->mode == GST_PREREC_MODE_BUFFERING) {
+        loop->trigger_received = received;
         /* Increment flush counter (T026) */
         loop->stats.flush_count++;
-        GstQueueItem qitem; /* stack-allocated (FR-015) */
-        while (gst_prerec_locked_dequeue(loop, &qitem)) {
-          if (qitem.item) {
-            if (GST_IS_BUFFER(qitem.item)) {
-              GstBuffer* buf = GST_BUFFER_CAST(qitem.item);
-              GST_CAT_LOG_OBJECT(prerec_dataflow, loop, "PUSH(trigger flush) buffer=%p ref=%d", buf,
-                                 (int) GST_MINI_OBJECT_REFCOUNT_VALUE(buf));
-              prerec_track_push(loop, GST_MINI_OBJECT_CAST(buf), FALSE, "trigger-flush");
-              gst_pad_push(loop->srcpad, buf);
-            } else if (GST_IS_EVENT(qitem.item)) {
-              GstEvent* ev = GST_EVENT_CAST(qitem.item);
-              GST_CAT_LOG_OBJECT(prerec_dataflow, loop, "PUSH(trigger flush) event=%p type=%s ref=%d", ev,
-                                 GST_EVENT_TYPE_NAME(ev), (int) GST_MINI_OBJECT_REFCOUNT_VALUE(ev));
-              prerec_track_push(loop, GST_MINI_OBJECT_CAST(ev), TRUE, "trigger-flush");
-              gst_pad_push_event(loop->srcpad, ev);
-            } else {
-              PREREC_UNREF(qitem.item, "trigger flush unknown item");
-            }
-            qitem.item = NULL;
-          }
+        gst_prerec_flight_record(&loop->flight, GST_PREREC_FLIGHT_TRIGGER, loop->current_gop_id,
+                                 loop->cur_level.bytes, loop->cur_level.buffers);
+        if (loop->clip_events) {
+          GstEvent* clip_end = gst_prerec_locked_take_clip_end(loop);
+          if (clip_end)
+            gst_pad_push_event(loop->srcpad, clip_end);
+          loop->clip_id++;
+          loop->clip_start_pending = TRUE;
+          loop->clip_drain_bytes = loop->cur_level.bytes;
         }
+        loop->rebase_pending = loop->drain_rebase;
+        loop->rebase_active = FALSE;
+        if (loop->handoff)
+          gst_prerec_locked_handoff(loop);
+        gst_prerec_locked_drain(loop, "trigger-flush");
         loop->mode = GST_PREREC_MODE_PASS_THROUGH; /* marks drain complete and future triggers ignored */
         /* T027: Log state transition with stats snapshot */
         GST_CAT_INFO_OBJECT(prerec_debug, loop,
@@ -1294,17 +4108,27 @@ static gboolean gst_pre_record_loop_sink_event(GstPad* pad, GstObject* parent, G
                           loop->stats.flush_count, loop->stats.queued_gops_cur, loop->stats.queued_buffers_cur);
         }
         GST_CAT_INFO_OBJECT(prerec_debug, loop, "Switched to passthrough mode after trigger");
+        gst_prerec_locked_note_mode(loop);
+        gst_prerec_locked_publish_stats(loop);
       }
       GST_PREREC_MUTEX_UNLOCK(loop);
+      gst_prerec_post_messages(loop);
       gst_event_unref(event);
       ret = TRUE;
     } else {
-      ret = gst_pad_event_default(pad, parent, event);
+      gboolean queued;
+      GST_PREREC_MUTEX_LOCK(loop);
+      queued = loop->mode == GST_PREREC_MODE_BUFFERING && gst_prerec_locked_queue_event(loop, event);
+      GST_PREREC_MUTEX_UNLOCK(loop);
+      ret = queued || gst_pad_event_default(pad, parent, event);
     }
     break;
   }
-  default:
+  default: {
+    gboolean queued = FALSE;
     GST_PREREC_MUTEX_LOCK(loop);
+    if (GST_EVENT_IS_STICKY(event))
+      gst_prerec_locked_note_sticky(loop, event);
     if (GST_EVENT_IS_SERIALIZED(event)) {
       if (event->type == GST_EVENT_SEGMENT || event->type == GST_EVENT_GAP) {
         /* T034b: Only queue SEGMENT/GAP events in BUFFERING mode.
@@ -1327,17 +4151,34 @@ static gboolean gst_pre_record_loop_sink_event(GstPad* pad, GstObject* parent, G
         } else {
           GST_CAT_LOG_OBJECT(prerec_dataflow, loop, "Skipping queue for %s event in PASS_THROUGH mode",
                              GST_EVENT_TYPE_NAME(event));
+          if (event->type == GST_EVENT_SEGMENT && loop->rebase_active) {
+            /* Keep post-roll running time continuous with the rebased drain */
+            GstSegment segment;
+            gst_event_copy_segment(event, &segment);
+            GstEvent* rebased = gst_prerec_rebase_segment_event(loop, &segment, gst_event_get_seqnum(event));
+            gst_event_unref(event);
+            event = rebased;
+          }
         }
+      } else if (loop->mode == GST_PREREC_MODE_BUFFERING && gst_prerec_locked_queue_event(loop, event)) {
+        GST_CAT_LOG_OBJECT(prerec_dataflow, loop, "Queued %s event in order with the data",
+                           GST_EVENT_TYPE_NAME(event));
+        queued = TRUE;
       } else if (GST_EVENT_IS_STICKY(event)) {
         /* Observe only; default handler performs sticky storage. */
         prerec_track_sticky(loop, event, "observe-serialized-sticky");
       }
     }
     GST_PREREC_MUTEX_UNLOCK(loop);
-    GST_INFO_OBJECT(parent, "%s Sending to Default Handler", GST_EVENT_TYPE_NAME(event));
+    if (queued) {
+      ret = TRUE;
+      break;
+    }
+    GST_CAT_LOG_OBJECT(prerec_dataflow, loop, "%s Sending to Default Handler", GST_EVENT_TYPE_NAME(event));
     ret = gst_pad_event_default(pad, parent, event);
     break;
   }
+  }
   return ret;
 }
 
@@ -1364,12 +4205,19 @@ static gboolean gst_pre_record_loop_src_event(GstPad* pad, GstObject* parent, Gs
       if (loop->mode == GST_PREREC_MODE_PASS_THROUGH) {
         /* Increment rearm counter (T026) */
         loop->stats.rearm_count++;
+        PREREC_PROBE2(arm, loop, loop->stats.rearm_count);
+        gst_prerec_flight_record(&loop->flight, GST_PREREC_FLIGHT_ARM, 0, loop->stats.rearm_count, 0);
         loop->mode = GST_PREREC_MODE_BUFFERING;
+        /* Close the clip on the streaming thread, behind the last pass-through buffer */
+        loop->clip_end_pending = loop->clip_open;
+        loop->rebase_pending = loop->rebase_active = FALSE;
         loop->current_gop_id = 0;
         loop->last_gop_id = 0;
+        g_array_set_size(loop->gop_catalog, 0);
         loop->cur_level.time = 0;
         loop->cur_level.buffers = 0;
         loop->cur_level.bytes = 0;
+        loop->cur_level.events = 0;
         gst_segment_init(&loop->sink_segment, GST_FORMAT_TIME);
         gst_segment_init(&loop->src_segment, GST_FORMAT_TIME);
         loop->sinktime = loop->srctime = GST_CLOCK_STIME_NONE;
@@ -1383,33 +4231,294 @@ static gboolean gst_pre_record_loop_src_event(GstPad* pad, GstObject* parent, Gs
                             loop->stats.drops_gops, loop->stats.drops_buffers, loop->stats.drops_events,
                             loop->stats.flush_count, loop->stats.rearm_count);
 
-        /* T038: Optional metric logging for production monitoring */
-        if (G_UNLIKELY(prerec_metrics_are_enabled())) {
-          GST_INFO_OBJECT(loop,
-                          "[METRIC] Mode transition: PASS_THROUGH -> BUFFERING "
-                          "rearm_count=%u gop_baseline_reset=TRUE",
-                          loop->stats.rearm_count);
-        }
-        GST_CAT_INFO_OBJECT(prerec_debug, loop, "Received prerecord-arm: re-entering BUFFERING mode");
-      } else {
-        GST_CAT_INFO_OBJECT(prerec_debug, loop, "Received prerecord-arm while already BUFFERING - ignoring");
-      }
-      GST_PREREC_MUTEX_UNLOCK(loop);
-      gst_event_unref(event);
-      return TRUE; /* consumed */
-    }
-    /* Not our custom upstream event: fall through to default handler */
-    return gst_pad_event_default(pad, parent, event);
+        /* T038: Optional metric logging for production monitoring */
+        if (G_UNLIKELY(prerec_metrics_are_enabled())) {
+          GST_INFO_OBJECT(loop,
+                          "[METRIC] Mode transition: PASS_THROUGH -> BUFFERING "
+                          "rearm_count=%u gop_baseline_reset=TRUE",
+                          loop->stats.rearm_count);
+        }
+        GST_CAT_INFO_OBJECT(prerec_debug, loop, "Received prerecord-arm: re-entering BUFFERING mode");
+        gst_prerec_locked_note_mode(loop);
+        gst_prerec_locked_publish_stats(loop);
+      } else {
+        GST_CAT_INFO_OBJECT(prerec_debug, loop, "Received prerecord-arm while already BUFFERING - ignoring");
+      }
+      GST_PREREC_MUTEX_UNLOCK(loop);
+      gst_prerec_post_messages(loop);
+      gst_event_unref(event);
+      return TRUE; /* consumed */
+    }
+    if (st && gst_structure_has_name(st, "prerecord-discard")) {
+      GST_PREREC_MUTEX_LOCK(loop);
+      GST_CAT_INFO_OBJECT(prerec_debug, loop, "Received prerecord-discard: dropping %u buffered buffers",
+                          loop->cur_level.buffers);
+      gst_prerec_locked_discard(loop);
+      GST_PREREC_MUTEX_UNLOCK(loop);
+      gst_event_unref(event);
+      return TRUE; /* consumed */
+    }
+    /* Not our custom upstream event: fall through to default handler */
+    return gst_pad_event_default(pad, parent, event);
+  }
+  case GST_EVENT_QOS: {
+    gboolean ours;
+    gdouble proportion;
+    GstClockTimeDiff diff;
+    GstClockTime timestamp;
+
+    /* may arrive from within a drain push: qos_lock only, never the ring lock */
+    gst_event_parse_qos(event, NULL, &proportion, &diff, &timestamp);
+    g_mutex_lock(&loop->qos_lock);
+    ours = loop->qos_draining;
+    if (ours) {
+      loop->qos_proportion = proportion;
+      loop->qos_jitter = diff;
+      loop->qos_timestamp = timestamp;
+    }
+    g_mutex_unlock(&loop->qos_lock);
+    if (ours) {
+      /* it rates the backlog, not what upstream is producing now */
+      gst_event_unref(event);
+      return TRUE;
+    }
+    return gst_pad_event_default(pad, parent, event);
+  }
+  default:
+    return gst_pad_event_default(pad, parent, event);
+  }
+}
+
+/* Standard queries answered from the ring
+ *
+ * BUFFERING: percent is the time level against max-time (100 once anything
+ * is held when unlimited), busy while the ring is still filling. The stats
+ * give the ingest byte rate over the buffered window, the throughput of the
+ * last drain and the time left until the window is full; the range is the
+ * buffered running-time span (bytes for BYTES queries) with the estimated
+ * drain time of the current content, in ms, as estimated-total.
+ *
+ * LATENCY: upstream's figures plus ours. The minimum is unchanged since
+ * pass-through data is never held; the maximum grows by max-time, which the
+ * ring can hold back, and by the last drain duration, which a frame arriving
+ * during a drain waits behind.
+ */
+static gboolean gst_prerec_query_buffering(GstPreRecordLoop* loop, GstQuery* query) {
+  GstFormat format;
+  gboolean busy;
+  gint percent, avg_in = 0, avg_out;
+  gint64 start, stop, drain_ms = -1, left_ms = 0;
+
+  gst_query_parse_buffering_range(query, &format, NULL, NULL, NULL);
+  GST_PREREC_MUTEX_LOCK(loop);
+  if (loop->max_size.time > 0)
+    percent = (gint) MIN(100, loop->cur_level.time * 100 / loop->max_size.time);
+  else
+    percent = loop->cur_level.buffers > 0 ? 100 : 0;
+  busy = loop->mode == GST_PREREC_MODE_BUFFERING && percent < 100;
+  if (loop->cur_level.time > 0)
+    avg_in = (gint) MIN(G_MAXINT, gst_util_uint64_scale(loop->cur_level.bytes, GST_SECOND, loop->cur_level.time));
+  avg_out = (gint) MIN(G_MAXINT, loop->drain_bytes_per_sec);
+  if (loop->drain_bytes_per_sec > 0)
+    drain_ms = (gint64) gst_util_uint64_scale(loop->cur_level.bytes, 1000, loop->drain_bytes_per_sec);
+  if (busy && loop->max_size.time > loop->cur_level.time)
+    left_ms = (gint64) ((loop->max_size.time - loop->cur_level.time) / GST_MSECOND);
+  if (format == GST_FORMAT_BYTES) {
+    start = 0;
+    stop = loop->cur_level.bytes;
+  } else {
+    format = GST_FORMAT_TIME;
+    start = GST_CLOCK_STIME_IS_VALID(loop->srctime) ? loop->srctime : loop->sink_start_time;
+    stop = loop->cur_level.buffers > 0 ? loop->sinktime : start;
+    if (!GST_CLOCK_STIME_IS_VALID(start) || !GST_CLOCK_STIME_IS_VALID(stop))
+      start = stop = -1;
+  }
+  GST_PREREC_MUTEX_UNLOCK(loop);
+
+  gst_query_set_buffering_percent(query, busy, percent);
+  gst_query_set_buffering_stats(query, GST_BUFFERING_LIVE, avg_in, avg_out, left_ms);
+  gst_query_set_buffering_range(query, format, start, stop, drain_ms);
+  if (start >= 0 && stop > start)
+    gst_query_add_buffering_range(query, start, stop);
+  return TRUE;
+}
+
+static gboolean gst_prerec_query_latency(GstPreRecordLoop* loop, GstQuery* query) {
+  gboolean live;
+  GstClockTime min, max;
+
+  if (!gst_pad_peer_query(loop->sinkpad, query))
+    return FALSE;
+  gst_query_parse_latency(query, &live, &min, &max);
+  GST_PREREC_MUTEX_LOCK(loop);
+  if (GST_CLOCK_TIME_IS_VALID(max)) {
+    if (loop->max_size.time > 0)
+      max += loop->max_size.time + loop->drain_duration;
+    else
+      max = GST_CLOCK_TIME_NONE;
+  }
+  GST_PREREC_MUTEX_UNLOCK(loop);
+  GST_CAT_DEBUG_OBJECT(prerec_debug, loop, "Latency: live %d min %" GST_TIME_FORMAT " max %" GST_TIME_FORMAT, live,
+                       GST_TIME_ARGS(min), GST_TIME_ARGS(max));
+  gst_query_set_latency(query, live, min, max);
+  return TRUE;
+}
+
+static void gst_prerec_array_append_uint64(GValue* array, guint64 v) {
+  GValue item = G_VALUE_INIT;
+
+  g_value_init(&item, G_TYPE_UINT64);
+  g_value_set_uint64(&item, v);
+  gst_value_array_append_and_take_value(array, &item);
+}
+
+/* prerec-catalog: the queued GOPs as parallel arrays, oldest first. Optional
+ * "start"/"stop" fields (running time) keep only the GOPs overlapping that
+ * range. The lock is only held to copy the catalog. */
+static gboolean gst_prerec_query_catalog(GstPreRecordLoop* loop, GstStructure* s) {
+  guint64 from = 0, to = G_MAXUINT64, total = 0;
+  gboolean filter = FALSE;
+  GValue starts = G_VALUE_INIT, durations = G_VALUE_INIT, bytes = G_VALUE_INIT, keyframe_bytes = G_VALUE_INIT,
+         buffers = G_VALUE_INIT;
+  GArray* gops;
+  guint n = 0;
+
+  filter |= gst_structure_get_uint64(s, "start", &from);
+  filter |= gst_structure_get_uint64(s, "stop", &to);
+
+  GST_PREREC_MUTEX_LOCK(loop);
+  gops = g_array_copy(loop->gop_catalog);
+  GST_PREREC_MUTEX_UNLOCK(loop);
+
+  g_value_init(&starts, GST_TYPE_ARRAY);
+  g_value_init(&durations, GST_TYPE_ARRAY);
+  g_value_init(&bytes, GST_TYPE_ARRAY);
+  g_value_init(&keyframe_bytes, GST_TYPE_ARRAY);
+  g_value_init(&buffers, GST_TYPE_ARRAY);
+  for (guint i = 0; i < gops->len; ++i) {
+    const GstPreRecGopInfo* info = &g_array_index(gops, GstPreRecGopInfo, i);
+    gboolean timed = GST_CLOCK_STIME_IS_VALID(info->start);
+    /* data before the segment start has a negative running time */
+    guint64 start = timed ? (guint64) MAX(info->start, 0) : GST_CLOCK_TIME_NONE;
+    guint64 end = timed ? (guint64) MAX(info->end, (GstClockTimeDiff) start) : GST_CLOCK_TIME_NONE;
+    GValue count = G_VALUE_INIT;
+
+    if (filter && (!timed || end <= from || start >= to))
+      continue;
+    gst_prerec_array_append_uint64(&starts, start);
+    gst_prerec_array_append_uint64(&durations, timed ? end - start : GST_CLOCK_TIME_NONE);
+    gst_prerec_array_append_uint64(&bytes, info->bytes);
+    gst_prerec_array_append_uint64(&keyframe_bytes, info->keyframe_bytes);
+    g_value_init(&count, G_TYPE_UINT);
+    g_value_set_uint(&count, info->buffers);
+    gst_value_array_append_and_take_value(&buffers, &count);
+    total += info->bytes;
+    n++;
   }
-  default:
-    return gst_pad_event_default(pad, parent, event);
+  g_array_unref(gops);
+
+  gst_structure_take_value(s, "gop-start", &starts);
+  gst_structure_take_value(s, "gop-duration", &durations);
+  gst_structure_take_value(s, "gop-bytes", &bytes);
+  gst_structure_take_value(s, "gop-keyframe-bytes", &keyframe_bytes);
+  gst_structure_take_value(s, "gop-buffers", &buffers);
+  gst_structure_set(s, "n-gops", G_TYPE_UINT, n, "total-bytes", G_TYPE_UINT64, total, NULL);
+  return TRUE;
+}
+
+/* Counters of a stats snapshot, shared by prerec-stats and the element
+ * messages */
+static void gst_prerec_stats_to_structure(const GstPreRecStats* stats, GstStructure* s) {
+  gst_structure_set(s, "drops-gops", G_TYPE_UINT, stats->drops_gops, "drops-buffers", G_TYPE_UINT,
+                    stats->drops_buffers, "drops-events", G_TYPE_UINT, stats->drops_events, "queued-gops",
+                    G_TYPE_UINT, stats->queued_gops_cur, "queued-buffers", G_TYPE_UINT, stats->queued_buffers_cur,
+                    "flush-count", G_TYPE_UINT, stats->flush_count, "rearm-count", G_TYPE_UINT, stats->rearm_count,
+                    "adopt-count", G_TYPE_UINT, stats->adopt_count, "live-drops", G_TYPE_UINT, stats->live_drops,
+                    NULL);
+  /* tier sizes and spill throughput (bytes per second of worker copy time) */
+  gst_structure_set(s, "ram-bytes", G_TYPE_UINT64, stats->ram_bytes_cur, "spill-bytes", G_TYPE_UINT64,
+                    stats->spill_bytes_cur, "spill-written", G_TYPE_UINT64, stats->spill_written,
+                    "spill-throughput", G_TYPE_UINT64,
+                    stats->spill_time_us ? stats->spill_written * G_USEC_PER_SEC / stats->spill_time_us : 0,
+                    "spill-full", G_TYPE_UINT, stats->spill_full, NULL);
+  gst_structure_set(s, "journal-written", G_TYPE_UINT, stats->journal_written, "journal-recovered", G_TYPE_UINT,
+                    stats->journal_recovered, "journal-corrupt", G_TYPE_UINT, stats->journal_corrupt,
+                    "journal-skipped", G_TYPE_UINT, stats->journal_skipped, NULL);
+  gst_structure_set(s, "handoff-count", G_TYPE_UINT, stats->handoff_count, "handoff-failed", G_TYPE_UINT,
+                    stats->handoff_failed, "handoff-copied", G_TYPE_UINT, stats->handoff_copied, NULL);
+  gst_structure_set(s, "slab-reserved", G_TYPE_UINT64, stats->slab_reserved_cur, "slab-used", G_TYPE_UINT64,
+                    stats->slab_used_cur, "slab-fallbacks", G_TYPE_UINT, stats->slab_fallbacks, NULL);
+  gst_structure_set(s, "meta-stripped", G_TYPE_UINT64, stats->meta_stripped, "meta-stripped-bytes",
+                    G_TYPE_UINT64, stats->meta_stripped_bytes, NULL);
+  gst_structure_set(s, "state-restored", G_TYPE_UINT, stats->state_restored, "gaps-coalesced", G_TYPE_UINT,
+                    stats->gaps_coalesced, NULL);
+  gst_structure_set(s, "events-queued", G_TYPE_UINT, stats->events_queued, "events-superseded", G_TYPE_UINT,
+                    stats->events_superseded, "events-overflow", G_TYPE_UINT, stats->events_overflow, NULL);
+  gst_structure_set(s, "qos-dropped-buffers", G_TYPE_UINT, stats->qos_dropped_buffers, "qos-dropped-gops",
+                    G_TYPE_UINT, stats->qos_dropped_gops, NULL);
+}
+
+/* Posts the element messages queued under the lock. Must be called without
+ * the lock; cheap when nothing is pending. */
+static void gst_prerec_post_messages(GstPreRecordLoop* loop) {
+  GPtrArray* messages;
+  GstPreRecStats stats;
+
+  if (G_LIKELY(!g_atomic_int_get(&loop->messages_pending)))
+    return;
+  GST_PREREC_MUTEX_LOCK(loop);
+  messages = loop->messages;
+  loop->messages = g_ptr_array_new();
+  g_atomic_int_set(&loop->messages_pending, 0);
+  GST_PREREC_MUTEX_UNLOCK(loop);
+
+  gst_prerec_get_stats(loop, &stats);
+  for (guint i = 0; i < messages->len; ++i) {
+    GstStructure* s = g_ptr_array_index(messages, i);
+    gst_prerec_stats_to_structure(&stats, s);
+    gst_element_post_message(GST_ELEMENT(loop), gst_message_new_element(GST_OBJECT(loop), s));
+  }
+  g_ptr_array_unref(messages);
+}
+
+/* Latency histograms for prerec-stats. They are copied under the lock and
+ * formatted outside it; "reset-histograms"=TRUE in the query clears them in
+ * the same critical section, so periodic scrapes see disjoint intervals. */
+static void gst_prerec_stats_add_histograms(GstPreRecordLoop* loop, GstStructure* s) {
+  GstPreRecHist* hists = g_new(GstPreRecHist, 4);
+  gboolean reset = FALSE;
+
+  gst_structure_get_boolean(s, "reset-histograms", &reset);
+  GST_PREREC_MUTEX_LOCK(loop);
+  hists[0] = loop->hist_enqueue;
+  hists[1] = loop->hist_prune;
+  hists[2] = loop->hist_drain_push;
+  hists[3] = loop->hist_residency;
+  if (reset) {
+    gst_prerec_hist_reset(&loop->hist_enqueue);
+    gst_prerec_hist_reset(&loop->hist_prune);
+    gst_prerec_hist_reset(&loop->hist_drain_push);
+    gst_prerec_hist_reset(&loop->hist_residency);
   }
+  GST_PREREC_MUTEX_UNLOCK(loop);
+
+  gst_prerec_hist_to_structure(&hists[0], s, "enqueue");
+  gst_prerec_hist_to_structure(&hists[1], s, "prune");
+  gst_prerec_hist_to_structure(&hists[2], s, "drain-push");
+  gst_prerec_hist_to_structure(&hists[3], s, "residency");
+  g_free(hists);
 }
 
 static gboolean gst_pre_record_loop_src_query(GstPad* pad, GstObject* parent, GstQuery* query) {
   GstPreRecordLoop* loop = GST_PRERECORDLOOP(parent);
+  if (GST_QUERY_TYPE(query) == GST_QUERY_BUFFERING)
+    return gst_prerec_query_buffering(loop, query);
+  if (GST_QUERY_TYPE(query) == GST_QUERY_LATENCY)
+    return gst_prerec_query_latency(loop, query);
   if (GST_QUERY_TYPE(query) == GST_QUERY_CUSTOM) {
     const GstStructure* in_s = gst_query_get_structure(query);
+    if (in_s && gst_structure_has_name(in_s, "prerec-catalog"))
+      return gst_prerec_query_catalog(loop, (GstStructure*) in_s); /* writable like prerec-stats */
     if (in_s && gst_structure_has_name(in_s, "prerec-stats")) {
       GstPreRecStats stats;
       gst_prerec_get_stats(loop, &stats);
@@ -1417,11 +4526,8 @@ static gboolean gst_pre_record_loop_src_query(GstPad* pad, GstObject* parent, Gs
        * structure and insert its fields into the existing one (which already has
        * desired name). */
       GstStructure* w = (GstStructure*) in_s; /* cast away const for field updates */
-      gst_structure_set(w, "drops-gops", G_TYPE_UINT, stats.drops_gops, "drops-buffers", G_TYPE_UINT,
-                        stats.drops_buffers, "drops-events", G_TYPE_UINT, stats.drops_events, "queued-gops",
-                        G_TYPE_UINT, stats.queued_gops_cur, "queued-buffers", G_TYPE_UINT, stats.queued_buffers_cur,
-                        "flush-count", G_TYPE_UINT, stats.flush_count, "rearm-count", G_TYPE_UINT, stats.rearm_count,
-                        NULL);
+      gst_prerec_stats_to_structure(&stats, w);
+      gst_prerec_stats_add_histograms(loop, w);
       return TRUE;
     }
   }
@@ -1446,7 +4552,8 @@ static gboolean gst_pre_record_loop_src_activate_mode(GstPad* pad, GstObject* pa
       GST_CAT_INFO(prerec_debug, "Source pad deactivated");
       GST_PREREC_MUTEX_LOCK(loop);
       loop->srcresult = GST_FLOW_FLUSHING;
-      gst_prerec_locked_flush(loop, FALSE);
+      if (!gst_prerec_keeps_ring(loop))
+        gst_prerec_locked_flush(loop, FALSE);
       GST_PREREC_MUTEX_UNLOCK(loop);
       result = TRUE;
     }
@@ -1478,10 +4585,15 @@ static gboolean gst_pre_record_loop_sink_activate_mode(GstPad* pad, GstObject* p
       GST_PREREC_SIGNAL_DEL(loop);
       GST_PREREC_MUTEX_UNLOCK(loop);
 
-      /* step 2, wait until streaming thread stopped and flush queue */
+      /* step 2, wait until streaming thread stopped and flush queue, unless
+       * the ring must survive the reconfiguration (discarded on NULL instead) */
       GST_PAD_STREAM_LOCK(pad);
       GST_PREREC_MUTEX_LOCK(loop);
-      gst_prerec_locked_flush(loop, TRUE);
+      if (gst_prerec_keeps_ring(loop))
+        GST_CAT_INFO_OBJECT(prerec_debug, loop, "Sink pad deactivated - preserving %u buffered buffers",
+                            loop->cur_level.buffers);
+      else
+        gst_prerec_locked_flush(loop, TRUE);
       GST_PREREC_MUTEX_UNLOCK(loop);
       GST_PAD_STREAM_UNLOCK(pad);
     }
@@ -1502,12 +4614,43 @@ static GstStateChangeReturn gst_pre_record_loop_change_state(GstElement* element
   switch (transition) {
   case GST_STATE_CHANGE_NULL_TO_READY:
     loop->preroll_sent = FALSE;
+    gst_prerec_slab_start(loop);
+    if (!gst_prerec_handoff_start(loop))
+      return GST_STATE_CHANGE_FAILURE;
+    if (!gst_prerec_spill_start(loop)) {
+      gst_prerec_handoff_stop(loop);
+      return GST_STATE_CHANGE_FAILURE;
+    }
+    if (!gst_prerec_journal_start(loop)) {
+      gst_prerec_spill_stop(loop);
+      gst_prerec_handoff_stop(loop);
+      return GST_STATE_CHANGE_FAILURE;
+    }
+    gst_prerec_stats_page_start(loop);
     break;
   default:
     break;
   }
 
   ret = GST_ELEMENT_CLASS(gst_pre_record_loop_parent_class)->change_state(element, transition);
+
+  switch (transition) {
+  case GST_STATE_CHANGE_READY_TO_NULL:
+    /* Pads are already deactivated; a preserved ring ends its life here,
+     * unless it has a ring-id and gets parked on finalize. */
+    gst_prerec_spill_stop(loop);
+    GST_PREREC_MUTEX_LOCK(loop);
+    if (!loop->ring_id)
+      gst_prerec_locked_discard(loop);
+    GST_PREREC_MUTEX_UNLOCK(loop);
+    gst_prerec_journal_stop(loop); /* after the discard so its files go too */
+    gst_prerec_handoff_stop(loop);
+    gst_prerec_slab_stop(loop);
+    gst_prerec_stats_page_stop(loop);
+    break;
+  default:
+    break;
+  }
   return ret;
 }
 
@@ -1543,6 +4686,25 @@ static gboolean gst_pre_record_loop_sink_query(GstPad* pad, GstObject* parent, G
     gst_query_set_accept_caps_result(query, ret);
     break;
   }
+  case GST_QUERY_ALLOCATION: {
+    GstAllocator* allocator = NULL;
+
+    /* the hand-off arena wins: payloads allocated there need no copy */
+    GST_PREREC_MUTEX_LOCK(loop);
+    if (loop->handoff_allocator)
+      allocator = gst_object_ref(loop->handoff_allocator);
+    else if (loop->slab)
+      allocator = gst_object_ref(loop->slab);
+    GST_PREREC_MUTEX_UNLOCK(loop);
+
+    ret = gst_pad_query_default(pad, parent, query);
+    if (allocator) {
+      gst_prerec_propose_allocator(query, allocator);
+      gst_object_unref(allocator);
+      ret = TRUE;
+    }
+    break;
+  }
   default:
     ret = gst_pad_query_default(pad, parent, query);
     break;
@@ -1626,8 +4788,11 @@ static void gst_pre_record_loop_class_init(GstPreRecordLoopClass* klass) {
    *
    * When the total queued time exceeds this limit, the oldest complete GOPs
    * are dropped to maintain the time window. However, the element enforces
-   * a 2-GOP minimum floor - even if max-time is exceeded, at least 2 complete
-   * GOPs are always retained to ensure playback continuity.
+   * a minimum floor of #GstPreRecordLoop:min-gops GOPs (2 by default) - even
+   * if max-time is exceeded, those GOPs are always retained to ensure
+   * playback continuity. #GstPreRecordLoop:retention-policy decides whether
+   * the window may end up shorter or longer than max-time. Lowering it while
+   * buffering prunes at once.
    *
    * - Positive values: Time limit in seconds (integer only, no sub-second precision)
    * - Zero or negative: Unlimited buffering (pruning disabled)
@@ -1652,14 +4817,602 @@ static void gst_pre_record_loop_class_init(GstPreRecordLoopClass* klass) {
                        (gint) (DEFAULT_MAX_SIZE_TIME / GST_SECOND), /* default */
                        G_PARAM_READWRITE));
 
+  /**
+   * GstPreRecordLoop:clip-events:
+   *
+   * Mark clip boundaries in the outgoing stream so a single long-lived
+   * splitting muxer (e.g. splitmuxsink) can serve every incident.
+   *
+   * When %TRUE, each accepted flush trigger, and each EOS that drains a
+   * buffered window (flush-on-eos), opens a clip with an increasing id.
+   * Right before the first drained keyframe the element pushes a
+   * serialized `prerecord-clip-start` custom event (fields: clip-id,
+   * timestamp, running-time, drain-bytes = ring payload at the trigger)
+   * followed by a downstream `GstForceKeyUnit` event (all-headers=TRUE,
+   * count=clip-id). Re-arm or EOS closes the clip with `prerecord-clip-end`
+   * (clip-id) after the last pass-through buffer.
+   *
+   * Example: cut splitmuxsink exactly at the drained keyframe
+   * |[<!-- language="C" -->
+   * static GstPadProbeReturn on_clip_event(GstPad* pad, GstPadProbeInfo* info, gpointer splitmux) {
+   *   const GstStructure* s = gst_event_get_structure(GST_PAD_PROBE_INFO_EVENT(info));
+   *   if (s && gst_structure_has_name(s, "prerecord-clip-start"))
+   *     g_signal_emit_by_name(splitmux, "split-now");
+   *   return GST_PAD_PROBE_OK;
+   * }
+   * ]|
+   *
+   * Default: %FALSE
+   */
+  g_object_class_install_property(
+      gobject_class, PROP_CLIP_EVENTS,
+      g_param_spec_boolean("clip-events", "Clip Events",
+                           "Emit prerecord-clip-start/GstForceKeyUnit before the first drained keyframe and "
+                           "prerecord-clip-end when the clip is closed by re-arm or EOS",
+                           FALSE, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:preserve-on-reconfigure:
+   *
+   * Keep the buffered ring, including its segment timing and GOP tracking,
+   * when the pads are deactivated (relink, downstream swap, PAUSED→READY).
+   * On reactivation buffering continues on top of the preserved history.
+   *
+   * The ring is still discarded on FLUSH_START, on an upstream
+   * `prerecord-discard` custom event and on the transition to NULL.
+   *
+   * Default: %FALSE (every deactivation empties the ring)
+   */
+  g_object_class_install_property(
+      gobject_class, PROP_PRESERVE_ON_RECONFIGURE,
+      g_param_spec_boolean("preserve-on-reconfigure", "Preserve On Reconfigure",
+                           "Keep buffered history across pad deactivation and PAUSED/READY cycles; "
+                           "discard only on prerecord-discard or NULL",
+                           FALSE, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:ring-id:
+   *
+   * Process-wide identity of this ring, e.g. a camera id. When set, the ring
+   * is not emptied on pad deactivation or NULL; on finalize it is parked in
+   * a process-wide registry for #GstPreRecordLoop:ring-park-timeout.
+   *
+   * A new instance with the same ring-id adopts the parked ring on its first
+   * CAPS event, provided the caps are equal and it has not buffered anything
+   * yet. Buffers, GOP tracking and segment timing move over without copies,
+   * so an incident right after a pipeline rebuild still has history. The
+   * adopted buffers keep their original timestamps and queued SEGMENT events.
+   *
+   * Default: %NULL (no parking)
+   */
+  g_object_class_install_property(
+      gobject_class, PROP_RING_ID,
+      g_param_spec_string("ring-id", "Ring Id",
+                          "Registry key under which the ring is parked on finalize and adopted by a new instance",
+                          NULL, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:ring-park-timeout:
+   *
+   * How long, in milliseconds, a parked ring waits for adoption before its
+   * buffers are released. Zero disables parking.
+   *
+   * Default: 30000
+   */
+  g_object_class_install_property(
+      gobject_class, PROP_RING_PARK_TIMEOUT,
+      g_param_spec_uint("ring-park-timeout", "Ring Park Timeout (ms)",
+                        "Milliseconds a parked ring stays adoptable before it is released (0 = never park)", 0,
+                        G_MAXUINT, DEFAULT_RING_PARK_TIMEOUT, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:drain-rebase:
+   *
+   * Rebase the running time of each drained clip. On every accepted flush
+   * trigger the element pushes a fresh SEGMENT right before the first drained
+   * keyframe (or the first pass-through buffer if the ring was empty) that
+   * maps that keyframe's PTS to #GstPreRecordLoop:drain-base-time.
+   *
+   * The shift is applied as a running-time offset, so every later SEGMENT of
+   * the clip (queued in the ring or arriving in pass-through) is rewritten
+   * with the same offset and running time stays continuous until re-arm.
+   * Buffer timestamps themselves are never modified.
+   *
+   * Default: %FALSE (drained buffers keep their original running time)
+   */
+  g_object_class_install_property(
+      gobject_class, PROP_DRAIN_REBASE,
+      g_param_spec_boolean("drain-rebase", "Drain Rebase",
+                           "Push a SEGMENT on each drain mapping the first drained keyframe to drain-base-time "
+                           "and keep pass-through SEGMENTs consistent with it until re-arm",
+                           FALSE, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:drain-base-time:
+   *
+   * Running time, in nanoseconds, assigned to the first drained keyframe when
+   * #GstPreRecordLoop:drain-rebase is enabled.
+   *
+   * Default: 0
+   */
+  g_object_class_install_property(
+      gobject_class, PROP_DRAIN_BASE_TIME,
+      g_param_spec_uint64("drain-base-time", "Drain Base Time (ns)",
+                          "Running time of the first drained keyframe when drain-rebase is enabled", 0, G_MAXINT64, 0,
+                          G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:live-max-buffers:
+   *
+   * Maximum number of buffers waiting on the "live" request pad. When full,
+   * #GstPreRecordLoop:live-leaky decides which buffer is dropped; the sink
+   * pad is never blocked by a slow live consumer.
+   *
+   * Default: 30
+   */
+  g_object_class_install_property(
+      gobject_class, PROP_LIVE_MAX_BUFFERS,
+      g_param_spec_uint("live-max-buffers", "Live Max Buffers",
+                        "Maximum buffers queued on the live pad before the leaky policy drops one", 1, G_MAXUINT,
+                        DEFAULT_LIVE_MAX_BUFFERS, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:live-leaky:
+   *
+   * Which buffer the "live" pad drops when its queue is full: the incoming
+   * one (upstream) or the oldest queued one (downstream, lowest latency).
+   * Drops are counted in the `live-drops` field of `prerec-stats`.
+   *
+   * Example: always-on viewer next to the gated recording branch
+   * |[
+   * gst-launch-1.0 ... ! h264parse ! pre_record_loop name=pr live-leaky=downstream ! mp4mux ! filesink ...
+   *     pr.live ! avdec_h264 ! autovideosink
+   * ]|
+   *
+   * Default: downstream
+   */
+  g_object_class_install_property(gobject_class, PROP_LIVE_LEAKY,
+                                  g_param_spec_enum("live-leaky", "Live Leaky",
+                                                    "Buffer dropped when the live pad queue is full",
+                                                    GST_TYPE_PREREC_LIVE_LEAKY, GST_PREREC_LIVE_LEAKY_DOWNSTREAM,
+                                                    G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:spill-location:
+   *
+   * Directory (NVMe or tmpfs) for the disk spill tier. When set, GOPs older
+   * than #GstPreRecordLoop:spill-ram-time are copied by a worker thread into
+   * a memory-mapped file of #GstPreRecordLoop:spill-max-bytes and their RAM
+   * is released. Drains push the spilled data as #GstMemory wrapping the
+   * mapping, without a copy, and prefetch the next GOP while pushing.
+   *
+   * The file is unlinked as soon as it is created. The arena is set up on
+   * the NULL→READY transition; a failure is reported as a resource error.
+   * #GstPreRecordLoop:max-time still bounds the whole window.
+   *
+   * Example: 10-minute look-back with the newest 5 s in RAM
+   * |[
+   * gst-launch-1.0 ... ! pre_record_loop max-time=600 spill-location=/mnt/nvme \
+   *     spill-max-bytes=8589934592 ! ...
+   * ]|
+   *
+   * Default: %NULL (whole ring in RAM)
+   */
+  g_object_class_install_property(
+      gobject_class, PROP_SPILL_LOCATION,
+      g_param_spec_string("spill-location", "Spill Location",
+                          "Directory for the memory-mapped spill file holding GOPs older than spill-ram-time "
+                          "(NULL keeps the whole ring in RAM)",
+                          NULL, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:spill-ram-time:
+   *
+   * Newest part of the ring, in nanoseconds, that always stays in RAM when
+   * the spill tier is enabled. The newest GOP never spills.
+   *
+   * Default: 5 seconds
+   */
+  g_object_class_install_property(
+      gobject_class, PROP_SPILL_RAM_TIME,
+      g_param_spec_uint64("spill-ram-time", "Spill RAM Time (ns)",
+                          "Newest buffered duration kept in RAM when spilling", 0, G_MAXUINT64,
+                          DEFAULT_SPILL_RAM_TIME, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:spill-max-bytes:
+   *
+   * Size of the spill file. When it is full older GOPs stay in RAM until
+   * pruning or a drain releases space (counted as `spill-full` in stats).
+   *
+   * Default: 1 GiB
+   */
+  g_object_class_install_property(
+      gobject_class, PROP_SPILL_MAX_BYTES,
+      g_param_spec_uint64("spill-max-bytes", "Spill Max Bytes", "Size of the memory-mapped spill file", 1,
+                          G_MAXUINT64, DEFAULT_SPILL_MAX_BYTES, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:journal-location:
+   *
+   * Directory for the crash-persistent GOP journal. When set, every GOP is
+   * written there by a worker thread as soon as the next keyframe closes it:
+   * one file per GOP holding the caps and segment snapshot, a frame index
+   * and a CRC32C per frame, made durable with fdatasync() and an atomic
+   * rename. Files are removed once their GOP is pruned, drained or
+   * discarded.
+   *
+   * GOPs left over by a crashed process are read and validated by the
+   * worker from NULL→READY on, and replayed into the ring on the first CAPS
+   * event, ahead of live data (like an adopted ring-id ring), so a trigger
+   * right after a restart still carries the history from before the crash.
+   * Files with a bad CRC are skipped and deleted (`journal-corrupt` in
+   * stats); files with different caps are deleted. The GOP still open at
+   * the time of a crash is lost.
+   *
+   * At most 8 GOP writes are queued for the worker; when the disk falls
+   * further behind, closing GOPs are left out of the journal
+   * (`journal-skipped` in stats) and a warning is posted once. The replay
+   * stops at the first GOP that was left out, so the recovered window never
+   * has a hole.
+   *
+   * Default: %NULL (no journal)
+   */
+  g_object_class_install_property(
+      gobject_class, PROP_JOURNAL_LOCATION,
+      g_param_spec_string("journal-location", "Journal Location",
+                          "Directory for the crash-persistent GOP journal replayed on restart (NULL disables it)",
+                          NULL, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:handoff-socket:
+   *
+   * Path of a Unix stream socket to hand each triggered window to another
+   * process. When set, buffered payloads live in a sealed memfd of
+   * #GstPreRecordLoop:handoff-max-bytes. The memfd's allocator is proposed
+   * upstream in ALLOCATION queries (ahead of the slab allocator), so a
+   * producer that uses it writes frames straight into the memfd; other
+   * payloads are copied in once at ingest (`handoff-copied` in stats). On
+   * a trigger a
+   * worker connects, passes a read-only descriptor of the memfd together
+   * with the caps and a frame index (offset, size, timestamps, keyframe
+   * flag; see gstprerechandoffproto.h), and keeps the frames alive until
+   * the consumer replies with a one-byte ack. The consumer maps the memfd
+   * and can write the clip with no further copy;
+   * `tools/prerec-handoff-consumer` is a minimal one.
+   *
+   * Each hand-off posts a `prerec-handoff-done` element message and counts
+   * in `handoff-count` or `handoff-failed` in stats. The drain downstream is
+   * unchanged. Linux only. GOPs moved to the spill tier are copied back
+   * into the memfd by the hand-off worker on a trigger.
+   *
+   * Default: %NULL (no hand-off)
+   */
+  g_object_class_install_property(
+      gobject_class, PROP_HANDOFF_SOCKET,
+      g_param_spec_string("handoff-socket", "Hand-off Socket",
+                          "Unix socket of a process receiving each triggered window as a memfd and frame index "
+                          "(NULL disables it)",
+                          NULL, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:handoff-max-bytes:
+   *
+   * Size of the hand-off memfd. Payloads that do not fit at ingest stay in
+   * RAM and are copied in at trigger time if space has been released by
+   * then; frames that still do not fit are left out of the hand-off
+   * (`skipped` in the done message).
+   *
+   * Default: 256 MiB
+   */
+  g_object_class_install_property(
+      gobject_class, PROP_HANDOFF_MAX_BYTES,
+      g_param_spec_uint64("handoff-max-bytes", "Hand-off Max Bytes", "Size of the memfd backing the hand-off arena",
+                          1, G_MAXUINT64, DEFAULT_HANDOFF_MAX_BYTES, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:slab-allocator:
+   *
+   * Answer ALLOCATION queries on the sink pad with a slab allocator sized
+   * for encoded frames (memory type "PreRecSlab"), so upstream encoders and
+   * parsers allocate frames that the ring keeps for the whole window from
+   * reused slab blocks instead of the general heap. Downstream pools are
+   * removed from the answer. Applied on NULL→READY.
+   *
+   * `prerec-stats` reports `slab-reserved`, `slab-used` and
+   * `slab-fallbacks` (allocations the slab could not serve).
+   *
+   * Default: %FALSE
+   */
+  g_object_class_install_property(gobject_class, PROP_SLAB_ALLOCATOR,
+                                  g_param_spec_boolean("slab-allocator", "Slab Allocator",
+                                                       "Propose a slab allocator for buffered frames upstream",
+                                                       FALSE, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:slab-max-bytes:
+   *
+   * Most memory the slab allocator reserves, in 4 MiB chunks. Allocations
+   * beyond it come from system memory.
+   *
+   * Default: 512 MiB
+   */
+  g_object_class_install_property(
+      gobject_class, PROP_SLAB_MAX_BYTES,
+      g_param_spec_uint64("slab-max-bytes", "Slab Max Bytes", "Most memory the slab allocator reserves", 0,
+                          G_MAXUINT64, DEFAULT_SLAB_MAX_BYTES, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:slab-hugepages:
+   *
+   * Back slab chunks with hugepages: reserved hugetlb pages when available,
+   * transparent hugepages otherwise (Linux).
+   *
+   * Default: %FALSE
+   */
+  g_object_class_install_property(gobject_class, PROP_SLAB_HUGEPAGES,
+                                  g_param_spec_boolean("slab-hugepages", "Slab Hugepages",
+                                                       "Back slab chunks with hugepages", FALSE, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:slab-mlock:
+   *
+   * mlock() slab chunks so the window is never paged out. Subject to
+   * RLIMIT_MEMLOCK; a failure is logged once and the chunk is used unlocked.
+   *
+   * Default: %FALSE
+   */
+  g_object_class_install_property(gobject_class, PROP_SLAB_MLOCK,
+                                  g_param_spec_boolean("slab-mlock", "Slab mlock", "Lock slab chunks in RAM", FALSE,
+                                                       G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:strip-meta-apis:
+   *
+   * Comma separated meta API type names (e.g.
+   * `GstVideoRegionOfInterestMetaAPI,GstAnalyticsRelationMetaAPI`) or custom
+   * meta names. Buffers entering the ring lose the listed metas, or all
+   * other metas with #GstPreRecordLoop:strip-meta-mode=keep; pass-through
+   * buffers are untouched. Locked metas are never removed.
+   *
+   * `prerec-stats` counts removed metas in `meta-stripped` and their struct
+   * sizes in `meta-stripped-bytes`.
+   *
+   * Default: %NULL (metas are kept)
+   */
+  g_object_class_install_property(gobject_class, PROP_STRIP_META_APIS,
+                                  g_param_spec_string("strip-meta-apis", "Strip Meta APIs",
+                                                      "Meta API types removed from (or kept on) buffered frames",
+                                                      NULL, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:strip-meta-mode:
+   *
+   * Whether #GstPreRecordLoop:strip-meta-apis lists the metas to remove or
+   * the only metas to keep. With keep and an empty list every unlocked meta
+   * is removed.
+   *
+   * Default: remove
+   */
+  g_object_class_install_property(gobject_class, PROP_STRIP_META_MODE,
+                                  g_param_spec_enum("strip-meta-mode", "Strip Meta Mode",
+                                                    "Whether strip-meta-apis lists metas to remove or to keep",
+                                                    GST_TYPE_PREREC_META_STRIP_MODE, GST_PREREC_META_STRIP_REMOVE,
+                                                    G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:max-queued-events:
+   *
+   * Serialized events other than SEGMENT and GAP (tags, custom downstream
+   * events, segment-done, stream-group-done, ...) are normally forwarded as
+   * they arrive, ahead of the buffered data they follow. When non-zero, up
+   * to this many of them are queued in order with the data while buffering
+   * and pruned with their GOP; a sticky event replaces the one of the same
+   * kind queued earlier in the same GOP. Events past the limit are forwarded
+   * right away. `prerec-stats` reports `events-queued`,
+   * `events-superseded` and `events-overflow`.
+   *
+   * Default: 0 (forward them all)
+   */
+  g_object_class_install_property(
+      gobject_class, PROP_MAX_QUEUED_EVENTS,
+      g_param_spec_uint("max-queued-events", "Max Queued Events",
+                        "Serialized events kept in order with the buffered data (0 = forward them)", 0, G_MAXUINT,
+                        DEFAULT_MAX_QUEUED_EVENTS, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:min-gops:
+   *
+   * Pruning for #GstPreRecordLoop:max-time never goes below this many GOPs,
+   * so a clip stays playable even when a single GOP is longer than the
+   * window. The GOP being recorded is never pruned; all-intra streams can
+   * use 0 to hold exactly the window. Lowering it prunes at once.
+   *
+   * Default: 2
+   */
+  g_object_class_install_property(
+      gobject_class, PROP_MIN_GOPS,
+      g_param_spec_uint("min-gops", "Min GOPs", "GOPs always kept when pruning for max-time", 0, G_MAXUINT,
+                        DEFAULT_MIN_GOPS, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:max-gops:
+   *
+   * Upper bound on the number of buffered GOPs, independent of
+   * #GstPreRecordLoop:max-time and taking precedence over
+   * #GstPreRecordLoop:min-gops. Lowering it prunes at once.
+   *
+   * Default: 0 (no limit)
+   */
+  g_object_class_install_property(
+      gobject_class, PROP_MAX_GOPS,
+      g_param_spec_uint("max-gops", "Max GOPs", "Maximum number of buffered GOPs (0 = unlimited)", 0, G_MAXUINT,
+                        DEFAULT_MAX_GOPS, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:retention-policy:
+   *
+   * at-most drops the oldest GOP as soon as the ring holds more than
+   * #GstPreRecordLoop:max-time, so the window can end up shorter than
+   * max-time by up to one GOP. at-least only drops it while the GOPs after
+   * it still cover max-time, so a clip always reaches back at least that far
+   * at the cost of up to one GOP more memory.
+   *
+   * Default: at-most
+   */
+  g_object_class_install_property(gobject_class, PROP_RETENTION_POLICY,
+                                  g_param_spec_enum("retention-policy", "Retention Policy",
+                                                    "Whether max-time is an upper or a lower bound of the window",
+                                                    GST_TYPE_PREREC_RETENTION_POLICY, GST_PREREC_RETENTION_AT_MOST,
+                                                    G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:drain-qos:
+   *
+   * Use downstream QOS reports to thin the drain so a synchronised live sink
+   * catches up with live sooner: late GOPs of the backlog are skipped as a
+   * whole, late droppable frames one by one. QOS events seen during such a
+   * drain are not forwarded upstream. `prerec-stats` reports
+   * `qos-dropped-buffers` and `qos-dropped-gops`.
+   *
+   * Default: false
+   */
+  g_object_class_install_property(gobject_class, PROP_DRAIN_QOS,
+                                  g_param_spec_boolean("drain-qos", "Drain QoS",
+                                                       "Drop late backlog frames and GOPs reported by downstream QOS",
+                                                       FALSE, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:post-messages:
+   *
+   * Post element messages instead of making applications poll
+   * `prerec-stats`: `prerec-fill` when the ring reaches a fill-thresholds
+   * level, `prerec-prune` when GOPs are pruned (at most once per
+   * message-interval), `prerec-drain-done` after each drain and
+   * `prerec-mode` on BUFFERING/PASS_THROUGH transitions. Every message also
+   * carries the `prerec-stats` counters as of posting.
+   *
+   * Default: false
+   */
+  g_object_class_install_property(gobject_class, PROP_POST_MESSAGES,
+                                  g_param_spec_boolean("post-messages", "Post messages",
+                                                       "Post fill, prune, drain and mode change element messages",
+                                                       FALSE, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:fill-thresholds:
+   *
+   * Comma-separated fill levels, in percent of max-time, that post a
+   * `prerec-fill` message when reached. Each level is posted once until a
+   * drain or flush empties the ring. Ignored without max-time.
+   *
+   * Default: "100"
+   */
+  g_object_class_install_property(gobject_class, PROP_FILL_THRESHOLDS,
+                                  g_param_spec_string("fill-thresholds", "Fill thresholds",
+                                                      "Comma-separated percentages of max-time posting prerec-fill",
+                                                      DEFAULT_FILL_THRESHOLDS, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:message-interval:
+   *
+   * Minimum time in milliseconds between two `prerec-prune` messages; GOPs
+   * pruned in between are added to the next one.
+   *
+   * Default: 1000
+   */
+  g_object_class_install_property(gobject_class, PROP_MESSAGE_INTERVAL,
+                                  g_param_spec_uint("message-interval", "Message interval",
+                                                    "Minimum milliseconds between prune messages", 0, G_MAXUINT,
+                                                    DEFAULT_MESSAGE_INTERVAL, G_PARAM_READWRITE));
+
+  /**
+   * GstPreRecordLoop:stats-page:
+   *
+   * Publish the ring level and counters in a POSIX shared-memory page
+   * (/dev/shm/prerec-stats-<pid>-<n> on Linux) guarded by a seqlock, for
+   * monitors such as `prerec-top` that need neither pipeline access nor
+   * queries. The element only writes to the page; readers never make it
+   * wait. Layout in gstprerecordloop/gstprerecstatsproto.h. Taken into
+   * account on the next NULL→READY transition.
+   *
+   * Default: false
+   */
+  g_object_class_install_property(gobject_class, PROP_STATS_PAGE,
+                                  g_param_spec_boolean("stats-page", "Stats page",
+                                                       "Publish level and counters in a shared-memory page",
+                                                       DEFAULT_STATS_PAGE, G_PARAM_READWRITE));
+
   gst_element_class_set_details_simple(gstelement_class, "PreRecordLoop", "Generic",
                                        "Capture data in ring buffer and flush onwards on event",
                                        "Kartik Aiyer <kartik.aiyer@gmail.com>");
 
   gst_element_class_add_pad_template(gstelement_class, gst_static_pad_template_get(&src_factory));
   gst_element_class_add_pad_template(gstelement_class, gst_static_pad_template_get(&sink_factory));
+  gst_element_class_add_pad_template(gstelement_class, gst_static_pad_template_get(&live_factory));
+
+  /**
+   * GstPreRecordLoop::dump-window:
+   * @prerecordloop: the #GstPreRecordLoop
+   * @location: file to write
+   * @format: a #GstPreRecDumpFormat
+   *
+   * Writes the currently buffered window to @location without leaving
+   * BUFFERING and without a downstream branch, e.g. for evidence capture.
+   * The buffers are referenced, not copied; a worker thread writes them
+   * with vectored I/O straight from the mapped buffer memory while the ring
+   * keeps running.
+   *
+   * `annexb` writes the elementary stream (length-prefixed H.264/H.265 is
+   * rewritten to start codes, with the codec_data parameter sets before
+   * every keyframe). `fmp4` writes a fragmented MP4 with one fragment per
+   * GOP and needs length-prefixed caps with codec_data.
+   *
+   * When done, an element message `prerec-dump-done` is posted with the
+   * fields location, format, success, buffers, bytes, elapsed (ns) and,
+   * on failure, error.
+   *
+   * |[<!-- language="C" -->
+   * gboolean started;
+   * g_signal_emit_by_name(prerecordloop, "dump-window", "/var/evidence/cam1.mp4",
+   *                       GST_PREREC_DUMP_FMP4, &started);
+   * ]|
+   *
+   * Returns: %TRUE if the dump was started, %FALSE if nothing is buffered
+   */
+  gst_prerec_signals[SIGNAL_DUMP_WINDOW] = g_signal_new_class_handler(
+      "dump-window", G_TYPE_FROM_CLASS(klass), G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_CALLBACK(gst_pre_record_loop_dump_window), NULL, NULL, NULL, G_TYPE_BOOLEAN, 2, G_TYPE_STRING,
+      GST_TYPE_PREREC_DUMP_FORMAT);
+
+  /**
+   * GstPreRecordLoop::dump-flight-recorder:
+   * @prerecordloop: the #GstPreRecordLoop
+   *
+   * Formats the flight recorder: the last 1024 enqueue, prune, trigger,
+   * drain, arm, flush and EOS decisions of this element, one per line and
+   * oldest first, each with its sequence number, its age relative to the
+   * newest one, the GOP id and the queue level involved. Recording is
+   * always on and takes no lock; the same dump goes to the debug log at
+   * ERROR level when a downstream push returns a fatal flow such as
+   * not-negotiated.
+   *
+   * |[<!-- language="C" -->
+   * gchar *text;
+   * g_signal_emit_by_name(prerecordloop, "dump-flight-recorder", &text);
+   * g_print("%s", text);
+   * g_free(text);
+   * ]|
+   *
+   * Returns: (transfer full): the recorded decisions as text
+   */
+  gst_prerec_signals[SIGNAL_DUMP_FLIGHT_RECORDER] = g_signal_new_class_handler(
+      "dump-flight-recorder", G_TYPE_FROM_CLASS(klass), G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_CALLBACK(gst_pre_record_loop_dump_flight_recorder), NULL, NULL, NULL, G_TYPE_STRING, 0);
 
   gstelement_class->change_state = gst_pre_record_loop_change_state;
+  gstelement_class->request_new_pad = gst_pre_record_loop_request_new_pad;
+  gstelement_class->release_pad = gst_pre_record_loop_release_pad;
 
   GST_DEBUG_REGISTER_FUNCPTR(gst_pre_record_loop_finalize);
   GST_DEBUG_REGISTER_FUNCPTR(gst_pre_record_loop_sink_activate_mode);
@@ -1668,6 +5421,8 @@ static void gst_pre_record_loop_class_init(GstPreRecordLoopClass* klass) {
   GST_DEBUG_REGISTER_FUNCPTR(gst_pre_record_loop_src_activate_mode);
   GST_DEBUG_REGISTER_FUNCPTR(gst_pre_record_loop_src_event);
   GST_DEBUG_REGISTER_FUNCPTR(gst_pre_record_loop_src_query);
+  GST_DEBUG_REGISTER_FUNCPTR(gst_pre_record_loop_sink_iterate_internal_links);
+  GST_DEBUG_REGISTER_FUNCPTR(gst_prerec_live_activate_mode);
 }
 
 /* initialize the new element
@@ -1683,6 +5438,7 @@ static void gst_pre_record_loop_init(GstPreRecordLoop* filter) {
 
   gst_pad_set_query_function(filter->sinkpad, gst_pre_record_loop_sink_query);
   gst_pad_set_activatemode_function(filter->sinkpad, gst_pre_record_loop_sink_activate_mode);
+  gst_pad_set_iterate_internal_links_function(filter->sinkpad, gst_pre_record_loop_sink_iterate_internal_links);
   gst_element_add_pad(GST_ELEMENT(filter), filter->sinkpad);
 
   filter->srcpad = gst_pad_new_from_static_template(&src_factory, "src");
@@ -1705,6 +5461,10 @@ static void gst_pre_record_loop_init(GstPreRecordLoop* filter) {
   filter->max_size.buffers = DEFAULT_MAX_SIZE_BUFFERS;
   filter->max_size.bytes = DEFAULT_MAX_SIZE_BYTES;
   filter->max_size.time = DEFAULT_MAX_SIZE_TIME;
+  filter->max_size.events = DEFAULT_MAX_QUEUED_EVENTS;
+  filter->min_gops = DEFAULT_MIN_GOPS;
+  filter->max_gops = DEFAULT_MAX_GOPS;
+  filter->retention_policy = GST_PREREC_RETENTION_AT_MOST;
   clear_level(&filter->cur_level);
 
   // Initialize segments
@@ -1720,6 +5480,7 @@ static void gst_pre_record_loop_init(GstPreRecordLoop* filter) {
   filter->mode = GST_PREREC_MODE_BUFFERING;
 
   filter->current_gop_id = 0;
+  filter->gop_catalog = g_array_new(FALSE, FALSE, sizeof(GstPreRecGopInfo));
   filter->gop_size = 0;
   filter->last_gop_id = 0;
   filter->num_gops = 0;
@@ -1728,6 +5489,87 @@ static void gst_pre_record_loop_init(GstPreRecordLoop* filter) {
   memset(&filter->stats, 0, sizeof(filter->stats));
   filter->flush_on_eos = GST_PREREC_FLUSH_ON_EOS_AUTO;
   filter->flush_trigger_name = NULL;
+  filter->clip_events = FALSE;
+  filter->clip_id = 0;
+  filter->clip_drain_bytes = 0;
+  filter->clip_open = filter->clip_start_pending = filter->clip_end_pending = FALSE;
+  filter->preserve_on_reconfigure = FALSE;
+  filter->ring_id = NULL;
+  filter->ring_park_timeout = DEFAULT_RING_PARK_TIMEOUT;
+  filter->caps = NULL;
+  filter->adopt_offset = 0;
+  filter->adopt_rebase_pending = filter->adopt_epoch_pending = FALSE;
+  filter->drain_rebase = FALSE;
+  filter->drain_base_time = 0;
+  filter->rebase_offset = 0;
+  filter->rebase_pending = filter->rebase_active = FALSE;
+  filter->drain_bytes_per_sec = 0;
+  filter->drain_duration = 0;
+  filter->trigger_received = GST_CLOCK_TIME_NONE;
+  filter->drain_qos = FALSE;
+  g_mutex_init(&filter->qos_lock);
+  filter->qos_draining = FALSE;
+  filter->qos_proportion = 1.0;
+  filter->qos_jitter = 0;
+  filter->qos_timestamp = GST_CLOCK_TIME_NONE;
+  gst_prerec_hist_reset(&filter->hist_enqueue);
+  gst_prerec_hist_reset(&filter->hist_prune);
+  gst_prerec_hist_reset(&filter->hist_drain_push);
+  gst_prerec_hist_reset(&filter->hist_residency);
+  gst_prerec_flight_init(&filter->flight);
+  filter->post_messages = FALSE;
+  filter->fill_thresholds = NULL;
+  filter->fill_levels = NULL;
+  gst_prerec_set_fill_thresholds(filter, DEFAULT_FILL_THRESHOLDS);
+  filter->message_interval = DEFAULT_MESSAGE_INTERVAL;
+  filter->prune_posted_at = GST_CLOCK_TIME_NONE;
+  filter->prune_pending_gops = 0;
+  filter->messages = g_ptr_array_new();
+  filter->messages_pending = 0;
+  filter->stats_page = DEFAULT_STATS_PAGE;
+  filter->stats_shm = NULL;
+
+  g_mutex_init(&filter->live_lock);
+  g_cond_init(&filter->live_cond);
+  filter->live_pad = NULL;
+  filter->live_queue = gst_vec_deque_new(DEFAULT_LIVE_MAX_BUFFERS + 8);
+  filter->live_level = 0;
+  filter->live_events = 0;
+  filter->live_max_buffers = DEFAULT_LIVE_MAX_BUFFERS;
+  filter->live_leaky = GST_PREREC_LIVE_LEAKY_DOWNSTREAM;
+  filter->live_flushing = TRUE;
+  filter->live_paused = FALSE;
+
+  filter->spill_location = NULL;
+  filter->spill_ram_time = DEFAULT_SPILL_RAM_TIME;
+  filter->spill_max_bytes = DEFAULT_SPILL_MAX_BYTES;
+  filter->handoff_max_bytes = DEFAULT_HANDOFF_MAX_BYTES;
+  filter->slab_enabled = FALSE;
+  filter->slab_max_bytes = DEFAULT_SLAB_MAX_BYTES;
+  filter->slab_hugepages = FALSE;
+  filter->slab_mlock = FALSE;
+  filter->slab = NULL;
+  filter->strip_meta_apis = NULL;
+  filter->strip_meta_quarks = NULL;
+  filter->strip_meta_mode = GST_PREREC_META_STRIP_REMOVE;
+  filter->spill = NULL;
+  filter->spill_thread = NULL;
+  g_cond_init(&filter->spill_cond);
+  filter->spill_stop = FALSE;
+  filter->spill_newest_ts = GST_CLOCK_TIME_NONE;
+  filter->spill_queued_bytes = 0;
+
+  filter->journal_location = NULL;
+  filter->journal_dir = NULL;
+  filter->journal_thread = NULL;
+  filter->journal_jobs = NULL;
+  filter->journal_pending = 0;
+  filter->journal_entries = g_array_new(FALSE, FALSE, sizeof(GstPreRecJournalEntry));
+  filter->journal_seq = 0;
+  filter->journal_recover_pending = FALSE;
+  filter->journal_loaded = NULL;
+  filter->journal_loaded_done = FALSE;
+  g_cond_init(&filter->journal_cond);
 }
 
 static void gst_prerec_get_stats(GstPreRecordLoop* loop, GstPreRecStats* out_stats) {
@@ -1735,7 +5577,15 @@ static void gst_prerec_get_stats(GstPreRecordLoop* loop, GstPreRecStats* out_sta
   g_return_if_fail(out_stats != NULL);
   GST_PREREC_MUTEX_LOCK(loop);
   *out_stats = loop->stats; /* shallow copy */
+  out_stats->ram_bytes_cur = loop->cur_level.bytes - loop->spill_queued_bytes;
+  out_stats->spill_bytes_cur = loop->spill ? gst_prerec_spill_get_used(loop->spill) : 0;
+  if (loop->slab)
+    gst_prerec_slab_allocator_get_stats(loop->slab, &out_stats->slab_reserved_cur, &out_stats->slab_used_cur,
+                                        &out_stats->slab_fallbacks);
   GST_PREREC_MUTEX_UNLOCK(loop);
+  g_mutex_lock(&loop->live_lock); /* live_drops is owned by the live queue */
+  out_stats->live_drops = loop->stats.live_drops;
+  g_mutex_unlock(&loop->live_lock);
 }
 
 /* entry point to initialize the plug-in
@@ -1752,7 +5602,9 @@ static gboolean prerecordloop_init(GstPlugin* prerecordloop) {
                           "pre capture ring bufffer element");
   GST_DEBUG_CATEGORY_INIT(prerec_dataflow, "pre_record_loop_dataflow", GST_DEBUG_FG_CYAN | GST_DEBUG_BOLD,
                           "dataflow inside the prerec loop");
-  return GST_ELEMENT_REGISTER(pre_record_loop, prerecordloop);
+  /* companion sink for drained clips */
+  return GST_ELEMENT_REGISTER(pre_record_loop, prerecordloop) && GST_ELEMENT_REGISTER(prerec_clipsink, prerecordloop) &&
+         gst_prerec_tracer_register(prerecordloop);
 }
 
 /* PACKAGE: this is usually set by meson depending on some _INIT macro
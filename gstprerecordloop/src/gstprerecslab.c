@@ -0,0 +1,288 @@
+/*
+ * GStreamer pre-record loop: slab allocator for encoded frames
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#include <gstprerecordloop/gstprerecslab.h>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+
+GST_DEBUG_CATEGORY_STATIC(prerec_slab_debug);
+#define GST_CAT_DEFAULT prerec_slab_debug
+
+#define SLAB_CHUNK_SIZE (4 << 20) /* multiple of the 2 MiB hugepage size */
+#define SLAB_MIN_SHIFT 10
+#define SLAB_MAX_SHIFT 20
+#define SLAB_MIN_BLOCK (1 << SLAB_MIN_SHIFT)
+#define SLAB_MAX_BLOCK (1 << SLAB_MAX_SHIFT)
+#define SLAB_N_CLASSES ((SLAB_MAX_SHIFT - SLAB_MIN_SHIFT) * 4 + 1)
+#define SLAB_ALIGN 256 /* every class size is a multiple of it */
+
+typedef struct {
+  GstMemory mem;
+  guint8* data;
+  gint cls; /* size class the block returns to; -1 for shared sub-memories */
+} GstPreRecSlabMemory;
+
+struct _GstPreRecSlabAllocator {
+  GstAllocator parent;
+
+  GMutex lock;
+  guint64 max_bytes;
+  gboolean hugepages;
+  gboolean lock_pages;
+  gboolean lock_warned;
+
+  GPtrArray* chunks;                    /* SLAB_CHUNK_SIZE mappings */
+  guint8 *cur, *end;                    /* not yet carved part of the newest chunk */
+  guint8* free_lists[SLAB_N_CLASSES];   /* next pointer stored in the free block */
+  guint64 reserved, used;
+  gint fallbacks;
+};
+
+G_DEFINE_TYPE(GstPreRecSlabAllocator, gst_prerec_slab_allocator, GST_TYPE_ALLOCATOR);
+
+/* Class 0 is SLAB_MIN_BLOCK; above it every power of two is split in four:
+ * 1280, 1536, 1792, 2048, 2560, ... so a frame wastes at most 20%. */
+static gsize slab_class_size(guint cls) {
+  gsize base;
+
+  if (cls == 0)
+    return SLAB_MIN_BLOCK;
+  base = (gsize) 1 << (SLAB_MIN_SHIFT + (cls - 1) / 4);
+  return base + ((cls - 1) % 4 + 1) * (base / 4);
+}
+
+/* Smallest class holding size (size <= SLAB_MAX_BLOCK) */
+static guint slab_class_for(gsize size) {
+  guint k;
+  gsize base, step;
+
+  if (size <= SLAB_MIN_BLOCK)
+    return 0;
+  k = g_bit_storage(size - 1) - 1; /* 2^k < size <= 2^(k+1) */
+  base = (gsize) 1 << k;
+  step = base / 4;
+  return (k - SLAB_MIN_SHIFT) * 4 + (guint) ((size - base + step - 1) / step);
+}
+
+static guint8* slab_map_chunk(GstPreRecSlabAllocator* self) {
+  void* p = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+  if (self->hugepages)
+    p = mmap(NULL, SLAB_CHUNK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+  if (p == MAP_FAILED) {
+    p = mmap(NULL, SLAB_CHUNK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+      GST_WARNING_OBJECT(self, "cannot map a chunk: %s", g_strerror(errno));
+      return NULL;
+    }
+#ifdef MADV_HUGEPAGE
+    /* no reserved hugepages: let transparent hugepages back the chunk */
+    if (self->hugepages)
+      madvise(p, SLAB_CHUNK_SIZE, MADV_HUGEPAGE);
+#endif
+  }
+  if (self->lock_pages && mlock(p, SLAB_CHUNK_SIZE) != 0 && !self->lock_warned) {
+    GST_WARNING_OBJECT(self, "cannot lock chunk pages (RLIMIT_MEMLOCK?): %s", g_strerror(errno));
+    self->lock_warned = TRUE;
+  }
+  return p;
+}
+
+/* Hands what is left of the current chunk to the free lists of the largest
+ * classes that fit, before a new chunk replaces it */
+static void slab_locked_retire_tail(GstPreRecSlabAllocator* self) {
+  while (self->cur && (gsize) (self->end - self->cur) >= SLAB_MIN_BLOCK) {
+    gsize rest = MIN((gsize) (self->end - self->cur), SLAB_MAX_BLOCK);
+    guint cls = slab_class_for(rest);
+
+    if (slab_class_size(cls) > rest)
+      cls--;
+    *(guint8**) self->cur = self->free_lists[cls];
+    self->free_lists[cls] = self->cur;
+    self->cur += slab_class_size(cls);
+  }
+}
+
+static guint8* slab_locked_take(GstPreRecSlabAllocator* self, guint cls) {
+  gsize size = slab_class_size(cls);
+  guint8* block = self->free_lists[cls];
+
+  if (block) {
+    self->free_lists[cls] = *(guint8**) block;
+  } else {
+    if (!self->cur || (gsize) (self->end - self->cur) < size) {
+      guint8* chunk;
+
+      if (self->reserved + SLAB_CHUNK_SIZE > self->max_bytes)
+        return NULL;
+      chunk = slab_map_chunk(self);
+      if (!chunk)
+        return NULL;
+      slab_locked_retire_tail(self);
+      g_ptr_array_add(self->chunks, chunk);
+      self->reserved += SLAB_CHUNK_SIZE;
+      self->cur = chunk;
+      self->end = chunk + SLAB_CHUNK_SIZE;
+      GST_DEBUG_OBJECT(self, "chunk %u mapped, %" G_GUINT64_FORMAT " bytes reserved", self->chunks->len,
+                       self->reserved);
+    }
+    block = self->cur;
+    self->cur += size;
+  }
+  self->used += size;
+  return block;
+}
+
+static GstMemory* gst_prerec_slab_alloc(GstAllocator* allocator, gsize size, GstAllocationParams* params) {
+  GstPreRecSlabAllocator* self = GST_PREREC_SLAB_ALLOCATOR(allocator);
+  gsize maxsize = size + params->prefix + params->padding;
+  GstPreRecSlabMemory* mem;
+  guint8* block = NULL;
+  guint cls = 0;
+
+  if (params->align < SLAB_ALIGN && maxsize <= SLAB_MAX_BLOCK) {
+    cls = slab_class_for(maxsize);
+    g_mutex_lock(&self->lock);
+    block = slab_locked_take(self, cls);
+    g_mutex_unlock(&self->lock);
+  }
+  if (!block) {
+    g_atomic_int_inc(&self->fallbacks);
+    return gst_allocator_alloc(NULL, size, params);
+  }
+
+  mem = g_new(GstPreRecSlabMemory, 1);
+  gst_memory_init(GST_MEMORY_CAST(mem), params->flags, allocator, NULL, maxsize, params->align, params->prefix, size);
+  mem->data = block;
+  mem->cls = (gint) cls;
+  if (params->prefix && (params->flags & GST_MEMORY_FLAG_ZERO_PREFIXED))
+    memset(block, 0, params->prefix);
+  if (params->padding && (params->flags & GST_MEMORY_FLAG_ZERO_PADDED))
+    memset(block + params->prefix + size, 0, params->padding);
+  return GST_MEMORY_CAST(mem);
+}
+
+static void gst_prerec_slab_free(GstAllocator* allocator, GstMemory* memory) {
+  GstPreRecSlabAllocator* self = GST_PREREC_SLAB_ALLOCATOR(allocator);
+  GstPreRecSlabMemory* mem = (GstPreRecSlabMemory*) memory;
+
+  if (mem->cls >= 0) {
+    g_mutex_lock(&self->lock);
+    *(guint8**) mem->data = self->free_lists[mem->cls];
+    self->free_lists[mem->cls] = mem->data;
+    self->used -= slab_class_size((guint) mem->cls);
+    g_mutex_unlock(&self->lock);
+  }
+  g_free(mem);
+}
+
+static gpointer gst_prerec_slab_mem_map(GstMemory* memory, gsize maxsize, GstMapFlags flags) {
+  return ((GstPreRecSlabMemory*) memory)->data;
+}
+
+static void gst_prerec_slab_mem_unmap(GstMemory* memory) {
+}
+
+static GstMemory* gst_prerec_slab_mem_share(GstMemory* memory, gssize offset, gssize size) {
+  GstMemory* parent = memory->parent ? memory->parent : memory;
+  GstPreRecSlabMemory* sub;
+
+  if (size == -1)
+    size = memory->size - offset;
+  sub = g_new(GstPreRecSlabMemory, 1);
+  gst_memory_init(GST_MEMORY_CAST(sub), GST_MINI_OBJECT_FLAGS(parent) | GST_MINI_OBJECT_FLAG_LOCK_READONLY,
+                  memory->allocator, parent, memory->maxsize, memory->align, memory->offset + offset, size);
+  sub->data = ((GstPreRecSlabMemory*) memory)->data;
+  sub->cls = -1; /* the block goes back when parent is freed */
+  return GST_MEMORY_CAST(sub);
+}
+
+static GstMemory* gst_prerec_slab_mem_copy(GstMemory* memory, gssize offset, gssize size) {
+  GstAllocationParams params;
+  GstMemory* copy;
+  GstMapInfo map;
+
+  if (size == -1)
+    size = memory->size > (gsize) offset ? memory->size - offset : 0;
+  gst_allocation_params_init(&params);
+  params.align = memory->align;
+  copy = gst_allocator_alloc(memory->allocator, size, &params);
+  if (copy && gst_memory_map(copy, &map, GST_MAP_WRITE)) {
+    memcpy(map.data, ((GstPreRecSlabMemory*) memory)->data + memory->offset + offset, size);
+    gst_memory_unmap(copy, &map);
+  }
+  return copy;
+}
+
+static gboolean gst_prerec_slab_mem_is_span(GstMemory* mem1, GstMemory* mem2, gsize* offset) {
+  if (offset)
+    *offset = mem1->offset - mem1->parent->offset;
+  return ((GstPreRecSlabMemory*) mem1)->data + mem1->offset + mem1->size ==
+         ((GstPreRecSlabMemory*) mem2)->data + mem2->offset;
+}
+
+static void gst_prerec_slab_allocator_finalize(GObject* object) {
+  GstPreRecSlabAllocator* self = GST_PREREC_SLAB_ALLOCATOR(object);
+
+  /* every memory held a ref: nothing points into the chunks any more */
+  for (guint i = 0; i < self->chunks->len; ++i)
+    munmap(g_ptr_array_index(self->chunks, i), SLAB_CHUNK_SIZE);
+  g_ptr_array_unref(self->chunks);
+  g_mutex_clear(&self->lock);
+  G_OBJECT_CLASS(gst_prerec_slab_allocator_parent_class)->finalize(object);
+}
+
+static void gst_prerec_slab_allocator_class_init(GstPreRecSlabAllocatorClass* klass) {
+  GObjectClass* gobject_class = G_OBJECT_CLASS(klass);
+  GstAllocatorClass* allocator_class = GST_ALLOCATOR_CLASS(klass);
+
+  GST_DEBUG_CATEGORY_INIT(prerec_slab_debug, "pre_record_loop_slab", 0, "pre record loop slab allocator");
+
+  gobject_class->finalize = gst_prerec_slab_allocator_finalize;
+  allocator_class->alloc = gst_prerec_slab_alloc;
+  allocator_class->free = gst_prerec_slab_free;
+}
+
+static void gst_prerec_slab_allocator_init(GstPreRecSlabAllocator* self) {
+  GstAllocator* allocator = GST_ALLOCATOR_CAST(self);
+
+  allocator->mem_type = GST_PREREC_SLAB_MEMORY_TYPE;
+  allocator->mem_map = gst_prerec_slab_mem_map;
+  allocator->mem_unmap = gst_prerec_slab_mem_unmap;
+  allocator->mem_share = gst_prerec_slab_mem_share;
+  allocator->mem_copy = gst_prerec_slab_mem_copy;
+  allocator->mem_is_span = gst_prerec_slab_mem_is_span;
+
+  g_mutex_init(&self->lock);
+  self->chunks = g_ptr_array_new();
+}
+
+GstAllocator* gst_prerec_slab_allocator_new(guint64 max_bytes, gboolean hugepages, gboolean lock_pages) {
+  GstPreRecSlabAllocator* self = g_object_new(GST_TYPE_PREREC_SLAB_ALLOCATOR, NULL);
+
+  gst_object_ref_sink(self);
+  self->max_bytes = max_bytes;
+  self->hugepages = hugepages;
+  self->lock_pages = lock_pages;
+  GST_INFO_OBJECT(self, "up to %" G_GUINT64_FORMAT " bytes (hugepages=%d, mlock=%d)", max_bytes, hugepages,
+                  lock_pages);
+  return GST_ALLOCATOR_CAST(self);
+}
+
+void gst_prerec_slab_allocator_get_stats(GstAllocator* allocator, guint64* reserved, guint64* used,
+                                         guint* fallbacks) {
+  GstPreRecSlabAllocator* self = GST_PREREC_SLAB_ALLOCATOR(allocator);
+
+  g_mutex_lock(&self->lock);
+  *reserved = self->reserved;
+  *used = self->used;
+  g_mutex_unlock(&self->lock);
+  *fallbacks = (guint) g_atomic_int_get(&self->fallbacks);
+}
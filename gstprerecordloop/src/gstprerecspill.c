@@ -0,0 +1,453 @@
+/*
+ * GStreamer pre-record loop: disk spill tier
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE /* memfd_create */
+#endif
+
+#include <gstprerecordloop/gstprerecspill.h>
+#include <gst/gstvecdeque.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+GST_DEBUG_CATEGORY_STATIC(prerec_spill_debug);
+#define GST_CAT_DEFAULT prerec_spill_debug
+
+#define SPILL_ALIGN 64 /* keep blocks cache-line aligned */
+
+typedef struct {
+  gsize offset;
+  gsize len;
+  gboolean released;
+} GstPreRecSpillBlock;
+
+/* user_data of a wrapped memory */
+typedef struct {
+  GstPreRecSpill* spill;
+  guint64 seq;
+} GstPreRecSpillRef;
+
+struct _GstPreRecSpill {
+  gint refcount;
+  GMutex lock;
+
+  gint fd;
+  guint8* base;
+  gsize capacity;
+  gboolean evict; /* file-backed: drop PTEs after each copy */
+
+  /* live region is [tail, head), possibly wrapped; blocks in allocation order */
+  gsize head, tail, used;
+  GstVecDeque* blocks; /* GstPreRecSpillBlock */
+  guint64 first_seq;   /* seq of the block at the head of blocks */
+};
+
+static void gst_prerec_spill_init_debug(void) {
+  static gsize done = 0;
+  if (g_once_init_enter(&done)) {
+    GST_DEBUG_CATEGORY_INIT(prerec_spill_debug, "pre_record_loop_spill", 0, "pre record loop disk spill tier");
+    g_once_init_leave(&done, 1);
+  }
+}
+
+/* Sizes, reserves and maps fd; takes ownership of fd. The blocks are
+ * allocated up front: the arena is written through a shared mapping, where
+ * a full filesystem (tmpfs included) would only show up as SIGBUS on the
+ * spill thread. */
+static GstPreRecSpill* gst_prerec_spill_new_for_fd(gint fd, guint64 max_bytes, const gchar* desc, GError** error) {
+  GstPreRecSpill* spill;
+  void* base;
+  gint err = 0;
+
+#ifdef __APPLE__
+  /* no posix_fallocate() on macOS: sized only */
+  if (ftruncate(fd, (off_t) max_bytes) != 0)
+    err = errno;
+#else
+  err = posix_fallocate(fd, 0, (off_t) max_bytes);
+#endif
+  if (err != 0) {
+    g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(err), "Cannot reserve %" G_GUINT64_FORMAT
+                " bytes for arena %s: %s", max_bytes, desc, g_strerror(err));
+    close(fd);
+    return NULL;
+  }
+  base = mmap(NULL, max_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED) {
+    g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno), "Cannot map arena %s: %s", desc,
+                g_strerror(errno));
+    close(fd);
+    return NULL;
+  }
+
+  spill = g_new0(GstPreRecSpill, 1);
+  spill->refcount = 1;
+  g_mutex_init(&spill->lock);
+  spill->fd = fd;
+  spill->base = base;
+  spill->capacity = max_bytes;
+  spill->blocks = gst_vec_deque_new_for_struct(sizeof(GstPreRecSpillBlock), 256);
+  GST_INFO("arena of %" G_GUINT64_FORMAT " bytes in %s", max_bytes, desc);
+  return spill;
+}
+
+GstPreRecSpill* gst_prerec_spill_new(const gchar* location, guint64 max_bytes, GError** error) {
+  GstPreRecSpill* spill;
+  gchar* path;
+  gint fd;
+
+  g_return_val_if_fail(location != NULL, NULL);
+  g_return_val_if_fail(max_bytes > 0, NULL);
+  gst_prerec_spill_init_debug();
+
+  path = g_build_filename(location, "prerec-spill-XXXXXX", NULL);
+  fd = g_mkstemp(path);
+  if (fd < 0) {
+    g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno), "Cannot create spill file in %s: %s", location,
+                g_strerror(errno));
+    g_free(path);
+    return NULL;
+  }
+  /* anonymous from here on: the data dies with the process */
+  unlink(path);
+
+  spill = gst_prerec_spill_new_for_fd(fd, max_bytes, path, error);
+  if (spill)
+    spill->evict = TRUE;
+  g_free(path);
+  return spill;
+}
+
+GstPreRecSpill* gst_prerec_spill_new_memfd(const gchar* name, guint64 max_bytes, GError** error) {
+  g_return_val_if_fail(max_bytes > 0, NULL);
+  gst_prerec_spill_init_debug();
+
+#ifdef __linux__
+  GstPreRecSpill* spill;
+  gint fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno), "Cannot create memfd %s: %s", name,
+                g_strerror(errno));
+    return NULL;
+  }
+  spill = gst_prerec_spill_new_for_fd(fd, max_bytes, name, error);
+  /* consumers may rely on the size never changing under their mapping */
+  if (spill)
+    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+  return spill;
+#else
+  g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_NOSYS, "memfd arenas need Linux");
+  return NULL;
+#endif
+}
+
+GstPreRecSpill* gst_prerec_spill_ref(GstPreRecSpill* spill) {
+  g_atomic_int_inc(&spill->refcount);
+  return spill;
+}
+
+void gst_prerec_spill_unref(GstPreRecSpill* spill) {
+  if (!g_atomic_int_dec_and_test(&spill->refcount))
+    return;
+  munmap(spill->base, spill->capacity);
+  close(spill->fd);
+  gst_vec_deque_free(spill->blocks);
+  g_mutex_clear(&spill->lock);
+  g_free(spill);
+}
+
+/* Reserves len bytes; returns the block seq or -1 when full */
+static gint64 gst_prerec_spill_locked_alloc(GstPreRecSpill* spill, gsize len, gsize* out_offset) {
+  GstPreRecSpillBlock block;
+  gsize offset;
+
+  if (gst_vec_deque_is_empty(spill->blocks)) {
+    spill->head = spill->tail = 0;
+    if (len > spill->capacity)
+      return -1;
+    offset = 0;
+  } else if (spill->tail < spill->head) {
+    if (spill->capacity - spill->head >= len)
+      offset = spill->head;
+    else if (spill->tail >= len)
+      offset = 0; /* wrap; the end gap is reclaimed with the block before it */
+    else
+      return -1;
+  } else {
+    if (spill->tail - spill->head >= len)
+      offset = spill->head;
+    else
+      return -1;
+  }
+
+  block.offset = offset;
+  block.len = len;
+  block.released = FALSE;
+  gst_vec_deque_push_tail_struct(spill->blocks, &block);
+  spill->head = offset + len;
+  spill->used += len;
+  *out_offset = offset;
+  return (gint64) (spill->first_seq + gst_vec_deque_get_length(spill->blocks) - 1);
+}
+
+static void gst_prerec_spill_release(gpointer user_data) {
+  GstPreRecSpillRef* ref = user_data;
+  GstPreRecSpill* spill = ref->spill;
+  GstPreRecSpillBlock* block;
+
+  g_mutex_lock(&spill->lock);
+  block = gst_vec_deque_peek_nth_struct(spill->blocks, (guint) (ref->seq - spill->first_seq));
+  block->released = TRUE;
+  while ((block = gst_vec_deque_peek_head_struct(spill->blocks)) && block->released) {
+    spill->used -= block->len;
+    gst_vec_deque_pop_head_struct(spill->blocks);
+    spill->first_seq++;
+  }
+  block = gst_vec_deque_peek_head_struct(spill->blocks);
+  spill->tail = block ? block->offset : spill->head;
+  g_mutex_unlock(&spill->lock);
+
+  g_free(ref);
+  gst_prerec_spill_unref(spill);
+}
+
+/* Drops the process' page table entries for the fully covered pages of a
+ * block; the data stays in the file (page cache / NVMe). */
+static void gst_prerec_spill_evict(guint8* data, gsize len) {
+  gsize page = (gsize) sysconf(_SC_PAGESIZE);
+  guintptr start = GPOINTER_TO_SIZE(data);
+  guintptr first = (start + page - 1) & ~(guintptr) (page - 1);
+  guintptr last = (start + len) & ~(guintptr) (page - 1);
+
+  if (last > first)
+    madvise(GSIZE_TO_POINTER(first), last - first, MADV_DONTNEED);
+}
+
+GstBuffer* gst_prerec_spill_store(GstPreRecSpill* spill, GstBuffer* buf) {
+  gsize size = gst_buffer_get_size(buf);
+  gsize len = (size + SPILL_ALIGN - 1) & ~(gsize) (SPILL_ALIGN - 1);
+  gsize offset = 0;
+  gint64 seq;
+  GstPreRecSpillRef* ref;
+  GstBuffer* out;
+  guint8* data;
+
+  if (size == 0)
+    return NULL;
+
+  g_mutex_lock(&spill->lock);
+  seq = gst_prerec_spill_locked_alloc(spill, len, &offset);
+  g_mutex_unlock(&spill->lock);
+  if (seq < 0)
+    return NULL;
+
+  /* the block is ours until released: copy without the arena lock */
+  data = spill->base + offset;
+  gst_buffer_extract(buf, 0, data, size);
+  if (spill->evict)
+    gst_prerec_spill_evict(data, size);
+
+  ref = g_new(GstPreRecSpillRef, 1);
+  ref->spill = gst_prerec_spill_ref(spill);
+  ref->seq = (guint64) seq;
+
+  out = gst_buffer_new();
+  gst_buffer_copy_into(out, buf, GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS | GST_BUFFER_COPY_META, 0, -1);
+  gst_buffer_append_memory(out, gst_memory_new_wrapped(GST_MEMORY_FLAG_READONLY, data, size, 0, size, ref,
+                                                       gst_prerec_spill_release));
+  return out;
+}
+
+guint64 gst_prerec_spill_get_used(GstPreRecSpill* spill) {
+  guint64 used;
+  g_mutex_lock(&spill->lock);
+  used = spill->used;
+  g_mutex_unlock(&spill->lock);
+  return used;
+}
+
+void gst_prerec_spill_prefetch(GstBuffer* buf) {
+  GstMapInfo map;
+  gsize page = (gsize) sysconf(_SC_PAGESIZE);
+
+  if (!gst_buffer_map(buf, &map, GST_MAP_READ))
+    return;
+  if (map.size > 0) {
+    guintptr start = GPOINTER_TO_SIZE(map.data) & ~(guintptr) (page - 1);
+    madvise(GSIZE_TO_POINTER(start), GPOINTER_TO_SIZE(map.data) + map.size - start, MADV_WILLNEED);
+  }
+  gst_buffer_unmap(buf, &map);
+}
+
+gint gst_prerec_spill_get_fd(GstPreRecSpill* spill) {
+  return spill->fd;
+}
+
+gsize gst_prerec_spill_get_capacity(GstPreRecSpill* spill) {
+  return spill->capacity;
+}
+
+gboolean gst_prerec_spill_locate(GstPreRecSpill* spill, GstBuffer* buf, guint64* offset) {
+  GstMapInfo map;
+  gboolean found;
+
+  if (gst_buffer_n_memory(buf) != 1 || !gst_buffer_map(buf, &map, GST_MAP_READ))
+    return FALSE;
+  /* a single wrapped memory maps to its own data, so no copy happens here */
+  found = map.size > 0 && map.data >= spill->base && map.data + map.size <= spill->base + spill->capacity;
+  if (found)
+    *offset = (guint64) (map.data - spill->base);
+  gst_buffer_unmap(buf, &map);
+  return found;
+}
+
+/* Arena allocator */
+
+typedef struct {
+  GstMemory mem;
+  guint8* data;
+  GstPreRecSpillRef* ref; /* block to release; NULL for shared sub-memories */
+} GstPreRecArenaMemory;
+
+struct _GstPreRecArenaAllocator {
+  GstAllocator parent;
+  GstPreRecSpill* spill;
+};
+
+G_DEFINE_TYPE(GstPreRecArenaAllocator, gst_prerec_arena_allocator, GST_TYPE_ALLOCATOR);
+
+static GstMemory* gst_prerec_arena_alloc(GstAllocator* allocator, gsize size, GstAllocationParams* params) {
+  GstPreRecArenaAllocator* self = GST_PREREC_ARENA_ALLOCATOR(allocator);
+  GstPreRecSpill* spill = self->spill;
+  gsize maxsize = size + params->prefix + params->padding;
+  gsize len = (maxsize + SPILL_ALIGN - 1) & ~(gsize) (SPILL_ALIGN - 1);
+  gsize offset = 0;
+  gint64 seq = -1;
+  GstPreRecArenaMemory* mem;
+  guint8* data;
+
+  /* block offsets are SPILL_ALIGN aligned and the mapping page aligned */
+  if (maxsize > 0 && params->align < SPILL_ALIGN) {
+    g_mutex_lock(&spill->lock);
+    seq = gst_prerec_spill_locked_alloc(spill, len, &offset);
+    g_mutex_unlock(&spill->lock);
+  }
+  if (seq < 0) {
+    GST_LOG_OBJECT(self, "arena cannot serve %" G_GSIZE_FORMAT " bytes, using system memory", maxsize);
+    return gst_allocator_alloc(NULL, size, params);
+  }
+
+  data = spill->base + offset;
+  mem = g_new(GstPreRecArenaMemory, 1);
+  gst_memory_init(GST_MEMORY_CAST(mem), params->flags, allocator, NULL, maxsize, params->align, params->prefix, size);
+  mem->data = data;
+  mem->ref = g_new(GstPreRecSpillRef, 1);
+  mem->ref->spill = gst_prerec_spill_ref(spill);
+  mem->ref->seq = (guint64) seq;
+  if (params->prefix && (params->flags & GST_MEMORY_FLAG_ZERO_PREFIXED))
+    memset(data, 0, params->prefix);
+  if (params->padding && (params->flags & GST_MEMORY_FLAG_ZERO_PADDED))
+    memset(data + params->prefix + size, 0, params->padding);
+  return GST_MEMORY_CAST(mem);
+}
+
+static void gst_prerec_arena_free(GstAllocator* allocator, GstMemory* memory) {
+  GstPreRecArenaMemory* mem = (GstPreRecArenaMemory*) memory;
+
+  if (mem->ref)
+    gst_prerec_spill_release(mem->ref);
+  g_free(mem);
+}
+
+static gpointer gst_prerec_arena_mem_map(GstMemory* memory, gsize maxsize, GstMapFlags flags) {
+  return ((GstPreRecArenaMemory*) memory)->data;
+}
+
+static void gst_prerec_arena_mem_unmap(GstMemory* memory) {
+}
+
+static GstMemory* gst_prerec_arena_mem_share(GstMemory* memory, gssize offset, gssize size) {
+  GstMemory* parent = memory->parent ? memory->parent : memory;
+  GstPreRecArenaMemory* sub;
+
+  if (size == -1)
+    size = memory->size - offset;
+  sub = g_new(GstPreRecArenaMemory, 1);
+  gst_memory_init(GST_MEMORY_CAST(sub), GST_MINI_OBJECT_FLAGS(parent) | GST_MINI_OBJECT_FLAG_LOCK_READONLY,
+                  memory->allocator, parent, memory->maxsize, memory->align, memory->offset + offset, size);
+  sub->data = ((GstPreRecArenaMemory*) memory)->data;
+  sub->ref = NULL; /* the block goes back when parent is freed */
+  return GST_MEMORY_CAST(sub);
+}
+
+/* Copies are made to be written to: keep them out of the arena */
+static GstMemory* gst_prerec_arena_mem_copy(GstMemory* memory, gssize offset, gssize size) {
+  GstAllocationParams params;
+  GstMemory* copy;
+  GstMapInfo map;
+
+  if (size == -1)
+    size = memory->size > (gsize) offset ? memory->size - offset : 0;
+  gst_allocation_params_init(&params);
+  params.align = memory->align;
+  copy = gst_allocator_alloc(NULL, size, &params);
+  if (copy && gst_memory_map(copy, &map, GST_MAP_WRITE)) {
+    memcpy(map.data, ((GstPreRecArenaMemory*) memory)->data + memory->offset + offset, size);
+    gst_memory_unmap(copy, &map);
+  }
+  return copy;
+}
+
+static gboolean gst_prerec_arena_mem_is_span(GstMemory* mem1, GstMemory* mem2, gsize* offset) {
+  if (offset)
+    *offset = mem1->offset - mem1->parent->offset;
+  return ((GstPreRecArenaMemory*) mem1)->data + mem1->offset + mem1->size ==
+         ((GstPreRecArenaMemory*) mem2)->data + mem2->offset;
+}
+
+static void gst_prerec_arena_allocator_finalize(GObject* object) {
+  GstPreRecArenaAllocator* self = GST_PREREC_ARENA_ALLOCATOR(object);
+
+  gst_prerec_spill_unref(self->spill);
+  G_OBJECT_CLASS(gst_prerec_arena_allocator_parent_class)->finalize(object);
+}
+
+static void gst_prerec_arena_allocator_class_init(GstPreRecArenaAllocatorClass* klass) {
+  GObjectClass* gobject_class = G_OBJECT_CLASS(klass);
+  GstAllocatorClass* allocator_class = GST_ALLOCATOR_CLASS(klass);
+
+  gobject_class->finalize = gst_prerec_arena_allocator_finalize;
+  allocator_class->alloc = gst_prerec_arena_alloc;
+  allocator_class->free = gst_prerec_arena_free;
+}
+
+static void gst_prerec_arena_allocator_init(GstPreRecArenaAllocator* self) {
+  GstAllocator* allocator = GST_ALLOCATOR_CAST(self);
+
+  allocator->mem_type = GST_PREREC_ARENA_MEMORY_TYPE;
+  allocator->mem_map = gst_prerec_arena_mem_map;
+  allocator->mem_unmap = gst_prerec_arena_mem_unmap;
+  allocator->mem_share = gst_prerec_arena_mem_share;
+  allocator->mem_copy = gst_prerec_arena_mem_copy;
+  allocator->mem_is_span = gst_prerec_arena_mem_is_span;
+}
+
+GstAllocator* gst_prerec_arena_allocator_new(GstPreRecSpill* spill) {
+  GstPreRecArenaAllocator* self;
+
+  g_return_val_if_fail(spill != NULL, NULL);
+  gst_prerec_spill_init_debug();
+
+  self = g_object_new(GST_TYPE_PREREC_ARENA_ALLOCATOR, NULL);
+  gst_object_ref_sink(self);
+  self->spill = gst_prerec_spill_ref(spill);
+  GST_INFO_OBJECT(self, "over an arena of %" G_GSIZE_FORMAT " bytes", spill->capacity);
+  return GST_ALLOCATOR_CAST(self);
+}
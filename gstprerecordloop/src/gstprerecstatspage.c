@@ -0,0 +1,72 @@
+/*
+ * GStreamer pre-record loop: shared-memory stats page
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+#include <gstprerecordloop/gstprerecstatspage.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Numbers the pages of one process; pids keep processes apart */
+static gint page_counter;
+
+GstPreRecStatsShm* gst_prerec_stats_shm_new(const gchar* element_path, GError** error) {
+  GstPreRecStatsShm* shm;
+  GstPreRecStatsPage* page;
+  gchar* name;
+  gint fd;
+
+  name = g_strdup_printf(GST_PREREC_STATS_SHM_PREFIX "%d-%d", (gint) getpid(), g_atomic_int_add(&page_counter, 1));
+  fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno), "Cannot create stats page %s: %s", name,
+                g_strerror(errno));
+    g_free(name);
+    return NULL;
+  }
+  if (ftruncate(fd, sizeof(GstPreRecStatsPage)) != 0) {
+    g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno), "Cannot size stats page %s: %s", name,
+                g_strerror(errno));
+    goto fail;
+  }
+  page = mmap(NULL, sizeof(GstPreRecStatsPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (page == MAP_FAILED) {
+    g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno), "Cannot map stats page %s: %s", name,
+                g_strerror(errno));
+    goto fail;
+  }
+  close(fd);
+
+  /* ftruncate zero-filled it: seq is even, every counter 0. magic goes
+   * last so monitors skip a page that is still being set up. */
+  page->version = GST_PREREC_STATS_VERSION;
+  page->size = sizeof(GstPreRecStatsPage);
+  page->pid = (guint32) getpid();
+  g_strlcpy(page->element, element_path, sizeof(page->element));
+  __atomic_store_n(&page->magic, GST_PREREC_STATS_MAGIC, __ATOMIC_RELEASE);
+
+  shm = g_new0(GstPreRecStatsShm, 1);
+  shm->page = page;
+  shm->name = name;
+  return shm;
+
+fail:
+  close(fd);
+  shm_unlink(name);
+  g_free(name);
+  return NULL;
+}
+
+void gst_prerec_stats_shm_free(GstPreRecStatsShm* shm) {
+  if (!shm)
+    return;
+  shm_unlink(shm->name);
+  munmap(shm->page, sizeof(GstPreRecStatsPage));
+  g_free(shm->name);
+  g_free(shm);
+}
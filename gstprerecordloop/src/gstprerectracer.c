@@ -0,0 +1,128 @@
+/*
+ * GStreamer pre-record loop: "prerec" tracer
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ */
+
+/**
+ * SECTION:tracer-prerec
+ *
+ * Logs the ring of every pre_record_loop instance as tracer records, so
+ * tracer-log tooling sees it next to the rest of the pipeline without any
+ * application code:
+ *
+ * - `prerec-level`: queued GOPs, buffers, bytes and time after each
+ *   buffered frame;
+ * - `prerec-prune`: one record per pruned GOP with the time it took;
+ * - `prerec-drain`: one record per drain (trigger or EOS) with the buffers
+ *   and bytes pushed and its duration;
+ * - `prerec-trigger`: time from the flush trigger (or EOS) reaching the
+ *   element to the first drained buffer leaving it.
+ *
+ * |[
+ * GST_TRACERS=prerec GST_DEBUG=GST_TRACER:7 gst-launch-1.0 ... ! pre_record_loop ! ...
+ * ]|
+ *
+ * The element logs through the functions below and skips all of it while
+ * no prerec tracer exists.
+ */
+
+#include <gstprerecordloop/gstprerectracer.h>
+
+GST_DEBUG_CATEGORY_STATIC(prerec_tracer_debug);
+#define GST_CAT_DEFAULT prerec_tracer_debug
+
+struct _GstPreRecTracer {
+  GstTracer parent;
+};
+
+gint gst_prerec_tracer_active = 0;
+
+static GstTracerRecord* tr_level;
+static GstTracerRecord* tr_prune;
+static GstTracerRecord* tr_drain;
+static GstTracerRecord* tr_trigger;
+
+G_DEFINE_TYPE(GstPreRecTracer, gst_prerec_tracer, GST_TYPE_TRACER);
+
+void gst_prerec_tracer_log_level(GstElement* element, guint gops, guint buffers, guint64 bytes, GstClockTime time) {
+  gst_tracer_record_log(tr_level, gst_util_get_timestamp(), GST_OBJECT_NAME(element), gops, buffers, bytes, time);
+}
+
+void gst_prerec_tracer_log_prune(GstElement* element, guint gops, GstClockTime time, GstClockTime duration) {
+  gst_tracer_record_log(tr_prune, gst_util_get_timestamp(), GST_OBJECT_NAME(element), gops, time, duration);
+}
+
+void gst_prerec_tracer_log_drain(GstElement* element, const gchar* reason, guint buffers, guint64 bytes,
+                                 GstClockTime duration) {
+  gst_tracer_record_log(tr_drain, gst_util_get_timestamp(), GST_OBJECT_NAME(element), reason, buffers, bytes,
+                        duration);
+}
+
+void gst_prerec_tracer_log_trigger(GstElement* element, const gchar* reason, GstClockTime latency) {
+  gst_tracer_record_log(tr_trigger, gst_util_get_timestamp(), GST_OBJECT_NAME(element), reason, latency);
+}
+
+/* Field specs shared by the records */
+static GstStructure* field_ts(void) {
+  return gst_structure_new("value", "type", G_TYPE_GTYPE, GST_TYPE_CLOCK_TIME, "description", G_TYPE_STRING,
+                           "event ts", NULL);
+}
+
+static GstStructure* field_element(void) {
+  return gst_structure_new("scope", "type", G_TYPE_GTYPE, G_TYPE_STRING, "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+                           GST_TRACER_VALUE_SCOPE_ELEMENT, NULL);
+}
+
+static GstStructure* field_value(GType type, const gchar* description) {
+  return gst_structure_new("value", "type", G_TYPE_GTYPE, type, "description", G_TYPE_STRING, description, NULL);
+}
+
+/* Records live as long as the process, like the core tracers' */
+static GstTracerRecord* keep_record(GstTracerRecord* record) {
+  GST_OBJECT_FLAG_SET(record, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+  return record;
+}
+
+static void gst_prerec_tracer_finalize(GObject* object) {
+  g_atomic_int_add(&gst_prerec_tracer_active, -1);
+  G_OBJECT_CLASS(gst_prerec_tracer_parent_class)->finalize(object);
+}
+
+static void gst_prerec_tracer_class_init(GstPreRecTracerClass* klass) {
+  GObjectClass* gobject_class = G_OBJECT_CLASS(klass);
+
+  gobject_class->finalize = gst_prerec_tracer_finalize;
+
+  GST_DEBUG_CATEGORY_INIT(prerec_tracer_debug, "prerec_tracer", 0, "pre record loop tracer");
+
+  tr_level = keep_record(gst_tracer_record_new(
+      "prerec-level.class", "ts", GST_TYPE_STRUCTURE, field_ts(), "element", GST_TYPE_STRUCTURE, field_element(),
+      "gops", GST_TYPE_STRUCTURE, field_value(G_TYPE_UINT, "queued GOPs"), "buffers", GST_TYPE_STRUCTURE,
+      field_value(G_TYPE_UINT, "queued buffers"), "bytes", GST_TYPE_STRUCTURE,
+      field_value(G_TYPE_UINT64, "queued bytes"), "time", GST_TYPE_STRUCTURE,
+      field_value(GST_TYPE_CLOCK_TIME, "queued running time"), NULL));
+  tr_prune = keep_record(gst_tracer_record_new(
+      "prerec-prune.class", "ts", GST_TYPE_STRUCTURE, field_ts(), "element", GST_TYPE_STRUCTURE, field_element(),
+      "gops", GST_TYPE_STRUCTURE, field_value(G_TYPE_UINT, "GOPs left"), "time", GST_TYPE_STRUCTURE,
+      field_value(GST_TYPE_CLOCK_TIME, "queued running time left"), "duration", GST_TYPE_STRUCTURE,
+      field_value(GST_TYPE_CLOCK_TIME, "time to prune the GOP"), NULL));
+  tr_drain = keep_record(gst_tracer_record_new(
+      "prerec-drain.class", "ts", GST_TYPE_STRUCTURE, field_ts(), "element", GST_TYPE_STRUCTURE, field_element(),
+      "reason", GST_TYPE_STRUCTURE, field_value(G_TYPE_STRING, "trigger-flush or eos-flush"), "buffers",
+      GST_TYPE_STRUCTURE, field_value(G_TYPE_UINT, "buffers pushed"), "bytes", GST_TYPE_STRUCTURE,
+      field_value(G_TYPE_UINT64, "bytes drained"), "duration", GST_TYPE_STRUCTURE,
+      field_value(GST_TYPE_CLOCK_TIME, "drain span"), NULL));
+  tr_trigger = keep_record(gst_tracer_record_new(
+      "prerec-trigger.class", "ts", GST_TYPE_STRUCTURE, field_ts(), "element", GST_TYPE_STRUCTURE, field_element(),
+      "reason", GST_TYPE_STRUCTURE, field_value(G_TYPE_STRING, "trigger-flush or eos-flush"), "latency",
+      GST_TYPE_STRUCTURE, field_value(GST_TYPE_CLOCK_TIME, "trigger received to first drained buffer"), NULL));
+}
+
+static void gst_prerec_tracer_init(GstPreRecTracer* self) {
+  g_atomic_int_inc(&gst_prerec_tracer_active);
+}
+
+gboolean gst_prerec_tracer_register(GstPlugin* plugin) {
+  return gst_tracer_register(plugin, "prerec", GST_TYPE_PREREC_TRACER);
+}
@@ -0,0 +1,181 @@
+/* Journal cost benchmark: pre_record_loop with and without journal-location.
+ *
+ * GOPS GOPs of FRAMES x FRAME_SIZE bytes are chained straight into the sink
+ * pad of a buffering loop (max-time large enough to keep them all), once
+ * without a journal and once with journal-location pointing at a temporary
+ * directory. Every closing GOP then costs the journal thread one file write,
+ * one fdatasync() and one rename().
+ *
+ * Reported per mode:
+ *   - ingest throughput (MiB/s) and mean time per frame on the streaming
+ *     thread; the journal target is "a few percent of throughput at most"
+ *   - with the journal: the sustained journal throughput (first frame to
+ *     last GOP durable), how far the last GOP lags behind ingest, and
+ *     journal-written / journal-skipped from prerec-stats
+ *
+ * The numbers are printed for comparison; the test only fails on errors and
+ * warns when the ingest overhead is above 5%. Set PREREC_BENCH_DIR to a
+ * directory on the target disk (the default temp dir is often tmpfs, where
+ * fdatasync() is free).
+ */
+
+#define FAIL_PREFIX "JOURNAL COST FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+
+#define GOPS 200
+#define FRAMES 30
+#define FRAME_SIZE (32 * 1024)
+#define PASSES 3
+
+typedef struct {
+  gint64 ingest_us;
+  gint64 durable_us;
+  guint written;
+  guint skipped;
+} PassResult;
+
+static GstBuffer* make_frame(guint i, guint64 pts) {
+  GstBuffer* b = gst_buffer_new_allocate(NULL, FRAME_SIZE, NULL);
+  gst_buffer_memset(b, 0, (guint8) i, FRAME_SIZE);
+  GST_BUFFER_PTS(b) = pts;
+  GST_BUFFER_DURATION(b) = GST_SECOND / FRAMES;
+  if (i % FRAMES != 0)
+    GST_BUFFER_FLAG_SET(b, GST_BUFFER_FLAG_DELTA_UNIT);
+  return b;
+}
+
+static gboolean run_pass(const gchar* journal_dir, PassResult* out) {
+  GError* error = NULL;
+  GstElement *pipeline, *appsrc, *pr;
+  GstPad* sink;
+  guint64 pts = 0;
+  gint64 start;
+  gboolean ok = TRUE;
+
+  pipeline = prerec_build_pipeline("appsrc name=src is-live=true format=time caps=video/x-h264 ! "
+                                   "pre_record_loop name=pr max-time=3600 ! fakesink sync=false",
+                                   &error);
+  if (!pipeline) {
+    g_clear_error(&error);
+    return FALSE;
+  }
+  appsrc = gst_bin_get_by_name(GST_BIN(pipeline), "src");
+  pr = gst_bin_get_by_name(GST_BIN(pipeline), "pr");
+  if (journal_dir)
+    g_object_set(pr, "journal-location", journal_dir, NULL);
+  if (gst_element_set_state(pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+    ok = FALSE;
+    goto done;
+  }
+  gst_element_get_state(pipeline, NULL, NULL, 2 * GST_SECOND);
+
+  /* the first frame goes through appsrc for stream-start/caps/segment */
+  if (gst_app_src_push_buffer(GST_APP_SRC(appsrc), make_frame(0, pts)) != GST_FLOW_OK ||
+      !prerec_wait_for_stat(pr, "queued-buffers", 1, 2000)) {
+    ok = FALSE;
+    goto done;
+  }
+  pts += GST_SECOND / FRAMES;
+
+  sink = gst_element_get_static_pad(pr, "sink");
+  start = g_get_monotonic_time();
+  for (guint i = 1; i < GOPS * FRAMES && ok; ++i) {
+    ok = gst_pad_chain(sink, make_frame(i, pts)) == GST_FLOW_OK;
+    pts += GST_SECOND / FRAMES;
+  }
+  out->ingest_us = g_get_monotonic_time() - start;
+  gst_object_unref(sink);
+
+  /* all GOPs but the open one are handed to the journal */
+  out->durable_us = 0;
+  if (ok && journal_dir) {
+    while (prerec_stat_uint(pr, "journal-written") + prerec_stat_uint(pr, "journal-skipped") < GOPS - 1) {
+      if (g_get_monotonic_time() - start > 120 * G_TIME_SPAN_SECOND) {
+        ok = FALSE;
+        break;
+      }
+      g_usleep(G_TIME_SPAN_MILLISECOND);
+    }
+    out->durable_us = g_get_monotonic_time() - start;
+  }
+  out->written = prerec_stat_uint(pr, "journal-written");
+  out->skipped = prerec_stat_uint(pr, "journal-skipped");
+
+done:
+  gst_element_set_state(pipeline, GST_STATE_NULL);
+  gst_object_unref(appsrc);
+  gst_object_unref(pr);
+  gst_object_unref(pipeline);
+  return ok;
+}
+
+static void remove_journal(const gchar* dir) {
+  GDir* d = g_dir_open(dir, 0, NULL);
+  const gchar* name;
+  if (!d)
+    return;
+  while ((name = g_dir_read_name(d))) {
+    gchar* path = g_build_filename(dir, name, NULL);
+    g_unlink(path);
+    g_free(path);
+  }
+  g_dir_close(d);
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  const gchar* base = g_getenv("PREREC_BENCH_DIR");
+  gchar* dir = base ? g_build_filename(base, "prerec-journal-bench", NULL)
+                    : g_dir_make_tmp("prerec-journal-bench-XXXXXX", NULL);
+  const double total_mib = (double) GOPS * FRAMES * FRAME_SIZE / 1048576.0;
+  gint64 plain_us = G_MAXINT64, journal_us = G_MAXINT64;
+  PassResult best = {0};
+
+  if (g_mkdir_with_parents(dir, 0755) != 0)
+    FAIL("cannot create %s", dir);
+
+  /* best of PASSES for each mode, alternating so both see the same disk state */
+  for (guint p = 0; p < PASSES; ++p) {
+    PassResult plain = {0}, journal = {0};
+    if (!run_pass(NULL, &plain))
+      FAIL("pass without journal failed");
+    remove_journal(dir);
+    if (!run_pass(dir, &journal))
+      FAIL("pass with journal failed");
+    remove_journal(dir);
+    plain_us = MIN(plain_us, plain.ingest_us);
+    if (journal.ingest_us < journal_us) {
+      journal_us = journal.ingest_us;
+      best = journal;
+    }
+  }
+
+  double overhead = 100.0 * (journal_us - plain_us) / (double) plain_us;
+  g_print("\n=== Journal cost: %d GOPs x %d frames x %d KiB (%.0f MiB), best of %d ===\n", GOPS, FRAMES,
+          FRAME_SIZE / 1024, total_mib, PASSES);
+  g_print("%-10s %10.1f MiB/s   %7.3f us/frame\n", "plain", total_mib / (plain_us / 1e6),
+          (double) plain_us / (GOPS * FRAMES));
+  g_print("%-10s %10.1f MiB/s   %7.3f us/frame   ingest overhead %+.2f%%\n", "journal",
+          total_mib / (journal_us / 1e6), (double) journal_us / (GOPS * FRAMES), overhead);
+  g_print("%-10s %10.1f MiB/s durable   last GOP %.2f ms behind ingest   written %u  skipped %u\n\n", "",
+          total_mib / (best.durable_us / 1e6), (best.durable_us - best.ingest_us) / 1000.0, best.written,
+          best.skipped);
+
+  if (overhead > 5.0)
+    g_warning("journal costs %.2f%% of ingest throughput, above the few-percent target", overhead);
+  if (best.skipped)
+    g_warning("%u GOPs were not journaled: the disk does not keep up with %.1f MiB/s", best.skipped,
+              total_mib / (journal_us / 1e6));
+
+  g_rmdir(dir);
+  g_free(dir);
+  g_print("Journal cost benchmark completed successfully.\n");
+  return 0;
+}
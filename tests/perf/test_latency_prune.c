@@ -134,6 +134,33 @@ int main(int argc, char** argv) {
   g_print("  Maximum:  %8.3f ms\n", max_ns / 1000000.0);
   g_print("\n");
 
+  /* The element's own timings, without appsrc and streaming thread overhead */
+  GstQuery* q_hist = gst_query_new_custom(GST_QUERY_CUSTOM, gst_structure_new_empty("prerec-stats"));
+  if (gst_element_query(tp.pr, q_hist)) {
+    const GstStructure* s = gst_query_get_structure(q_hist);
+    static const char* names[] = {"enqueue", "prune", "residency"};
+    g_print("Element histograms (p50 / p99 / max):\n");
+    for (guint n = 0; n < G_N_ELEMENTS(names); ++n) {
+      guint64 count = 0, p50 = 0, p99 = 0, max = 0;
+      gchar* f_count = g_strdup_printf("%s-count", names[n]);
+      gchar* f_p50 = g_strdup_printf("%s-p50", names[n]);
+      gchar* f_p99 = g_strdup_printf("%s-p99", names[n]);
+      gchar* f_max = g_strdup_printf("%s-max", names[n]);
+      gst_structure_get_uint64(s, f_count, &count);
+      gst_structure_get_uint64(s, f_p50, &p50);
+      gst_structure_get_uint64(s, f_p99, &p99);
+      gst_structure_get_uint64(s, f_max, &max);
+      g_print("  %-10s %8.3f / %8.3f / %8.3f us (%" G_GUINT64_FORMAT " samples)\n", names[n], p50 / 1000.0,
+              p99 / 1000.0, max / 1000.0, count);
+      g_free(f_count);
+      g_free(f_p50);
+      g_free(f_p99);
+      g_free(f_max);
+    }
+    g_print("\n");
+  }
+  gst_query_unref(q_hist);
+
   /* Sanity checks: latencies should be reasonable (< 100ms for typical case) */
   if (median_ns > 100 * GST_MSECOND) {
     g_warning("Median latency unusually high (%.3f ms) - possible performance issue", median_ns / 1000000.0);
@@ -0,0 +1,192 @@
+/* Soak benchmark: frames from the heap vs from the slab allocator.
+ *
+ * A synthetic encoder pushes SOAK_SECONDS of 30 fps H.264-like frames
+ * (keyframes 80-160 KiB, deltas 2-40 KiB) through pre_record_loop with a
+ * WINDOW_SECONDS look-back, interleaved with short-lived scratch allocations
+ * as an encoder would make. Frames come either from the default allocator or
+ * from the allocator pre_record_loop slab-allocator=true proposes in the
+ * ALLOCATION query.
+ *
+ * Each mode runs in its own child process so the heap state of one does not
+ * skew the other. Reported per mode, once the window is full:
+ *   - RSS above the pre-run baseline, and its ratio to the window payload
+ *   - minor page faults per frame
+ *   - mean time per frame (allocate, fill, chain into the loop)
+ *
+ * The numbers are printed for comparison; the test only fails on errors.
+ */
+
+#define FAIL_PREFIX "SLAB SOAK FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define FPS 30
+#define GOP 30
+#define WINDOW_SECONDS 10
+#define SOAK_SECONDS 600
+
+static guint64 rss_bytes(void) {
+#ifdef __linux__
+  unsigned long size = 0, resident = 0;
+  FILE* f = fopen("/proc/self/statm", "r");
+  if (f) {
+    if (fscanf(f, "%lu %lu", &size, &resident) != 2)
+      resident = 0;
+    fclose(f);
+  }
+  return (guint64) resident * (guint64) sysconf(_SC_PAGESIZE);
+#else
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return (guint64) ru.ru_maxrss; /* bytes on macOS; peak only */
+#endif
+}
+
+static guint64 minor_faults(void) {
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return (guint64) ru.ru_minflt;
+}
+
+static GstAllocator* query_allocator(GstElement* appsrc) {
+  GstPad* pad = gst_element_get_static_pad(appsrc, "src");
+  GstCaps* caps = gst_caps_new_empty_simple("video/x-h264");
+  GstQuery* q = gst_query_new_allocation(caps, FALSE);
+  GstAllocator* allocator = NULL;
+
+  if (gst_pad_peer_query(pad, q) && gst_query_get_n_allocation_params(q) > 0)
+    gst_query_parse_nth_allocation_param(q, 0, &allocator, NULL);
+  gst_query_unref(q);
+  gst_caps_unref(caps);
+  gst_object_unref(pad);
+  return allocator;
+}
+
+static gsize frame_size(GRand* rand, guint64 n) {
+  if (n % GOP == 0)
+    return (gsize) g_rand_int_range(rand, 80 * 1024, 160 * 1024);
+  /* skewed towards small deltas */
+  gdouble r = g_rand_double(rand);
+  return 2 * 1024 + (gsize) (r * r * 38 * 1024);
+}
+
+static GstBuffer* make_frame(GstAllocator* allocator, gsize size, guint64 n) {
+  GstBuffer* b = gst_buffer_new_allocate(allocator, size, NULL);
+  GstMapInfo map;
+
+  /* an encoder writes every byte of its output */
+  gst_buffer_map(b, &map, GST_MAP_WRITE);
+  memset(map.data, (int) (n & 0xff), map.size);
+  gst_buffer_unmap(b, &map);
+  GST_BUFFER_PTS(b) = n * GST_SECOND / FPS;
+  GST_BUFFER_DURATION(b) = GST_SECOND / FPS;
+  if (n % GOP != 0)
+    GST_BUFFER_FLAG_SET(b, GST_BUFFER_FLAG_DELTA_UNIT);
+  return b;
+}
+
+/* Child: one soak run; prints one result line */
+static int run_mode(const char* mode) {
+  gboolean use_slab = g_str_equal(mode, "slab");
+  PrerecTestPipeline tp;
+  GstAllocator* allocator = NULL;
+  GRand* rand = g_rand_new_with_seed(42);
+  guint64 frames = (guint64) SOAK_SECONDS * FPS, warm = (guint64) 2 * WINDOW_SECONDS * FPS;
+  guint64 base_rss, peak_rss = 0, faults0 = 0, t0 = 0, ram_bytes = 0;
+  guint64 reserved = 0;
+  guint fallbacks = 0;
+  GstPad* sink;
+
+  if (!prerec_pipeline_create(&tp, mode))
+    FAIL("%s: pipeline creation failed", mode);
+  gst_element_set_state(tp.pipeline, GST_STATE_NULL);
+  g_object_set(tp.pr, "max-time", WINDOW_SECONDS, "slab-allocator", use_slab, NULL);
+  if (gst_element_set_state(tp.pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    FAIL("%s: pipeline does not restart", mode);
+  gst_element_get_state(tp.pipeline, NULL, NULL, 2 * GST_SECOND);
+  if (use_slab) {
+    allocator = query_allocator(tp.appsrc);
+    if (!allocator || g_strcmp0(allocator->mem_type, "PreRecSlab") != 0)
+      FAIL("%s: slab allocator not proposed", mode);
+  }
+
+  /* first frame through appsrc for stream-start/caps/segment, the rest are
+   * chained directly so the measured time is ours */
+  if (gst_app_src_push_buffer(GST_APP_SRC(tp.appsrc), make_frame(allocator, frame_size(rand, 0), 0)) != GST_FLOW_OK)
+    FAIL("%s: first push failed", mode);
+  g_usleep(50 * G_TIME_SPAN_MILLISECOND);
+  sink = gst_element_get_static_pad(tp.pr, "sink");
+  base_rss = rss_bytes();
+
+  for (guint64 n = 1; n < frames; ++n) {
+    gsize size = frame_size(rand, n);
+    gpointer scratch;
+
+    if (n == warm) {
+      faults0 = minor_faults();
+      t0 = (guint64) g_get_monotonic_time();
+    }
+    scratch = g_malloc(size / 4 + 512); /* encoder side data, freed right away */
+    memset(scratch, 0, size / 4 + 512);
+    if (gst_pad_chain(sink, make_frame(allocator, size, n)) != GST_FLOW_OK)
+      FAIL("%s: chain failed at frame %" G_GUINT64_FORMAT, mode, n);
+    g_free(scratch);
+    if (n > warm && n % FPS == 0)
+      peak_rss = MAX(peak_rss, rss_bytes());
+  }
+
+  guint64 elapsed_us = (guint64) g_get_monotonic_time() - t0;
+  guint64 faults = minor_faults() - faults0;
+  GstQuery* q = gst_query_new_custom(GST_QUERY_CUSTOM, gst_structure_new_empty("prerec-stats"));
+  if (gst_element_query(tp.pr, q)) {
+    const GstStructure* s = gst_query_get_structure(q);
+    gst_structure_get_uint64(s, "ram-bytes", &ram_bytes);
+    gst_structure_get_uint64(s, "slab-reserved", &reserved);
+    gst_structure_get_uint(s, "slab-fallbacks", &fallbacks);
+  }
+  gst_query_unref(q);
+
+  guint64 growth = peak_rss > base_rss ? peak_rss - base_rss : 0;
+  g_print("%-5s  window %7.1f MiB  RSS +%7.1f MiB (x%.2f)  minflt/frame %7.2f  %6.1f us/frame  "
+          "slab %5.1f MiB reserved, %u fallbacks\n",
+          mode, ram_bytes / 1048576.0, growth / 1048576.0, ram_bytes ? (gdouble) growth / ram_bytes : 0.0,
+          (gdouble) faults / (frames - warm), (gdouble) elapsed_us / (frames - warm), reserved / 1048576.0,
+          fallbacks);
+
+  gst_object_unref(sink);
+  prerec_pipeline_shutdown(&tp);
+  if (allocator)
+    gst_object_unref(allocator);
+  g_rand_free(rand);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+  if (argc > 1)
+    return run_mode(argv[1]);
+
+  g_print("\n=== Soak: %d s at %d fps, %d s window, frames from heap vs slab ===\n", SOAK_SECONDS, FPS,
+          WINDOW_SECONDS);
+  const char* modes[] = {"heap", "slab"};
+  for (guint i = 0; i < G_N_ELEMENTS(modes); ++i) {
+    gchar* child_argv[] = {argv[0], (gchar*) modes[i], NULL};
+    gint status = -1;
+    GError* error = NULL;
+
+    if (!g_spawn_sync(NULL, child_argv, NULL, G_SPAWN_DEFAULT, NULL, NULL, NULL, NULL, &status, &error))
+      FAIL("cannot run the %s pass: %s", modes[i], error->message);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      FAIL("%s pass failed (status %d)", modes[i], status);
+  }
+  g_print("\nSlab soak benchmark completed successfully.\n");
+  return 0;
+}
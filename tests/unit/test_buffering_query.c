@@ -0,0 +1,109 @@
+/* BUFFERING and LATENCY queries on the src pad are answered from the ring.
+ *
+ * Test Flow (max-time=10, 64 byte frames, 1 s each):
+ *   Part 1: 2 GOPs (6 s) → 60 %, busy, live mode, 64 B/s in, 4000 ms left,
+ *           range 0-6 s in TIME and 0-384 in BYTES, no drain estimate yet
+ *   Part 2: flush, re-arm, 1 GOP → the drain was measured: avg-out > 0 and
+ *           an estimated-total for the 3 buffered frames
+ *   Part 3: LATENCY with appsrc max-latency=1 s → live, min unchanged,
+ *           max >= 1 s + max-time
+ */
+
+#define FAIL_PREFIX "BUFFERING QUERY FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <stdio.h>
+
+#define FRAME PREREC_CHAIN_FRAME_BYTES
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  PrerecTestPipeline tp;
+  GstSegment segment;
+  guint64 ts = 0;
+  gboolean busy, live;
+  gint percent, avg_in, avg_out;
+  gint64 left, start, stop, total;
+  GstFormat format;
+  GstBufferingMode mode;
+  GstClockTime min, max;
+  GstQuery* q;
+
+  if (!prerec_pipeline_create(&tp, "buffering-query"))
+    FAIL("pipeline creation failed");
+  g_object_set(tp.pr, "max-time", 10, NULL);
+  g_object_set(tp.appsrc, "min-latency", (gint64) 0, "max-latency", (gint64) GST_SECOND, NULL);
+  gst_element_get_state(tp.pipeline, NULL, NULL, 2 * GST_SECOND);
+
+  GstPad* sink = gst_element_get_static_pad(tp.pr, "sink");
+  prerec_send_stream_setup(sink, "buffering-query");
+
+  /* === Part 1 === */
+  for (int i = 0; i < 2; ++i) {
+    if (!prerec_chain_gop(sink, &ts))
+      FAIL("part1: gop push failed");
+  }
+  q = gst_query_new_buffering(GST_FORMAT_TIME);
+  if (!gst_element_query(tp.pr, q))
+    FAIL("part1: BUFFERING query not answered");
+  gst_query_parse_buffering_percent(q, &busy, &percent);
+  gst_query_parse_buffering_stats(q, &mode, &avg_in, &avg_out, &left);
+  gst_query_parse_buffering_range(q, &format, &start, &stop, &total);
+  if (!busy || percent != 60)
+    FAIL("part1: expected busy at 60%%, got busy=%d %d%%", busy, percent);
+  if (mode != GST_BUFFERING_LIVE || avg_in != FRAME || avg_out != 0 || left != 4000)
+    FAIL("part1: stats mode=%d in=%d out=%d left=%" G_GINT64_FORMAT ", expected live/%d/0/4000", mode, avg_in,
+         avg_out, left, FRAME);
+  if (format != GST_FORMAT_TIME || start != 0 || stop != 6 * GST_SECOND || total != -1)
+    FAIL("part1: range %" G_GINT64_FORMAT "-%" G_GINT64_FORMAT " total %" G_GINT64_FORMAT
+         ", expected 0-6 s without estimate",
+         start, stop, total);
+  if (gst_query_get_n_buffering_ranges(q) != 1)
+    FAIL("part1: expected one buffered range, got %u", gst_query_get_n_buffering_ranges(q));
+  gst_query_unref(q);
+
+  q = gst_query_new_buffering(GST_FORMAT_BYTES);
+  gst_element_query(tp.pr, q);
+  gst_query_parse_buffering_range(q, &format, &start, &stop, NULL);
+  if (format != GST_FORMAT_BYTES || start != 0 || stop != 6 * FRAME)
+    FAIL("part1: byte range %" G_GINT64_FORMAT "-%" G_GINT64_FORMAT ", expected 0-%d", start, stop, 6 * FRAME);
+  gst_query_unref(q);
+  g_print("BUFFERING QUERY: Part 1 ✓ - fill level, rates and range\n");
+
+  /* === Part 2 === */
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                     gst_structure_new_empty("prerecord-flush")));
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_UPSTREAM,
+                                                     gst_structure_new_empty("prerecord-arm")));
+  gst_segment_init(&segment, GST_FORMAT_TIME);
+  gst_pad_send_event(sink, gst_event_new_segment(&segment));
+  if (!prerec_chain_gop(sink, &ts))
+    FAIL("part2: gop push failed");
+  q = gst_query_new_buffering(GST_FORMAT_TIME);
+  gst_element_query(tp.pr, q);
+  gst_query_parse_buffering_stats(q, NULL, NULL, &avg_out, NULL);
+  gst_query_parse_buffering_range(q, NULL, NULL, NULL, &total);
+  if (avg_out <= 0 || total < 0)
+    FAIL("part2: expected a drain estimate, got avg-out=%d estimated-total=%" G_GINT64_FORMAT, avg_out, total);
+  gst_query_unref(q);
+  g_print("BUFFERING QUERY: Part 2 ✓ - drain throughput measured\n");
+
+  /* === Part 3 === */
+  q = gst_query_new_latency();
+  if (!gst_element_query(tp.pr, q))
+    FAIL("part3: LATENCY query not answered");
+  gst_query_parse_latency(q, &live, &min, &max);
+  if (!live || min != 0 || !GST_CLOCK_TIME_IS_VALID(max) || max < 11 * GST_SECOND)
+    FAIL("part3: latency live=%d min %" GST_TIME_FORMAT " max %" GST_TIME_FORMAT ", expected live, 0, >= 11 s", live,
+         GST_TIME_ARGS(min), GST_TIME_ARGS(max));
+  gst_query_unref(q);
+  g_print("BUFFERING QUERY: Part 3 ✓ - latency includes the ring\n");
+
+  g_print("BUFFERING QUERY PASS\n");
+  gst_object_unref(sink);
+  prerec_pipeline_shutdown(&tp);
+  return 0;
+}
@@ -0,0 +1,179 @@
+/* post-messages: fill thresholds, prune bursts, drains and mode changes are
+ * posted as element messages carrying the prerec-stats counters.
+ *
+ * A bus sync handler queries prerec-stats for every message, which would
+ * deadlock if the element posted with its lock held.
+ *
+ * Test Flow (max-time=10, fill-thresholds="50,100", message-interval=60 s):
+ *   Part 1: 2 GOPs (6 s) → one prerec-fill at 50 %, nothing else
+ *   Part 2: 3 more GOPs → prerec-fill at 100 %, then a single prerec-prune
+ *           although later GOPs were pruned too (rate limited)
+ *   Part 3: flush → prerec-drain-done (trigger-flush, all queued buffers)
+ *           followed by prerec-mode pass-through; re-arm → prerec-mode
+ *           buffering
+ *   Part 4: post-messages=false → a flush posts nothing
+ */
+
+#define FAIL_PREFIX "BUS MESSAGES FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <stdio.h>
+
+typedef struct {
+  GstElement* pr;
+  GPtrArray* messages; /* GstStructure* copies, in posting order */
+  guint queried;       /* stats queries answered from the sync handler */
+} MessageLog;
+
+static GstBusSyncReply on_message(GstBus* bus, GstMessage* msg, gpointer user_data) {
+  MessageLog* log = user_data;
+  const GstStructure* s = gst_message_get_structure(msg);
+
+  if (GST_MESSAGE_TYPE(msg) != GST_MESSAGE_ELEMENT || !s || !g_str_has_prefix(gst_structure_get_name(s), "prerec-"))
+    return GST_BUS_PASS;
+  g_ptr_array_add(log->messages, gst_structure_copy(s));
+
+  GstQuery* q = gst_query_new_custom(GST_QUERY_CUSTOM, gst_structure_new_empty("prerec-stats"));
+  if (gst_element_query(log->pr, q))
+    log->queried++;
+  gst_query_unref(q);
+  return GST_BUS_DROP;
+}
+
+static guint msg_uint(const GstStructure* s, const char* field) {
+  guint v = G_MAXUINT;
+  gst_structure_get_uint(s, field, &v);
+  return v;
+}
+
+static const GstStructure* msg_at(MessageLog* log, guint i) {
+  return i < log->messages->len ? g_ptr_array_index(log->messages, i) : NULL;
+}
+
+static void clear_log(MessageLog* log) {
+  g_ptr_array_set_size(log->messages, 0);
+  log->queried = 0;
+}
+
+static void send_flush(GstElement* pr) {
+  gst_element_send_event(pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                  gst_structure_new_empty("prerecord-flush")));
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  PrerecTestPipeline tp;
+  MessageLog log = {NULL, g_ptr_array_new_with_free_func((GDestroyNotify) gst_structure_free), 0};
+  const GstStructure* s;
+  GstSegment segment;
+  guint64 ts = 0;
+  guint queued;
+
+  if (!prerec_pipeline_create(&tp, "bus-messages"))
+    FAIL("pipeline creation failed");
+  log.pr = tp.pr;
+  g_object_set(tp.pr, "max-time", 10, "post-messages", TRUE, "fill-thresholds", "100, 50", "message-interval",
+               60000, NULL);
+  gst_element_get_state(tp.pipeline, NULL, NULL, 2 * GST_SECOND);
+  GstBus* bus = gst_element_get_bus(tp.pipeline);
+  gst_bus_set_sync_handler(bus, on_message, &log, NULL);
+
+  GstPad* sink = gst_element_get_static_pad(tp.pr, "sink");
+  prerec_send_stream_setup(sink, "bus-messages");
+
+  /* === Part 1 === */
+  for (int i = 0; i < 2; ++i) {
+    if (!prerec_chain_gop(sink, &ts))
+      FAIL("part1: gop push failed");
+  }
+  s = msg_at(&log, 0);
+  if (log.messages->len != 1 || !gst_structure_has_name(s, "prerec-fill") || msg_uint(s, "threshold") != 50)
+    FAIL("part1: expected one prerec-fill at 50%%, got %u messages (first %s)", log.messages->len,
+         s ? gst_structure_get_name(s) : "none");
+  if (msg_uint(s, "percent") < 50 || msg_uint(s, "queued-gops") != 2)
+    FAIL("part1: prerec-fill percent=%u queued-gops=%u, expected >= 50 and the stats snapshot", msg_uint(s, "percent"),
+         msg_uint(s, "queued-gops"));
+  if (log.queried != 1)
+    FAIL("part1: stats query from the sync handler failed");
+  g_print("BUS MESSAGES: Part 1 ✓ - fill threshold posted with stats\n");
+
+  /* === Part 2 === */
+  clear_log(&log);
+  for (int i = 0; i < 3; ++i) {
+    if (!prerec_chain_gop(sink, &ts))
+      FAIL("part2: gop push failed");
+  }
+  guint fills = 0, prunes = 0;
+  for (guint i = 0; i < log.messages->len; ++i) {
+    s = msg_at(&log, i);
+    if (gst_structure_has_name(s, "prerec-fill")) {
+      if (msg_uint(s, "threshold") != 100 || prunes)
+        FAIL("part2: prerec-fill at %u%% after %u prunes, expected 100%% before pruning", msg_uint(s, "threshold"),
+             prunes);
+      fills++;
+    } else if (gst_structure_has_name(s, "prerec-prune")) {
+      if (msg_uint(s, "gops") < 1)
+        FAIL("part2: prerec-prune without pruned GOPs");
+      prunes++;
+    } else {
+      FAIL("part2: unexpected %s", gst_structure_get_name(s));
+    }
+  }
+  if (fills != 1 || prunes != 1)
+    FAIL("part2: expected 1 fill and 1 prune message, got %u and %u", fills, prunes);
+  if (prerec_stat_uint(tp.pr, "drops-gops") < 2)
+    FAIL("part2: expected several pruned GOPs, got %u", prerec_stat_uint(tp.pr, "drops-gops"));
+  g_print("BUS MESSAGES: Part 2 ✓ - ring full once, prune burst rate limited\n");
+
+  /* === Part 3 === */
+  clear_log(&log);
+  queued = prerec_stat_uint(tp.pr, "queued-buffers");
+  send_flush(tp.pr);
+  const gchar* reason = NULL;
+  const gchar* mode = NULL;
+  s = msg_at(&log, 0);
+  if (log.messages->len != 2 || !gst_structure_has_name(s, "prerec-drain-done"))
+    FAIL("part3: expected drain-done and mode, got %u messages", log.messages->len);
+  reason = gst_structure_get_string(s, "reason");
+  if (g_strcmp0(reason, "trigger-flush") != 0 || msg_uint(s, "buffers") != queued)
+    FAIL("part3: drain-done reason=%s buffers=%u, expected trigger-flush and %u", reason, msg_uint(s, "buffers"),
+         queued);
+  s = msg_at(&log, 1);
+  mode = gst_structure_get_string(s, "mode");
+  if (!gst_structure_has_name(s, "prerec-mode") || g_strcmp0(mode, "pass-through") != 0 ||
+      msg_uint(s, "flush-count") != 1)
+    FAIL("part3: expected prerec-mode pass-through with flush-count=1, got %s mode=%s", gst_structure_get_name(s),
+         mode);
+
+  clear_log(&log);
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_UPSTREAM,
+                                                     gst_structure_new_empty("prerecord-arm")));
+  s = msg_at(&log, 0);
+  mode = s ? gst_structure_get_string(s, "mode") : NULL;
+  if (log.messages->len != 1 || g_strcmp0(mode, "buffering") != 0)
+    FAIL("part3: expected one prerec-mode buffering after re-arm, got %u messages", log.messages->len);
+  g_print("BUS MESSAGES: Part 3 ✓ - drain and mode changes posted\n");
+
+  /* === Part 4 === */
+  clear_log(&log);
+  g_object_set(tp.pr, "post-messages", FALSE, NULL);
+  gst_segment_init(&segment, GST_FORMAT_TIME);
+  gst_pad_send_event(sink, gst_event_new_segment(&segment));
+  if (!prerec_chain_gop(sink, &ts))
+    FAIL("part4: gop push failed");
+  send_flush(tp.pr);
+  if (log.messages->len != 0)
+    FAIL("part4: %u messages posted while disabled", log.messages->len);
+  g_print("BUS MESSAGES: Part 4 ✓ - nothing posted when disabled\n");
+
+  g_print("BUS MESSAGES PASS\n");
+  gst_bus_set_sync_handler(bus, NULL, NULL, NULL);
+  gst_object_unref(bus);
+  gst_object_unref(sink);
+  prerec_pipeline_shutdown(&tp);
+  g_ptr_array_unref(log.messages);
+  return 0;
+}
@@ -0,0 +1,139 @@
+/* Clip boundary events (clip-events property)
+ *
+ * Test Flow:
+ *   Phase 1: clip-events=TRUE, buffer 2 GOPs → expect no clip events yet
+ *   Phase 2: flush → expect prerecord-clip-start (clip-id=1) + GstForceKeyUnit
+ *            immediately before the first drained keyframe
+ *   Phase 3: pass-through GOP, re-arm, push 1 GOP → expect prerecord-clip-end
+ *            (clip-id=1) after the last pass-through buffer
+ *   Phase 4: second flush → expect clip-id=2
+ *
+ * Each item leaving the src pad is logged as one character:
+ *   S = clip-start, F = GstForceKeyUnit, E = clip-end, K = keyframe, d = delta
+ */
+
+#define FAIL_PREFIX "CLIP FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <stdio.h>
+#include <string.h>
+
+static GMutex log_lock;
+static GString* item_log = NULL;
+static guint last_clip_id = 0;
+
+static GstPadProbeReturn src_probe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+  g_mutex_lock(&log_lock);
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+    GstBuffer* buf = GST_PAD_PROBE_INFO_BUFFER(info);
+    g_string_append_c(item_log, GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_DELTA_UNIT) ? 'd' : 'K');
+  } else if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    const GstStructure* s = gst_event_get_structure(GST_PAD_PROBE_INFO_EVENT(info));
+    if (s && gst_structure_has_name(s, "prerecord-clip-start")) {
+      gst_structure_get_uint(s, "clip-id", &last_clip_id);
+      g_string_append_c(item_log, 'S');
+    } else if (s && gst_structure_has_name(s, "GstForceKeyUnit")) {
+      g_string_append_c(item_log, 'F');
+    } else if (s && gst_structure_has_name(s, "prerecord-clip-end")) {
+      gst_structure_get_uint(s, "clip-id", &last_clip_id);
+      g_string_append_c(item_log, 'E');
+    }
+  }
+  g_mutex_unlock(&log_lock);
+  return GST_PAD_PROBE_OK;
+}
+
+static gboolean send_flush(GstElement* pr) {
+  return gst_element_send_event(pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                         gst_structure_new_empty("prerecord-flush")));
+}
+
+static gboolean send_rearm(GstElement* pr) {
+  return gst_element_send_event(pr, gst_event_new_custom(GST_EVENT_CUSTOM_UPSTREAM,
+                                                         gst_structure_new_empty("prerecord-arm")));
+}
+
+/* Returns a copy of the log collected so far and clears it */
+static gchar* take_log(void) {
+  g_mutex_lock(&log_lock);
+  gchar* out = g_strdup(item_log->str);
+  g_string_truncate(item_log, 0);
+  g_mutex_unlock(&log_lock);
+  return out;
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  PrerecTestPipeline tp;
+  if (!prerec_pipeline_create(&tp, "clip-events"))
+    FAIL("pipeline creation failed");
+  g_object_set(tp.pr, "clip-events", TRUE, NULL);
+
+  item_log = g_string_new(NULL);
+  GstPad* src = gst_element_get_static_pad(tp.pr, "src");
+  gst_pad_add_probe(src, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, src_probe, NULL, NULL);
+  gst_object_unref(src);
+
+  guint64 ts = 0;
+  gchar* log;
+
+  /* Phase 1 */
+  for (int i = 0; i < 2; ++i) {
+    if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+      FAIL("phase1: gop push failed");
+  }
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 6, 2000))
+    FAIL("phase1: ring did not reach 6 queued buffers");
+  log = take_log();
+  if (strlen(log) != 0)
+    FAIL("phase1: expected nothing on src while buffering, got '%s'", log);
+  g_free(log);
+
+  /* Phase 2 */
+  if (!send_flush(tp.pr))
+    FAIL("phase2: flush send failed");
+  SETTLE(tp.pipeline);
+  log = take_log();
+  if (g_strcmp0(log, "SFKddKdd") != 0)
+    FAIL("phase2: expected 'SFKddKdd', got '%s'", log);
+  if (last_clip_id != 1)
+    FAIL("phase2: expected clip-id 1, got %u", last_clip_id);
+  g_free(log);
+
+  /* Phase 3 */
+  if (!prerec_push_gop(tp.appsrc, 1, &ts, GST_SECOND, NULL))
+    FAIL("phase3: pass-through push failed");
+  SETTLE(tp.pipeline);
+  if (!send_rearm(tp.pr))
+    FAIL("phase3: rearm send failed");
+  if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+    FAIL("phase3: post-rearm push failed");
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 6, 2000))
+    FAIL("phase3: ring did not reach 6 queued buffers");
+  log = take_log();
+  if (g_strcmp0(log, "KdE") != 0)
+    FAIL("phase3: expected 'KdE', got '%s'", log);
+  if (last_clip_id != 1)
+    FAIL("phase3: expected clip-end for clip-id 1, got %u", last_clip_id);
+  g_free(log);
+
+  /* Phase 4 */
+  if (!send_flush(tp.pr))
+    FAIL("phase4: flush send failed");
+  SETTLE(tp.pipeline);
+  log = take_log();
+  if (g_strcmp0(log, "SFKdd") != 0)
+    FAIL("phase4: expected 'SFKdd', got '%s'", log);
+  if (last_clip_id != 2)
+    FAIL("phase4: expected clip-id 2, got %u", last_clip_id);
+  g_free(log);
+
+  g_print("CLIP PASS: clip boundaries emitted around drained keyframes\n");
+  prerec_pipeline_shutdown(&tp);
+  g_string_free(item_log, TRUE);
+  return 0;
+}
@@ -0,0 +1,167 @@
+/* prerec_clipsink: drained clips written one file per clip.
+ *
+ * Test Flow:
+ *   Part 1: appsrc ! pre_record_loop clip-events=true ! prerec_clipsink
+ *           location=<dir>/clip-%u.bin buffer-size=4096; 2 GOPs of
+ *           3 x 1000 bytes, flush, 1 pass-through GOP, re-arm →
+ *           prerec-clip-written (clip-id=1, bytes=9000), clip-1.bin holds
+ *           exactly the 9 payloads in order (no block padding)
+ *   Part 2: the GOP buffered after re-arm, EOS (flush-on-eos=always) →
+ *           the EOS drain is its own clip: clip-2.bin with 3000 bytes,
+ *           clip-1.bin untouched, EOS reaches the bus
+ */
+
+#define FAIL_PREFIX "CLIPSINK FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+
+#define PAYLOAD 1000 /* not a multiple of the I/O block size */
+
+/* keyframe + 2 deltas, payload filled with the PTS in seconds */
+static gboolean push_gop(GstElement* appsrc, guint64* ts) {
+  for (int i = 0; i < 3; ++i) {
+    GstBuffer* b = gst_buffer_new_allocate(NULL, PAYLOAD, NULL);
+    gst_buffer_memset(b, 0, (guint8) (*ts / GST_SECOND), PAYLOAD);
+    GST_BUFFER_PTS(b) = *ts;
+    GST_BUFFER_DURATION(b) = GST_SECOND;
+    if (i > 0)
+      GST_BUFFER_FLAG_SET(b, GST_BUFFER_FLAG_DELTA_UNIT);
+    if (gst_app_src_push_buffer(GST_APP_SRC(appsrc), b) != GST_FLOW_OK)
+      return FALSE;
+    *ts += GST_SECOND;
+  }
+  return TRUE;
+}
+
+static gboolean send_flush(GstElement* pr) {
+  return gst_element_send_event(pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                         gst_structure_new_empty("prerecord-flush")));
+}
+
+static gboolean send_rearm(GstElement* pr) {
+  return gst_element_send_event(pr, gst_event_new_custom(GST_EVENT_CUSTOM_UPSTREAM,
+                                                         gst_structure_new_empty("prerecord-arm")));
+}
+
+/* Pops bus messages until one of type (and name, for element messages) shows up */
+static GstMessage* wait_message(GstElement* pipeline, GstMessageType type, const char* name) {
+  GstBus* bus = gst_element_get_bus(pipeline);
+  GstMessage* found = NULL;
+
+  for (int i = 0; i < 300 && !found; ++i) {
+    GstMessage* msg = gst_bus_timed_pop_filtered(bus, 10 * GST_MSECOND, type);
+    if (msg && (!name || gst_structure_has_name(gst_message_get_structure(msg), name)))
+      found = msg;
+    else if (msg)
+      gst_message_unref(msg);
+  }
+  gst_object_unref(bus);
+  return found;
+}
+
+/* clip file must hold n payloads whose bytes are first, first + 1, ... */
+static gboolean check_clip(const gchar* path, guint n, guint first, gchar** why) {
+  gchar* data = NULL;
+  gsize len = 0;
+  gboolean ok = TRUE;
+
+  if (!g_file_get_contents(path, &data, &len, NULL) || len != (gsize) n * PAYLOAD) {
+    *why = g_strdup_printf("%s has %zu bytes, expected %u", path, len, n * PAYLOAD);
+    g_free(data);
+    return FALSE;
+  }
+  for (gsize i = 0; i < len && ok; ++i) {
+    if ((guint8) data[i] != (guint8) (first + i / PAYLOAD)) {
+      *why = g_strdup_printf("%s byte %zu is %u, expected %u", path, i, (guint8) data[i],
+                             (guint) (first + i / PAYLOAD));
+      ok = FALSE;
+    }
+  }
+  g_free(data);
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  gchar* dir = g_dir_make_tmp("prerec-clipsink-XXXXXX", NULL);
+  gchar* pattern = g_build_filename(dir, "clip-%u.bin", NULL);
+  gchar* launch = g_strdup_printf("appsrc name=src is-live=true format=time caps=video/x-h264 ! "
+                                  "pre_record_loop name=pr clip-events=true flush-on-eos=always ! "
+                                  "prerec_clipsink name=sink location=\"%s\" buffer-size=4096 sync-per-clip=true",
+                                  pattern);
+  GError* error = NULL;
+  GstElement* pipeline = prerec_build_pipeline(launch, &error);
+  if (!pipeline)
+    FAIL("cannot build pipeline: %s", error ? error->message : "?");
+  GstElement* appsrc = gst_bin_get_by_name(GST_BIN(pipeline), "src");
+  GstElement* pr = gst_bin_get_by_name(GST_BIN(pipeline), "pr");
+  if (gst_element_set_state(pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    FAIL("pipeline does not start");
+  gst_element_get_state(pipeline, NULL, NULL, 2 * GST_SECOND);
+
+  guint64 ts = 0, bytes = 0;
+  guint clip_id = 0;
+  gchar* why = NULL;
+
+  /* === Part 1 === */
+  for (int i = 0; i < 2; ++i) {
+    if (!push_gop(appsrc, &ts))
+      FAIL("part1: gop push failed");
+  }
+  g_usleep(50 * G_TIME_SPAN_MILLISECOND);
+  send_flush(pr);
+  if (!push_gop(appsrc, &ts)) /* pass-through, same clip */
+    FAIL("part1: pass-through push failed");
+  g_usleep(50 * G_TIME_SPAN_MILLISECOND);
+  send_rearm(pr);
+  if (!push_gop(appsrc, &ts)) /* first buffer after re-arm carries the clip-end */
+    FAIL("part1: post re-arm push failed");
+
+  GstMessage* msg = wait_message(pipeline, GST_MESSAGE_ELEMENT, "prerec-clip-written");
+  if (!msg)
+    FAIL("part1: no prerec-clip-written message");
+  gst_structure_get_uint(gst_message_get_structure(msg), "clip-id", &clip_id);
+  gst_structure_get_uint64(gst_message_get_structure(msg), "bytes", &bytes);
+  gst_message_unref(msg);
+  if (clip_id != 1 || bytes != 9 * PAYLOAD)
+    FAIL("part1: expected clip 1 with %d bytes, got clip %u with %" G_GUINT64_FORMAT, 9 * PAYLOAD, clip_id, bytes);
+  gchar* clip1 = g_build_filename(dir, "clip-1.bin", NULL);
+  if (!check_clip(clip1, 9, 0, &why))
+    FAIL("part1: %s", why);
+  g_print("CLIPSINK: Part 1 ✓ - drained + pass-through clip written exactly\n");
+
+  /* === Part 2 === (the GOP pushed after re-arm is buffered) */
+  g_usleep(50 * G_TIME_SPAN_MILLISECOND);
+  gst_app_src_end_of_stream(GST_APP_SRC(appsrc));
+  msg = wait_message(pipeline, GST_MESSAGE_EOS, NULL);
+  if (!msg)
+    FAIL("part2: EOS did not reach the bus");
+  gst_message_unref(msg);
+  gchar* clip2 = g_build_filename(dir, "clip-2.bin", NULL);
+  if (!check_clip(clip2, 3, 9, &why))
+    FAIL("part2: %s", why);
+  if (!check_clip(clip1, 9, 0, &why))
+    FAIL("part2: EOS drain touched the finished clip: %s", why);
+  g_print("CLIPSINK: Part 2 ✓ - EOS drain written as a clip of its own\n");
+
+  g_print("CLIPSINK PASS\n");
+  gst_element_set_state(pipeline, GST_STATE_NULL);
+  gst_object_unref(appsrc);
+  gst_object_unref(pr);
+  gst_object_unref(pipeline);
+  g_unlink(clip1);
+  g_unlink(clip2);
+  g_rmdir(dir);
+  g_free(clip1);
+  g_free(clip2);
+  g_free(launch);
+  g_free(pattern);
+  g_free(dir);
+  return 0;
+}
@@ -0,0 +1,91 @@
+/* drain-qos: a QOS report during the drain thins the rest of the backlog.
+ *
+ * The src pad probe plays a late sink: when the first drained buffer (0 s)
+ * goes out it sends QOS with jitter 4 s and proportion 1.5, so everything
+ * ending before 8 s would be rendered late.
+ *
+ * Test Flow (4 GOPs of 3 x 1 s frames, 0-12 s):
+ *   flush → GOP1 keyframe pushed, its late deltas dropped (proportion >= 1),
+ *           GOP2 and GOP3 dropped as a whole, GOP4 (9 s, on time) pushed:
+ *           4 buffers out, qos-dropped-buffers=8, qos-dropped-gops=2, and the
+ *           QOS never reached upstream
+ *   pass-through → a QOS event is forwarded upstream again
+ */
+
+#define FAIL_PREFIX "DRAIN QOS FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <stdio.h>
+
+typedef struct {
+  guint buffers;
+  guint upstream_qos;
+} QosLog;
+
+static GstPadProbeReturn late_sink(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+  QosLog* log = user_data;
+
+  if (log->buffers++ == 0)
+    gst_pad_send_event(pad, gst_event_new_qos(GST_QOS_TYPE_UNDERFLOW, 1.5, 4 * GST_SECOND, 0));
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn count_qos(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+  QosLog* log = user_data;
+
+  if (GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)) == GST_EVENT_QOS)
+    log->upstream_qos++;
+  return GST_PAD_PROBE_OK;
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  PrerecTestPipeline tp;
+  QosLog log = {0};
+  guint64 ts = 0;
+
+  if (!prerec_pipeline_create(&tp, "drain-qos"))
+    FAIL("pipeline creation failed");
+  g_object_set(tp.pr, "max-time", 0, "drain-qos", TRUE, NULL);
+  gst_element_get_state(tp.pipeline, NULL, NULL, 2 * GST_SECOND);
+
+  GstPad* sink = gst_element_get_static_pad(tp.pr, "sink");
+  GstPad* src = gst_element_get_static_pad(tp.pr, "src");
+  prerec_send_stream_setup(sink, "drain-qos");
+  for (int i = 0; i < 4; ++i) {
+    if (!prerec_chain_gop(sink, &ts))
+      FAIL("gop %d push failed", i + 1);
+  }
+
+  gulong buffer_probe = gst_pad_add_probe(src, GST_PAD_PROBE_TYPE_BUFFER, late_sink, &log, NULL);
+  gulong qos_probe = gst_pad_add_probe(sink, GST_PAD_PROBE_TYPE_EVENT_UPSTREAM, count_qos, &log, NULL);
+
+  /* === Drain === */
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                     gst_structure_new_empty("prerecord-flush")));
+  if (log.buffers != 4)
+    FAIL("expected 4 drained buffers, got %u", log.buffers);
+  if (prerec_stat_uint(tp.pr, "qos-dropped-buffers") != 8 || prerec_stat_uint(tp.pr, "qos-dropped-gops") != 2)
+    FAIL("expected qos-dropped-buffers=8 gops=2, got %u/%u", prerec_stat_uint(tp.pr, "qos-dropped-buffers"),
+         prerec_stat_uint(tp.pr, "qos-dropped-gops"));
+  if (log.upstream_qos != 0)
+    FAIL("QOS about the backlog was forwarded upstream");
+  g_print("DRAIN QOS: late backlog thinned to catch up with live\n");
+
+  /* === Pass-through === */
+  gst_pad_send_event(src, gst_event_new_qos(GST_QOS_TYPE_UNDERFLOW, 1.0, GST_MSECOND, ts));
+  if (log.upstream_qos != 1)
+    FAIL("pass-through QOS not forwarded upstream");
+  g_print("DRAIN QOS: pass-through QOS forwarded\n");
+
+  g_print("DRAIN QOS PASS\n");
+  gst_pad_remove_probe(src, buffer_probe);
+  gst_pad_remove_probe(sink, qos_probe);
+  gst_object_unref(src);
+  gst_object_unref(sink);
+  prerec_pipeline_shutdown(&tp);
+  return 0;
+}
@@ -0,0 +1,124 @@
+/* drain-rebase: each drain pushes a SEGMENT mapping the first drained keyframe
+ * to drain-base-time; pass-through running time continues from there.
+ *
+ * Test Flow:
+ *   Part 1: buffers start at PTS 100s, buffer 2 GOPs, flush → first drained
+ *           buffer at running time 0, the 6 drained buffers at 0..5s, the
+ *           following pass-through GOP at 6..8s
+ *   Part 2: drain-base-time=10s, re-arm, buffer 2 GOPs, flush → first drained
+ *           buffer at running time 10s
+ *
+ * Running time is computed on the src pad against the last SEGMENT seen there.
+ */
+
+#define FAIL_PREFIX "REBASE FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <stdio.h>
+
+static GMutex rt_lock;
+static GstSegment src_segment;
+static GArray* running_times = NULL; /* guint64, one per buffer */
+
+static GstPadProbeReturn src_probe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+  g_mutex_lock(&rt_lock);
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+    GstBuffer* buf = GST_PAD_PROBE_INFO_BUFFER(info);
+    guint64 rt = gst_segment_to_running_time(&src_segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buf));
+    g_array_append_val(running_times, rt);
+  } else if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    GstEvent* ev = GST_PAD_PROBE_INFO_EVENT(info);
+    if (GST_EVENT_TYPE(ev) == GST_EVENT_SEGMENT)
+      gst_event_copy_segment(ev, &src_segment);
+  }
+  g_mutex_unlock(&rt_lock);
+  return GST_PAD_PROBE_OK;
+}
+
+static gboolean send_custom(GstElement* pr, GstEventType type, const char* name) {
+  return gst_element_send_event(pr, gst_event_new_custom(type, gst_structure_new_empty(name)));
+}
+
+static guint64 rt_at(guint index) {
+  guint64 rt = GST_CLOCK_TIME_NONE;
+  g_mutex_lock(&rt_lock);
+  if (index < running_times->len)
+    rt = g_array_index(running_times, guint64, index);
+  g_mutex_unlock(&rt_lock);
+  return rt;
+}
+
+static guint rt_count(void) {
+  g_mutex_lock(&rt_lock);
+  guint n = running_times->len;
+  g_mutex_unlock(&rt_lock);
+  return n;
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  PrerecTestPipeline tp;
+  if (!prerec_pipeline_create(&tp, "drain-rebase"))
+    FAIL("pipeline creation failed");
+  g_object_set(tp.pr, "drain-rebase", TRUE, NULL);
+
+  gst_segment_init(&src_segment, GST_FORMAT_TIME);
+  running_times = g_array_new(FALSE, FALSE, sizeof(guint64));
+  GstPad* src = gst_element_get_static_pad(tp.pr, "src");
+  gst_pad_add_probe(src, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, src_probe, NULL, NULL);
+  gst_object_unref(src);
+
+  guint64 ts = 100 * GST_SECOND;
+
+  /* === Part 1 === */
+  for (int i = 0; i < 2; ++i) {
+    if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+      FAIL("part1: gop push failed");
+  }
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 6, 2000))
+    FAIL("part1: ring did not reach 6 queued buffers");
+  if (!send_custom(tp.pr, GST_EVENT_CUSTOM_DOWNSTREAM, "prerecord-flush"))
+    FAIL("part1: flush send failed");
+  SETTLE(tp.pipeline);
+  if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+    FAIL("part1: pass-through push failed");
+  SETTLE(tp.pipeline);
+  if (rt_count() != 9)
+    FAIL("part1: expected 9 buffers on src, got %u", rt_count());
+  for (guint i = 0; i < 9; ++i) {
+    if (rt_at(i) != i * GST_SECOND)
+      FAIL("part1: buffer %u expected running time %" GST_TIME_FORMAT ", got %" GST_TIME_FORMAT, i,
+           GST_TIME_ARGS(i * GST_SECOND), GST_TIME_ARGS(rt_at(i)));
+  }
+  g_print("REBASE: Part 1 ✓ - drain starts at 0, pass-through continues\n");
+
+  /* === Part 2 === */
+  g_object_set(tp.pr, "drain-base-time", (guint64) (10 * GST_SECOND), NULL);
+  if (!send_custom(tp.pr, GST_EVENT_CUSTOM_UPSTREAM, "prerecord-arm"))
+    FAIL("part2: rearm send failed");
+  for (int i = 0; i < 2; ++i) {
+    if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+      FAIL("part2: gop push failed");
+  }
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 6, 2000))
+    FAIL("part2: ring did not reach 6 queued buffers");
+  if (!send_custom(tp.pr, GST_EVENT_CUSTOM_DOWNSTREAM, "prerecord-flush"))
+    FAIL("part2: flush send failed");
+  SETTLE(tp.pipeline);
+  if (rt_count() != 15)
+    FAIL("part2: expected 15 buffers on src, got %u", rt_count());
+  if (rt_at(9) != 10 * GST_SECOND)
+    FAIL("part2: expected first drained buffer at 10s, got %" GST_TIME_FORMAT, GST_TIME_ARGS(rt_at(9)));
+  if (rt_at(14) != 15 * GST_SECOND)
+    FAIL("part2: expected last drained buffer at 15s, got %" GST_TIME_FORMAT, GST_TIME_ARGS(rt_at(14)));
+  g_print("REBASE: Part 2 ✓ - drain-base-time honoured\n");
+
+  g_print("REBASE PASS\n");
+  prerec_pipeline_shutdown(&tp);
+  g_array_free(running_times, TRUE);
+  return 0;
+}
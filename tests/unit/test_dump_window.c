@@ -0,0 +1,181 @@
+/* dump-window action signal: the buffered window is written to a file by a
+ * worker while the element stays in BUFFERING.
+ *
+ * Test Flow:
+ *   Part 1: byte-stream caps, buffer 2 GOPs of 3 x 64 byte buffers,
+ *           dump-window(annexb) → prerec-dump-done with bytes=384, file holds
+ *           the payloads in order; a flush still drains all 6 buffers
+ *   Part 2: avc caps with codec_data, 2 length-prefixed GOPs,
+ *           dump-window(fmp4) → ftyp/moov then one moof per GOP;
+ *           dump-window(annexb) → start codes, SPS/PPS before each keyframe
+ */
+
+#define FAIL_PREFIX "DUMP FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PAYLOAD 64
+
+static const guint8 avcc[] = {0x01, 0x64, 0x00, 0x1f, 0xff, 0xe1, 0x00, 0x04, 0x67, 0x64, 0x00, 0x1f,
+                              0x01, 0x00, 0x02, 0x68, 0xee};
+
+/* keyframe + 2 deltas; payload bytes = PTS in seconds, optionally one
+ * 4-byte length prefixed NAL */
+static gboolean push_gop(GstElement* appsrc, guint64* ts, gboolean length_prefixed) {
+  for (int i = 0; i < 3; ++i) {
+    GstBuffer* b = gst_buffer_new_allocate(NULL, PAYLOAD, NULL);
+    gst_buffer_memset(b, 0, (guint8) (*ts / GST_SECOND), PAYLOAD);
+    if (length_prefixed) {
+      guint8 prefix[5] = {0, 0, 0, PAYLOAD - 4, i == 0 ? 0x65 : 0x41};
+      gst_buffer_fill(b, 0, prefix, sizeof(prefix));
+    }
+    GST_BUFFER_PTS(b) = GST_BUFFER_DTS(b) = *ts;
+    GST_BUFFER_DURATION(b) = GST_SECOND;
+    if (i > 0)
+      GST_BUFFER_FLAG_SET(b, GST_BUFFER_FLAG_DELTA_UNIT);
+    if (gst_app_src_push_buffer(GST_APP_SRC(appsrc), b) != GST_FLOW_OK)
+      return FALSE;
+    *ts += GST_SECOND;
+  }
+  return TRUE;
+}
+
+/* Emits dump-window and waits for its prerec-dump-done message */
+static gboolean dump(PrerecTestPipeline* tp, const gchar* path, const gchar* format, guint64* bytes) {
+  GstBus* bus = gst_element_get_bus(tp->pipeline);
+  GValue v = G_VALUE_INIT;
+  gboolean started = FALSE, ok = FALSE;
+
+  g_value_init(&v, g_type_from_name("GstPreRecDumpFormat"));
+  gst_value_deserialize(&v, format);
+  g_signal_emit_by_name(tp->pr, "dump-window", path, g_value_get_enum(&v), &started);
+  g_value_unset(&v);
+  if (!started) {
+    gst_object_unref(bus);
+    return FALSE;
+  }
+  for (int i = 0; i < 200; ++i) {
+    GstMessage* msg = gst_bus_timed_pop_filtered(bus, 10 * GST_MSECOND, GST_MESSAGE_ELEMENT);
+    const GstStructure* s = msg ? gst_message_get_structure(msg) : NULL;
+    if (s && gst_structure_has_name(s, "prerec-dump-done")) {
+      gst_structure_get_boolean(s, "success", &ok);
+      gst_structure_get_uint64(s, "bytes", bytes);
+      gst_message_unref(msg);
+      break;
+    }
+    if (msg)
+      gst_message_unref(msg);
+  }
+  gst_object_unref(bus);
+  return ok;
+}
+
+static guint count_boxes(const guint8* data, gsize len, const char* type) {
+  guint n = 0;
+  for (gsize off = 0; off + 8 <= len;) {
+    guint32 size = GST_READ_UINT32_BE(data + off);
+    if (memcmp(data + off + 4, type, 4) == 0)
+      n++;
+    if (size < 8)
+      break;
+    off += size;
+  }
+  return n;
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  gchar* dir = g_dir_make_tmp("prerec-dump-XXXXXX", NULL);
+  gchar* path = g_build_filename(dir, "window.bin", NULL);
+  gchar* data = NULL;
+  gsize len = 0;
+  guint64 ts = 0, bytes = 0;
+  PrerecTestPipeline tp;
+
+  /* === Part 1 === */
+  if (!prerec_pipeline_create(&tp, "dump-raw"))
+    FAIL("part1: pipeline creation failed");
+  for (int i = 0; i < 2; ++i) {
+    if (!push_gop(tp.appsrc, &ts, FALSE))
+      FAIL("part1: gop push failed");
+  }
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 6, 2000))
+    FAIL("part1: ring did not reach 6 queued buffers");
+  if (!dump(&tp, path, "annexb", &bytes))
+    FAIL("part1: dump failed");
+  if (bytes != 6 * PAYLOAD)
+    FAIL("part1: expected %d bytes written, got %" G_GUINT64_FORMAT, 6 * PAYLOAD, bytes);
+  if (!g_file_get_contents(path, &data, &len, NULL) || len != 6 * PAYLOAD)
+    FAIL("part1: dump file has %zu bytes", len);
+  for (gsize i = 0; i < len; ++i) {
+    if (data[i] != (gchar) (i / PAYLOAD))
+      FAIL("part1: byte %zu is %d, expected %d", i, data[i], (int) (i / PAYLOAD));
+  }
+  g_free(data);
+
+  guint64 emitted = 0;
+  gulong probe_id = prerec_attach_count_probe(tp.pr, &emitted);
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                     gst_structure_new_empty("prerecord-flush")));
+  SETTLE(tp.pipeline);
+  if (emitted != 6)
+    FAIL("part1: expected the window to stay buffered (6 drained), got %llu", (unsigned long long) emitted);
+  prerec_remove_probe(tp.pr, probe_id);
+  prerec_pipeline_shutdown(&tp);
+  g_print("DUMP: Part 1 ✓ - raw window dumped, ring untouched\n");
+
+  /* === Part 2 === */
+  if (!prerec_pipeline_create(&tp, "dump-avc"))
+    FAIL("part2: pipeline creation failed");
+  GstBuffer* codec_data = gst_buffer_new_memdup(avcc, sizeof(avcc));
+  GstCaps* caps = gst_caps_new_simple("video/x-h264", "stream-format", G_TYPE_STRING, "avc", "alignment",
+                                      G_TYPE_STRING, "au", "width", G_TYPE_INT, 320, "height", G_TYPE_INT, 240,
+                                      "codec_data", GST_TYPE_BUFFER, codec_data, NULL);
+  g_object_set(tp.appsrc, "caps", caps, NULL);
+  gst_caps_unref(caps);
+  gst_buffer_unref(codec_data);
+  ts = 0;
+  for (int i = 0; i < 2; ++i) {
+    if (!push_gop(tp.appsrc, &ts, TRUE))
+      FAIL("part2: gop push failed");
+  }
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 6, 2000))
+    FAIL("part2: ring did not reach 6 queued buffers");
+
+  if (!dump(&tp, path, "fmp4", &bytes))
+    FAIL("part2: fmp4 dump failed");
+  if (!g_file_get_contents(path, &data, &len, NULL) || len != bytes)
+    FAIL("part2: fmp4 file has %zu bytes, reported %" G_GUINT64_FORMAT, len, bytes);
+  if (count_boxes((guint8*) data, len, "ftyp") != 1 || count_boxes((guint8*) data, len, "moov") != 1)
+    FAIL("part2: missing init segment");
+  if (count_boxes((guint8*) data, len, "moof") != 2 || count_boxes((guint8*) data, len, "mdat") != 2)
+    FAIL("part2: expected one fragment per GOP");
+  g_free(data);
+
+  if (!dump(&tp, path, "annexb", &bytes))
+    FAIL("part2: annexb dump failed");
+  /* per GOP: SPS + PPS + 3 NALs, each behind a 4-byte start code */
+  gsize expected = 2 * ((4 + 4) + (4 + 2) + 3 * (4 + PAYLOAD - 4));
+  if (!g_file_get_contents(path, &data, &len, NULL) || len != expected)
+    FAIL("part2: annexb file has %zu bytes, expected %zu", len, expected);
+  static const guint8 head[] = {0, 0, 0, 1, 0x67, 0x64, 0x00, 0x1f, 0, 0, 0, 1, 0x68, 0xee, 0, 0, 0, 1, 0x65};
+  if (memcmp(data, head, sizeof(head)) != 0)
+    FAIL("part2: annexb stream does not start with SPS, PPS and the IDR NAL");
+  g_free(data);
+  g_print("DUMP: Part 2 ✓ - fmp4 and annexb conversion of avc input\n");
+
+  g_print("DUMP PASS\n");
+  prerec_pipeline_shutdown(&tp);
+  g_unlink(path);
+  g_rmdir(dir);
+  g_free(path);
+  g_free(dir);
+  return 0;
+}
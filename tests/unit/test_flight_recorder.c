@@ -0,0 +1,131 @@
+/* dump-flight-recorder returns the last ring decisions of the element as
+ * text, one line per decision, oldest first.
+ *
+ * Test Flow (max-time=4, 1 s frames, 3 per GOP):
+ *   Part 1: 3 GOPs → 9 enqueue lines with GOP ids and sizes, one prune
+ *           line per pruned GOP
+ *   Part 2: flush → a trigger line and a drain line with all queued
+ *           buffers; re-arm → an arm line
+ *   Part 3: 400 more GOPs → the dump keeps only the newest 1024 decisions,
+ *           with consecutive sequence numbers, and ends with the last enqueue
+ */
+
+#define FAIL_PREFIX "FLIGHT RECORDER FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static gchar** dump_lines(GstElement* pr, guint* n) {
+  gchar* text = NULL;
+  gchar** lines;
+
+  g_signal_emit_by_name(pr, "dump-flight-recorder", &text);
+  lines = g_strsplit(text ? text : "", "\n", -1);
+  g_free(text);
+  *n = g_strv_length(lines);
+  if (*n > 0 && lines[*n - 1][0] == '\0')
+    (*n)--; /* trailing newline */
+  return lines;
+}
+
+static guint count_kind(gchar** lines, guint n, const char* kind, const gchar** last) {
+  guint count = 0;
+  gchar* needle = g_strdup_printf(" %s ", kind);
+
+  for (guint i = 0; i < n; ++i) {
+    if (strstr(lines[i], needle)) {
+      count++;
+      if (last)
+        *last = lines[i];
+    }
+  }
+  g_free(needle);
+  return count;
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  PrerecTestPipeline tp;
+  guint64 ts = 0;
+  gchar** lines;
+  const gchar* last = NULL;
+  guint n, queued;
+
+  if (!prerec_pipeline_create(&tp, "flight-recorder"))
+    FAIL("pipeline creation failed");
+  g_object_set(tp.pr, "max-time", 4, NULL);
+  gst_element_get_state(tp.pipeline, NULL, NULL, 2 * GST_SECOND);
+
+  GstPad* sink = gst_element_get_static_pad(tp.pr, "sink");
+  prerec_send_stream_setup(sink, "flight-recorder");
+
+  /* === Part 1 === */
+  for (int i = 0; i < 3; ++i) {
+    if (!prerec_chain_gop(sink, &ts))
+      FAIL("part1: gop push failed");
+  }
+  queued = prerec_stat_uint(tp.pr, "queued-buffers");
+  lines = dump_lines(tp.pr, &n);
+  if (count_kind(lines, n, "enqueue", &last) != 9)
+    FAIL("part1: expected 9 enqueue lines, got %u", count_kind(lines, n, "enqueue", NULL));
+  if (!strstr(last, "pts=0:00:08.000000000") || !strstr(last, "size=64"))
+    FAIL("part1: last enqueue line '%s' lacks pts 8 s and size 64", last);
+  if (count_kind(lines, n, "prune", NULL) != prerec_stat_uint(tp.pr, "drops-gops") || prerec_stat_uint(tp.pr, "drops-gops") == 0)
+    FAIL("part1: %u prune lines for %u pruned GOPs", count_kind(lines, n, "prune", NULL),
+         prerec_stat_uint(tp.pr, "drops-gops"));
+  g_strfreev(lines);
+  g_print("FLIGHT RECORDER: Part 1 ✓ - enqueue and prune decisions\n");
+
+  /* === Part 2 === */
+  gchar* expect;
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                     gst_structure_new_empty("prerecord-flush")));
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_UPSTREAM,
+                                                     gst_structure_new_empty("prerecord-arm")));
+  lines = dump_lines(tp.pr, &n);
+  if (count_kind(lines, n, "trigger", &last) != 1)
+    FAIL("part2: expected one trigger line");
+  expect = g_strdup_printf("queued-buffers=%u ", queued);
+  if (!strstr(last, expect))
+    FAIL("part2: trigger line '%s' lacks %s", last, expect);
+  g_free(expect);
+  if (count_kind(lines, n, "drain", &last) != 1)
+    FAIL("part2: expected one drain line");
+  expect = g_strdup_printf("buffers=%u ", queued);
+  if (!strstr(last, expect))
+    FAIL("part2: drain line '%s' lacks %s", last, expect);
+  g_free(expect);
+  if (count_kind(lines, n, "arm", &last) != 1 || !strstr(last, "rearm-count=1"))
+    FAIL("part2: expected one arm line with rearm-count=1");
+  g_strfreev(lines);
+  g_print("FLIGHT RECORDER: Part 2 ✓ - trigger, drain and arm decisions\n");
+
+  /* === Part 3 === */
+  gchar expect_pts[64];
+  for (int i = 0; i < 400; ++i) {
+    if (!prerec_chain_gop(sink, &ts))
+      FAIL("part3: gop push failed");
+  }
+  lines = dump_lines(tp.pr, &n);
+  if (n != 1024)
+    FAIL("part3: expected the newest 1024 decisions, got %u", n);
+  for (guint i = 1; i < n; ++i) {
+    if (strtoul(lines[i], NULL, 10) != strtoul(lines[i - 1], NULL, 10) + 1)
+      FAIL("part3: sequence gap between '%s' and '%s'", lines[i - 1], lines[i]);
+  }
+  g_snprintf(expect_pts, sizeof(expect_pts), "pts=%" GST_TIME_FORMAT " ", GST_TIME_ARGS(ts - GST_SECOND));
+  if (!strstr(lines[n - 1], " enqueue ") || !strstr(lines[n - 1], expect_pts))
+    FAIL("part3: newest line '%s' is not the last enqueue (%s)", lines[n - 1], expect_pts);
+  g_strfreev(lines);
+  g_print("FLIGHT RECORDER: Part 3 ✓ - bounded ring keeps the newest decisions\n");
+
+  g_print("FLIGHT RECORDER PASS\n");
+  gst_object_unref(sink);
+  prerec_pipeline_shutdown(&tp);
+  return 0;
+}
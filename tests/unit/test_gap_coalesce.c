@@ -0,0 +1,92 @@
+/* GAP coalescing: runs of GAPs queued in BUFFERING mode take one ring slot
+ * and are drained as one GAP spanning the run.
+ *
+ * Test Flow:
+ *   GOP at 0-3 s, GAPs 3+1, 4+1, 5+1 s, GOP at 6-9 s, GAP 9+1 s, GAP 12 s
+ *   without duration, GAP 13+1 s
+ *   flush → 4 GAPs drained: 3 s + 3 s, 9 s + 1 s, 12 s (no duration),
+ *           13 s + 1 s; gaps-coalesced=2; every GAP was still forwarded
+ *           downstream when it arrived
+ */
+
+#define FAIL_PREFIX "GAP COALESCE FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <stdio.h>
+
+typedef struct {
+  guint count;
+  GstClockTime ts[8];
+  GstClockTime dur[8];
+} GapLog;
+
+static GstPadProbeReturn log_gaps(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+  GapLog* log = user_data;
+  GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+
+  if (GST_EVENT_TYPE(event) == GST_EVENT_GAP) {
+    if (log->count < G_N_ELEMENTS(log->ts))
+      gst_event_parse_gap(event, &log->ts[log->count], &log->dur[log->count]);
+    log->count++;
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  static const GstClockTime expect_ts[] = {3 * GST_SECOND, 9 * GST_SECOND, 12 * GST_SECOND, 13 * GST_SECOND};
+  static const GstClockTime expect_dur[] = {3 * GST_SECOND, GST_SECOND, GST_CLOCK_TIME_NONE, GST_SECOND};
+  PrerecTestPipeline tp;
+  GapLog log = {0};
+  guint64 ts = 0;
+
+  if (!prerec_pipeline_create(&tp, "gap-coalesce"))
+    FAIL("pipeline creation failed");
+  gst_element_get_state(tp.pipeline, NULL, NULL, 2 * GST_SECOND);
+
+  GstPad* sink = gst_element_get_static_pad(tp.pr, "sink");
+  GstPad* src = gst_element_get_static_pad(tp.pr, "src");
+  prerec_send_stream_setup(sink, "gap-coalesce");
+  gulong probe_id = gst_pad_add_probe(src, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, log_gaps, &log, NULL);
+
+  if (!prerec_chain_gop(sink, &ts))
+    FAIL("first gop push failed");
+  for (int i = 0; i < 3; ++i) {
+    gst_pad_send_event(sink, gst_event_new_gap(ts, GST_SECOND));
+    ts += GST_SECOND;
+  }
+  if (!prerec_chain_gop(sink, &ts))
+    FAIL("second gop push failed");
+  gst_pad_send_event(sink, gst_event_new_gap(9 * GST_SECOND, GST_SECOND));
+  gst_pad_send_event(sink, gst_event_new_gap(12 * GST_SECOND, GST_CLOCK_TIME_NONE));
+  gst_pad_send_event(sink, gst_event_new_gap(13 * GST_SECOND, GST_SECOND));
+
+  if (log.count != 6)
+    FAIL("expected the 6 GAPs forwarded on arrival, got %u", log.count);
+  if (prerec_stat_uint(tp.pr, "gaps-coalesced") != 2)
+    FAIL("expected gaps-coalesced=2, got %u", prerec_stat_uint(tp.pr, "gaps-coalesced"));
+
+  log = (GapLog){0};
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                     gst_structure_new_empty("prerecord-flush")));
+  if (log.count != G_N_ELEMENTS(expect_ts))
+    FAIL("expected %u GAPs drained, got %u", (guint) G_N_ELEMENTS(expect_ts), log.count);
+  for (guint i = 0; i < G_N_ELEMENTS(expect_ts); ++i) {
+    if (log.ts[i] != expect_ts[i] || log.dur[i] != expect_dur[i])
+      FAIL("drained GAP %u is %" GST_TIME_FORMAT " + %" GST_TIME_FORMAT ", expected %" GST_TIME_FORMAT
+           " + %" GST_TIME_FORMAT,
+           i, GST_TIME_ARGS(log.ts[i]), GST_TIME_ARGS(log.dur[i]), GST_TIME_ARGS(expect_ts[i]),
+           GST_TIME_ARGS(expect_dur[i]));
+  }
+  g_print("GAP COALESCE: runs of GAPs drained as spanning GAPs\n");
+
+  g_print("GAP COALESCE PASS\n");
+  gst_pad_remove_probe(src, probe_id);
+  gst_object_unref(src);
+  gst_object_unref(sink);
+  prerec_pipeline_shutdown(&tp);
+  return 0;
+}
@@ -0,0 +1,142 @@
+/* Per-GOP sticky state: after pruning removed the queued SEGMENT of the
+ * oldest GOP left, the drain still emits the caps and segment that GOP was
+ * recorded under, and switches to the newer state before the GOP that
+ * follows it.
+ *
+ * Events and 1 s buffers (3 per GOP) go straight into the sink pad; the
+ * SEGMENTs only differ in stream time so the ring's time level is unaffected.
+ *
+ * Test Flow:
+ *   caps a, segment time=0, GOP1, GOP2
+ *   caps b, segment time=1000 s, GOP3, GOP4
+ *   caps c, segment time=2000 s, GOP5
+ *   max-time=4 prunes down to GOP4 + GOP5 (downstream now holds c / 2000 s)
+ *   flush → the first drained buffer follows caps b and segment 1000 s, the
+ *           first GOP5 buffer follows caps c and segment 2000 s, and
+ *           state-restored counts the re-sent events
+ */
+
+#define FAIL_PREFIX "GOP STATE FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <stdio.h>
+
+typedef struct {
+  gchar caps[8];       /* variant of the last caps seen */
+  GstClockTime seg;    /* time of the last segment seen */
+  gboolean recording;
+  guint buffers;
+  gchar first_caps[8]; /* state in effect at the first drained buffer */
+  GstClockTime first_seg;
+  gchar gop5_caps[8];  /* ... and at the first GOP5 buffer */
+  GstClockTime gop5_seg;
+} Timeline;
+
+static GstPadProbeReturn record(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+  Timeline* tl = user_data;
+
+  if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    GstBuffer* buf = GST_PAD_PROBE_INFO_BUFFER(info);
+    if (!tl->recording)
+      return GST_PAD_PROBE_OK;
+    if (tl->buffers++ == 0) {
+      g_strlcpy(tl->first_caps, tl->caps, sizeof(tl->first_caps));
+      tl->first_seg = tl->seg;
+    }
+    if (GST_BUFFER_PTS(buf) == 12 * GST_SECOND) {
+      g_strlcpy(tl->gop5_caps, tl->caps, sizeof(tl->gop5_caps));
+      tl->gop5_seg = tl->seg;
+    }
+    return GST_PAD_PROBE_OK;
+  }
+
+  GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+  if (GST_EVENT_TYPE(event) == GST_EVENT_CAPS) {
+    GstCaps* caps;
+    const gchar* variant;
+    gst_event_parse_caps(event, &caps);
+    variant = gst_structure_get_string(gst_caps_get_structure(caps, 0), "variant");
+    g_strlcpy(tl->caps, variant ? variant : "?", sizeof(tl->caps));
+  } else if (GST_EVENT_TYPE(event) == GST_EVENT_SEGMENT) {
+    const GstSegment* segment;
+    gst_event_parse_segment(event, &segment);
+    tl->seg = segment->time;
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+static void send_state(GstPad* sink, const gchar* variant, GstClockTime time) {
+  GstCaps* caps = gst_caps_new_simple("video/x-h264", "variant", G_TYPE_STRING, variant, NULL);
+  GstSegment segment;
+
+  gst_pad_send_event(sink, gst_event_new_caps(caps));
+  gst_caps_unref(caps);
+  gst_segment_init(&segment, GST_FORMAT_TIME);
+  segment.time = time;
+  gst_pad_send_event(sink, gst_event_new_segment(&segment));
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  PrerecTestPipeline tp;
+  Timeline tl = {0};
+  guint64 ts = 0;
+
+  if (!prerec_pipeline_create(&tp, "gop-state"))
+    FAIL("pipeline creation failed");
+  g_object_set(tp.pr, "max-time", 4, NULL);
+  gst_element_get_state(tp.pipeline, NULL, NULL, 2 * GST_SECOND);
+
+  GstPad* sink = gst_element_get_static_pad(tp.pr, "sink");
+  GstPad* src = gst_element_get_static_pad(tp.pr, "src");
+  gulong probe_id =
+      gst_pad_add_probe(src, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, record, &tl, NULL);
+
+  gst_pad_send_event(sink, gst_event_new_stream_start("gop-state"));
+  send_state(sink, "a", 0);
+  for (int i = 0; i < 2; ++i) {
+    if (!prerec_chain_gop(sink, &ts))
+      FAIL("gop %d push failed", i + 1);
+  }
+  send_state(sink, "b", 1000 * GST_SECOND);
+  for (int i = 2; i < 4; ++i) {
+    if (!prerec_chain_gop(sink, &ts))
+      FAIL("gop %d push failed", i + 1);
+  }
+  send_state(sink, "c", 2000 * GST_SECOND);
+  if (!prerec_chain_gop(sink, &ts))
+    FAIL("gop 5 push failed");
+
+  if (prerec_stat_uint(tp.pr, "drops-gops") < 3 || prerec_stat_uint(tp.pr, "queued-gops") != 2)
+    FAIL("expected GOP4 + GOP5 left after pruning, got %u queued after %u drops", prerec_stat_uint(tp.pr, "queued-gops"),
+         prerec_stat_uint(tp.pr, "drops-gops"));
+  if (g_strcmp0(tl.caps, "c") != 0 || tl.seg != 2000 * GST_SECOND)
+    FAIL("downstream should hold caps c / segment 2000 s before the drain, has %s / %" GST_TIME_FORMAT, tl.caps,
+         GST_TIME_ARGS(tl.seg));
+
+  tl.recording = TRUE;
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                     gst_structure_new_empty("prerecord-flush")));
+  if (tl.buffers != 6)
+    FAIL("expected 6 drained buffers, got %u", tl.buffers);
+  if (g_strcmp0(tl.first_caps, "b") != 0 || tl.first_seg != 1000 * GST_SECOND)
+    FAIL("first drained GOP went out under caps %s / segment %" GST_TIME_FORMAT ", expected b / 1000 s",
+         tl.first_caps, GST_TIME_ARGS(tl.first_seg));
+  if (g_strcmp0(tl.gop5_caps, "c") != 0 || tl.gop5_seg != 2000 * GST_SECOND)
+    FAIL("GOP5 went out under caps %s / segment %" GST_TIME_FORMAT ", expected c / 2000 s", tl.gop5_caps,
+         GST_TIME_ARGS(tl.gop5_seg));
+  /* caps b and segment 1000 s before GOP4, caps c before GOP5 (its segment is queued) */
+  if (prerec_stat_uint(tp.pr, "state-restored") != 3)
+    FAIL("expected state-restored=3, got %u", prerec_stat_uint(tp.pr, "state-restored"));
+  g_print("GOP STATE: pruned GOPs' state restored before the drained GOPs\n");
+
+  g_print("GOP STATE PASS\n");
+  gst_pad_remove_probe(src, probe_id);
+  gst_object_unref(src);
+  gst_object_unref(sink);
+  prerec_pipeline_shutdown(&tp);
+  return 0;
+}
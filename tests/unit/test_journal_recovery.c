@@ -0,0 +1,185 @@
+/* Crash-persistent journal: closed GOPs are written to journal-location and a
+ * new instance replays them, skipping files that fail the CRC check.
+ *
+ * Test Flow:
+ *   Part 1: journal-location=<dir A>, buffer 3 GOPs + a keyframe → 3 GOP
+ *           files written (journal-written=3); the files are copied to
+ *           <dir B> as a crashed run would leave them, one byte of the
+ *           second GOP's payload flipped
+ *   Part 2: flush on A → the drained GOPs' files are removed from <dir A>
+ *   Part 3: new pipeline with journal-location=<dir B> → journal-recovered=2,
+ *           journal-corrupt=1; flush → 6 recovered + 3 live buffers with
+ *           intact payload, <dir B> empty
+ */
+
+#define FAIL_PREFIX "JOURNAL FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+
+#define PAYLOAD 256
+
+static gint drained = 0;
+static gint corrupt = 0;
+
+static GstPadProbeReturn check_probe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+  GstBuffer* buf = GST_PAD_PROBE_INFO_BUFFER(info);
+  guint8 expected = (guint8) (GST_BUFFER_PTS(buf) / GST_SECOND);
+  GstMapInfo map;
+
+  if (gst_buffer_map(buf, &map, GST_MAP_READ)) {
+    if (map.size != PAYLOAD || map.data[0] != expected || map.data[PAYLOAD - 1] != expected)
+      g_atomic_int_inc(&corrupt);
+    gst_buffer_unmap(buf, &map);
+  }
+  g_atomic_int_inc(&drained);
+  return GST_PAD_PROBE_OK;
+}
+
+/* One keyframe + (n - 1) deltas, 1 s each, payload filled with the PTS in seconds */
+static gboolean push_frames(GstElement* appsrc, guint64* ts, int n) {
+  for (int i = 0; i < n; ++i) {
+    GstBuffer* b = gst_buffer_new_allocate(NULL, PAYLOAD, NULL);
+    gst_buffer_memset(b, 0, (guint8) (*ts / GST_SECOND), PAYLOAD);
+    GST_BUFFER_PTS(b) = *ts;
+    GST_BUFFER_DURATION(b) = GST_SECOND;
+    if (i > 0)
+      GST_BUFFER_FLAG_SET(b, GST_BUFFER_FLAG_DELTA_UNIT);
+    if (gst_app_src_push_buffer(GST_APP_SRC(appsrc), b) != GST_FLOW_OK)
+      return FALSE;
+    *ts += GST_SECOND;
+  }
+  return TRUE;
+}
+
+/* Sorted names of the journal files in dir */
+static GPtrArray* list_files(const gchar* dir) {
+  GPtrArray* names = g_ptr_array_new_with_free_func(g_free);
+  GDir* d = g_dir_open(dir, 0, NULL);
+  const gchar* name;
+  while (d && (name = g_dir_read_name(d)))
+    g_ptr_array_add(names, g_strdup(name));
+  if (d)
+    g_dir_close(d);
+  g_ptr_array_sort(names, (GCompareFunc) g_strcmp0);
+  return names;
+}
+
+static gboolean create_with_journal(PrerecTestPipeline* tp, const char* name, const gchar* dir) {
+  if (!prerec_pipeline_create(tp, name))
+    return FALSE;
+  /* the journal is opened on NULL→READY */
+  gst_element_set_state(tp->pipeline, GST_STATE_NULL);
+  g_object_set(tp->pr, "journal-location", dir, NULL);
+  return gst_element_set_state(tp->pipeline, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE;
+}
+
+static void remove_dir(gchar* dir) {
+  GPtrArray* names = list_files(dir);
+  for (guint i = 0; i < names->len; ++i) {
+    gchar* path = g_build_filename(dir, g_ptr_array_index(names, i), NULL);
+    g_unlink(path);
+    g_free(path);
+  }
+  g_ptr_array_unref(names);
+  g_rmdir(dir);
+  g_free(dir);
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  gchar* dir_a = g_dir_make_tmp("prerec-journal-a-XXXXXX", NULL);
+  gchar* dir_b = g_dir_make_tmp("prerec-journal-b-XXXXXX", NULL);
+  if (!dir_a || !dir_b)
+    FAIL("could not create temp dirs");
+
+  PrerecTestPipeline tp;
+  guint64 ts = 0;
+
+  /* === Part 1 === */
+  if (!create_with_journal(&tp, "journal-a", dir_a))
+    FAIL("part1: pipeline creation failed");
+  for (int i = 0; i < 3; ++i) {
+    if (!push_frames(tp.appsrc, &ts, 3))
+      FAIL("part1: gop push failed");
+  }
+  if (!push_frames(tp.appsrc, &ts, 1)) /* closes GOP 3 */
+    FAIL("part1: keyframe push failed");
+  if (!prerec_wait_for_stat(tp.pr, "journal-written", 3, 2000))
+    FAIL("part1: journal-written did not reach 3");
+  if (prerec_stat_uint(tp.pr, "journal-written") != 3)
+    FAIL("part1: expected journal-written=3, got %u", prerec_stat_uint(tp.pr, "journal-written"));
+
+  GPtrArray* files = list_files(dir_a);
+  if (files->len != 3)
+    FAIL("part1: expected 3 journal files, found %u", files->len);
+  for (guint i = 0; i < files->len; ++i) {
+    gchar *src = g_build_filename(dir_a, g_ptr_array_index(files, i), NULL),
+          *dst = g_build_filename(dir_b, g_ptr_array_index(files, i), NULL);
+    gchar* data = NULL;
+    gsize len = 0;
+    if (!g_file_get_contents(src, &data, &len, NULL))
+      FAIL("part1: cannot read %s", src);
+    if (i == 1)
+      data[len - 1] ^= 0xff; /* last payload byte of GOP 2 */
+    if (!g_file_set_contents(dst, data, len, NULL))
+      FAIL("part1: cannot write %s", dst);
+    g_free(data);
+    g_free(src);
+    g_free(dst);
+  }
+  g_ptr_array_unref(files);
+  g_print("JOURNAL: Part 1 ✓ - closed GOPs journaled\n");
+
+  /* === Part 2 === */
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                     gst_structure_new_empty("prerecord-flush")));
+  SETTLE(tp.pipeline);
+  files = list_files(dir_a);
+  if (files->len != 0)
+    FAIL("part2: expected the journal to be empty after the drain, found %u files", files->len);
+  g_ptr_array_unref(files);
+  prerec_pipeline_shutdown(&tp);
+  g_print("JOURNAL: Part 2 ✓ - drained GOPs removed from the journal\n");
+
+  /* === Part 3 === */
+  if (!create_with_journal(&tp, "journal-b", dir_b))
+    FAIL("part3: pipeline creation failed");
+  GstPad* src = gst_element_get_static_pad(tp.pr, "src");
+  gst_pad_add_probe(src, GST_PAD_PROBE_TYPE_BUFFER, check_probe, NULL, NULL);
+  gst_object_unref(src);
+
+  ts = 100 * GST_SECOND; /* the restarted source has its own timeline */
+  if (!push_frames(tp.appsrc, &ts, 3))
+    FAIL("part3: gop push failed");
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 9, 2000))
+    FAIL("part3: ring did not reach 9 queued buffers");
+  if (prerec_stat_uint(tp.pr, "journal-recovered") != 2)
+    FAIL("part3: expected journal-recovered=2, got %u", prerec_stat_uint(tp.pr, "journal-recovered"));
+  if (prerec_stat_uint(tp.pr, "journal-corrupt") != 1)
+    FAIL("part3: expected journal-corrupt=1, got %u", prerec_stat_uint(tp.pr, "journal-corrupt"));
+
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                     gst_structure_new_empty("prerecord-flush")));
+  SETTLE(tp.pipeline);
+  if (g_atomic_int_get(&drained) != 9)
+    FAIL("part3: expected 9 drained buffers, got %d", g_atomic_int_get(&drained));
+  if (g_atomic_int_get(&corrupt) != 0)
+    FAIL("part3: %d drained buffers had a corrupt payload", g_atomic_int_get(&corrupt));
+  files = list_files(dir_b);
+  if (files->len != 0)
+    FAIL("part3: expected the journal to be empty after the drain, found %u files", files->len);
+  g_ptr_array_unref(files);
+  g_print("JOURNAL: Part 3 ✓ - intact GOPs recovered, corrupt GOP skipped\n");
+
+  g_print("JOURNAL PASS\n");
+  prerec_pipeline_shutdown(&tp);
+  remove_dir(dir_a);
+  remove_dir(dir_b);
+  return 0;
+}
@@ -0,0 +1,118 @@
+/* Latency histograms in prerec-stats: enqueue, prune, drain push and buffer
+ * residency are recorded by the element and can be reset by the query.
+ *
+ * Test Flow (max-time=4, 3 GOPs of 3 x 1 s frames):
+ *   Part 1: GOP3's keyframe prunes GOP1 → enqueue-count=9, prune-count=1,
+ *           residency-count=3 (the pruned frames); quantiles ordered and
+ *           bucket counts add up to the sample count
+ *   Part 2: flush → drain-push-count >= 6, residency-count=9
+ *   Part 3: query with reset-histograms=TRUE still reports the samples, the
+ *           next query reports none
+ */
+
+#define FAIL_PREFIX "LATENCY HISTOGRAMS FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <stdio.h>
+
+static GstStructure* query_stats(GstElement* pr, gboolean reset) {
+  GstStructure* s = NULL;
+  GstQuery* q = gst_query_new_custom(GST_QUERY_CUSTOM,
+                                     gst_structure_new("prerec-stats", "reset-histograms", G_TYPE_BOOLEAN, reset, NULL));
+  if (gst_element_query(pr, q))
+    s = gst_structure_copy(gst_query_get_structure(q));
+  gst_query_unref(q);
+  return s;
+}
+
+static guint64 field_uint64(const GstStructure* s, const char* name, const char* suffix) {
+  guint64 v = G_MAXUINT64;
+  gchar* field = g_strdup_printf("%s-%s", name, suffix);
+  gst_structure_get_uint64(s, field, &v);
+  g_free(field);
+  return v;
+}
+
+/* min <= p50 <= p99 <= max and the (start, count) bucket pairs sum to count */
+static gboolean histogram_consistent(const GstStructure* s, const char* name) {
+  guint64 count = field_uint64(s, name, "count"), sum = 0;
+  gchar* field = g_strdup_printf("%s-buckets", name);
+  const GValue* buckets = gst_structure_get_value(s, field);
+  g_free(field);
+
+  if (!buckets || gst_value_array_get_size(buckets) % 2 != 0)
+    return FALSE;
+  for (guint i = 1; i < gst_value_array_get_size(buckets); i += 2)
+    sum += g_value_get_uint64(gst_value_array_get_value(buckets, i));
+  return sum == count && field_uint64(s, name, "min") <= field_uint64(s, name, "p50") &&
+         field_uint64(s, name, "p50") <= field_uint64(s, name, "p99") &&
+         field_uint64(s, name, "p99") <= field_uint64(s, name, "max");
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  PrerecTestPipeline tp;
+  GstStructure* s;
+  guint64 ts = 0;
+
+  if (!prerec_pipeline_create(&tp, "latency-histograms"))
+    FAIL("pipeline creation failed");
+  g_object_set(tp.pr, "max-time", 4, NULL);
+  gst_element_get_state(tp.pipeline, NULL, NULL, 2 * GST_SECOND);
+
+  GstPad* sink = gst_element_get_static_pad(tp.pr, "sink");
+  prerec_send_stream_setup(sink, "latency-histograms");
+
+  /* === Part 1 === */
+  for (int i = 0; i < 3; ++i) {
+    if (!prerec_chain_gop(sink, &ts))
+      FAIL("part1: gop %d push failed", i + 1);
+  }
+  s = query_stats(tp.pr, FALSE);
+  if (!s)
+    FAIL("part1: prerec-stats not answered");
+  if (field_uint64(s, "enqueue", "count") != 9 || field_uint64(s, "prune", "count") != 1 ||
+      field_uint64(s, "residency", "count") != 3)
+    FAIL("part1: enqueue/prune/residency counts %" G_GUINT64_FORMAT "/%" G_GUINT64_FORMAT "/%" G_GUINT64_FORMAT
+         ", expected 9/1/3",
+         field_uint64(s, "enqueue", "count"), field_uint64(s, "prune", "count"),
+         field_uint64(s, "residency", "count"));
+  if (!histogram_consistent(s, "enqueue") || !histogram_consistent(s, "prune") ||
+      !histogram_consistent(s, "residency"))
+    FAIL("part1: inconsistent quantiles or buckets: %" GST_PTR_FORMAT, s);
+  gst_structure_free(s);
+  g_print("LATENCY HISTOGRAMS: Part 1 ✓ - enqueue, prune and residency recorded\n");
+
+  /* === Part 2 === */
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                     gst_structure_new_empty("prerecord-flush")));
+  s = query_stats(tp.pr, FALSE);
+  if (field_uint64(s, "drain-push", "count") < 6 || field_uint64(s, "residency", "count") != 9)
+    FAIL("part2: drain-push-count=%" G_GUINT64_FORMAT " residency-count=%" G_GUINT64_FORMAT
+         ", expected >= 6 and 9",
+         field_uint64(s, "drain-push", "count"), field_uint64(s, "residency", "count"));
+  if (!histogram_consistent(s, "drain-push") || !histogram_consistent(s, "residency"))
+    FAIL("part2: inconsistent quantiles or buckets: %" GST_PTR_FORMAT, s);
+  gst_structure_free(s);
+  g_print("LATENCY HISTOGRAMS: Part 2 ✓ - drain pushes and residency recorded\n");
+
+  /* === Part 3 === */
+  s = query_stats(tp.pr, TRUE);
+  if (field_uint64(s, "enqueue", "count") != 9)
+    FAIL("part3: resetting query lost its own samples");
+  gst_structure_free(s);
+  s = query_stats(tp.pr, FALSE);
+  if (field_uint64(s, "enqueue", "count") != 0 || field_uint64(s, "residency", "count") != 0 ||
+      field_uint64(s, "enqueue", "max") != 0)
+    FAIL("part3: histograms not reset: %" GST_PTR_FORMAT, s);
+  gst_structure_free(s);
+  g_print("LATENCY HISTOGRAMS: Part 3 ✓ - reset-histograms clears them\n");
+
+  g_print("LATENCY HISTOGRAMS PASS\n");
+  gst_object_unref(sink);
+  prerec_pipeline_shutdown(&tp);
+  return 0;
+}
@@ -0,0 +1,131 @@
+/* "live" request pad: every input buffer reaches the live pad regardless of
+ * mode, and a stalled live consumer only costs live drops, never ingest.
+ *
+ * Test Flow:
+ *   Part 1: request pr.live → fakesink, buffer 2 GOPs → live=6, src=0
+ *   Part 2: flush, push 1 pass-through GOP → live=9, src=9
+ *   Part 3: block the live sink, live-max-buffers=2, push 2 GOPs → src
+ *           still receives all 6 buffers and live-drops > 0
+ *   Part 4: EOS into the live sink, push 1 GOP → the live task pauses
+ *           after one refused buffer; flush the live sink and send
+ *           RECONFIGURE on pr.live, push 1 GOP → all 3 reach the live pad
+ */
+
+#define FAIL_PREFIX "LIVE FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <stdio.h>
+
+static GstPadProbeReturn count_probe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+  g_atomic_int_inc((gint*) user_data);
+  return GST_PAD_PROBE_OK;
+}
+
+static GstPadProbeReturn block_probe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+  return GST_PAD_PROBE_OK; /* GST_PAD_PROBE_TYPE_BLOCK holds the buffer until removed */
+}
+
+static guint live_drops(GstElement* pr) {
+  guint drops = G_MAXUINT;
+  GstQuery* q = gst_query_new_custom(GST_QUERY_CUSTOM, gst_structure_new_empty("prerec-stats"));
+  if (gst_element_query(pr, q))
+    gst_structure_get_uint(gst_query_get_structure(q), "live-drops", &drops);
+  gst_query_unref(q);
+  return drops;
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  PrerecTestPipeline tp;
+  if (!prerec_pipeline_create(&tp, "live-pad"))
+    FAIL("pipeline creation failed");
+
+  GstPad* live = gst_element_request_pad_simple(tp.pr, "live");
+  if (!live)
+    FAIL("live pad request failed");
+  GstElement* live_sink = gst_element_factory_make("fakesink", "live-sink");
+  g_object_set(live_sink, "sync", FALSE, NULL);
+  gst_bin_add(GST_BIN(tp.pipeline), live_sink);
+  GstPad* live_sink_pad = gst_element_get_static_pad(live_sink, "sink");
+  if (gst_pad_link(live, live_sink_pad) != GST_PAD_LINK_OK)
+    FAIL("live pad link failed");
+  gst_element_sync_state_with_parent(live_sink);
+
+  gint live_count = 0;
+  gst_pad_add_probe(live, GST_PAD_PROBE_TYPE_BUFFER, count_probe, &live_count, NULL);
+  guint64 src_count = 0;
+  gulong src_probe = prerec_attach_count_probe(tp.pr, &src_count);
+
+  guint64 ts = 0;
+
+  /* === Part 1 === */
+  for (int i = 0; i < 2; ++i) {
+    if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+      FAIL("part1: gop push failed");
+  }
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 6, 2000))
+    FAIL("part1: ring did not reach 6 queued buffers");
+  if (g_atomic_int_get(&live_count) != 6 || src_count != 0)
+    FAIL("part1: expected live=6 src=0, got live=%d src=%llu", g_atomic_int_get(&live_count),
+         (unsigned long long) src_count);
+  g_print("LIVE: Part 1 ✓ - live pad flows while buffering\n");
+
+  /* === Part 2 === */
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                     gst_structure_new_empty("prerecord-flush")));
+  if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+    FAIL("part2: gop push failed");
+  SETTLE(tp.pipeline);
+  if (g_atomic_int_get(&live_count) != 9 || src_count != 9)
+    FAIL("part2: expected live=9 src=9, got live=%d src=%llu", g_atomic_int_get(&live_count),
+         (unsigned long long) src_count);
+  g_print("LIVE: Part 2 ✓ - live pad unaffected by drain\n");
+
+  /* === Part 3 === */
+  g_object_set(tp.pr, "live-max-buffers", 2, NULL);
+  gulong block_id = gst_pad_add_probe(live_sink_pad, GST_PAD_PROBE_TYPE_BLOCK | GST_PAD_PROBE_TYPE_BUFFER,
+                                      block_probe, NULL, NULL);
+  for (int i = 0; i < 2; ++i) {
+    if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+      FAIL("part3: gop push failed");
+  }
+  SETTLE(tp.pipeline);
+  if (src_count != 15)
+    FAIL("part3: ingest stalled behind the live pad, src=%llu", (unsigned long long) src_count);
+  if (live_drops(tp.pr) == 0 || live_drops(tp.pr) == G_MAXUINT)
+    FAIL("part3: expected live drops, got %u", live_drops(tp.pr));
+  gst_pad_remove_probe(live_sink_pad, block_id);
+  g_print("LIVE: Part 3 ✓ - slow viewer dropped %u buffers without stalling ingest\n", live_drops(tp.pr));
+
+  /* === Part 4 === */
+  SETTLE(tp.pipeline);
+  gint before = g_atomic_int_get(&live_count);
+  gst_pad_send_event(live_sink_pad, gst_event_new_eos());
+  if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+    FAIL("part4: gop push failed");
+  SETTLE(tp.pipeline);
+  gint paused = g_atomic_int_get(&live_count);
+  if (paused - before > 1)
+    FAIL("part4: live task kept pushing into an EOS branch (%d buffers)", paused - before);
+  gst_pad_send_event(live_sink_pad, gst_event_new_flush_start());
+  gst_pad_send_event(live_sink_pad, gst_event_new_flush_stop(TRUE));
+  gst_pad_send_event(live, gst_event_new_reconfigure());
+  if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+    FAIL("part4: gop push after reconfigure failed");
+  SETTLE(tp.pipeline);
+  if (g_atomic_int_get(&live_count) != paused + 3)
+    FAIL("part4: expected 3 live buffers after RECONFIGURE, got %d", g_atomic_int_get(&live_count) - paused);
+  g_print("LIVE: Part 4 ✓ - live task paused on EOS and resumed on RECONFIGURE\n");
+
+  g_print("LIVE PASS\n");
+  prerec_remove_probe(tp.pr, src_probe);
+  gst_object_unref(live_sink_pad);
+  gst_element_release_request_pad(tp.pr, live);
+  gst_object_unref(live);
+  prerec_pipeline_shutdown(&tp);
+  return 0;
+}
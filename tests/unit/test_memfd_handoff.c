@@ -0,0 +1,255 @@
+/* memfd hand-off: on a trigger the buffered window is passed to another
+ * process as a memfd plus frame index over handoff-socket.
+ *
+ * Test Flow:
+ *   Part 1: bundled prerec-handoff-consumer (--once) listening,
+ *           handoff-socket set, 2 GOPs of 3 x 128 byte buffers, trigger →
+ *           prerec-handoff-done with success, frames=6, skipped=0;
+ *           clip-<id>.bin holds the payloads in order; handoff-count=1;
+ *           the system-memory payloads were copied in (handoff-copied=6);
+ *           the drain downstream still emits all 6 buffers
+ *   Part 2: consumer gone, re-arm, 1 GOP, trigger → handoff-failed=1 and
+ *           the drain is unaffected
+ *   Part 3: the ALLOCATION query proposes the memfd allocator; a new
+ *           consumer, re-arm, 1 GOP allocated from it, trigger → 3 frames
+ *           handed off and handoff-copied unchanged
+ *
+ * The consumer binary comes from PREREC_HANDOFF_CONSUMER (set by CTest).
+ */
+
+#define FAIL_PREFIX "HANDOFF FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <sys/wait.h>
+
+#define PAYLOAD 128
+
+/* keyframe + 2 deltas from allocator, payload filled with the PTS in seconds */
+static gboolean push_gop(GstElement* appsrc, GstAllocator* allocator, guint64* ts) {
+  for (int i = 0; i < 3; ++i) {
+    GstBuffer* b = gst_buffer_new_allocate(allocator, PAYLOAD, NULL);
+    gst_buffer_memset(b, 0, (guint8) (*ts / GST_SECOND), PAYLOAD);
+    GST_BUFFER_PTS(b) = *ts;
+    GST_BUFFER_DURATION(b) = GST_SECOND;
+    if (i > 0)
+      GST_BUFFER_FLAG_SET(b, GST_BUFFER_FLAG_DELTA_UNIT);
+    if (gst_app_src_push_buffer(GST_APP_SRC(appsrc), b) != GST_FLOW_OK)
+      return FALSE;
+    *ts += GST_SECOND;
+  }
+  return TRUE;
+}
+
+/* First allocator of the ALLOCATION answer, asked the way an encoder would */
+static GstAllocator* query_allocator(GstElement* appsrc) {
+  GstPad* pad = gst_element_get_static_pad(appsrc, "src");
+  GstCaps* caps = gst_caps_new_empty_simple("video/x-h264");
+  GstQuery* q = gst_query_new_allocation(caps, FALSE);
+  GstAllocator* allocator = NULL;
+
+  if (gst_pad_peer_query(pad, q) && gst_query_get_n_allocation_params(q) > 0)
+    gst_query_parse_nth_allocation_param(q, 0, &allocator, NULL);
+  gst_query_unref(q);
+  gst_caps_unref(caps);
+  gst_object_unref(pad);
+  return allocator;
+}
+
+/* Starts the bundled consumer for one hand-off and waits for its socket */
+static gboolean start_consumer(const gchar* consumer, const gchar* sock, const gchar* dir, GPid* pid) {
+  gchar* argv_consumer[] = {(gchar*) consumer, "--once", (gchar*) sock, (gchar*) dir, NULL};
+  GError* error = NULL;
+
+  g_unlink(sock);
+  if (!g_spawn_async(NULL, argv_consumer, NULL, G_SPAWN_DO_NOT_REAP_CHILD, NULL, NULL, pid, &error)) {
+    g_printerr("cannot start consumer: %s\n", error->message);
+    g_clear_error(&error);
+    return FALSE;
+  }
+  for (int i = 0; i < 200 && !g_file_test(sock, G_FILE_TEST_EXISTS); ++i)
+    g_usleep(10 * G_TIME_SPAN_MILLISECOND);
+  return g_file_test(sock, G_FILE_TEST_EXISTS);
+}
+
+/* Reaps the consumer; returns its exit status (-1 if it did not exit) */
+static gint wait_consumer(GPid pid) {
+  gint status = -1;
+  for (int i = 0; i < 200 && waitpid(pid, &status, WNOHANG) == 0; ++i)
+    g_usleep(10 * G_TIME_SPAN_MILLISECOND);
+  g_spawn_close_pid(pid);
+  return status;
+}
+
+static void send_flush(GstElement* pr) {
+  gst_element_send_event(pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                  gst_structure_new_empty("prerecord-flush")));
+}
+
+static void send_rearm(GstElement* pr) {
+  gst_element_send_event(pr, gst_event_new_custom(GST_EVENT_CUSTOM_UPSTREAM, gst_structure_new_empty("prerecord-arm")));
+}
+
+/* Waits for prerec-handoff-done; returns its structure (caller frees) */
+static GstStructure* wait_done(GstElement* pipeline) {
+  GstBus* bus = gst_element_get_bus(pipeline);
+  GstStructure* done = NULL;
+
+  for (int i = 0; i < 500 && !done; ++i) {
+    GstMessage* msg = gst_bus_timed_pop_filtered(bus, 10 * GST_MSECOND, GST_MESSAGE_ELEMENT);
+    const GstStructure* s = msg ? gst_message_get_structure(msg) : NULL;
+    if (s && gst_structure_has_name(s, "prerec-handoff-done"))
+      done = gst_structure_copy(s);
+    if (msg)
+      gst_message_unref(msg);
+  }
+  gst_object_unref(bus);
+  return done;
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  const gchar* consumer = g_getenv("PREREC_HANDOFF_CONSUMER");
+  if (!consumer)
+    FAIL("PREREC_HANDOFF_CONSUMER not set");
+
+  gchar* dir = g_dir_make_tmp("prerec-handoff-XXXXXX", NULL);
+  gchar* sock = g_build_filename(dir, "handoff.sock", NULL);
+  GPid pid;
+  if (!start_consumer(consumer, sock, dir, &pid))
+    FAIL("consumer did not start listening on %s", sock);
+
+  PrerecTestPipeline tp;
+  guint64 ts = 0, emitted = 0;
+  guint frames = 0, skipped = G_MAXUINT;
+  guint64 clip_id = 0;
+  gboolean success = FALSE;
+
+  /* === Part 1 === */
+  if (!prerec_pipeline_create(&tp, "handoff"))
+    FAIL("part1: pipeline creation failed");
+  /* the memfd arena is created on NULL→READY */
+  gst_element_set_state(tp.pipeline, GST_STATE_NULL);
+  g_object_set(tp.pr, "handoff-socket", sock, NULL);
+  if (gst_element_set_state(tp.pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    FAIL("part1: could not restart with handoff-socket");
+  gulong probe_id = prerec_attach_count_probe(tp.pr, &emitted);
+
+  for (int i = 0; i < 2; ++i) {
+    if (!push_gop(tp.appsrc, NULL, &ts))
+      FAIL("part1: gop push failed");
+  }
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 6, 2000))
+    FAIL("part1: ring did not reach 6 queued buffers");
+  send_flush(tp.pr);
+  GstStructure* done = wait_done(tp.pipeline);
+  if (!done)
+    FAIL("part1: no prerec-handoff-done message");
+  gst_structure_get_boolean(done, "success", &success);
+  gst_structure_get_uint(done, "frames", &frames);
+  gst_structure_get_uint(done, "skipped", &skipped);
+  gst_structure_get_uint64(done, "clip-id", &clip_id);
+  if (!success)
+    FAIL("part1: hand-off failed: %s", gst_structure_get_string(done, "error"));
+  gst_structure_free(done);
+  if (frames != 6 || skipped != 0)
+    FAIL("part1: expected 6 frames and none skipped, got %u/%u", frames, skipped);
+
+  gchar* name = g_strdup_printf("clip-%" G_GUINT64_FORMAT ".bin", clip_id);
+  gchar* clip = g_build_filename(dir, name, NULL);
+  gchar* data = NULL;
+  gsize len = 0;
+  if (!g_file_get_contents(clip, &data, &len, NULL) || len != 6 * PAYLOAD)
+    FAIL("part1: %s has %zu bytes, expected %d", clip, len, 6 * PAYLOAD);
+  for (gsize i = 0; i < len; ++i) {
+    if (data[i] != (gchar) (i / PAYLOAD))
+      FAIL("part1: byte %zu is %d, expected %d", i, data[i], (int) (i / PAYLOAD));
+  }
+  g_free(data);
+  if (prerec_stat_uint(tp.pr, "handoff-count") != 1)
+    FAIL("part1: expected handoff-count=1, got %u", prerec_stat_uint(tp.pr, "handoff-count"));
+  if (prerec_stat_uint(tp.pr, "handoff-copied") != 6)
+    FAIL("part1: expected handoff-copied=6, got %u", prerec_stat_uint(tp.pr, "handoff-copied"));
+  SETTLE(tp.pipeline);
+  if (emitted != 6)
+    FAIL("part1: expected 6 drained buffers, got %llu", (unsigned long long) emitted);
+
+  gint status = wait_consumer(pid);
+  if (status != 0)
+    FAIL("part1: consumer exited with status %d", status);
+  g_print("HANDOFF: Part 1 ✓ - window handed off through the memfd\n");
+
+  /* === Part 2 === */
+  send_rearm(tp.pr);
+  emitted = 0;
+  if (!push_gop(tp.appsrc, NULL, &ts))
+    FAIL("part2: gop push failed");
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 3, 2000))
+    FAIL("part2: ring did not reach 3 queued buffers");
+  send_flush(tp.pr);
+  done = wait_done(tp.pipeline);
+  if (!done)
+    FAIL("part2: no prerec-handoff-done message");
+  success = TRUE;
+  gst_structure_get_boolean(done, "success", &success);
+  gst_structure_free(done);
+  if (success || prerec_stat_uint(tp.pr, "handoff-failed") != 1)
+    FAIL("part2: expected a failed hand-off, handoff-failed=%u", prerec_stat_uint(tp.pr, "handoff-failed"));
+  SETTLE(tp.pipeline);
+  if (emitted != 3)
+    FAIL("part2: expected 3 drained buffers, got %llu", (unsigned long long) emitted);
+  g_print("HANDOFF: Part 2 ✓ - missing consumer reported, drain unaffected\n");
+
+  /* === Part 3 === */
+  GstAllocator* arena = query_allocator(tp.appsrc);
+  if (!arena || g_strcmp0(arena->mem_type, "PreRecArena") != 0)
+    FAIL("part3: memfd allocator not proposed (got %s)", arena ? arena->mem_type : "none");
+  guint copied = prerec_stat_uint(tp.pr, "handoff-copied");
+  if (!start_consumer(consumer, sock, dir, &pid))
+    FAIL("part3: consumer did not start listening on %s", sock);
+  send_rearm(tp.pr);
+  if (!push_gop(tp.appsrc, arena, &ts))
+    FAIL("part3: gop push failed");
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 3, 2000))
+    FAIL("part3: ring did not reach 3 queued buffers");
+  send_flush(tp.pr);
+  done = wait_done(tp.pipeline);
+  if (!done)
+    FAIL("part3: no prerec-handoff-done message");
+  success = FALSE;
+  gst_structure_get_boolean(done, "success", &success);
+  gst_structure_get_uint(done, "frames", &frames);
+  gst_structure_get_uint64(done, "clip-id", &clip_id);
+  gst_structure_free(done);
+  if (!success || frames != 3)
+    FAIL("part3: expected 3 frames handed off, got %u (success=%d)", frames, success);
+  if (prerec_stat_uint(tp.pr, "handoff-copied") != copied)
+    FAIL("part3: arena-allocated payloads were copied (handoff-copied %u -> %u)", copied,
+         prerec_stat_uint(tp.pr, "handoff-copied"));
+  status = wait_consumer(pid);
+  if (status != 0)
+    FAIL("part3: consumer exited with status %d", status);
+  gchar* name3 = g_strdup_printf("clip-%" G_GUINT64_FORMAT ".bin", clip_id);
+  gchar* clip3 = g_build_filename(dir, name3, NULL);
+  g_unlink(clip3);
+  g_free(clip3);
+  g_free(name3);
+  gst_object_unref(arena);
+  g_print("HANDOFF: Part 3 ✓ - frames allocated in the memfd handed off without a copy\n");
+
+  g_print("HANDOFF PASS\n");
+  prerec_remove_probe(tp.pr, probe_id);
+  prerec_pipeline_shutdown(&tp);
+  g_unlink(clip);
+  g_rmdir(dir);
+  g_free(clip);
+  g_free(name);
+  g_free(sock);
+  g_free(dir);
+  return 0;
+}
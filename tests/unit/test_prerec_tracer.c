@@ -0,0 +1,128 @@
+/* GST_TRACERS=prerec logs the ring of pre_record_loop as tracer records.
+ *
+ * The test enables the tracer before gst_init and collects the GST_TRACER
+ * debug output with its own log function.
+ *
+ * Test Flow (max-time=4, 1 s frames, 3 per GOP):
+ *   Part 1: 3 GOPs → one prerec-level per frame naming the element, the
+ *           last one with the level after pruning; prerec-prune records
+ *   Part 2: flush → one prerec-drain (trigger-flush, all queued buffers)
+ *           and one prerec-trigger with a latency
+ */
+
+#define FAIL_PREFIX "PREREC TRACER FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <stdio.h>
+
+typedef struct {
+  guint level, prune, drain, trigger;
+  GstStructure* last_level;
+  GstStructure* last_drain;
+  GstStructure* last_trigger;
+} TraceLog;
+
+static TraceLog trace;
+
+static void keep(GstStructure** slot, GstStructure* s) {
+  if (*slot)
+    gst_structure_free(*slot);
+  *slot = s;
+}
+
+static void collect(GstDebugCategory* category, GstDebugLevel level, const gchar* file, const gchar* function,
+                    gint line, GObject* object, GstDebugMessage* message, gpointer user_data) {
+  GstStructure* s;
+
+  if (g_strcmp0(gst_debug_category_get_name(category), "GST_TRACER") != 0)
+    return;
+  s = gst_structure_from_string(gst_debug_message_get(message), NULL);
+  if (!s)
+    return;
+  if (gst_structure_has_name(s, "prerec-level")) {
+    trace.level++;
+    keep(&trace.last_level, s);
+  } else if (gst_structure_has_name(s, "prerec-prune")) {
+    trace.prune++;
+    gst_structure_free(s);
+  } else if (gst_structure_has_name(s, "prerec-drain")) {
+    trace.drain++;
+    keep(&trace.last_drain, s);
+  } else if (gst_structure_has_name(s, "prerec-trigger")) {
+    trace.trigger++;
+    keep(&trace.last_trigger, s);
+  } else {
+    gst_structure_free(s);
+  }
+}
+
+static guint field_uint(const GstStructure* s, const char* field) {
+  guint v = G_MAXUINT;
+  if (s)
+    gst_structure_get_uint(s, field, &v);
+  return v;
+}
+
+int main(int argc, char** argv) {
+  g_setenv("GST_TRACERS", "prerec", TRUE);
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+  gst_debug_set_active(TRUE);
+  gst_debug_set_threshold_for_name("GST_TRACER", GST_LEVEL_TRACE);
+  gst_debug_add_log_function(collect, NULL, NULL);
+
+  PrerecTestPipeline tp;
+  guint64 ts = 0;
+  guint queued;
+
+  if (!prerec_pipeline_create(&tp, "prerec-tracer"))
+    FAIL("pipeline creation failed");
+  g_object_set(tp.pr, "max-time", 4, NULL);
+  gst_element_get_state(tp.pipeline, NULL, NULL, 2 * GST_SECOND);
+
+  GstPad* sink = gst_element_get_static_pad(tp.pr, "sink");
+  prerec_send_stream_setup(sink, "prerec-tracer");
+
+  /* === Part 1 === */
+  for (int i = 0; i < 3; ++i) {
+    if (!prerec_chain_gop(sink, &ts))
+      FAIL("part1: gop push failed");
+  }
+  queued = prerec_stat_uint(tp.pr, "queued-buffers");
+  if (trace.level != 9)
+    FAIL("part1: expected 9 prerec-level records, got %u (is the tracer registered?)", trace.level);
+  if (g_strcmp0(gst_structure_get_string(trace.last_level, "element"), GST_OBJECT_NAME(tp.pr)) != 0)
+    FAIL("part1: prerec-level names element %s, expected %s", gst_structure_get_string(trace.last_level, "element"),
+         GST_OBJECT_NAME(tp.pr));
+  if (field_uint(trace.last_level, "buffers") != queued || field_uint(trace.last_level, "gops") != 2)
+    FAIL("part1: last level buffers=%u gops=%u, expected %u and 2", field_uint(trace.last_level, "buffers"),
+         field_uint(trace.last_level, "gops"), queued);
+  if (trace.prune == 0 || trace.prune != prerec_stat_uint(tp.pr, "drops-gops"))
+    FAIL("part1: %u prerec-prune records for %u pruned GOPs", trace.prune, prerec_stat_uint(tp.pr, "drops-gops"));
+  g_print("PREREC TRACER: Part 1 ✓ - level and prune records\n");
+
+  /* === Part 2 === */
+  guint64 latency = G_MAXUINT64;
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                     gst_structure_new_empty("prerecord-flush")));
+  if (trace.drain != 1 || trace.trigger != 1)
+    FAIL("part2: expected one drain and one trigger record, got %u and %u", trace.drain, trace.trigger);
+  if (g_strcmp0(gst_structure_get_string(trace.last_drain, "reason"), "trigger-flush") != 0 ||
+      field_uint(trace.last_drain, "buffers") != queued)
+    FAIL("part2: drain reason=%s buffers=%u, expected trigger-flush and %u",
+         gst_structure_get_string(trace.last_drain, "reason"), field_uint(trace.last_drain, "buffers"), queued);
+  gst_structure_get_uint64(trace.last_trigger, "latency", &latency);
+  if (latency == G_MAXUINT64 || latency > 10 * GST_SECOND)
+    FAIL("part2: implausible trigger latency %" G_GUINT64_FORMAT, latency);
+  g_print("PREREC TRACER: Part 2 ✓ - drain and trigger latency records\n");
+
+  g_print("PREREC TRACER PASS\n");
+  gst_debug_remove_log_function(collect);
+  gst_object_unref(sink);
+  prerec_pipeline_shutdown(&tp);
+  keep(&trace.last_level, NULL);
+  keep(&trace.last_drain, NULL);
+  keep(&trace.last_trigger, NULL);
+  return 0;
+}
@@ -0,0 +1,104 @@
+/* preserve-on-reconfigure: buffered history survives a PLAYING → READY → PLAYING
+ * cycle and is only discarded by prerecord-discard or the transition to NULL.
+ *
+ * Test Flow:
+ *   Part 1: preserve=TRUE, buffer 2 GOPs, cycle through READY, buffer 1 GOP,
+ *           flush → expect all 9 buffers (6 preserved + 3 new) emitted
+ *   Part 2: re-arm, buffer 2 GOPs, send prerecord-discard → queued-buffers=0
+ *   Part 3: buffer 2 GOPs, cycle through NULL → queued-buffers=0
+ */
+
+#define FAIL_PREFIX "PRESERVE FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <stdio.h>
+
+static gboolean cycle_state(GstElement* pipeline, GstState via) {
+  if (gst_element_set_state(pipeline, via) == GST_STATE_CHANGE_FAILURE)
+    return FALSE;
+  if (gst_element_get_state(pipeline, NULL, NULL, 2 * GST_SECOND) == GST_STATE_CHANGE_FAILURE)
+    return FALSE;
+  if (gst_element_set_state(pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    return FALSE;
+  return gst_element_get_state(pipeline, NULL, NULL, 2 * GST_SECOND) != GST_STATE_CHANGE_FAILURE;
+}
+
+static gboolean send_custom(GstElement* pr, GstEventType type, const char* name) {
+  return gst_element_send_event(pr, gst_event_new_custom(type, gst_structure_new_empty(name)));
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  PrerecTestPipeline tp;
+  if (!prerec_pipeline_create(&tp, "preserve-reconfigure"))
+    FAIL("pipeline creation failed");
+  g_object_set(tp.pr, "preserve-on-reconfigure", TRUE, NULL);
+
+  guint64 emitted = 0;
+  gulong probe_id = prerec_attach_count_probe(tp.pr, &emitted);
+  if (!probe_id)
+    FAIL("failed to attach emission probe");
+
+  guint64 ts = 0;
+
+  /* === Part 1: READY cycle keeps the ring === */
+  for (int i = 0; i < 2; ++i) {
+    if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+      FAIL("part1: gop push failed");
+  }
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 6, 2000))
+    FAIL("part1: ring did not reach 6 queued buffers");
+  if (!cycle_state(tp.pipeline, GST_STATE_READY))
+    FAIL("part1: READY cycle failed");
+  if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+    FAIL("part1: post-cycle gop push failed");
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 9, 2000))
+    FAIL("part1: ring did not reach 9 queued buffers");
+  if (prerec_stat_uint(tp.pr, "queued-buffers") != 9)
+    FAIL("part1: expected 9 queued buffers after READY cycle, got %u", prerec_stat_uint(tp.pr, "queued-buffers"));
+  if (!send_custom(tp.pr, GST_EVENT_CUSTOM_DOWNSTREAM, "prerecord-flush"))
+    FAIL("part1: flush send failed");
+  SETTLE(tp.pipeline);
+  if (emitted != 9)
+    FAIL("part1: expected 9 buffers drained, got %llu", (unsigned long long) emitted);
+  g_print("PRESERVE: Part 1 ✓ - history survived READY cycle\n");
+
+  /* === Part 2: explicit discard === */
+  if (!send_custom(tp.pr, GST_EVENT_CUSTOM_UPSTREAM, "prerecord-arm"))
+    FAIL("part2: rearm send failed");
+  for (int i = 0; i < 2; ++i) {
+    if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+      FAIL("part2: gop push failed");
+  }
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 6, 2000))
+    FAIL("part2: ring did not reach 6 queued buffers");
+  if (prerec_stat_uint(tp.pr, "queued-buffers") != 6)
+    FAIL("part2: expected 6 queued buffers, got %u", prerec_stat_uint(tp.pr, "queued-buffers"));
+  if (!send_custom(tp.pr, GST_EVENT_CUSTOM_UPSTREAM, "prerecord-discard"))
+    FAIL("part2: discard send failed");
+  if (prerec_stat_uint(tp.pr, "queued-buffers") != 0)
+    FAIL("part2: expected empty ring after prerecord-discard, got %u", prerec_stat_uint(tp.pr, "queued-buffers"));
+  g_print("PRESERVE: Part 2 ✓ - prerecord-discard empties the ring\n");
+
+  /* === Part 3: NULL discards === */
+  for (int i = 0; i < 2; ++i) {
+    if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+      FAIL("part3: gop push failed");
+  }
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 6, 2000))
+    FAIL("part3: ring did not reach 6 queued buffers");
+  if (!cycle_state(tp.pipeline, GST_STATE_NULL))
+    FAIL("part3: NULL cycle failed");
+  if (prerec_stat_uint(tp.pr, "queued-buffers") != 0)
+    FAIL("part3: expected empty ring after NULL, got %u", prerec_stat_uint(tp.pr, "queued-buffers"));
+  g_print("PRESERVE: Part 3 ✓ - NULL discards the ring\n");
+
+  g_print("PRESERVE PASS\n");
+  prerec_remove_probe(tp.pr, probe_id);
+  prerec_pipeline_shutdown(&tp);
+  return 0;
+}
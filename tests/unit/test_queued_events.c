@@ -0,0 +1,115 @@
+/* max-queued-events: serialized events other than SEGMENT/GAP stay in order
+ * with the buffered data instead of overtaking it.
+ *
+ * Test Flow (max-queued-events=2):
+ *   GOP1, marker 1, TAG "a", TAG "b", marker 2, GOP2
+ *     → TAG "b" replaces TAG "a" in the same GOP; marker 2 does not fit and
+ *       is forwarded right away, so downstream only saw "M" so far
+ *   flush → BBB M T(b) BBB; events-queued=3, events-superseded=1,
+ *           events-overflow=1
+ *   pass-through → a marker is forwarded immediately
+ */
+
+#define FAIL_PREFIX "QUEUED EVENTS FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <stdio.h>
+
+typedef struct {
+  GString* seq;   /* B buffer, M marker, T tag */
+  gchar title[8]; /* title of the last tag seen */
+} EventLog;
+
+static GstPadProbeReturn log_items(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+  EventLog* log = user_data;
+
+  if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    g_string_append_c(log->seq, 'B');
+    return GST_PAD_PROBE_OK;
+  }
+
+  GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+  if (GST_EVENT_TYPE(event) == GST_EVENT_CUSTOM_DOWNSTREAM &&
+      gst_structure_has_name(gst_event_get_structure(event), "app-marker")) {
+    g_string_append_c(log->seq, 'M');
+  } else if (GST_EVENT_TYPE(event) == GST_EVENT_TAG) {
+    GstTagList* tags;
+    gchar* title = NULL;
+    gst_event_parse_tag(event, &tags);
+    if (gst_tag_list_get_string(tags, GST_TAG_TITLE, &title)) {
+      g_strlcpy(log->title, title, sizeof(log->title));
+      g_free(title);
+    }
+    g_string_append_c(log->seq, 'T');
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+static void send_marker(GstPad* sink) {
+  gst_pad_send_event(sink, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM, gst_structure_new_empty("app-marker")));
+}
+
+static void send_title(GstPad* sink, const gchar* title) {
+  gst_pad_send_event(sink, gst_event_new_tag(gst_tag_list_new(GST_TAG_TITLE, title, NULL)));
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  PrerecTestPipeline tp;
+  EventLog log = {g_string_new(NULL), ""};
+  guint64 ts = 0;
+
+  if (!prerec_pipeline_create(&tp, "queued-events"))
+    FAIL("pipeline creation failed");
+  g_object_set(tp.pr, "max-queued-events", 2, NULL);
+  gst_element_get_state(tp.pipeline, NULL, NULL, 2 * GST_SECOND);
+
+  GstPad* sink = gst_element_get_static_pad(tp.pr, "sink");
+  GstPad* src = gst_element_get_static_pad(tp.pr, "src");
+  prerec_send_stream_setup(sink, "queued-events");
+  gulong probe_id =
+      gst_pad_add_probe(src, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, log_items, &log, NULL);
+
+  /* === Buffering === */
+  if (!prerec_chain_gop(sink, &ts))
+    FAIL("gop 1 push failed");
+  send_marker(sink);
+  send_title(sink, "a");
+  send_title(sink, "b");
+  send_marker(sink);
+  if (!prerec_chain_gop(sink, &ts))
+    FAIL("gop 2 push failed");
+  if (g_strcmp0(log.seq->str, "M") != 0)
+    FAIL("while buffering downstream saw \"%s\", expected only the overflowing marker", log.seq->str);
+  g_print("QUEUED EVENTS: events held back while buffering, overflow forwarded\n");
+
+  /* === Drain === */
+  g_string_truncate(log.seq, 0);
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                     gst_structure_new_empty("prerecord-flush")));
+  if (g_strcmp0(log.seq->str, "BBBMTBBB") != 0 || g_strcmp0(log.title, "b") != 0)
+    FAIL("drained \"%s\" (last title \"%s\"), expected \"BBBMTBBB\" with title \"b\"", log.seq->str, log.title);
+  if (prerec_stat_uint(tp.pr, "events-queued") != 3 || prerec_stat_uint(tp.pr, "events-superseded") != 1 ||
+      prerec_stat_uint(tp.pr, "events-overflow") != 1)
+    FAIL("expected events-queued=3 superseded=1 overflow=1, got %u/%u/%u", prerec_stat_uint(tp.pr, "events-queued"),
+         prerec_stat_uint(tp.pr, "events-superseded"), prerec_stat_uint(tp.pr, "events-overflow"));
+  g_print("QUEUED EVENTS: drained in order with the data, latest tag only\n");
+
+  /* === Pass-through === */
+  g_string_truncate(log.seq, 0);
+  send_marker(sink);
+  if (g_strcmp0(log.seq->str, "M") != 0)
+    FAIL("pass-through marker not forwarded (\"%s\")", log.seq->str);
+  g_print("QUEUED EVENTS: pass-through events forwarded immediately\n");
+
+  g_print("QUEUED EVENTS PASS\n");
+  gst_pad_remove_probe(src, probe_id);
+  gst_object_unref(src);
+  gst_object_unref(sink);
+  g_string_free(log.seq, TRUE);
+  prerec_pipeline_shutdown(&tp);
+  return 0;
+}
@@ -0,0 +1,90 @@
+/* Retention limits: max-gops caps the GOP count, retention-policy decides
+ * whether max-time bounds the window from above or below, and lowering a
+ * limit prunes at once without waiting for the next buffer.
+ *
+ * Test Flow (1 s frames, 3 per GOP, max-time=0 while filling):
+ *   Part 1: 3 GOPs, then max-gops=2 → 2 GOPs queued right away
+ *   Part 2: flush, re-arm, min-gops=0, 4 GOPs at 9-21 s,
+ *           retention-policy=at-least, max-time=5 → 2 GOPs (15-21 s) still
+ *           cover the window
+ *   Part 3: retention-policy=at-most → 1 GOP, the oldest now starts at 18 s
+ */
+
+#define FAIL_PREFIX "RETENTION FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <stdio.h>
+
+static guint64 oldest_gop_start(GstElement* pr) {
+  guint64 v = G_MAXUINT64;
+  GstQuery* q = gst_query_new_custom(GST_QUERY_CUSTOM, gst_structure_new_empty("prerec-catalog"));
+  if (gst_element_query(pr, q)) {
+    const GValue* starts = gst_structure_get_value(gst_query_get_structure(q), "gop-start");
+    if (starts && gst_value_array_get_size(starts) > 0)
+      v = g_value_get_uint64(gst_value_array_get_value(starts, 0));
+  }
+  gst_query_unref(q);
+  return v;
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  PrerecTestPipeline tp;
+  GstSegment segment;
+  guint64 ts = 0;
+
+  if (!prerec_pipeline_create(&tp, "retention"))
+    FAIL("pipeline creation failed");
+  g_object_set(tp.pr, "max-time", 0, NULL);
+  gst_element_get_state(tp.pipeline, NULL, NULL, 2 * GST_SECOND);
+
+  GstPad* sink = gst_element_get_static_pad(tp.pr, "sink");
+  prerec_send_stream_setup(sink, "retention");
+
+  /* === Part 1 === */
+  for (int i = 0; i < 3; ++i) {
+    if (!prerec_chain_gop(sink, &ts))
+      FAIL("part1: gop %d push failed", i + 1);
+  }
+  if (prerec_stat_uint(tp.pr, "queued-gops") != 3)
+    FAIL("part1: expected 3 GOPs before the cap, got %u", prerec_stat_uint(tp.pr, "queued-gops"));
+  g_object_set(tp.pr, "max-gops", 2, NULL);
+  if (prerec_stat_uint(tp.pr, "queued-gops") != 2 || oldest_gop_start(tp.pr) != 3 * GST_SECOND)
+    FAIL("part1: max-gops=2 left %u GOPs starting at %" GST_TIME_FORMAT ", expected 2 from 3 s",
+         prerec_stat_uint(tp.pr, "queued-gops"), GST_TIME_ARGS(oldest_gop_start(tp.pr)));
+  g_print("RETENTION: Part 1 ✓ - lowering max-gops prunes at once\n");
+
+  /* === Part 2 === */
+  g_object_set(tp.pr, "max-gops", 0, "min-gops", 0, NULL);
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                     gst_structure_new_empty("prerecord-flush")));
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_UPSTREAM,
+                                                     gst_structure_new_empty("prerecord-arm")));
+  gst_segment_init(&segment, GST_FORMAT_TIME);
+  gst_pad_send_event(sink, gst_event_new_segment(&segment));
+  for (int i = 0; i < 4; ++i) {
+    if (!prerec_chain_gop(sink, &ts))
+      FAIL("part2: gop %d push failed", i + 1);
+  }
+  gst_util_set_object_arg(G_OBJECT(tp.pr), "retention-policy", "at-least");
+  g_object_set(tp.pr, "max-time", 5, NULL);
+  if (prerec_stat_uint(tp.pr, "queued-gops") != 2 || oldest_gop_start(tp.pr) != 15 * GST_SECOND)
+    FAIL("part2: at-least kept %u GOPs starting at %" GST_TIME_FORMAT ", expected 2 from 15 s",
+         prerec_stat_uint(tp.pr, "queued-gops"), GST_TIME_ARGS(oldest_gop_start(tp.pr)));
+  g_print("RETENTION: Part 2 ✓ - at-least keeps the window covered\n");
+
+  /* === Part 3 === */
+  gst_util_set_object_arg(G_OBJECT(tp.pr), "retention-policy", "at-most");
+  if (prerec_stat_uint(tp.pr, "queued-gops") != 1 || oldest_gop_start(tp.pr) != 18 * GST_SECOND)
+    FAIL("part3: at-most kept %u GOPs starting at %" GST_TIME_FORMAT ", expected 1 from 18 s",
+         prerec_stat_uint(tp.pr, "queued-gops"), GST_TIME_ARGS(oldest_gop_start(tp.pr)));
+  g_print("RETENTION: Part 3 ✓ - at-most trims below the window\n");
+
+  g_print("RETENTION PASS\n");
+  gst_object_unref(sink);
+  prerec_pipeline_shutdown(&tp);
+  return 0;
+}
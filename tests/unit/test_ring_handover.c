@@ -0,0 +1,93 @@
+/* ring-id: a finalized element parks its ring and a new instance with the same
+ * ring-id (and equal caps) adopts it.
+ *
+ * Test Flow:
+ *   Part 1: pipeline A (ring-id=cam-1) buffers 2 GOPs and is destroyed
+ *   Part 2: pipeline B (ring-id=cam-1) buffers 1 GOP → adopt-count=1,
+ *           flush emits 9 buffers (6 adopted + 3 own)
+ *   Part 3: pipeline C parks with ring-park-timeout=50ms; after it expired
+ *           pipeline D (same id) starts empty → adopt-count=0
+ */
+
+#define FAIL_PREFIX "HANDOVER FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <stdio.h>
+
+/* Creates a pipeline whose element has ring-id set before any caps arrive */
+static gboolean create_with_id(PrerecTestPipeline* tp, const char* name, const char* ring_id, guint timeout_ms) {
+  if (!prerec_pipeline_create(tp, name))
+    return FALSE;
+  g_object_set(tp->pr, "ring-id", ring_id, "ring-park-timeout", timeout_ms, NULL);
+  return TRUE;
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  PrerecTestPipeline tp;
+  guint64 ts = 0;
+
+  /* === Part 1 === */
+  if (!create_with_id(&tp, "handover-a", "cam-1", 5000))
+    FAIL("part1: pipeline creation failed");
+  for (int i = 0; i < 2; ++i) {
+    if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+      FAIL("part1: gop push failed");
+  }
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 6, 2000))
+    FAIL("part1: ring did not reach 6 queued buffers");
+  prerec_pipeline_shutdown(&tp); /* finalize parks the ring */
+
+  /* === Part 2 === */
+  if (!create_with_id(&tp, "handover-b", "cam-1", 5000))
+    FAIL("part2: pipeline creation failed");
+  guint64 emitted = 0;
+  gulong probe_id = prerec_attach_count_probe(tp.pr, &emitted);
+  if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+    FAIL("part2: gop push failed");
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 9, 2000))
+    FAIL("part2: ring did not reach 9 queued buffers");
+  if (prerec_stat_uint(tp.pr, "adopt-count") != 1)
+    FAIL("part2: expected adopt-count=1, got %u", prerec_stat_uint(tp.pr, "adopt-count"));
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                     gst_structure_new_empty("prerecord-flush")));
+  SETTLE(tp.pipeline);
+  if (emitted != 9)
+    FAIL("part2: expected 9 buffers drained, got %llu", (unsigned long long) emitted);
+  prerec_remove_probe(tp.pr, probe_id);
+  prerec_pipeline_shutdown(&tp); /* pass-through with empty ring: nothing parked */
+  g_print("HANDOVER: Part 2 ✓ - adopted ring drained\n");
+
+  /* === Part 3 === */
+  if (!create_with_id(&tp, "handover-c", "cam-2", 50))
+    FAIL("part3: pipeline creation failed");
+  for (int i = 0; i < 2; ++i) {
+    if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+      FAIL("part3: gop push failed");
+  }
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 6, 2000))
+    FAIL("part3: ring did not reach 6 queued buffers");
+  prerec_pipeline_shutdown(&tp);
+  g_usleep(300 * 1000);
+
+  if (!create_with_id(&tp, "handover-d", "cam-2", 50))
+    FAIL("part3: pipeline creation failed");
+  if (!prerec_push_gop(tp.appsrc, 2, &ts, GST_SECOND, NULL))
+    FAIL("part3: gop push failed");
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 3, 2000))
+    FAIL("part3: ring did not reach 3 queued buffers");
+  if (prerec_stat_uint(tp.pr, "adopt-count") != 0)
+    FAIL("part3: expired ring was adopted");
+  if (prerec_stat_uint(tp.pr, "queued-buffers") != 3)
+    FAIL("part3: expected 3 queued buffers, got %u", prerec_stat_uint(tp.pr, "queued-buffers"));
+  g_object_set(tp.pr, "ring-park-timeout", 0, NULL); /* do not leave a parked ring behind at exit */
+  prerec_pipeline_shutdown(&tp);
+  g_print("HANDOVER: Part 3 ✓ - expired ring released\n");
+
+  g_print("HANDOVER PASS\n");
+  return 0;
+}
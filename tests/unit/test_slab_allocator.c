@@ -0,0 +1,132 @@
+/* slab-allocator: the ALLOCATION query on the sink pad is answered with the
+ * slab allocator, and buffered frames live in reused slab blocks.
+ *
+ * Test Flow:
+ *   Part 1: slab-allocator=true → the query (asked from appsrc's pad) gets
+ *           a "PreRecSlab" allocator first and no pools; a freed block is
+ *           handed out again; 2 GOPs of 3 x 3000 byte slab buffers show in
+ *           slab-used while queued, drain intact, and slab-used is back to 0
+ *           once fakesink dropped them
+ *   Part 2: default element → no PreRecSlab allocator in the answer
+ */
+
+#define FAIL_PREFIX "SLAB FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PAYLOAD 3000
+
+/* Asks the allocation query the way an encoder would; returns the first
+ * proposed allocator (or NULL) and the number of pools */
+static GstAllocator* query_allocator(GstElement* appsrc, guint* n_pools) {
+  GstPad* pad = gst_element_get_static_pad(appsrc, "src");
+  GstCaps* caps = gst_caps_new_empty_simple("video/x-h264");
+  GstQuery* q = gst_query_new_allocation(caps, TRUE);
+  GstAllocator* allocator = NULL;
+
+  if (gst_pad_peer_query(pad, q) && gst_query_get_n_allocation_params(q) > 0)
+    gst_query_parse_nth_allocation_param(q, 0, &allocator, NULL);
+  *n_pools = gst_query_get_n_allocation_pools(q);
+  gst_query_unref(q);
+  gst_caps_unref(caps);
+  gst_object_unref(pad);
+  return allocator;
+}
+
+static gboolean is_slab(GstAllocator* allocator) {
+  return allocator && allocator->mem_type && strcmp(allocator->mem_type, "PreRecSlab") == 0;
+}
+
+static gboolean push_gop(GstElement* appsrc, GstAllocator* allocator, guint64* ts) {
+  for (int i = 0; i < 3; ++i) {
+    GstBuffer* b = gst_buffer_new_allocate(allocator, PAYLOAD, NULL);
+    gst_buffer_memset(b, 0, (guint8) (*ts / GST_SECOND), PAYLOAD);
+    GST_BUFFER_PTS(b) = *ts;
+    GST_BUFFER_DURATION(b) = GST_SECOND;
+    if (i > 0)
+      GST_BUFFER_FLAG_SET(b, GST_BUFFER_FLAG_DELTA_UNIT);
+    if (gst_app_src_push_buffer(GST_APP_SRC(appsrc), b) != GST_FLOW_OK)
+      return FALSE;
+    *ts += GST_SECOND;
+  }
+  return TRUE;
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  PrerecTestPipeline tp;
+  guint n_pools = G_MAXUINT;
+  guint64 ts = 0, emitted = 0;
+
+  /* === Part 1 === */
+  if (!prerec_pipeline_create(&tp, "slab"))
+    FAIL("part1: pipeline creation failed");
+  /* the allocator is created on NULL→READY */
+  gst_element_set_state(tp.pipeline, GST_STATE_NULL);
+  g_object_set(tp.pr, "slab-allocator", TRUE, NULL);
+  if (gst_element_set_state(tp.pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    FAIL("part1: could not restart with slab-allocator");
+  gst_element_get_state(tp.pipeline, NULL, NULL, 2 * GST_SECOND);
+
+  GstAllocator* slab = query_allocator(tp.appsrc, &n_pools);
+  if (!is_slab(slab))
+    FAIL("part1: first proposed allocator is %s, expected PreRecSlab", slab ? slab->mem_type : "none");
+  if (n_pools != 0)
+    FAIL("part1: expected downstream pools to be dropped, got %u", n_pools);
+
+  GstMemory* mem = gst_allocator_alloc(slab, PAYLOAD, NULL);
+  GstMapInfo map;
+  if (!mem || !gst_memory_map(mem, &map, GST_MAP_WRITE) || map.size != PAYLOAD)
+    FAIL("part1: cannot map a %d byte slab memory", PAYLOAD);
+  gpointer first = map.data;
+  gst_memory_unmap(mem, &map);
+  gst_memory_unref(mem);
+  mem = gst_allocator_alloc(slab, PAYLOAD, NULL);
+  if (!gst_memory_map(mem, &map, GST_MAP_READ) || map.data != first)
+    FAIL("part1: freed block was not reused");
+  gst_memory_unmap(mem, &map);
+  gst_memory_unref(mem);
+
+  gulong probe_id = prerec_attach_count_probe(tp.pr, &emitted);
+  for (int i = 0; i < 2; ++i) {
+    if (!push_gop(tp.appsrc, slab, &ts))
+      FAIL("part1: gop push failed");
+  }
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 6, 2000))
+    FAIL("part1: ring did not reach 6 queued buffers");
+  if (prerec_stat_uint64(tp.pr, "slab-used") < 6 * PAYLOAD || prerec_stat_uint64(tp.pr, "slab-reserved") == 0)
+    FAIL("part1: expected the queued frames in slab-used, got %" G_GUINT64_FORMAT " of %" G_GUINT64_FORMAT,
+         prerec_stat_uint64(tp.pr, "slab-used"), prerec_stat_uint64(tp.pr, "slab-reserved"));
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                     gst_structure_new_empty("prerecord-flush")));
+  SETTLE(tp.pipeline);
+  if (emitted != 6)
+    FAIL("part1: expected 6 drained buffers, got %llu", (unsigned long long) emitted);
+  if (prerec_stat_uint64(tp.pr, "slab-used") != 0)
+    FAIL("part1: expected slab-used=0 after the drain, got %" G_GUINT64_FORMAT, prerec_stat_uint64(tp.pr, "slab-used"));
+  g_print("SLAB: Part 1 ✓ - slab proposed upstream, blocks reused and returned\n");
+  prerec_remove_probe(tp.pr, probe_id);
+  gst_object_unref(slab);
+  prerec_pipeline_shutdown(&tp);
+
+  /* === Part 2 === */
+  if (!prerec_pipeline_create(&tp, "noslab"))
+    FAIL("part2: pipeline creation failed");
+  gst_element_get_state(tp.pipeline, NULL, NULL, 2 * GST_SECOND);
+  slab = query_allocator(tp.appsrc, &n_pools);
+  if (is_slab(slab))
+    FAIL("part2: slab proposed without slab-allocator");
+  if (slab)
+    gst_object_unref(slab);
+  g_print("SLAB: Part 2 ✓ - default element leaves the query to downstream\n");
+
+  g_print("SLAB PASS\n");
+  prerec_pipeline_shutdown(&tp);
+  return 0;
+}
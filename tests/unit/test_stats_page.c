@@ -0,0 +1,154 @@
+/* stats-page: the element publishes its level and counters in a
+ * shared-memory page that other processes read without touching the
+ * pipeline.
+ *
+ * Test Flow (max-time=4, 1 s frames, 3 per GOP, stats-page=true):
+ *   Part 1: 3 GOPs → the page named after this process carries the
+ *           element path, BUFFERING and the same level and drop counters
+ *           as prerec-stats
+ *   Part 2: flush → the page shows PASS_THROUGH, flush-count=1 and an
+ *           empty ring; seq stays even between updates
+ *   Part 3: bundled prerec-top --once lists the ring
+ *   Part 4: NULL → the page is unlinked
+ *
+ * The prerec-top binary comes from PREREC_TOP (set by CTest).
+ */
+
+#define FAIL_PREFIX "STATS PAGE FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <gstprerecordloop/gstprerecstatsproto.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* Maps the page of this process whose element field is path; NULL if none.
+ * *file receives its /dev/shm name. */
+static const GstPreRecStatsPage* find_page(const gchar* path, gchar** file) {
+  gchar* prefix = g_strdup_printf("%s%d-", GST_PREREC_STATS_SHM_PREFIX + 1, (gint) getpid());
+  const GstPreRecStatsPage* found = NULL;
+  GDir* dir = g_dir_open("/dev/shm", 0, NULL);
+  const gchar* name;
+
+  while (dir && !found && (name = g_dir_read_name(dir))) {
+    gchar* full;
+    const GstPreRecStatsPage* page;
+    gint fd;
+
+    if (!g_str_has_prefix(name, prefix))
+      continue;
+    full = g_build_filename("/dev/shm", name, NULL);
+    fd = open(full, O_RDONLY);
+    g_free(full);
+    if (fd < 0)
+      continue;
+    page = mmap(NULL, sizeof(GstPreRecStatsPage), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (page == MAP_FAILED)
+      continue;
+    if (page->magic == GST_PREREC_STATS_MAGIC && g_strcmp0(page->element, path) == 0) {
+      found = page;
+      *file = g_strdup(name);
+    } else {
+      munmap((void*) page, sizeof(GstPreRecStatsPage));
+    }
+  }
+  if (dir)
+    g_dir_close(dir);
+  g_free(prefix);
+  return found;
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  PrerecTestPipeline tp;
+  GstPreRecStatsPage snap;
+  const GstPreRecStatsPage* page;
+  gchar *path, *file = NULL;
+  guint64 ts = 0;
+
+  if (!prerec_pipeline_create(&tp, "stats-page"))
+    FAIL("pipeline creation failed");
+  /* the page is created on NULL→READY */
+  gst_element_set_state(tp.pipeline, GST_STATE_NULL);
+  g_object_set(tp.pr, "max-time", 4, "stats-page", TRUE, NULL);
+  gst_element_set_state(tp.pipeline, GST_STATE_PLAYING);
+  gst_element_get_state(tp.pipeline, NULL, NULL, 2 * GST_SECOND);
+
+  GstPad* sink = gst_element_get_static_pad(tp.pr, "sink");
+  prerec_send_stream_setup(sink, "stats-page");
+
+  /* === Part 1 === */
+  for (int i = 0; i < 3; ++i) {
+    if (!prerec_chain_gop(sink, &ts))
+      FAIL("part1: gop push failed");
+  }
+  path = gst_object_get_path_string(GST_OBJECT(tp.pr));
+  page = find_page(path, &file);
+  if (!page)
+    FAIL("part1: no /dev/shm page for %s", path);
+  if (page->version != GST_PREREC_STATS_VERSION || page->size != sizeof(GstPreRecStatsPage) ||
+      page->pid != (guint32) getpid())
+    FAIL("part1: bad header version=%u size=%u pid=%u", page->version, page->size, page->pid);
+  if (gst_prerec_stats_page_read(page, &snap) != 0)
+    FAIL("part1: page stayed busy");
+  if (snap.mode != GST_PREREC_STATS_MODE_BUFFERING || snap.max_time != 4 * GST_SECOND)
+    FAIL("part1: mode=%u max_time=%" G_GUINT64_FORMAT ", expected buffering and 4 s", snap.mode, snap.max_time);
+  if (snap.buffers != prerec_stat_uint(tp.pr, "queued-buffers") || snap.gops != prerec_stat_uint(tp.pr, "queued-gops") ||
+      snap.drops_gops != prerec_stat_uint(tp.pr, "drops-gops") || snap.drops_gops == 0)
+    FAIL("part1: page buffers=%u gops=%u drops=%u disagree with prerec-stats %u/%u/%u", snap.buffers, snap.gops,
+         snap.drops_gops, prerec_stat_uint(tp.pr, "queued-buffers"), prerec_stat_uint(tp.pr, "queued-gops"),
+         prerec_stat_uint(tp.pr, "drops-gops"));
+  if (snap.bytes != 64u * snap.buffers || snap.time == 0 || snap.updated == 0)
+    FAIL("part1: bytes=%" G_GUINT64_FORMAT " time=%" G_GUINT64_FORMAT " updated=%" G_GUINT64_FORMAT, snap.bytes,
+         snap.time, snap.updated);
+  g_print("STATS PAGE: Part 1 ✓ - %s publishes the ring level\n", file);
+
+  /* === Part 2 === */
+  guint32 seq = snap.seq;
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                     gst_structure_new_empty("prerecord-flush")));
+  if (gst_prerec_stats_page_read(page, &snap) != 0)
+    FAIL("part2: page stayed busy");
+  if ((snap.seq & 1) || snap.seq <= seq)
+    FAIL("part2: seq %u after %u, expected a larger even value", snap.seq, seq);
+  if (snap.mode != GST_PREREC_STATS_MODE_PASS_THROUGH || snap.flush_count != 1 || snap.buffers != 0)
+    FAIL("part2: mode=%u flush_count=%u buffers=%u, expected pass-through, 1 and 0", snap.mode, snap.flush_count,
+         snap.buffers);
+  g_print("STATS PAGE: Part 2 ✓ - trigger published\n");
+
+  /* === Part 3 === */
+  const gchar* top = g_getenv("PREREC_TOP");
+  gchar* argv_top[] = {(gchar*) top, "--once", NULL};
+  gchar* out = NULL;
+  gint status = -1;
+  if (!top)
+    FAIL("PREREC_TOP not set");
+  if (!g_spawn_sync(NULL, argv_top, NULL, G_SPAWN_DEFAULT, NULL, NULL, &out, NULL, &status, NULL) || status != 0)
+    FAIL("part3: prerec-top failed (status %d)", status);
+  gchar* line = strstr(out, path);
+  if (!line || !strstr(line, "pass"))
+    FAIL("part3: prerec-top does not list %s in pass-through:\n%s", path, out);
+  g_free(out);
+  g_print("STATS PAGE: Part 3 ✓ - prerec-top lists the ring\n");
+
+  /* === Part 4 === */
+  gchar* shm_path = g_build_filename("/dev/shm", file, NULL);
+  gst_object_unref(sink);
+  munmap((void*) page, sizeof(GstPreRecStatsPage));
+  prerec_pipeline_shutdown(&tp);
+  if (g_file_test(shm_path, G_FILE_TEST_EXISTS))
+    FAIL("part4: %s still exists after NULL", shm_path);
+  g_print("STATS PAGE: Part 4 ✓ - page unlinked\n");
+
+  g_print("STATS PAGE PASS\n");
+  g_free(shm_path);
+  g_free(file);
+  g_free(path);
+  return 0;
+}
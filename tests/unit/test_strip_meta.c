@@ -0,0 +1,143 @@
+/* strip-meta-apis: configured metas are removed from buffers entering the
+ * ring, pass-through buffers keep theirs.
+ *
+ * Every pushed buffer carries a GstReferenceTimestampMeta, a
+ * GstProtectionMeta and a custom "PrerecTestMeta".
+ *
+ * Test Flow:
+ *   Part 1: strip-meta-apis="GstProtectionMetaAPI, PrerecTestMeta", 1 GOP,
+ *           flush → the 3 drained buffers only carry the reference
+ *           timestamp meta; meta-stripped=6, meta-stripped-bytes > 0
+ *   Part 2: 1 pass-through GOP → all three metas survive, no new strips
+ *   Part 3: strip-meta-mode=keep with "GstReferenceTimestampMetaAPI",
+ *           re-arm, 1 GOP, flush → same result; meta-stripped=12
+ */
+
+#define FAIL_PREFIX "STRIP META FAIL: "
+#include <test_utils.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <stdio.h>
+
+typedef struct {
+  guint buffers;
+  guint ref_ts;
+  guint protection;
+  guint custom;
+} MetaCount;
+
+static const GstMetaInfo* test_meta_info;
+
+static GstPadProbeReturn count_metas(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+  MetaCount* count = user_data;
+  GstBuffer* buf = GST_PAD_PROBE_INFO_BUFFER(info);
+
+  count->buffers++;
+  if (gst_buffer_get_meta(buf, GST_REFERENCE_TIMESTAMP_META_API_TYPE))
+    count->ref_ts++;
+  if (gst_buffer_get_meta(buf, GST_PROTECTION_META_API_TYPE))
+    count->protection++;
+  if (gst_buffer_get_custom_meta(buf, "PrerecTestMeta"))
+    count->custom++;
+  return GST_PAD_PROBE_OK;
+}
+
+static gboolean push_gop(GstElement* appsrc, guint64* ts) {
+  GstCaps* ref = gst_caps_new_empty_simple("timestamp/x-test");
+
+  for (int i = 0; i < 3; ++i) {
+    GstBuffer* b = gst_buffer_new_allocate(NULL, 128, NULL);
+    GST_BUFFER_PTS(b) = *ts;
+    GST_BUFFER_DURATION(b) = GST_SECOND;
+    if (i > 0)
+      GST_BUFFER_FLAG_SET(b, GST_BUFFER_FLAG_DELTA_UNIT);
+    gst_buffer_add_reference_timestamp_meta(b, ref, *ts, GST_CLOCK_TIME_NONE);
+    gst_buffer_add_protection_meta(b, gst_structure_new_empty("application/x-test-protection"));
+    gst_structure_set(gst_custom_meta_get_structure(gst_buffer_add_custom_meta(b, "PrerecTestMeta")), "index",
+                      G_TYPE_INT, i, NULL);
+    if (gst_app_src_push_buffer(GST_APP_SRC(appsrc), b) != GST_FLOW_OK) {
+      gst_caps_unref(ref);
+      return FALSE;
+    }
+    *ts += GST_SECOND;
+  }
+  gst_caps_unref(ref);
+  return TRUE;
+}
+
+static void send_flush(GstElement* pr) {
+  gst_element_send_event(pr, gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+                                                  gst_structure_new_empty("prerecord-flush")));
+}
+
+int main(int argc, char** argv) {
+  prerec_test_init(&argc, &argv);
+  if (!prerec_factory_available())
+    FAIL("factory not available");
+
+  test_meta_info = gst_meta_register_custom_simple("PrerecTestMeta");
+  if (!test_meta_info)
+    FAIL("cannot register the custom test meta");
+
+  PrerecTestPipeline tp;
+  MetaCount count = {0};
+  guint64 ts = 0;
+
+  if (!prerec_pipeline_create(&tp, "strip-meta"))
+    FAIL("pipeline creation failed");
+  g_object_set(tp.pr, "strip-meta-apis", "GstProtectionMetaAPI, PrerecTestMeta", NULL);
+  GstPad* srcpad = gst_element_get_static_pad(tp.pr, "src");
+  gulong probe_id = gst_pad_add_probe(srcpad, GST_PAD_PROBE_TYPE_BUFFER, count_metas, &count, NULL);
+
+  /* === Part 1 === */
+  if (!push_gop(tp.appsrc, &ts))
+    FAIL("part1: gop push failed");
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 3, 2000))
+    FAIL("part1: ring did not reach 3 queued buffers");
+  send_flush(tp.pr);
+  SETTLE(tp.pipeline);
+  if (count.buffers != 3 || count.ref_ts != 3 || count.protection != 0 || count.custom != 0)
+    FAIL("part1: drained %u buffers with %u/%u/%u ref-ts/protection/custom metas, expected 3 with 3/0/0",
+         count.buffers, count.ref_ts, count.protection, count.custom);
+  if (prerec_stat_uint64(tp.pr, "meta-stripped") != 6 || prerec_stat_uint64(tp.pr, "meta-stripped-bytes") == 0)
+    FAIL("part1: expected meta-stripped=6 with bytes, got %" G_GUINT64_FORMAT " (%" G_GUINT64_FORMAT " bytes)",
+         prerec_stat_uint64(tp.pr, "meta-stripped"), prerec_stat_uint64(tp.pr, "meta-stripped-bytes"));
+  g_print("STRIP META: Part 1 ✓ - listed metas removed from buffered frames\n");
+
+  /* === Part 2 === */
+  count = (MetaCount){0};
+  if (!push_gop(tp.appsrc, &ts))
+    FAIL("part2: gop push failed");
+  SETTLE(tp.pipeline);
+  if (count.buffers != 3 || count.ref_ts != 3 || count.protection != 3 || count.custom != 3)
+    FAIL("part2: pass-through %u buffers with %u/%u/%u metas, expected 3 with 3/3/3", count.buffers, count.ref_ts,
+         count.protection, count.custom);
+  if (prerec_stat_uint64(tp.pr, "meta-stripped") != 6)
+    FAIL("part2: pass-through stripped metas (%" G_GUINT64_FORMAT ")", prerec_stat_uint64(tp.pr, "meta-stripped"));
+  g_print("STRIP META: Part 2 ✓ - pass-through buffers untouched\n");
+
+  /* === Part 3 === */
+  gst_util_set_object_arg(G_OBJECT(tp.pr), "strip-meta-mode", "keep");
+  g_object_set(tp.pr, "strip-meta-apis", "GstReferenceTimestampMetaAPI", NULL);
+  gst_element_send_event(tp.pr, gst_event_new_custom(GST_EVENT_CUSTOM_UPSTREAM,
+                                                     gst_structure_new_empty("prerecord-arm")));
+  count = (MetaCount){0};
+  if (!push_gop(tp.appsrc, &ts))
+    FAIL("part3: gop push failed");
+  if (!prerec_wait_for_stat(tp.pr, "queued-buffers", 3, 2000))
+    FAIL("part3: ring did not reach 3 queued buffers");
+  send_flush(tp.pr);
+  SETTLE(tp.pipeline);
+  if (count.buffers != 3 || count.ref_ts != 3 || count.protection != 0 || count.custom != 0)
+    FAIL("part3: drained %u buffers with %u/%u/%u metas, expected 3 with 3/0/0", count.buffers, count.ref_ts,
+         count.protection, count.custom);
+  if (prerec_stat_uint64(tp.pr, "meta-stripped") != 12)
+    FAIL("part3: expected meta-stripped=12, got %" G_GUINT64_FORMAT, prerec_stat_uint64(tp.pr, "meta-stripped"));
+  g_print("STRIP META: Part 3 ✓ - keep mode removes everything else\n");
+
+  g_print("STRIP META PASS\n");
+  gst_pad_remove_probe(srcpad, probe_id);
+  gst_object_unref(srcpad);
+  prerec_pipeline_shutdown(&tp);
+  return 0;
+}
@@ -161,6 +161,35 @@ gboolean prerec_push_gop(GstElement* appsrc, guint delta_count, guint64* pts_bas
   return TRUE;
 }
 
+void prerec_send_stream_setup(GstPad* sink, const char* stream_id) {
+  GstCaps* caps = gst_caps_new_empty_simple("video/x-h264");
+  GstSegment segment;
+
+  gst_pad_send_event(sink, gst_event_new_stream_start(stream_id));
+  gst_pad_send_event(sink, gst_event_new_caps(caps));
+  gst_caps_unref(caps);
+  gst_segment_init(&segment, GST_FORMAT_TIME);
+  gst_pad_send_event(sink, gst_event_new_segment(&segment));
+}
+
+gboolean prerec_chain_gop_sized(GstPad* sink, guint64* pts_ns, gsize key_bytes, gsize delta_bytes) {
+  for (int i = 0; i < 3; ++i) {
+    GstBuffer* b = gst_buffer_new_allocate(NULL, i == 0 ? key_bytes : delta_bytes, NULL);
+    GST_BUFFER_PTS(b) = *pts_ns;
+    GST_BUFFER_DURATION(b) = GST_SECOND;
+    if (i > 0)
+      GST_BUFFER_FLAG_SET(b, GST_BUFFER_FLAG_DELTA_UNIT);
+    if (gst_pad_chain(sink, b) != GST_FLOW_OK)
+      return FALSE;
+    *pts_ns += GST_SECOND;
+  }
+  return TRUE;
+}
+
+gboolean prerec_chain_gop(GstPad* sink, guint64* pts_ns) {
+  return prerec_chain_gop_sized(sink, pts_ns, PREREC_CHAIN_FRAME_BYTES, PREREC_CHAIN_FRAME_BYTES);
+}
+
 gboolean prerec_wait_for_stats(GstElement* pr, guint min_gops, guint min_drops_gops, guint timeout_ms) {
   if (!pr)
     return FALSE;
@@ -188,3 +217,71 @@ gboolean prerec_wait_for_stats(GstElement* pr, guint min_gops, guint min_drops_g
   }
   return FALSE; /* timeout */
 }
+
+gboolean prerec_wait_for_stat(GstElement* pr, const char* field, guint min, guint timeout_ms) {
+  const guint step_ms = 5;
+  for (guint waited = 0; waited <= timeout_ms; waited += step_ms) {
+    guint v = prerec_stat_uint(pr, field);
+    if (v != G_MAXUINT && v >= min)
+      return TRUE;
+    g_usleep(step_ms * 1000);
+    while (g_main_context_iteration(NULL, FALSE))
+      ;
+  }
+  return FALSE; /* timeout */
+}
+
+static gboolean prerec_query_stats(GstElement* pr, GstQuery** out) {
+  GstQuery* q = gst_query_new_custom(GST_QUERY_CUSTOM, gst_structure_new_empty("prerec-stats"));
+  if (!pr || !gst_element_query(pr, q)) {
+    gst_query_unref(q);
+    return FALSE;
+  }
+  *out = q;
+  return TRUE;
+}
+
+guint prerec_stat_uint(GstElement* pr, const char* field) {
+  guint v = G_MAXUINT;
+  GstQuery* q;
+  if (prerec_query_stats(pr, &q)) {
+    gst_structure_get_uint(gst_query_get_structure(q), field, &v);
+    gst_query_unref(q);
+  }
+  return v;
+}
+
+guint64 prerec_stat_uint64(GstElement* pr, const char* field) {
+  guint64 v = G_MAXUINT64;
+  GstQuery* q;
+  if (prerec_query_stats(pr, &q)) {
+    gst_structure_get_uint64(gst_query_get_structure(q), field, &v);
+    gst_query_unref(q);
+  }
+  return v;
+}
+
+gboolean prerec_settle(GstElement* pipeline) {
+  GstBus* bus = gst_element_get_bus(pipeline);
+  gboolean ok = TRUE;
+
+  for (int i = 0; i < 20; ++i) {
+    GstMessage* msg = gst_bus_timed_pop_filtered(bus, 5 * GST_MSECOND, GST_MESSAGE_ANY);
+    if (msg && GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+      GError* err = NULL;
+      gchar* dbg = NULL;
+      gst_message_parse_error(msg, &err, &dbg);
+      g_printerr("ERROR from %s: %s (%s)\n", GST_OBJECT_NAME(GST_MESSAGE_SRC(msg)), err->message,
+                 dbg ? dbg : "no details");
+      g_clear_error(&err);
+      g_free(dbg);
+      ok = FALSE;
+    }
+    if (msg)
+      gst_message_unref(msg);
+    while (g_main_context_iteration(NULL, FALSE))
+      ;
+  }
+  gst_object_unref(bus);
+  return ok;
+}
@@ -45,10 +45,35 @@ void prerec_pipeline_shutdown(PrerecTestPipeline* p);
 gboolean prerec_push_gop(GstElement* appsrc, guint delta_count, guint64* pts_base_ns, guint64 duration_ns,
                          guint64* out_last_pts);
 
+/* Send stream-start (stream_id), video/x-h264 caps and a default TIME segment
+ * straight to a sink pad, for tests that chain buffers without appsrc. */
+void prerec_send_stream_setup(GstPad* sink, const char* stream_id);
+
+/* Chain a synthetic GOP straight into a sink pad: a keyframe and two deltas of
+ * 1 s each starting at *pts_ns (advanced past the GOP). prerec_chain_gop()
+ * uses 64-byte frames (PREREC_CHAIN_FRAME_BYTES).
+ * Returns FALSE as soon as a chain does not return GST_FLOW_OK. */
+#define PREREC_CHAIN_FRAME_BYTES 64
+gboolean prerec_chain_gop(GstPad* sink, guint64* pts_ns);
+gboolean prerec_chain_gop_sized(GstPad* sink, guint64* pts_ns, gsize key_bytes, gsize delta_bytes);
+
 /* Poll the prerecord element's custom stats query until conditions satisfied or timeout.
  * Returns TRUE if (queued_gops >= min_gops && drops_gops >= min_drops_gops) met before timeout_ms elapsed. */
 gboolean prerec_wait_for_stats(GstElement* pr, guint min_gops, guint min_drops_gops, guint timeout_ms);
 
+/* Same for one unsigned prerec-stats field, e.g. "queued-buffers", reaching min. */
+gboolean prerec_wait_for_stat(GstElement* pr, const char* field, guint min, guint timeout_ms);
+
+/* One field of the prerec-stats query; G_MAXUINT / G_MAXUINT64 when the
+ * query fails or lacks the field. */
+guint prerec_stat_uint(GstElement* pr, const char* field);
+guint64 prerec_stat_uint64(GstElement* pr, const char* field);
+
+/* Lets streaming threads run for ~100 ms while draining the pipeline bus and
+ * the default main context. Returns FALSE (after printing it) if an ERROR
+ * message was posted meanwhile; use SETTLE() from a test's main(). */
+gboolean prerec_settle(GstElement* pipeline);
+
 /* (Optional) Attach a probe to element src pad to count buffers emitted. */
 gulong prerec_attach_count_probe(GstElement* el, guint64* counter_out);
 void prerec_remove_probe(GstElement* el, gulong id);
@@ -70,6 +95,13 @@ void prerec_remove_probe(GstElement* el, gulong id);
     return 1;                            \
   } while (0)
 
+/* prerec_settle() that fails the test on an ERROR message */
+#define SETTLE(pipeline)                         \
+  do {                                           \
+    if (!prerec_settle(pipeline))                \
+      FAIL("error message on the pipeline bus"); \
+  } while (0)
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,203 @@
+/*
+ * prerec-handoff-consumer: minimal receiver for pre_record_loop's
+ * handoff-socket property.
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ *
+ * Usage: prerec-handoff-consumer [--once] <socket-path> <output-dir>
+ *
+ * Listens on socket-path; for every hand-off it maps the received memfd
+ * read-only and writes the frames, in index order, to
+ * <output-dir>/clip-<clip-id>.bin with writev() straight from the mapping,
+ * then acks so the element can release the ring regions. --once exits after
+ * the first clip.
+ */
+
+#define _GNU_SOURCE /* accept4 */
+
+#include <gstprerecordloop/gstprerechandoffproto.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/* Reads len bytes; the first chunk may carry the memfd (*fd set, else -1) */
+static int recv_all(int sock, void* data, size_t len, int* fd) {
+  char control[CMSG_SPACE(sizeof(int))];
+  uint8_t* p = data;
+
+  while (len > 0) {
+    struct iovec iov = {p, len};
+    struct msghdr msg;
+    ssize_t n;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (fd) {
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+    }
+    n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return -1;
+    if (fd) {
+      struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+      if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+        memcpy(fd, CMSG_DATA(cmsg), sizeof(int));
+      fd = NULL; /* the descriptor only rides on the first chunk */
+    }
+    p += n;
+    len -= (size_t) n;
+  }
+  return 0;
+}
+
+static int write_clip(const char* path, const uint8_t* base, const GstPreRecHandoffFrame* frames, uint32_t n) {
+  struct iovec iov[IOV_MAX];
+  int out = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  uint32_t i = 0;
+
+  if (out < 0)
+    return -1;
+  while (i < n) {
+    int cnt = 0;
+    size_t want = 0;
+    ssize_t done;
+
+    for (; i < n && cnt < IOV_MAX; ++i, ++cnt) {
+      iov[cnt].iov_base = (void*) (base + frames[i].offset);
+      iov[cnt].iov_len = frames[i].size;
+      want += frames[i].size;
+    }
+    done = writev(out, iov, cnt);
+    if (done < 0 || (size_t) done != want) { /* regular files do not short-write short of ENOSPC */
+      close(out);
+      return -1;
+    }
+  }
+  if (fdatasync(out) != 0) {
+    close(out);
+    return -1;
+  }
+  return close(out);
+}
+
+static int handle_client(int sock, const char* outdir) {
+  GstPreRecHandoffHeader header;
+  GstPreRecHandoffFrame* frames = NULL;
+  char* caps = NULL;
+  char path[PATH_MAX];
+  void* base = MAP_FAILED;
+  int fd = -1, ret = -1;
+  char ack = GST_PREREC_HANDOFF_ACK;
+
+  if (recv_all(sock, &header, sizeof(header), &fd) != 0 || fd < 0)
+    goto out;
+  if (header.magic != GST_PREREC_HANDOFF_MAGIC || header.version != GST_PREREC_HANDOFF_VERSION) {
+    fprintf(stderr, "prerec-handoff-consumer: bad header\n");
+    goto out;
+  }
+  caps = calloc(1, (size_t) header.caps_len + 1);
+  frames = calloc(header.n_frames ? header.n_frames : 1, sizeof(GstPreRecHandoffFrame));
+  if (!caps || !frames || recv_all(sock, caps, header.caps_len, NULL) != 0 ||
+      recv_all(sock, frames, (size_t) header.n_frames * sizeof(GstPreRecHandoffFrame), NULL) != 0)
+    goto out;
+  for (uint32_t i = 0; i < header.n_frames; ++i) {
+    if (frames[i].offset > header.arena_size || frames[i].size > header.arena_size - frames[i].offset) {
+      fprintf(stderr, "prerec-handoff-consumer: frame %" PRIu32 " outside the arena\n", i);
+      goto out;
+    }
+  }
+
+  base = mmap(NULL, header.arena_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED) {
+    perror("prerec-handoff-consumer: mmap");
+    goto out;
+  }
+  snprintf(path, sizeof(path), "%s/clip-%" PRIu64 ".bin", outdir, header.clip_id);
+  if (write_clip(path, base, frames, header.n_frames) != 0) {
+    perror("prerec-handoff-consumer: write");
+    goto out;
+  }
+  printf("clip %" PRIu64 ": %" PRIu32 " frames -> %s (%s)\n", header.clip_id, header.n_frames, path, caps);
+  fflush(stdout);
+  ret = send(sock, &ack, 1, MSG_NOSIGNAL) == 1 ? 0 : -1;
+
+out:
+  if (base != MAP_FAILED)
+    munmap(base, header.arena_size);
+  if (fd >= 0)
+    close(fd);
+  free(frames);
+  free(caps);
+  return ret;
+}
+
+int main(int argc, char** argv) {
+  struct sockaddr_un addr;
+  char tmp[sizeof(addr.sun_path)];
+  int once = 0, listener, argi = 1;
+
+  if (argi < argc && strcmp(argv[argi], "--once") == 0) {
+    once = 1;
+    argi++;
+  }
+  if (argc - argi != 2) {
+    fprintf(stderr, "usage: %s [--once] <socket-path> <output-dir>\n", argv[0]);
+    return 2;
+  }
+  if (snprintf(tmp, sizeof(tmp), "%s.tmp", argv[argi]) >= (int) sizeof(tmp)) {
+    fprintf(stderr, "prerec-handoff-consumer: socket path too long\n");
+    return 2;
+  }
+
+  listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, tmp);
+  unlink(tmp);
+  /* bind under a temporary name and rename once listening, so the socket
+   * path never exists without a listener behind it */
+  if (listener < 0 || bind(listener, (struct sockaddr*) &addr, sizeof(addr)) != 0 || listen(listener, 4) != 0 ||
+      rename(tmp, argv[argi]) != 0) {
+    perror("prerec-handoff-consumer: listen");
+    return 1;
+  }
+
+  for (;;) {
+    int client = accept4(listener, NULL, NULL, SOCK_CLOEXEC);
+    int ret;
+
+    if (client < 0) {
+      if (errno == EINTR)
+        continue;
+      perror("prerec-handoff-consumer: accept");
+      break;
+    }
+    ret = handle_client(client, argv[argi + 1]);
+    close(client);
+    if (once) {
+      unlink(argv[argi]);
+      return ret == 0 ? 0 : 1;
+    }
+  }
+  unlink(argv[argi]);
+  return 1;
+}
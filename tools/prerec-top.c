@@ -0,0 +1,212 @@
+/*
+ * prerec-top: lists the stats pages of every pre_record_loop on the host.
+ *
+ * Same licensing terms as gstprerecordloop.h (MIT / LGPL-2.1).
+ *
+ * Usage: prerec-top [--once] [--interval <ms>] [--gc]
+ *
+ * Elements with stats-page=true publish their level and counters in
+ * /dev/shm/prerec-stats-<pid>-<n> (layout in gstprerecstatsproto.h). This
+ * tool maps them read-only and prints one line per ring, refreshed every
+ * interval (1000 ms) until interrupted; --once prints a single table with no
+ * screen clearing, for scripts. Reading never blocks the elements. Pages
+ * left behind by processes that died are shown as "dead" and removed with
+ * --gc.
+ */
+
+#define _DEFAULT_SOURCE /* usleep, kill, NAME_MAX under -std=c11 */
+
+#include <gstprerecordloop/gstprerecstatsproto.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SHM_DIR "/dev/shm"
+
+typedef struct {
+  char file[NAME_MAX + 1];
+  GstPreRecStatsPage page;
+  int busy; /* no consistent copy */
+  int dead; /* writer process gone */
+} Ring;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+/* Maps one page and copies it out; 0 if it is a prerec stats page */
+static int load_ring(const char* file, Ring* ring) {
+  char path[PATH_MAX];
+  struct stat st;
+  const GstPreRecStatsPage* page;
+  int fd, ret = -1;
+
+  snprintf(path, sizeof(path), SHM_DIR "/%s", file);
+  fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return -1;
+  if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(GstPreRecStatsPage)) {
+    close(fd);
+    return -1;
+  }
+  page = mmap(NULL, sizeof(GstPreRecStatsPage), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (page == MAP_FAILED)
+    return -1;
+  if (__atomic_load_n(&page->magic, __ATOMIC_ACQUIRE) == GST_PREREC_STATS_MAGIC &&
+      page->version == GST_PREREC_STATS_VERSION) {
+    memset(ring, 0, sizeof(*ring));
+    snprintf(ring->file, sizeof(ring->file), "%s", file);
+    ring->busy = gst_prerec_stats_page_read(page, &ring->page) != 0;
+    if (ring->busy) { /* keep the header for the listing */
+      ring->page.pid = page->pid;
+      memcpy(ring->page.element, page->element, sizeof(ring->page.element));
+    }
+    ring->page.element[sizeof(ring->page.element) - 1] = '\0';
+    ring->dead = kill((pid_t) ring->page.pid, 0) != 0 && errno == ESRCH;
+    ret = 0;
+  }
+  munmap((void*) page, sizeof(GstPreRecStatsPage));
+  return ret;
+}
+
+static int compare_rings(const void* a, const void* b) {
+  const Ring* ra = a;
+  const Ring* rb = b;
+
+  if (ra->page.pid != rb->page.pid)
+    return ra->page.pid < rb->page.pid ? -1 : 1;
+  return strcmp(ra->page.element, rb->page.element);
+}
+
+/* All pages currently in SHM_DIR, sorted by pid and element; NULL on error */
+static Ring* scan(size_t* n_rings) {
+  size_t len = 0, cap = 64;
+  Ring* rings = malloc(cap * sizeof(Ring));
+  DIR* dir = opendir(SHM_DIR);
+  struct dirent* entry;
+
+  if (!rings || !dir) {
+    free(rings);
+    if (dir)
+      closedir(dir);
+    return NULL;
+  }
+  while ((entry = readdir(dir))) {
+    if (strncmp(entry->d_name, GST_PREREC_STATS_SHM_PREFIX + 1, strlen(GST_PREREC_STATS_SHM_PREFIX) - 1) != 0)
+      continue;
+    if (len == cap) {
+      Ring* grown = realloc(rings, 2 * cap * sizeof(Ring));
+      if (!grown)
+        break;
+      rings = grown;
+      cap *= 2;
+    }
+    if (load_ring(entry->d_name, &rings[len]) == 0)
+      len++;
+  }
+  closedir(dir);
+  qsort(rings, len, sizeof(Ring), compare_rings);
+  *n_rings = len;
+  return rings;
+}
+
+static void format_bytes(char* out, size_t size, uint64_t bytes) {
+  if (bytes >= 10u * 1024 * 1024)
+    snprintf(out, size, "%" PRIu64 "M", bytes >> 20);
+  else if (bytes >= 10u * 1024)
+    snprintf(out, size, "%" PRIu64 "K", bytes >> 10);
+  else
+    snprintf(out, size, "%" PRIu64, bytes);
+}
+
+static void print_table(const Ring* rings, size_t n, uint64_t now) {
+  printf("%-7s %-40s %-5s %5s %6s %7s %11s %6s %7s %6s %5s %5s %8s %6s\n", "PID", "ELEMENT", "MODE", "GOPS",
+         "BUFS", "BYTES", "TIME/MAX", "DGOPS", "DBUFS", "DEVTS", "FLUSH", "REARM", "DRAIN", "AGE");
+  for (size_t i = 0; i < n; ++i) {
+    const GstPreRecStatsPage* p = &rings[i].page;
+    const char* mode = rings[i].dead   ? "dead"
+                       : rings[i].busy ? "busy"
+                       : p->mode == GST_PREREC_STATS_MODE_BUFFERING ? "buf"
+                                                                    : "pass";
+    char bytes[16], level[24], age[16];
+
+    format_bytes(bytes, sizeof(bytes), p->bytes);
+    snprintf(level, sizeof(level), "%.1f/%.0fs", p->time / 1e9, p->max_time / 1e9);
+    if (p->updated && now >= p->updated)
+      snprintf(age, sizeof(age), "%.1fs", (now - p->updated) / 1e9);
+    else
+      snprintf(age, sizeof(age), "-");
+    printf("%-7" PRIu32 " %-40.40s %-5s %5" PRIu32 " %6" PRIu32 " %7s %11s %6" PRIu32 " %7" PRIu32 " %6" PRIu32
+           " %5" PRIu32 " %5" PRIu32 " %6.1fms %6s\n",
+           p->pid, p->element, mode, p->gops, p->buffers, bytes, level, p->drops_gops, p->drops_buffers,
+           p->drops_events, p->flush_count, p->rearm_count, p->drain_duration / 1e6, age);
+  }
+  printf("%zu ring%s\n", n, n == 1 ? "" : "s");
+}
+
+static void collect_garbage(const Ring* rings, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    char path[PATH_MAX];
+
+    if (!rings[i].dead)
+      continue;
+    snprintf(path, sizeof(path), SHM_DIR "/%s", rings[i].file);
+    if (unlink(path) == 0)
+      fprintf(stderr, "prerec-top: removed %s (pid %" PRIu32 " gone)\n", rings[i].file, rings[i].page.pid);
+  }
+}
+
+int main(int argc, char** argv) {
+  int once = 0, gc = 0;
+  long interval = 1000;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--once") == 0) {
+      once = 1;
+    } else if (strcmp(argv[i], "--gc") == 0) {
+      gc = 1;
+    } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+      interval = strtol(argv[++i], NULL, 10);
+    } else {
+      fprintf(stderr, "usage: %s [--once] [--interval <ms>] [--gc]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (interval <= 0)
+    interval = 1000;
+
+  for (;;) {
+    size_t n = 0;
+    Ring* rings = scan(&n);
+
+    if (!rings) {
+      perror("prerec-top: " SHM_DIR);
+      return 1;
+    }
+    if (gc)
+      collect_garbage(rings, n);
+    if (!once)
+      printf("\033[H\033[2J");
+    print_table(rings, n, now_ns());
+    fflush(stdout);
+    free(rings);
+    if (once)
+      return 0;
+    usleep((useconds_t) interval * 1000);
+  }
+}